@@ -24,6 +24,27 @@ adc_module_del_dev(adc_dev_handle device);
 esp_err_t
 adc_module_get_data(adc_dev_handle adc_device, uint32_t samples_to_read, uint32_t *out_data, uint32_t *samples_read);
 
+/**
+ * Fraction bits of the device's stream samples, fixed at init by its oversampling
+ */
+esp_err_t
+adc_module_get_frac_bits(adc_dev_handle adc_device, uint8_t *out_frac_bits);
+
+/**
+ * Streaming for continuous devices: a fixed pool of sample blocks, allocated once. The unit's demux task splits every
+ * finished conversion frame into the rings of its devices, borrow waits for a frame's share of the device's samples and
+ * copies what is there into a free block. Init before enabling the device, deinit after disabling it with every block
+ * returned. adc_module_get_data is not available while streaming.
+ */
+esp_err_t
+adc_module_stream_init(adc_dev_handle adc_device, const struct adc_dev_stream_config_t *stream_cfg);
+esp_err_t
+adc_module_stream_deinit(adc_dev_handle adc_device);
+esp_err_t
+adc_module_stream_borrow(adc_dev_handle adc_device, adc_module_block_t **out_block, uint32_t timeout_ms);
+esp_err_t
+adc_module_stream_return(adc_dev_handle adc_device, adc_module_block_t *block);
+
 // esp_err_t
 // adc_module_init_dev(const struct adc_dev_config_t *adc_dev_cfg, adc_dev_handle *ret_device);
 
@@ -31,10 +52,23 @@ esp_err_t
 adc_module_init_dev_oneshot(const struct adc_base_dev_config_t *adc_base_cfg, const struct adc_dev_oneshot_config_t *adc_dev_cfg,
                             adc_dev_handle *ret_device);
 
+/**
+ * Continuous devices of a unit share one DMA pattern with an entry per device. Every channel converts at the fastest
+ * device conversion rate, sample_freq_hz times oversampling, and the others decimate that down, so each conversion rate
+ * has to divide the fastest one. Oversampled devices decimate through a CIC, a half-band FIR and a droop compensator
+ * and keep the extra bits as fraction bits of their samples, the others average. A device added while the unit runs
+ * joins the pattern when it is enabled, which restarts the unit.
+ */
 esp_err_t
 adc_module_init_dev_continuous(const struct adc_base_dev_config_t *adc_base_cfg, const struct adc_dev_cont_config_t *adc_dev_cfg,
                                adc_dev_handle *ret_device);
 
+/**
+ * Runs noise through the decimation filter an oversampled device would get, in CPU cycles per output sample
+ */
+esp_err_t
+adc_module_benchmark_oversampling(uint16_t oversampling, uint32_t samples, uint32_t *out_cycles_per_sample);
+
 // esp_err_t
 // adc_module_init();
 
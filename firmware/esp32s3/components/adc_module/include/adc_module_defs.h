@@ -25,9 +25,27 @@ struct adc_base_dev_config_t {
 struct adc_dev_oneshot_config_t {};
 
 struct adc_dev_cont_config_t {
-  uint32_t sample_freq_hz;
+  uint32_t sample_freq_hz; // of this device, see adc_module_init_dev_continuous
+  uint16_t oversampling;   // conversions per sample through the decimation filter, 0 or 1 for none
 };
 
+struct adc_dev_stream_config_t {
+  uint8_t block_count; // blocks a consumer can hold at once, 0 for the default
+};
+
+/**
+ * One DMA conversion frame of a streaming device, converted to millivolts in fixed point. Owned by the caller between
+ * adc_module_stream_borrow and adc_module_stream_return.
+ */
+typedef struct {
+  uint16_t *samples;
+  uint32_t count;
+  uint32_t capacity;
+  uint8_t frac_bits; // samples are mV * 2^frac_bits, more than 0 only for oversampled devices
+
+  uint32_t frames_dropped; // frames lost to a full driver pool or device ring since the previous block
+} adc_module_block_t;
+
 #ifdef __cplusplus
 }
 #endif
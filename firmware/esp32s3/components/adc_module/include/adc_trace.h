@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ADC_TRACE_H
+#define ADC_TRACE_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "adc_module_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_TRACE_VERSION              1U
+#define ADC_TRACE_HEADER_SIZE          24U
+#define ADC_TRACE_RECORD_SIZE(samples) (ADC_TRACE_HEADER_SIZE + (samples) * sizeof(uint16_t))
+
+/**
+ * A trace is a plain concatenation of records, one per captured block, little endian:
+ *   "ADCT", version u8, frac_bits u8, count u16, sample_rate_hz u32, frames_dropped u32, timestamp_us u64,
+ *   count samples u16 as adc_module_block_t holds them, timestamp_us when the block was borrowed
+ * Every record describes itself, so captures cut at a record boundary or glued together stay readable, e.g.
+ *   mosquitto_sub -h <broker> -t <trace topic> -N > night.adct
+ */
+esp_err_t
+adc_trace_encode(const adc_module_block_t *block, uint32_t sample_rate_hz, uint64_t timestamp_us, uint8_t *buffer,
+                 uint32_t buffer_len, uint32_t *out_len);
+
+struct adc_trace_replay_config_t {
+  const char *path;
+};
+
+typedef struct adc_trace_replay *adc_trace_replay_handle;
+
+/**
+ * Replays a trace file as the device saw it. Every record keeps the rate and format of the first one.
+ */
+esp_err_t
+adc_trace_replay_open(const struct adc_trace_replay_config_t *replay_cfg, adc_trace_replay_handle *out_replay);
+esp_err_t
+adc_trace_replay_close(adc_trace_replay_handle replay);
+
+esp_err_t
+adc_trace_replay_get_format(adc_trace_replay_handle replay, uint32_t *out_sample_rate_hz, uint8_t *out_frac_bits);
+
+/**
+ * Same contract as adc_module_get_data on a continuous device, whole millivolts. ESP_ERR_NOT_FOUND once the trace is
+ * exhausted.
+ */
+esp_err_t
+adc_trace_replay_get_data(adc_trace_replay_handle replay, uint32_t samples_to_read, uint32_t *out_data,
+                          uint32_t *samples_read);
+
+/**
+ * Fills a caller's block up to its capacity the way adc_module_stream_borrow would, with the time it was handed out after
+ * its last sample. Records longer than the block continue in the next one. ESP_ERR_NOT_FOUND once the trace is exhausted.
+ */
+esp_err_t
+adc_trace_replay_next_block(adc_trace_replay_handle replay, adc_module_block_t *block, uint64_t *out_timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef ADC_DECIMATOR_H
+#define ADC_DECIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_DECIMATOR_MAX_ORDER      3U
+#define ADC_DECIMATOR_MAX_FRAC_BITS  4U  // 12 bit codes with 4 fraction bits still fit the uint16 samples
+#define ADC_DECIMATOR_HALFBAND_TAPS  39U // Blackman windowed, about 0.4 of the output rate stays flat
+#define ADC_DECIMATOR_HALFBAND_COEFS ((ADC_DECIMATOR_HALFBAND_TAPS + 1U) / 4U) // odd taps either side of the centre
+#define ADC_DECIMATOR_INTERNAL_FRAC  8U  // fraction bits between the CIC and the half-band stage
+#define ADC_DECIMATOR_COEF_BITS      30U
+#define ADC_DECIMATOR_COMP_TAP       6  // outer taps of the droop compensator, -a y[n] + (1 + 2a) y[n-1] - a y[n-2]
+#define ADC_DECIMATOR_COMP_BITS      7U // ... with a = ADC_DECIMATOR_COMP_TAP / 2^ADC_DECIMATOR_COMP_BITS
+
+struct adc_decimator_config_t {
+  uint16_t factor; // inputs per output, even when the half-band stage is used
+  uint8_t order;   // CIC order, 1 is a plain block average
+  uint8_t frac_bits;
+  uint8_t input_bits;
+  bool use_halfband; // the CIC takes factor / 2 and a half-band FIR the last 2, then a 3 tap FIR lifts the CIC droop
+};
+
+/**
+ * CIC decimator on raw ADC codes: order integrators at the input rate, order combs at the CIC output rate, the
+ * factor^order gain divided out. The registers wrap modulo 2^32, which the comb differences undo as long as
+ * input_bits + order * log2(factor) <= 32. The optional half-band and compensation FIRs run in fixed point behind it.
+ */
+typedef struct {
+  struct adc_decimator_config_t cfg;
+  uint16_t cic_factor;
+  uint8_t cic_frac; // fraction bits of the CIC output
+  uint8_t gain_shift; // factor^order as a shift when it is a power of two, 0 otherwise
+  uint64_t gain;
+  int32_t out_max;
+
+  uint16_t phase;
+  uint32_t integrators[ADC_DECIMATOR_MAX_ORDER];
+  uint32_t combs[ADC_DECIMATOR_MAX_ORDER];
+
+  bool halfband_odd;
+  uint8_t history_pos;
+  int32_t history[2U * ADC_DECIMATOR_HALFBAND_TAPS]; // written twice so the taps always read one contiguous window
+  int32_t coefs[ADC_DECIMATOR_HALFBAND_COEFS];       // ADC_DECIMATOR_COEF_BITS fraction bits, the centre tap is 1/2
+  int32_t compensator[2];                            // last two half-band outputs
+} adc_decimator;
+
+esp_err_t
+adc_decimator_init(adc_decimator *decimator, const struct adc_decimator_config_t *decimator_cfg);
+void
+adc_decimator_reset(adc_decimator *decimator);
+
+/**
+ * Codes in, codes with frac_bits fraction bits out, one per factor inputs. Works in place, returns the output count.
+ */
+uint32_t
+adc_decimator_process(adc_decimator *decimator, const uint16_t *codes, uint32_t count, uint16_t *out_codes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
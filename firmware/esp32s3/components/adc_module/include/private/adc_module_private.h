@@ -12,11 +12,24 @@ extern "C" {
 #define ADC_MAX_MV 3160
 #define ADC_MIN_MV 0
 
+#define ADC_MV_LUT_MAX_BITWIDTH 12 // 4096 entries, 8 KiB of internal RAM per enabled device
+
 #define ADC_GET_IO_NUM(unit, channel) (adc_channel_io_map[unit][channel])
 
 #define ADC_CONT_FLUSH_POOL_IF_FULL 1
 #define ADC_CONT_MAX_FRAMES_LENGTH 1200
 #define ADC_CONT_CONV_FRAME_SIZE 800
+#define ADC_CONT_FRAME_SAMPLES   (ADC_CONT_CONV_FRAME_SIZE / SOC_ADC_DIGI_RESULT_BYTES)
+
+#define ADC_STREAM_DEFAULT_BLOCKS     2U
+#define ADC_STREAM_MAX_PENDING_FRAMES (ADC_CONT_MAX_FRAMES_LENGTH / ADC_CONT_CONV_FRAME_SIZE + 1U)
+#define ADC_STREAM_RING_FRAMES        4U // frames of samples a device ring holds before its shares are dropped
+
+#define ADC_OVERSAMPLING_CIC_ORDER 3U // aliases folding into the lower half of the band stay 60 dB down from 16x up
+
+#define ADC_DEMUX_TASK_STACK 3072U
+#define ADC_DEMUX_TASK_PRIO  18U // above every consumer, the driver pool only holds a frame and a half
+#define ADC_DEMUX_TASK_CORE  0U
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ADC_MV_LUT_H
+#define ADC_MV_LUT_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_MV_LUT_LEN(_bit_width) (1UL << (_bit_width))
+
+/**
+ * Raw code to millivolts the slow way, the calibration scheme or a linear fallback
+ */
+typedef esp_err_t (*adc_mv_lut_convert_fn)(void *user_ctx, int raw, int *out_mv);
+
+/**
+ * raw -> mV for every code of a bit width, filled once through the conversion so the sample loops only index it. The
+ * table memory belongs to the caller, ADC_MV_LUT_LEN entries.
+ */
+typedef struct {
+  uint16_t *table;
+  uint32_t len;
+} adc_mv_lut;
+
+/**
+ * Leaves the lut empty when a conversion fails
+ */
+esp_err_t
+adc_mv_lut_build(adc_mv_lut *lut, uint16_t *table, uint8_t bit_width, adc_mv_lut_convert_fn convert, void *user_ctx);
+
+/**
+ * Oversampled codes with frac_bits fraction bits to millivolts with as many, interpolating between table entries. Works
+ * in place.
+ */
+void
+adc_mv_lut_codes_to_mv(const adc_mv_lut *lut, uint16_t *samples, uint32_t count, uint8_t frac_bits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
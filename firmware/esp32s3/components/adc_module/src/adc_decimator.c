@@ -0,0 +1,181 @@
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "private/adc_decimator.h"
+
+static const char *TAG = "adc_decimator";
+
+static void
+design_halfband(adc_decimator *decimator);
+static int32_t
+halfband_push(adc_decimator *decimator, int32_t sample, bool *out_ready);
+
+esp_err_t
+adc_decimator_init(adc_decimator *decimator, const struct adc_decimator_config_t *decimator_cfg) {
+  ESP_RETURN_ON_FALSE(decimator && decimator_cfg && decimator_cfg->factor, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  uint8_t order = decimator_cfg->order;
+  uint8_t input_bits = decimator_cfg->input_bits;
+  ESP_RETURN_ON_FALSE(order >= 1U && order <= ADC_DECIMATOR_MAX_ORDER, ESP_ERR_INVALID_ARG, TAG, "invalid order %u", order);
+  ESP_RETURN_ON_FALSE(decimator_cfg->frac_bits <= ADC_DECIMATOR_MAX_FRAC_BITS && input_bits + decimator_cfg->frac_bits <= 16U,
+                      ESP_ERR_INVALID_ARG, TAG, "%u fraction bits do not fit %u bit codes", decimator_cfg->frac_bits,
+                      input_bits);
+  ESP_RETURN_ON_FALSE(!decimator_cfg->use_halfband || !(decimator_cfg->factor & 1U), ESP_ERR_INVALID_ARG, TAG,
+                      "the half-band stage needs an even factor");
+
+  memset(decimator, 0, sizeof(adc_decimator));
+  decimator->cfg = *decimator_cfg;
+  decimator->cic_factor = decimator_cfg->use_halfband ? decimator_cfg->factor / 2U : decimator_cfg->factor;
+  decimator->cic_frac = decimator_cfg->use_halfband ? ADC_DECIMATOR_INTERNAL_FRAC : decimator_cfg->frac_bits;
+  decimator->out_max = (int32_t)(((1UL << input_bits) - 1U) << decimator_cfg->frac_bits);
+
+  uint64_t gain = 1U;
+  for (uint8_t i = 0; i < order; ++i) {
+    gain *= decimator->cic_factor;
+  }
+  // The largest output has to fit the wrapping registers
+  ESP_RETURN_ON_FALSE(gain * ((1ULL << input_bits) - 1U) <= UINT32_MAX, ESP_ERR_INVALID_ARG, TAG,
+                      "order %u over %u overflows the registers", order, decimator->cic_factor);
+  decimator->gain = gain;
+  if (!(gain & (gain - 1U))) {
+    while ((1ULL << decimator->gain_shift) < gain) {
+      decimator->gain_shift++;
+    }
+  }
+
+  if (decimator_cfg->use_halfband) {
+    design_halfband(decimator);
+  }
+  return ESP_OK;
+}
+void
+adc_decimator_reset(adc_decimator *decimator) {
+  decimator->phase = 0;
+  memset(decimator->integrators, 0, sizeof(decimator->integrators));
+  memset(decimator->combs, 0, sizeof(decimator->combs));
+  decimator->halfband_odd = false;
+  decimator->history_pos = 0;
+  memset(decimator->history, 0, sizeof(decimator->history));
+  memset(decimator->compensator, 0, sizeof(decimator->compensator));
+}
+
+uint32_t
+adc_decimator_process(adc_decimator *decimator, const uint16_t *codes, uint32_t count, uint16_t *out_codes) {
+  uint32_t out_count = 0;
+  if (decimator->cfg.factor == 1U) {
+    for (uint32_t i = 0; i < count; ++i) {
+      out_codes[i] = (uint16_t)(codes[i] << decimator->cfg.frac_bits);
+    }
+    return count;
+  }
+
+  // Integrators kept in locals, the recursion is the whole per input cost
+  uint32_t i0 = decimator->integrators[0];
+  uint32_t i1 = decimator->integrators[1];
+  uint32_t i2 = decimator->integrators[2];
+  uint8_t order = decimator->cfg.order;
+  uint16_t phase = decimator->phase;
+  uint16_t cic_factor = decimator->cic_factor;
+  uint8_t cic_frac = decimator->cic_frac;
+  uint64_t rounding = decimator->gain >> 1U;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    i0 += codes[i];
+    i1 += i0;
+    i2 += i1;
+    if (++phase < cic_factor)
+      continue;
+    phase = 0;
+
+    uint32_t y = order == 1U ? i0 : (order == 2U ? i1 : i2);
+    for (uint8_t k = 0; k < order; ++k) {
+      uint32_t delayed = decimator->combs[k];
+      decimator->combs[k] = y;
+      y -= delayed;
+    }
+    uint64_t scaled = ((uint64_t)y << cic_frac) + rounding;
+    int32_t sample = (int32_t)(decimator->gain_shift ? scaled >> decimator->gain_shift : scaled / decimator->gain);
+
+    if (decimator->cfg.use_halfband) {
+      bool ready = false;
+      sample = halfband_push(decimator, sample, &ready);
+      if (!ready)
+        continue;
+    }
+    // The FIR rings past the code range on steps
+    sample = sample < 0 ? 0 : (sample > decimator->out_max ? decimator->out_max : sample);
+    out_codes[out_count++] = (uint16_t)sample;
+  }
+
+  decimator->integrators[0] = i0;
+  decimator->integrators[1] = i1;
+  decimator->integrators[2] = i2;
+  decimator->phase = phase;
+  return out_count;
+}
+
+/**
+ * Windowed ideal half-band, the odd taps scaled so they add up to exactly 1/2 and the DC gain stays 1
+ */
+static void
+design_halfband(adc_decimator *decimator) {
+  const double half_len = (ADC_DECIMATOR_HALFBAND_TAPS - 1U) / 2.0;
+  double taps[ADC_DECIMATOR_HALFBAND_COEFS];
+  double sum = 0.0;
+  for (uint8_t k = 0; k < ADC_DECIMATOR_HALFBAND_COEFS; ++k) {
+    double n = 2.0 * k + 1.0;
+    double x = M_PI * n / (half_len + 1.0);
+    double window = 0.42 + 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+    taps[k] = sin(M_PI * n / 2.0) / (M_PI * n) * window;
+    sum += 2.0 * taps[k];
+  }
+
+  const int64_t one = 1LL << ADC_DECIMATOR_COEF_BITS;
+  int64_t total = 0;
+  for (uint8_t k = 0; k < ADC_DECIMATOR_HALFBAND_COEFS; ++k) {
+    decimator->coefs[k] = (int32_t)llround(taps[k] / sum * 0.5 * one);
+    total += 2 * (int64_t)decimator->coefs[k];
+  }
+  // Rounding left over goes to the tap next to the centre, the largest one
+  decimator->coefs[0] += (int32_t)((one / 2 - total) / 2);
+}
+/**
+ * Takes every CIC output, produces one sample for every second of them
+ */
+static int32_t
+halfband_push(adc_decimator *decimator, int32_t sample, bool *out_ready) {
+  uint8_t pos = decimator->history_pos;
+  decimator->history[pos] = sample;
+  decimator->history[pos + ADC_DECIMATOR_HALFBAND_TAPS] = sample;
+  decimator->history_pos = (uint8_t)((pos + 1U) % ADC_DECIMATOR_HALFBAND_TAPS);
+
+  decimator->halfband_odd = !decimator->halfband_odd;
+  if (decimator->halfband_odd) {
+    *out_ready = false;
+    return 0;
+  }
+
+  // Oldest sample first, the centre tap sits in the middle of the window
+  const int32_t *window = &decimator->history[decimator->history_pos];
+  const uint8_t centre = (ADC_DECIMATOR_HALFBAND_TAPS - 1U) / 2U;
+  int64_t acc = (int64_t)window[centre] << (ADC_DECIMATOR_COEF_BITS - 1U);
+  for (uint8_t k = 0; k < ADC_DECIMATOR_HALFBAND_COEFS; ++k) {
+    uint8_t offset = 2U * k + 1U;
+    acc += (int64_t)decimator->coefs[k] * (window[centre - offset] + window[centre + offset]);
+  }
+
+  int32_t halfband = (int32_t)((acc + (1LL << (ADC_DECIMATOR_COEF_BITS - 1U))) >> ADC_DECIMATOR_COEF_BITS);
+
+  // Symmetric, so one more output of delay and no phase change
+  int32_t y0 = decimator->compensator[0];
+  int32_t y1 = decimator->compensator[1];
+  decimator->compensator[0] = y1;
+  decimator->compensator[1] = halfband;
+  int32_t lifted = y1 * ((1 << ADC_DECIMATOR_COMP_BITS) + 2 * ADC_DECIMATOR_COMP_TAP) - ADC_DECIMATOR_COMP_TAP * (y0 + halfband);
+
+  uint8_t shift = ADC_DECIMATOR_COMP_BITS + ADC_DECIMATOR_INTERNAL_FRAC - decimator->cfg.frac_bits;
+  *out_ready = true;
+  return (lifted + (1 << (shift - 1U))) >> shift;
+}
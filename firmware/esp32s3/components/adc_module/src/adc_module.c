@@ -6,12 +6,18 @@
 #include "freertos/FreeRTOS.h"
 
 #include "FreeRTOSConfig.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
 #include "freertos/task.h"
 
 #include "portmacro.h"
 
+#include "esp_attr.h"
 #include "esp_check.h"
+#include "esp_cpu.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 
 #include "driver/gpio.h"
 #include "esp_adc/adc_cali.h"
@@ -24,6 +30,8 @@
 
 #include "adc_module.h"
 #include "adc_module_defs.h"
+#include "private/adc_decimator.h"
+#include "private/adc_mv_lut.h"
 #include "private/adc_module_private.h"
 
 typedef struct {
@@ -43,6 +51,22 @@ typedef struct {
     adc_continuous_handle_t cont;
   } handle;
   esp_adc_channel_t channels[SOC_ADC_MAX_CHANNEL_NUM];
+
+  // Continuous only: one DMA pattern over every device of the unit, split per device by the demux task
+  struct {
+    struct adc_dev *devices[SOC_ADC_MAX_CHANNEL_NUM]; // by channel id
+    uint8_t device_count;
+    uint32_t channel_rate_hz; // conversions per channel, the fastest device conversion rate
+    bool is_running;
+    bool is_pattern_dirty; // devices changed since the pattern was configured
+
+    uint8_t *raw_frame; // one conversion frame copied out of the driver pool
+    SemaphoreHandle_t lock;         // held by the demux task for every frame and by whoever changes the device set
+    SemaphoreHandle_t frames_ready; // given from the driver ISR for every finished conversion frame
+    TaskHandle_t demux_task;
+
+    volatile uint32_t frames_dropped; // pool overflows, only written from the ISR, every device loses the frame
+  } cont;
 } esp_adc_unit_t;
 
 struct adc_dev {
@@ -66,6 +90,32 @@ struct adc_dev {
 
   esp_adc_channel_t *adc_channel;
   esp_adc_unit_t *adc_unit;
+
+  adc_mv_lut mv_lut; // built on enable from the calibration scheme, empty for bit widths without a table
+
+  // Continuous only, written by the demux task
+  struct {
+    StreamBufferHandle_t ring; // millivolts with frac_bits fraction bits at the device rate
+    uint16_t *staging;         // the device's share of the frame being split, raw codes until decimated
+    uint32_t staged;
+
+    adc_decimator decimator; // channel conversions down to the device rate
+    uint8_t frac_bits;
+
+    volatile uint32_t shares_dropped; // frame shares lost to a full ring
+    uint32_t shares_dropped_seen;
+    uint32_t frames_dropped_seen; // of the unit's pool overflows
+  } demux;
+
+  struct {
+    bool is_initialized;
+    uint8_t block_count;
+    adc_module_block_t *blocks;
+    uint16_t *samples;
+    bool *is_borrowed; // per block, from borrow to return
+
+    QueueHandle_t free_blocks;
+  } stream;
 };
 
 static const char *TAG = "adc_module";
@@ -75,6 +125,17 @@ static esp_adc_unit_t adc_units[SOC_ADC_PERIPH_NUM] = {0}; // allocate dynamical
 static bool
 is_cont_adc_configured();
 
+static esp_err_t
+check_cont_rate(const esp_adc_unit_t *adc_unit, uint32_t conv_rate_hz);
+static uint32_t
+fastest_cont_rate(const esp_adc_unit_t *adc_unit);
+static uint32_t
+dev_conv_rate(const struct adc_dev_cont_config_t *cont_cfg);
+static uint8_t
+oversampling_frac_bits(uint16_t oversampling, uint8_t input_bits);
+static esp_err_t
+configure_pattern(esp_adc_unit_t *adc_unit);
+
 static esp_err_t
 init_unit(adc_unit_t unit_id, enum adc_module_mode mode);
 static esp_err_t
@@ -103,6 +164,24 @@ disable_dev_oneshot(adc_dev_handle adc_device);
 static esp_err_t
 disable_dev_cont(adc_dev_handle adc_device);
 
+static inline esp_err_t
+raw_to_mv(adc_dev_handle adc_device, int raw, int *out_mv);
+static esp_err_t
+convert_raw(void *user_ctx, int raw, int *out_mv);
+static esp_err_t
+build_mv_lut(adc_dev_handle adc_device);
+static void
+codes_to_mv(adc_dev_handle adc_device, uint16_t *samples, uint32_t count);
+static void
+demux_frame(esp_adc_unit_t *adc_unit, const uint8_t *raw_frame, uint32_t raw_bytes);
+static void
+task_demux(void *arg);
+
+static bool IRAM_ATTR
+on_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data);
+static bool IRAM_ATTR
+on_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data);
+
 esp_err_t
 adc_module_enable_dev(adc_dev_handle adc_device) {
   ESP_RETURN_ON_FALSE(adc_device, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -111,8 +190,6 @@ adc_module_enable_dev(adc_dev_handle adc_device) {
   ESP_RETURN_ON_FALSE(!adc_device->adc_channel->is_enabled, ESP_ERR_INVALID_STATE, TAG,
                       "adc channel enable failed, channel is already enabled");
 
-  enable_dev(adc_device, adc_device->adc_unit->mode);
-
   if (adc_device->cfg_base.perform_calibration) {
 #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
     adc_cali_curve_fitting_config_t cali_config = {
@@ -141,6 +218,10 @@ adc_module_enable_dev(adc_dev_handle adc_device) {
              (uint8_t)adc_device->adc_unit->id, (uint8_t)adc_device->adc_channel->id);
 #endif
   }
+  ESP_RETURN_ON_ERROR(build_mv_lut(adc_device), TAG, "adc channel conversion table build failed");
+
+  // The demux task converts with the table as soon as the channel is enabled
+  ESP_RETURN_ON_ERROR(enable_dev(adc_device, adc_device->adc_unit->mode), TAG, "adc channel enable failed");
   return ESP_OK;
 }
 
@@ -153,6 +234,11 @@ adc_module_disable_dev(adc_dev_handle adc_device) {
                       "adc channel disable failed, channel is not enabled");
   disable_dev(adc_device, adc_device->adc_unit->mode);
 
+  uint16_t *mv_lut = adc_device->mv_lut.table;
+  adc_device->mv_lut.table = NULL;
+  adc_device->mv_lut.len = 0;
+  free(mv_lut);
+
   if (adc_device->adc_cali.is_calibrated) {
 #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
     ESP_RETURN_ON_ERROR(adc_cali_delete_scheme_curve_fitting(adc_device->adc_cali.handle), TAG,
@@ -171,9 +257,6 @@ adc_module_disable_dev(adc_dev_handle adc_device) {
   return ESP_OK;
 }
 
-/**
- * NOTE: Very inefficient but the driver is ass
- */
 esp_err_t
 adc_module_get_data(adc_dev_handle adc_device, uint32_t samples_to_read, uint32_t *out_data, uint32_t *samples_read) {
   ESP_RETURN_ON_FALSE(adc_device && out_data && samples_read, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -193,14 +276,10 @@ adc_module_get_data(adc_dev_handle adc_device, uint32_t samples_to_read, uint32_
       }
 
       int voltage = 0;
-      if (adc_device->adc_cali.is_calibrated) {
-        ret = adc_cali_raw_to_voltage(adc_device->adc_cali.handle, raw, &voltage);
-        if (ret != ESP_OK) {
-          ESP_LOGW(TAG, "Calibration failed at sample %lu", i);
-          break;
-        }
-      } else {
-        voltage = raw * ((float)ADC_MAX_MV / ((1U << adc_device->cfg_base.data_bit_width) - 1U));
+      ret = raw_to_mv(adc_device, raw, &voltage);
+      if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Calibration failed at sample %lu", i);
+        break;
       }
 
       out_data[i] = (uint32_t)voltage;
@@ -210,57 +289,154 @@ adc_module_get_data(adc_dev_handle adc_device, uint32_t samples_to_read, uint32_
   }
 
   case ADC_MODULE_MODE_CONTINUOUS: {
-    const uint32_t dma_buf_bytes = samples_to_read * sizeof(adc_digi_output_data_t);
-    uint8_t *dma_buf = (uint8_t *)heap_caps_malloc(dma_buf_bytes, MALLOC_CAP_INTERNAL);
-    ESP_RETURN_ON_FALSE(dma_buf, ESP_ERR_NO_MEM, TAG, "failed to allocate DMA buffer");
+    ESP_RETURN_ON_FALSE(!adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG,
+                        "device is streaming, use adc_module_stream_borrow");
 
-    uint32_t raw_bytes_read = 0;
-    ret = adc_continuous_read(adc_device->adc_unit->handle.cont, dma_buf, dma_buf_bytes, &raw_bytes_read, 0);
-    if (ret != ESP_OK || raw_bytes_read == 0) {
+    // Whatever the demux task has already split off for this device
+    uint16_t chunk[ADC_CONT_FRAME_SAMPLES / 4U];
+    while (read_count < samples_to_read) {
+      uint32_t chunk_len = samples_to_read - read_count;
+      chunk_len = chunk_len < sizeof(chunk) / sizeof(chunk[0]) ? chunk_len : sizeof(chunk) / sizeof(chunk[0]);
+
+      uint32_t received = xStreamBufferReceive(adc_device->demux.ring, chunk, chunk_len * sizeof(uint16_t), 0) / sizeof(uint16_t);
+      if (received == 0)
+        break;
+      // Whole millivolts, the extra bits of an oversampled device only come with the blocks
+      uint8_t frac_bits = adc_device->demux.frac_bits;
+      uint32_t rounding = frac_bits ? 1UL << (frac_bits - 1U) : 0U;
+      for (uint32_t i = 0; i < received; ++i) {
+        out_data[read_count++] = (chunk[i] + rounding) >> frac_bits;
+      }
+    }
+    if (read_count == 0) {
       ESP_LOGW(TAG, "No DMA data available");
-      free(dma_buf);
       return ESP_ERR_TIMEOUT;
     }
+    break;
+  }
 
-    uint32_t raw_samples = raw_bytes_read / sizeof(adc_digi_output_data_t);
-    adc_digi_output_data_t *results = (adc_digi_output_data_t *)dma_buf;
+  default:
+    ESP_LOGE(TAG, "Invalid ADC mode");
+    return ESP_ERR_INVALID_ARG;
+  }
 
-    for (uint32_t i = 0; i < raw_samples && read_count < samples_to_read; ++i) {
-      adc_digi_output_data_t res = results[i];
+  *samples_read = read_count;
+  return ESP_OK;
+}
 
-      if (res.type2.channel > SOC_ADC_CHANNEL_NUM(adc_device->adc_unit->id))
-        continue;
-      if (res.type2.unit != adc_device->adc_unit->id)
-        continue;
-      if (res.type2.channel != adc_device->adc_channel->id)
-        continue;
+esp_err_t
+adc_module_get_frac_bits(adc_dev_handle adc_device, uint8_t *out_frac_bits) {
+  ESP_RETURN_ON_FALSE(adc_device && out_frac_bits, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-      uint16_t raw = res.type2.data;
-      int voltage = 0;
+  *out_frac_bits = adc_device->demux.frac_bits;
+  return ESP_OK;
+}
 
-      if (adc_device->adc_cali.is_calibrated) {
-        ret = adc_cali_raw_to_voltage(adc_device->adc_cali.handle, raw, &voltage);
-        if (ret != ESP_OK) {
-          ESP_LOGW(TAG, "Calibration failed at sample %lu", i);
-          continue;
-        }
-      } else {
-        voltage = raw * ((float)ADC_MAX_MV / ((1U << adc_device->cfg_base.data_bit_width) - 1U));
-      }
+esp_err_t
+adc_module_stream_init(adc_dev_handle adc_device, const struct adc_dev_stream_config_t *stream_cfg) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(adc_device && stream_cfg, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(adc_device->adc_unit->mode == ADC_MODULE_MODE_CONTINUOUS, ESP_ERR_NOT_SUPPORTED, TAG,
+                      "streaming needs a continuous device");
+  ESP_RETURN_ON_FALSE(!adc_device->adc_channel->is_enabled, ESP_ERR_INVALID_STATE, TAG,
+                      "stream init failed, the device must be disabled");
+  ESP_RETURN_ON_FALSE(!adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG, "stream already initialized");
+
+  uint8_t block_count = stream_cfg->block_count ? stream_cfg->block_count : ADC_STREAM_DEFAULT_BLOCKS;
+
+  adc_device->stream.blocks = calloc(block_count, sizeof(adc_module_block_t));
+  adc_device->stream.samples = heap_caps_calloc((size_t)block_count * ADC_CONT_FRAME_SAMPLES, sizeof(uint16_t),
+                                                MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  adc_device->stream.is_borrowed = calloc(block_count, sizeof(bool));
+  ESP_GOTO_ON_FALSE(adc_device->stream.blocks && adc_device->stream.samples && adc_device->stream.is_borrowed, ESP_ERR_NO_MEM,
+                    err, TAG, "failed to allocate stream blocks");
+
+  adc_device->stream.free_blocks = xQueueCreate(block_count, sizeof(adc_module_block_t *));
+  ESP_GOTO_ON_FALSE(adc_device->stream.free_blocks, ESP_ERR_NO_MEM, err, TAG, "failed to create block queue");
+
+  for (uint8_t i = 0; i < block_count; ++i) {
+    adc_module_block_t *block = &adc_device->stream.blocks[i];
+    block->samples = &adc_device->stream.samples[(size_t)i * ADC_CONT_FRAME_SAMPLES];
+    block->capacity = ADC_CONT_FRAME_SAMPLES;
+    xQueueSend(adc_device->stream.free_blocks, &block, 0);
+  }
 
-      out_data[read_count++] = (uint32_t)voltage;
-    }
+  adc_device->stream.block_count = block_count;
+  adc_device->stream.is_initialized = true;
+  return ESP_OK;
 
-    free(dma_buf);
-    break;
+err:
+  if (adc_device->stream.free_blocks) {
+    vQueueDelete(adc_device->stream.free_blocks);
   }
+  free(adc_device->stream.is_borrowed);
+  free(adc_device->stream.samples);
+  free(adc_device->stream.blocks);
+  memset(&adc_device->stream, 0, sizeof(adc_device->stream));
+  return ret;
+}
+esp_err_t
+adc_module_stream_deinit(adc_dev_handle adc_device) {
+  ESP_RETURN_ON_FALSE(adc_device, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG, "stream not initialized");
+  ESP_RETURN_ON_FALSE(!adc_device->adc_channel->is_enabled, ESP_ERR_INVALID_STATE, TAG,
+                      "stream deinit failed, the device must be disabled");
+  ESP_RETURN_ON_FALSE(uxQueueMessagesWaiting(adc_device->stream.free_blocks) == adc_device->stream.block_count,
+                      ESP_ERR_INVALID_STATE, TAG, "stream deinit failed, blocks still borrowed");
+
+  vQueueDelete(adc_device->stream.free_blocks);
+  free(adc_device->stream.is_borrowed);
+  free(adc_device->stream.samples);
+  free(adc_device->stream.blocks);
+  memset(&adc_device->stream, 0, sizeof(adc_device->stream));
+  return ESP_OK;
+}
 
-  default:
-    ESP_LOGE(TAG, "Invalid ADC mode");
-    return ESP_ERR_INVALID_ARG;
+esp_err_t
+adc_module_stream_borrow(adc_dev_handle adc_device, adc_module_block_t **out_block, uint32_t timeout_ms) {
+  ESP_RETURN_ON_FALSE(adc_device && out_block, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG, "stream not initialized");
+
+  adc_module_block_t *block = NULL;
+  ESP_RETURN_ON_FALSE(xQueueReceive(adc_device->stream.free_blocks, &block, 0) == pdTRUE, ESP_ERR_NO_MEM, TAG,
+                      "every block is borrowed, return one first");
+
+  // The ring wakes the consumer once a frame's share of samples is in, see configure_pattern
+  TickType_t timeout_ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+  size_t received =
+      xStreamBufferReceive(adc_device->demux.ring, block->samples, block->capacity * sizeof(uint16_t), timeout_ticks);
+  block->count = received / sizeof(uint16_t);
+  block->frac_bits = adc_device->demux.frac_bits;
+  if (block->count == 0) {
+    xQueueSend(adc_device->stream.free_blocks, &block, 0);
+    return ESP_ERR_TIMEOUT;
   }
 
-  *samples_read = read_count;
+  uint32_t frames_dropped = adc_device->adc_unit->cont.frames_dropped;
+  uint32_t shares_dropped = adc_device->demux.shares_dropped;
+  block->frames_dropped = (frames_dropped - adc_device->demux.frames_dropped_seen) +
+                          (shares_dropped - adc_device->demux.shares_dropped_seen);
+  adc_device->demux.frames_dropped_seen = frames_dropped;
+  adc_device->demux.shares_dropped_seen = shares_dropped;
+
+  adc_device->stream.is_borrowed[block - adc_device->stream.blocks] = true;
+  *out_block = block;
+  return ESP_OK;
+}
+esp_err_t
+adc_module_stream_return(adc_dev_handle adc_device, adc_module_block_t *block) {
+  ESP_RETURN_ON_FALSE(adc_device && block, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG, "stream not initialized");
+  ESP_RETURN_ON_FALSE(block >= adc_device->stream.blocks && block < &adc_device->stream.blocks[adc_device->stream.block_count],
+                      ESP_ERR_INVALID_ARG, TAG, "block does not belong to this device");
+  uint8_t index = (uint8_t)(block - adc_device->stream.blocks);
+  ESP_RETURN_ON_FALSE(block == &adc_device->stream.blocks[index], ESP_ERR_INVALID_ARG, TAG, "not a block of this device");
+  // Without the flag a second return of a block only shows once the queue is full
+  ESP_RETURN_ON_FALSE(adc_device->stream.is_borrowed[index], ESP_ERR_INVALID_STATE, TAG, "block %u returned twice", index);
+
+  adc_device->stream.is_borrowed[index] = false;
+  block->count = 0;
+  xQueueSend(adc_device->stream.free_blocks, &block, 0);
   return ESP_OK;
 }
 
@@ -271,7 +447,21 @@ adc_module_del_dev(adc_dev_handle adc_device) {
                       "delete device failed, make sure it is disabled");
   ESP_RETURN_ON_FALSE(!adc_device->adc_cali.is_calibrated, ESP_ERR_INVALID_STATE, TAG,
                       "delete device failed, make sure to delete the calibration scheme");
-
+  ESP_RETURN_ON_FALSE(!adc_device->stream.is_initialized, ESP_ERR_INVALID_STATE, TAG,
+                      "delete device failed, make sure to deinit the stream");
+
+  esp_adc_unit_t *adc_unit = adc_device->adc_unit;
+  if (adc_unit->mode == ADC_MODULE_MODE_CONTINUOUS) {
+    xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+    adc_unit->cont.devices[adc_device->adc_channel->id] = NULL;
+    adc_unit->cont.device_count--;
+    adc_unit->cont.channel_rate_hz = fastest_cont_rate(adc_unit);
+    adc_unit->cont.is_pattern_dirty = true;
+    xSemaphoreGive(adc_unit->cont.lock);
+
+    vStreamBufferDelete(adc_device->demux.ring);
+    free(adc_device->demux.staging);
+  }
   free(adc_device);
   return ESP_OK;
 }
@@ -344,8 +534,12 @@ esp_err_t
 adc_module_init_dev_continuous(const struct adc_base_dev_config_t *adc_base_cfg, const struct adc_dev_cont_config_t *adc_dev_cfg,
                                adc_dev_handle *ret_device) {
   esp_err_t ret = ESP_OK;
-  ESP_RETURN_ON_FALSE(adc_dev_cfg && ret_device, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
-  ESP_RETURN_ON_FALSE(!is_cont_adc_configured(), ESP_ERR_INVALID_STATE, TAG, "only one device permitted in continuous mode");
+  ESP_RETURN_ON_FALSE(adc_base_cfg && adc_dev_cfg && ret_device, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(adc_dev_cfg->sample_freq_hz, ESP_ERR_INVALID_ARG, TAG, "invalid sample rate");
+  ESP_RETURN_ON_FALSE((uint64_t)adc_dev_cfg->sample_freq_hz * (adc_dev_cfg->oversampling ? adc_dev_cfg->oversampling : 1U) <=
+                          SOC_ADC_SAMPLE_FREQ_THRES_HIGH,
+                      ESP_ERR_INVALID_ARG, TAG, "%" PRIu32 " Hz oversampled %u times is out of the adc range",
+                      adc_dev_cfg->sample_freq_hz, adc_dev_cfg->oversampling);
 
   gpio_num_t pin = adc_base_cfg->data_pin;
   adc_unit_t unit = ADC_UNIT_1;
@@ -357,7 +551,8 @@ adc_module_init_dev_continuous(const struct adc_base_dev_config_t *adc_base_cfg,
       continue;
 #endif
     for (uint8_t ch_idx = 0; ch_idx < SOC_ADC_CHANNEL_NUM(unit_idx); ++ch_idx) {
-      if (!adc_units[unit_idx].channels[ch_idx].is_enabled && ADC_GET_IO_NUM(unit_idx, ch_idx) == pin) {
+      if (!adc_units[unit_idx].channels[ch_idx].is_enabled && !adc_units[unit_idx].cont.devices[ch_idx] &&
+          ADC_GET_IO_NUM(unit_idx, ch_idx) == pin) {
         unit = (adc_unit_t)unit_idx;
         channel = (adc_channel_t)ch_idx;
         break;
@@ -368,51 +563,114 @@ adc_module_init_dev_continuous(const struct adc_base_dev_config_t *adc_base_cfg,
   }
 
   ESP_RETURN_ON_FALSE(channel != -1, ESP_ERR_NOT_FOUND, TAG, "no suitable adc channel found");
-  ESP_RETURN_ON_ERROR(init_unit(unit, ADC_MODULE_MODE_CONTINUOUS), TAG, "unit init failed");
-
-  adc_digi_pattern_config_t pattern = {
-      .atten = ESP_ADC_ATTEN,
-      .channel = channel,
-      .unit = unit,
-      .bit_width = adc_base_cfg->data_bit_width,
-  };
-
-  adc_continuous_config_t cont_cfg = {
-      .sample_freq_hz = adc_dev_cfg->sample_freq_hz,
-      .conv_mode = ADC_CONV_SINGLE_UNIT_1,
-      .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
-      .pattern_num = 1,
-      .adc_pattern = &pattern,
-  };
-
-  ESP_RETURN_ON_ERROR(adc_continuous_config(adc_units[unit].handle.cont, &cont_cfg), TAG, "config cont unit failed");
+  esp_adc_unit_t *adc_unit = &adc_units[unit];
+  ESP_RETURN_ON_FALSE(!adc_unit->is_configured || adc_unit->mode == ADC_MODULE_MODE_CONTINUOUS, ESP_ERR_INVALID_STATE, TAG,
+                      "adc unit is already in oneshot mode");
+  ESP_RETURN_ON_FALSE(adc_unit->cont.device_count < SOC_ADC_PATT_LEN_MAX, ESP_ERR_NO_MEM, TAG, "adc pattern is full");
+  ESP_RETURN_ON_ERROR(check_cont_rate(adc_unit, dev_conv_rate(adc_dev_cfg)), TAG, "unsupported sample rate");
+
+  // The filter for the device's own oversampling has to fit, a faster device on the unit is checked on enable
+  uint8_t input_bits = adc_base_cfg->data_bit_width ? adc_base_cfg->data_bit_width : SOC_ADC_DIGI_MAX_BITWIDTH;
+  uint8_t frac_bits = oversampling_frac_bits(adc_dev_cfg->oversampling, input_bits);
+  if (adc_dev_cfg->oversampling > 1U) {
+    adc_decimator trial;
+    struct adc_decimator_config_t decimator_cfg = {
+        .factor = adc_dev_cfg->oversampling,
+        .order = ADC_OVERSAMPLING_CIC_ORDER,
+        .frac_bits = frac_bits,
+        .input_bits = input_bits,
+    };
+    ESP_RETURN_ON_ERROR(adc_decimator_init(&trial, &decimator_cfg), TAG, "unsupported oversampling");
+  }
+  bool is_new_unit = !adc_unit->is_configured;
+  if (is_new_unit) {
+    ESP_RETURN_ON_ERROR(init_unit(unit, ADC_MODULE_MODE_CONTINUOUS), TAG, "unit init failed");
+  }
 
   struct adc_dev *adc_device = calloc(1, sizeof(struct adc_dev));
   ESP_GOTO_ON_FALSE(adc_device, ESP_ERR_NO_MEM, err, TAG, "calloc failed");
-
-  adc_device->adc_unit = &adc_units[unit];
-  adc_device->adc_channel = &adc_units[unit].channels[channel];
+  adc_device->demux.staging = heap_caps_malloc(ADC_CONT_FRAME_SAMPLES * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+  ESP_GOTO_ON_FALSE(adc_device->demux.staging, ESP_ERR_NO_MEM, err, TAG, "failed to allocate demux buffer");
+  adc_device->demux.ring =
+      xStreamBufferCreate(ADC_STREAM_RING_FRAMES * ADC_CONT_FRAME_SAMPLES * sizeof(uint16_t), sizeof(uint16_t));
+  ESP_GOTO_ON_FALSE(adc_device->demux.ring, ESP_ERR_NO_MEM, err, TAG, "failed to create sample ring");
+  adc_device->demux.frac_bits = frac_bits;
+
+  adc_device->adc_unit = adc_unit;
+  adc_device->adc_channel = &adc_unit->channels[channel];
   adc_device->adc_channel->id = channel;
-  adc_device->adc_unit->mode = ADC_MODULE_MODE_CONTINUOUS;
 
   adc_device->cfg_base.data_bit_width = adc_base_cfg->data_bit_width;
   adc_device->cfg_base.data_pin = adc_base_cfg->data_pin;
   adc_device->cfg_base.perform_calibration = adc_base_cfg->perform_calibration;
-  adc_device->cfg.cont.sample_freq_hz = adc_dev_cfg->sample_freq_hz;
+  adc_device->cfg.cont = *adc_dev_cfg;
+
+  // Joins the pattern the next time a device of the unit gets enabled
+  xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+  adc_unit->cont.devices[channel] = adc_device;
+  adc_unit->cont.device_count++;
+  adc_unit->cont.channel_rate_hz = fastest_cont_rate(adc_unit);
+  adc_unit->cont.is_pattern_dirty = true;
+  xSemaphoreGive(adc_unit->cont.lock);
 
   *ret_device = adc_device;
   return ESP_OK;
 
 err:
-  if (adc_units[unit].is_configured) {
+  if (is_new_unit && adc_unit->is_configured) {
     del_unit(unit, ADC_MODULE_MODE_CONTINUOUS);
   }
   if (adc_device) {
+    if (adc_device->demux.ring) {
+      vStreamBufferDelete(adc_device->demux.ring);
+    }
+    free(adc_device->demux.staging);
     free(adc_device);
   }
   return ret;
 }
 
+esp_err_t
+adc_module_benchmark_oversampling(uint16_t oversampling, uint32_t samples, uint32_t *out_cycles_per_sample) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(oversampling > 1U && samples && out_cycles_per_sample, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  adc_decimator decimator;
+  struct adc_decimator_config_t decimator_cfg = {
+      .factor = oversampling,
+      .order = ADC_OVERSAMPLING_CIC_ORDER,
+      .frac_bits = oversampling_frac_bits(oversampling, SOC_ADC_DIGI_MAX_BITWIDTH),
+      .input_bits = SOC_ADC_DIGI_MAX_BITWIDTH,
+      .use_halfband = oversampling >= 4U && !(oversampling & 1U),
+  };
+  ESP_RETURN_ON_ERROR(adc_decimator_init(&decimator, &decimator_cfg), TAG, "unsupported oversampling");
+
+  // One conversion frame at a time, as the demux task hands them over
+  uint16_t *codes = heap_caps_malloc(ADC_CONT_FRAME_SAMPLES * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+  uint16_t *frame = heap_caps_malloc(ADC_CONT_FRAME_SAMPLES * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+  ESP_GOTO_ON_FALSE(codes && frame, ESP_ERR_NO_MEM, err, TAG, "failed to allocate the benchmark input");
+  uint32_t seed = 1U;
+  for (uint32_t i = 0; i < ADC_CONT_FRAME_SAMPLES; ++i) {
+    seed = seed * 1664525U + 1013904223U;
+    codes[i] = (uint16_t)(seed >> 20U);
+  }
+
+  uint32_t produced = 0;
+  uint32_t cycles = 0;
+  while (produced < samples) {
+    memcpy(frame, codes, ADC_CONT_FRAME_SAMPLES * sizeof(uint16_t));
+    uint32_t start = esp_cpu_get_cycle_count();
+    produced += adc_decimator_process(&decimator, frame, ADC_CONT_FRAME_SAMPLES, frame);
+    cycles += esp_cpu_get_cycle_count() - start;
+  }
+  *out_cycles_per_sample = cycles / produced;
+
+err:
+  free(frame);
+  free(codes);
+  return ret;
+}
+
 static bool
 is_cont_adc_configured() {
   for (uint8_t i = 0; i < SOC_ADC_PERIPH_NUM; ++i) {
@@ -422,6 +680,121 @@ is_cont_adc_configured() {
   }
   return false;
 }
+/**
+ * Every channel of the pattern converts at the fastest device conversion rate, the others decimate it down by a whole
+ * factor
+ */
+static esp_err_t
+check_cont_rate(const esp_adc_unit_t *adc_unit, uint32_t conv_rate_hz) {
+  uint32_t channel_rate_hz = fastest_cont_rate(adc_unit);
+  channel_rate_hz = conv_rate_hz > channel_rate_hz ? conv_rate_hz : channel_rate_hz;
+  ESP_RETURN_ON_FALSE(channel_rate_hz % conv_rate_hz == 0, ESP_ERR_INVALID_ARG, TAG,
+                      "%" PRIu32 " Hz does not divide %" PRIu32 " Hz", conv_rate_hz, channel_rate_hz);
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    const struct adc_dev *adc_device = adc_unit->cont.devices[ch];
+    if (!adc_device)
+      continue;
+    uint32_t dev_rate_hz = dev_conv_rate(&adc_device->cfg.cont);
+    ESP_RETURN_ON_FALSE(channel_rate_hz % dev_rate_hz == 0, ESP_ERR_INVALID_ARG, TAG,
+                        "%" PRIu32 " Hz of channel %u does not divide %" PRIu32 " Hz", dev_rate_hz, ch, channel_rate_hz);
+  }
+
+  uint32_t unit_rate_hz = channel_rate_hz * (adc_unit->cont.device_count + 1U);
+  ESP_RETURN_ON_FALSE(unit_rate_hz >= SOC_ADC_SAMPLE_FREQ_THRES_LOW && unit_rate_hz <= SOC_ADC_SAMPLE_FREQ_THRES_HIGH,
+                      ESP_ERR_INVALID_ARG, TAG, "%" PRIu32 " conversions per second out of the adc range", unit_rate_hz);
+  return ESP_OK;
+}
+static uint32_t
+fastest_cont_rate(const esp_adc_unit_t *adc_unit) {
+  uint32_t channel_rate_hz = 0;
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    const struct adc_dev *adc_device = adc_unit->cont.devices[ch];
+    if (adc_device && dev_conv_rate(&adc_device->cfg.cont) > channel_rate_hz) {
+      channel_rate_hz = dev_conv_rate(&adc_device->cfg.cont);
+    }
+  }
+  return channel_rate_hz;
+}
+static uint32_t
+dev_conv_rate(const struct adc_dev_cont_config_t *cont_cfg) {
+  return cont_cfg->sample_freq_hz * (cont_cfg->oversampling ? cont_cfg->oversampling : 1U);
+}
+/**
+ * Averaging n conversions of white noise gains log2(n) / 2 bits, one more keeps the rounding below them
+ */
+static uint8_t
+oversampling_frac_bits(uint16_t oversampling, uint8_t input_bits) {
+  if (oversampling <= 1U)
+    return 0;
+
+  uint8_t log2_os = 0;
+  while ((1UL << (log2_os + 1U)) <= oversampling) {
+    log2_os++;
+  }
+  uint8_t frac_bits = (uint8_t)((log2_os + 1U) / 2U + 1U);
+  frac_bits = frac_bits > ADC_DECIMATOR_MAX_FRAC_BITS ? ADC_DECIMATOR_MAX_FRAC_BITS : frac_bits;
+  return input_bits + frac_bits > 16U ? (uint8_t)(16U - input_bits) : frac_bits;
+}
+/**
+ * One pattern entry per registered device, called with the unit stopped and its lock held
+ */
+static esp_err_t
+configure_pattern(esp_adc_unit_t *adc_unit) {
+  adc_digi_pattern_config_t patterns[SOC_ADC_PATT_LEN_MAX];
+  uint8_t pattern_num = 0;
+
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    struct adc_dev *adc_device = adc_unit->cont.devices[ch];
+    if (!adc_device)
+      continue;
+    patterns[pattern_num++] = (adc_digi_pattern_config_t){
+        .atten = ESP_ADC_ATTEN,
+        .channel = ch,
+        .unit = adc_unit->id,
+        .bit_width = adc_device->cfg_base.data_bit_width,
+    };
+  }
+  ESP_RETURN_ON_FALSE(pattern_num, ESP_ERR_INVALID_STATE, TAG, "no device to convert");
+
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    struct adc_dev *adc_device = adc_unit->cont.devices[ch];
+    if (!adc_device)
+      continue;
+    // Oversampled devices get the CIC and half-band chain, the others a plain average down to their rate
+    uint32_t factor = adc_unit->cont.channel_rate_hz / adc_device->cfg.cont.sample_freq_hz;
+    bool is_oversampled = adc_device->cfg.cont.oversampling > 1U;
+    struct adc_decimator_config_t decimator_cfg = {
+        .factor = (uint16_t)factor,
+        .order = is_oversampled ? ADC_OVERSAMPLING_CIC_ORDER : 1U,
+        .frac_bits = adc_device->demux.frac_bits,
+        .input_bits = adc_device->cfg_base.data_bit_width ? adc_device->cfg_base.data_bit_width : SOC_ADC_DIGI_MAX_BITWIDTH,
+        .use_halfband = is_oversampled && factor >= 4U && !(factor & 1U),
+    };
+    ESP_RETURN_ON_FALSE(factor <= UINT16_MAX, ESP_ERR_INVALID_ARG, TAG, "channel %u decimates by %" PRIu32, ch, factor);
+    ESP_RETURN_ON_ERROR(adc_decimator_init(&adc_device->demux.decimator, &decimator_cfg), TAG,
+                        "no decimation filter for channel %u", ch);
+
+    // Consumers wake once per frame with the device's share of it, as often as they would without oversampling
+    uint32_t oversampling = is_oversampled ? adc_device->cfg.cont.oversampling : 1U;
+    uint32_t share = ADC_CONT_FRAME_SAMPLES / pattern_num * oversampling / factor;
+    share = share > ADC_CONT_FRAME_SAMPLES ? ADC_CONT_FRAME_SAMPLES : share;
+    xStreamBufferSetTriggerLevel(adc_device->demux.ring, (share ? share : 1U) * sizeof(uint16_t));
+  }
+
+  adc_continuous_config_t cont_cfg = {
+      .pattern_num = pattern_num,
+      .adc_pattern = patterns,
+      .sample_freq_hz = adc_unit->cont.channel_rate_hz * pattern_num,
+      .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+      .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+  };
+  ESP_RETURN_ON_ERROR(adc_continuous_config(adc_unit->handle.cont, &cont_cfg), TAG, "config cont unit failed");
+
+  adc_unit->cont.is_pattern_dirty = false;
+  ESP_LOGD(TAG, "configured a %u channel pattern on adc unit %u, %" PRIu32 " Hz per channel", pattern_num, (uint8_t)adc_unit->id,
+           adc_unit->cont.channel_rate_hz);
+  return ESP_OK;
+}
 
 static esp_err_t
 init_unit(adc_unit_t unit_id, enum adc_module_mode mode) {
@@ -475,9 +848,31 @@ init_unit_cont(adc_unit_t unit_id) {
   };
   ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&cont_handle_cfg, &adc_units[id].handle.cont), TAG,
                       "create continuous adc handle failed");
+
+  esp_err_t ret = ESP_OK;
+  esp_adc_unit_t *adc_unit = &adc_units[id];
+  adc_unit->cont.raw_frame = heap_caps_malloc(ADC_CONT_CONV_FRAME_SIZE, MALLOC_CAP_INTERNAL);
+  ESP_GOTO_ON_FALSE(adc_unit->cont.raw_frame, ESP_ERR_NO_MEM, err, TAG, "failed to allocate frame buffer");
+  adc_unit->cont.lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(adc_unit->cont.lock, ESP_ERR_NO_MEM, err, TAG, "failed to create unit lock");
+  adc_unit->cont.frames_ready = xSemaphoreCreateCounting(ADC_STREAM_MAX_PENDING_FRAMES, 0);
+  ESP_GOTO_ON_FALSE(adc_unit->cont.frames_ready, ESP_ERR_NO_MEM, err, TAG, "failed to create frame semaphore");
+
+  adc_continuous_evt_cbs_t cbs = {
+      .on_conv_done = on_conv_done,
+      .on_pool_ovf = on_pool_ovf,
+  };
+  ESP_GOTO_ON_ERROR(adc_continuous_register_event_callbacks(adc_unit->handle.cont, &cbs, adc_unit), err, TAG,
+                    "failed to register adc callbacks");
+  ESP_GOTO_ON_FALSE(xTaskCreatePinnedToCore(task_demux, "adc demux tsk", ADC_DEMUX_TASK_STACK, adc_unit, ADC_DEMUX_TASK_PRIO,
+                                            &adc_unit->cont.demux_task, ADC_DEMUX_TASK_CORE) == pdTRUE,
+                    ESP_ERR_NO_MEM, err, TAG, "failed to create demux task");
   ESP_LOGD(TAG, "initialized continuous adc unit %u", id);
 
   return ESP_OK;
+err:
+  del_unit_cont(unit_id);
+  return ret;
 }
 
 static esp_err_t
@@ -511,7 +906,29 @@ del_unit_oneshot(adc_unit_t unit_id) {
 }
 static esp_err_t
 del_unit_cont(adc_unit_t unit_id) {
-  return adc_continuous_deinit(adc_units[unit_id].handle.cont);
+  esp_adc_unit_t *adc_unit = &adc_units[unit_id];
+  if (adc_unit->cont.is_running) {
+    ESP_RETURN_ON_ERROR(adc_continuous_stop(adc_unit->handle.cont), TAG, "failed to stop adc unit");
+    adc_unit->cont.is_running = false;
+  }
+
+  // Holding the lock keeps the demux task out of the driver while it is deleted
+  if (adc_unit->cont.demux_task) {
+    xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+    vTaskDelete(adc_unit->cont.demux_task);
+    adc_unit->cont.demux_task = NULL;
+    xSemaphoreGive(adc_unit->cont.lock);
+  }
+  if (adc_unit->cont.frames_ready) {
+    vSemaphoreDelete(adc_unit->cont.frames_ready);
+  }
+  if (adc_unit->cont.lock) {
+    vSemaphoreDelete(adc_unit->cont.lock);
+  }
+  free(adc_unit->cont.raw_frame);
+  memset(&adc_unit->cont, 0, sizeof(adc_unit->cont));
+
+  return adc_continuous_deinit(adc_unit->handle.cont);
 }
 
 static esp_err_t
@@ -539,9 +956,30 @@ enable_dev(adc_dev_handle adc_device, enum adc_module_mode mode) {
 
   return ret;
 }
+/**
+ * Starts the unit with the first enabled device, a device set that changed in between costs a restart
+ */
 static esp_err_t
 enable_dev_cont(adc_dev_handle adc_device) {
-  return adc_continuous_start(adc_device->adc_unit->handle.cont);
+  esp_err_t ret = ESP_OK;
+  esp_adc_unit_t *adc_unit = adc_device->adc_unit;
+  xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+
+  if (adc_unit->cont.is_running && adc_unit->cont.is_pattern_dirty) {
+    ESP_GOTO_ON_ERROR(adc_continuous_stop(adc_unit->handle.cont), out, TAG, "failed to stop adc unit");
+    adc_unit->cont.is_running = false;
+  }
+  if (!adc_unit->cont.is_running) {
+    ESP_GOTO_ON_ERROR(configure_pattern(adc_unit), out, TAG, "failed to configure the adc pattern");
+    ESP_GOTO_ON_ERROR(adc_continuous_start(adc_unit->handle.cont), out, TAG, "failed to start adc unit");
+    adc_unit->cont.is_running = true;
+  }
+  adc_decimator_reset(&adc_device->demux.decimator);
+  xStreamBufferReset(adc_device->demux.ring);
+
+out:
+  xSemaphoreGive(adc_unit->cont.lock);
+  return ret;
 }
 static esp_err_t
 enable_dev_oneshot(adc_dev_handle adc_device) {
@@ -580,7 +1018,167 @@ static esp_err_t
 disable_dev_oneshot(adc_dev_handle adc_device) {
   return gpio_reset_pin((gpio_num_t)adc_device->cfg_base.data_pin);
 }
+/**
+ * Stops the unit with the last enabled device, the others keep converting
+ */
 static esp_err_t
 disable_dev_cont(adc_dev_handle adc_device) {
-  return adc_continuous_stop(adc_device->adc_unit->handle.cont);
+  esp_err_t ret = ESP_OK;
+  esp_adc_unit_t *adc_unit = adc_device->adc_unit;
+  xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+
+  // Cleared under the lock, the demux task is done with the device and its table once this returns
+  adc_device->adc_channel->is_enabled = false;
+  bool any_enabled = false;
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    any_enabled |= adc_unit->cont.devices[ch] && adc_unit->channels[ch].is_enabled;
+  }
+  if (!any_enabled && adc_unit->cont.is_running) {
+    ESP_GOTO_ON_ERROR(adc_continuous_stop(adc_unit->handle.cont), out, TAG, "failed to stop adc unit");
+    adc_unit->cont.is_running = false;
+  }
+
+out:
+  xSemaphoreGive(adc_unit->cont.lock);
+  return ret;
+}
+
+static inline esp_err_t
+raw_to_mv(adc_dev_handle adc_device, int raw, int *out_mv) {
+  if (adc_device->mv_lut.table && (uint32_t)raw < adc_device->mv_lut.len) {
+    *out_mv = adc_device->mv_lut.table[raw];
+    return ESP_OK;
+  }
+  return convert_raw(adc_device, raw, out_mv);
+}
+static esp_err_t
+convert_raw(void *user_ctx, int raw, int *out_mv) {
+  adc_dev_handle adc_device = (adc_dev_handle)user_ctx;
+  if (adc_device->adc_cali.is_calibrated)
+    return adc_cali_raw_to_voltage(adc_device->adc_cali.handle, raw, out_mv);
+
+  *out_mv = raw * ((float)ADC_MAX_MV / ((1U << adc_device->cfg_base.data_bit_width) - 1U));
+  return ESP_OK;
+}
+/**
+ * Runs every raw code through the calibration scheme (or the linear fallback) once, so the sample loops only index a
+ * table. Bit widths above ADC_MV_LUT_MAX_BITWIDTH keep converting per sample.
+ */
+static esp_err_t
+build_mv_lut(adc_dev_handle adc_device) {
+  uint8_t bit_width = adc_device->cfg_base.data_bit_width;
+  if (bit_width == 0 || bit_width > ADC_MV_LUT_MAX_BITWIDTH) {
+    ESP_LOGW(TAG, "no conversion table for a %u bit channel, converting per sample", bit_width);
+    return ESP_OK;
+  }
+
+  uint16_t *mv_lut = heap_caps_malloc(ADC_MV_LUT_LEN(bit_width) * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+  ESP_RETURN_ON_FALSE(mv_lut, ESP_ERR_NO_MEM, TAG, "failed to allocate conversion table");
+
+  esp_err_t ret = adc_mv_lut_build(&adc_device->mv_lut, mv_lut, bit_width, convert_raw, adc_device);
+  if (ret != ESP_OK) {
+    free(mv_lut);
+    return ret;
+  }
+  ESP_LOGD(TAG, "built a %" PRIu32 " entry conversion table, unit_id:%u channel_id:%u", adc_device->mv_lut.len,
+           (uint8_t)adc_device->adc_unit->id, (uint8_t)adc_device->adc_channel->id);
+  return ESP_OK;
+}
+/**
+ * Oversampled codes with frac_bits fraction bits to millivolts with as many, through the table when there is one
+ */
+static void
+codes_to_mv(adc_dev_handle adc_device, uint16_t *samples, uint32_t count) {
+  uint8_t frac_bits = adc_device->demux.frac_bits;
+  if (adc_device->mv_lut.table) {
+    adc_mv_lut_codes_to_mv(&adc_device->mv_lut, samples, count, frac_bits);
+    return;
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    int voltage = 0;
+    raw_to_mv(adc_device, (int)(samples[i] >> frac_bits), &voltage);
+    int32_t mv = voltage << frac_bits;
+    samples[i] = (uint16_t)(mv < 0 ? 0 : (mv > UINT16_MAX ? UINT16_MAX : mv));
+  }
+}
+/**
+ * Splits a frame by channel in one pass into the staging buffers, then decimates and converts each device's codes and
+ * hands every device its share. A share that does not fit the ring is dropped whole.
+ */
+static void
+demux_frame(esp_adc_unit_t *adc_unit, const uint8_t *raw_frame, uint32_t raw_bytes) {
+  const adc_digi_output_data_t *results = (const adc_digi_output_data_t *)raw_frame;
+  uint32_t raw_samples = raw_bytes / SOC_ADC_DIGI_RESULT_BYTES;
+  uint32_t unit_id = adc_unit->id;
+
+  for (uint32_t i = 0; i < raw_samples; ++i) {
+    adc_digi_output_data_t res = results[i];
+    uint32_t channel_id = res.type2.channel;
+    if (res.type2.unit != unit_id || channel_id >= SOC_ADC_MAX_CHANNEL_NUM)
+      continue;
+    struct adc_dev *adc_device = adc_unit->cont.devices[channel_id];
+    if (!adc_device || !adc_unit->channels[channel_id].is_enabled)
+      continue;
+    adc_device->demux.staging[adc_device->demux.staged++] = (uint16_t)res.type2.data;
+  }
+
+  for (uint8_t ch = 0; ch < SOC_ADC_MAX_CHANNEL_NUM; ++ch) {
+    struct adc_dev *adc_device = adc_unit->cont.devices[ch];
+    if (!adc_device || !adc_device->demux.staged)
+      continue;
+
+    // In place, the outputs never overtake the codes they come from
+    adc_device->demux.staged = adc_decimator_process(&adc_device->demux.decimator, adc_device->demux.staging,
+                                                     adc_device->demux.staged, adc_device->demux.staging);
+    if (!adc_device->demux.staged)
+      continue;
+    codes_to_mv(adc_device, adc_device->demux.staging, adc_device->demux.staged);
+
+    size_t share_bytes = adc_device->demux.staged * sizeof(uint16_t);
+    if (xStreamBufferSpacesAvailable(adc_device->demux.ring) >= share_bytes) {
+      xStreamBufferSend(adc_device->demux.ring, adc_device->demux.staging, share_bytes, 0);
+    } else {
+      adc_device->demux.shares_dropped++;
+    }
+    adc_device->demux.staged = 0;
+  }
+}
+/**
+ * The only reader of the driver pool, one frame per conversion done interrupt
+ */
+static void
+task_demux(void *arg) {
+  esp_adc_unit_t *adc_unit = (esp_adc_unit_t *)arg;
+
+  for (;;) {
+    xSemaphoreTake(adc_unit->cont.frames_ready, portMAX_DELAY);
+    xSemaphoreTake(adc_unit->cont.lock, portMAX_DELAY);
+
+    // The frame may already be gone if the pool overflowed and got flushed
+    uint32_t raw_bytes_read = 0;
+    if (adc_unit->cont.is_running &&
+        adc_continuous_read(adc_unit->handle.cont, adc_unit->cont.raw_frame, ADC_CONT_CONV_FRAME_SIZE, &raw_bytes_read, 0) ==
+            ESP_OK &&
+        raw_bytes_read) {
+      demux_frame(adc_unit, adc_unit->cont.raw_frame, raw_bytes_read);
+    }
+    xSemaphoreGive(adc_unit->cont.lock);
+  }
+}
+
+static bool IRAM_ATTR
+on_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+  esp_adc_unit_t *adc_unit = (esp_adc_unit_t *)user_data;
+  BaseType_t task_woken = pdFALSE;
+
+  xSemaphoreGiveFromISR(adc_unit->cont.frames_ready, &task_woken);
+  return task_woken == pdTRUE;
+}
+static bool IRAM_ATTR
+on_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data) {
+  esp_adc_unit_t *adc_unit = (esp_adc_unit_t *)user_data;
+
+  adc_unit->cont.frames_dropped++;
+  return false;
 }
@@ -0,0 +1,45 @@
+#include <inttypes.h>
+#include <stdint.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "private/adc_mv_lut.h"
+
+static const char *TAG = "adc_mv_lut";
+
+esp_err_t
+adc_mv_lut_build(adc_mv_lut *lut, uint16_t *table, uint8_t bit_width, adc_mv_lut_convert_fn convert, void *user_ctx) {
+  ESP_RETURN_ON_FALSE(lut && table && convert && bit_width > 0U && bit_width <= 16U, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid argument");
+  lut->table = NULL;
+  lut->len = 0;
+
+  uint32_t len = ADC_MV_LUT_LEN(bit_width);
+  for (uint32_t raw = 0; raw < len; ++raw) {
+    int voltage = 0;
+    ESP_RETURN_ON_ERROR(convert(user_ctx, (int)raw, &voltage), TAG, "conversion of code %" PRIu32 " failed", raw);
+    table[raw] = (uint16_t)(voltage < 0 ? 0 : (voltage > UINT16_MAX ? UINT16_MAX : voltage));
+  }
+
+  lut->table = table;
+  lut->len = len;
+  return ESP_OK;
+}
+
+void
+adc_mv_lut_codes_to_mv(const adc_mv_lut *lut, uint16_t *samples, uint32_t count, uint8_t frac_bits) {
+  uint32_t frac_mask = (1UL << frac_bits) - 1U;
+  const uint16_t *table = lut->table;
+  uint32_t last = lut->len - 1U;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t code = samples[i] >> frac_bits;
+    code = code > last ? last : code;
+    int32_t mv = (int32_t)table[code] << frac_bits;
+    if (code < last) {
+      mv += ((int32_t)table[code + 1U] - (int32_t)table[code]) * (int32_t)(samples[i] & frac_mask);
+    }
+    samples[i] = (uint16_t)(mv < 0 ? 0 : (mv > UINT16_MAX ? UINT16_MAX : mv));
+  }
+}
@@ -0,0 +1,210 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "adc_module_defs.h"
+#include "adc_trace.h"
+
+static const uint8_t trace_magic[4] = {'A', 'D', 'C', 'T'};
+
+struct adc_trace_replay {
+  FILE *file;
+  uint32_t sample_rate_hz;
+  uint8_t frac_bits;
+
+  // Current record
+  uint16_t *samples;
+  uint32_t samples_len; // allocated
+  uint32_t count;
+  uint32_t pos;
+  uint32_t frames_dropped; // reported with the first block out of the record
+  uint64_t timestamp_us;
+};
+
+static const char *TAG = "adc_trace";
+
+static esp_err_t
+read_record(adc_trace_replay_handle replay);
+static void
+put_le(uint8_t *out, uint64_t value, uint8_t bytes);
+static uint64_t
+get_le(const uint8_t *in, uint8_t bytes);
+
+esp_err_t
+adc_trace_encode(const adc_module_block_t *block, uint32_t sample_rate_hz, uint64_t timestamp_us, uint8_t *buffer,
+                 uint32_t buffer_len, uint32_t *out_len) {
+  ESP_RETURN_ON_FALSE(block && buffer && out_len && sample_rate_hz, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(block->count <= UINT16_MAX, ESP_ERR_INVALID_SIZE, TAG, "%" PRIu32 " samples do not fit a record",
+                      block->count);
+  uint32_t len = ADC_TRACE_RECORD_SIZE(block->count);
+  if (len > buffer_len)
+    return ESP_ERR_NO_MEM;
+
+  memcpy(buffer, trace_magic, sizeof(trace_magic));
+  buffer[4] = ADC_TRACE_VERSION;
+  buffer[5] = block->frac_bits;
+  put_le(&buffer[6], block->count, 2U);
+  put_le(&buffer[8], sample_rate_hz, 4U);
+  put_le(&buffer[12], block->frames_dropped, 4U);
+  put_le(&buffer[16], timestamp_us, 8U);
+  for (uint32_t i = 0; i < block->count; ++i) {
+    put_le(&buffer[ADC_TRACE_HEADER_SIZE + 2U * i], block->samples[i], 2U);
+  }
+
+  *out_len = len;
+  return ESP_OK;
+}
+
+esp_err_t
+adc_trace_replay_open(const struct adc_trace_replay_config_t *replay_cfg, adc_trace_replay_handle *out_replay) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(replay_cfg && replay_cfg->path && out_replay, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  struct adc_trace_replay *replay = calloc(1, sizeof(struct adc_trace_replay));
+  ESP_RETURN_ON_FALSE(replay, ESP_ERR_NO_MEM, TAG, "calloc failed");
+  replay->file = fopen(replay_cfg->path, "rb");
+  ESP_GOTO_ON_FALSE(replay->file, ESP_ERR_NOT_FOUND, err, TAG, "failed to open %s", replay_cfg->path);
+
+  // The first record sets the format of the whole trace
+  ESP_GOTO_ON_ERROR(read_record(replay), err, TAG, "%s holds no trace records", replay_cfg->path);
+
+  *out_replay = replay;
+  return ESP_OK;
+err:
+  adc_trace_replay_close(replay);
+  return ret;
+}
+esp_err_t
+adc_trace_replay_close(adc_trace_replay_handle replay) {
+  ESP_RETURN_ON_FALSE(replay, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  if (replay->file) {
+    fclose(replay->file);
+  }
+  free(replay->samples);
+  free(replay);
+  return ESP_OK;
+}
+
+esp_err_t
+adc_trace_replay_get_format(adc_trace_replay_handle replay, uint32_t *out_sample_rate_hz, uint8_t *out_frac_bits) {
+  ESP_RETURN_ON_FALSE(replay && out_sample_rate_hz && out_frac_bits, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  *out_sample_rate_hz = replay->sample_rate_hz;
+  *out_frac_bits = replay->frac_bits;
+  return ESP_OK;
+}
+
+esp_err_t
+adc_trace_replay_get_data(adc_trace_replay_handle replay, uint32_t samples_to_read, uint32_t *out_data,
+                          uint32_t *samples_read) {
+  ESP_RETURN_ON_FALSE(replay && out_data && samples_read, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(samples_to_read > 0, ESP_ERR_INVALID_ARG, TAG, "zero samples requested");
+
+  uint8_t frac_bits = replay->frac_bits;
+  uint32_t rounding = frac_bits ? 1UL << (frac_bits - 1U) : 0U;
+  uint32_t read_count = 0;
+  while (read_count < samples_to_read) {
+    if (replay->pos == replay->count && read_record(replay) != ESP_OK)
+      break;
+    out_data[read_count++] = (replay->samples[replay->pos++] + rounding) >> frac_bits;
+  }
+  if (read_count == 0)
+    return ESP_ERR_NOT_FOUND;
+
+  *samples_read = read_count;
+  return ESP_OK;
+}
+
+esp_err_t
+adc_trace_replay_next_block(adc_trace_replay_handle replay, adc_module_block_t *block, uint64_t *out_timestamp_us) {
+  ESP_RETURN_ON_FALSE(replay && block && block->samples && block->capacity && out_timestamp_us, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid argument");
+  if (replay->pos == replay->count && read_record(replay) != ESP_OK)
+    return ESP_ERR_NOT_FOUND;
+
+  uint32_t len = replay->count - replay->pos;
+  len = len < block->capacity ? len : block->capacity;
+  memcpy(block->samples, &replay->samples[replay->pos], len * sizeof(uint16_t));
+  block->count = len;
+  block->frac_bits = replay->frac_bits;
+  block->frames_dropped = replay->frames_dropped;
+  replay->frames_dropped = 0;
+  replay->pos += len;
+
+  // The record was borrowed after its last sample, a part of it that much earlier
+  uint64_t ahead_us = (uint64_t)(replay->count - replay->pos) * 1000000ULL / replay->sample_rate_hz;
+  *out_timestamp_us = replay->timestamp_us > ahead_us ? replay->timestamp_us - ahead_us : 0U;
+  return ESP_OK;
+}
+
+/**
+ * Next record into the replay, skipping empty ones. A record cut short at the end of the file ends the trace.
+ */
+static esp_err_t
+read_record(adc_trace_replay_handle replay) {
+  uint8_t header[ADC_TRACE_HEADER_SIZE];
+  uint32_t count = 0;
+  do {
+    if (fread(header, 1, sizeof(header), replay->file) != sizeof(header))
+      return ESP_ERR_NOT_FOUND;
+    ESP_RETURN_ON_FALSE(!memcmp(header, trace_magic, sizeof(trace_magic)), ESP_ERR_INVALID_RESPONSE, TAG,
+                        "no trace record at offset %ld", ftell(replay->file) - (long)sizeof(header));
+    ESP_RETURN_ON_FALSE(header[4] == ADC_TRACE_VERSION, ESP_ERR_NOT_SUPPORTED, TAG, "trace version %u", header[4]);
+
+    uint32_t sample_rate_hz = (uint32_t)get_le(&header[8], 4U);
+    uint8_t frac_bits = header[5];
+    ESP_RETURN_ON_FALSE(sample_rate_hz, ESP_ERR_INVALID_RESPONSE, TAG, "trace record without a rate");
+    if (!replay->sample_rate_hz) {
+      replay->sample_rate_hz = sample_rate_hz;
+      replay->frac_bits = frac_bits;
+    }
+    ESP_RETURN_ON_FALSE(sample_rate_hz == replay->sample_rate_hz && frac_bits == replay->frac_bits, ESP_ERR_INVALID_STATE,
+                        TAG, "trace changes format from %" PRIu32 " Hz, %u bits to %" PRIu32 " Hz, %u bits",
+                        replay->sample_rate_hz, replay->frac_bits, sample_rate_hz, frac_bits);
+
+    count = (uint32_t)get_le(&header[6], 2U);
+    replay->frames_dropped += (uint32_t)get_le(&header[12], 4U);
+    replay->timestamp_us = get_le(&header[16], 8U);
+  } while (!count);
+
+  if (count > replay->samples_len) {
+    uint16_t *samples = realloc(replay->samples, count * sizeof(uint16_t));
+    ESP_RETURN_ON_FALSE(samples, ESP_ERR_NO_MEM, TAG, "failed to allocate %" PRIu32 " samples", count);
+    replay->samples = samples;
+    replay->samples_len = count;
+  }
+
+  uint8_t raw[2];
+  for (uint32_t i = 0; i < count; ++i) {
+    if (fread(raw, 1, sizeof(raw), replay->file) != sizeof(raw)) {
+      ESP_LOGW(TAG, "last trace record cut short after %" PRIu32 " of %" PRIu32 " samples", i, count);
+      replay->count = replay->pos = 0;
+      return ESP_ERR_NOT_FOUND;
+    }
+    replay->samples[i] = (uint16_t)get_le(raw, 2U);
+  }
+  replay->count = count;
+  replay->pos = 0;
+  return ESP_OK;
+}
+
+static void
+put_le(uint8_t *out, uint64_t value, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; ++i) {
+    out[i] = (uint8_t)(value >> (8U * i));
+  }
+}
+static uint64_t
+get_le(const uint8_t *in, uint8_t bytes) {
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < bytes; ++i) {
+    value |= (uint64_t)in[i] << (8U * i);
+  }
+  return value;
+}
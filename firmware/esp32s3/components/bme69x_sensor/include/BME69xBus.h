@@ -0,0 +1,28 @@
+#pragma once
+#ifndef BME69XBUS_H
+#define BME69XBUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+/**
+ * Register access for BME69xSensor, one call is one bus transaction
+ */
+class BME69xBus {
+public:
+  virtual ~BME69xBus() = default;
+
+  /* len registers from reg on, the address auto increments */
+  virtual esp_err_t read(uint8_t reg, uint8_t *data, size_t len) = 0;
+
+  /* Register and value pairs, the sensor takes any number of them in one write */
+  virtual esp_err_t write(const uint8_t *pairs, size_t len) = 0;
+
+  virtual void delayUs(uint32_t us) = 0;
+
+  virtual uint64_t timeUs() = 0;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef BME69XSENSOR_H
+#define BME69XSENSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BME6xxSensor.h"
+#include "BME6xxSensorDatatypes.h"
+
+#include "BME69xBus.h"
+#include "private/BME69xSensorPrivate.h"
+
+#ifndef BME6XX_USE_FPU
+#error "BME69xSensor only implements the floating point compensation"
+#endif
+
+/**
+ * BME69x on any BME69xBus. The control registers are shadowed after begin and configuration goes out as
+ * register and value pairs in one write, the three data fields come in with one burst read.
+ */
+class BME69xSensor : public BME6xxSensor {
+public:
+  explicit BME69xSensor(BME69xBus &bus);
+
+  /* Soft reset, chip id, variant and calibration. Also kept in bme6xxCheckStatus. */
+  BME6xxStatus begin();
+
+  void bme6xxSetHeaterProf(uint16_t *temp, uint16_t *mul, uint16_t sharedHeatrDur, uint8_t profileLen) override;
+  void bme6xxSetHeaterProf(uint16_t temp, uint16_t dur) override;
+  /* Sequential mode, a duration in ms per step */
+  void bme6xxSetHeaterProfSeq(uint16_t *temp, uint16_t *dur, uint8_t profileLen);
+
+  uint32_t bme6xxGetMeasDur(BME6xxMode opMode = BME6xxMode::SLEEP) override;
+
+  void bme6xxSetOS(BME6xxOversampling osTemp = BME6xxOversampling::X2, BME6xxOversampling osPres = BME6xxOversampling::X16,
+                   BME6xxOversampling osHum = BME6xxOversampling::X1) override;
+  void bme6xxSetOS(BME6xxOS &os) override;
+  void bme6xxSetFilter(BME6xxFilter filter);
+  /* Standby between the profiles of sequential mode */
+  void bme6xxSetSeqSleep(BME6xxODR odr);
+
+  uint32_t bme6xxGetUniqueId() override;
+
+  void bme6xxSetOpMode(BME6xxMode opMode = BME6xxMode::SLEEP) override;
+
+  BME6xxStatus bme6xxCheckStatus() override;
+
+  /* Fields with new data, 0 or 1 in forced mode, up to 3 in parallel and sequential mode ordered oldest first */
+  uint8_t bme6xxFetchData() override;
+
+  size_t bme6xxGetAllData(BME6xxData *dataOut, size_t maxLen) override;
+  /* One fetched field per call, returns how many are left after it */
+  size_t bme6xxGetData(BME6xxData &dataOut) override;
+
+  /* Blocks for about 13 s of heater cycles, leaves ERROR_SELF_TEST in the status on a failure */
+  void bme6xxSelftestCheck() override;
+
+  void bme6xxSoftReset() override;
+
+  const char *bme6xxGetType() override;
+
+  /* Bus transactions since begin, reads and writes */
+  uint32_t transactions() const;
+
+private:
+  bool read(uint8_t reg, uint8_t *data, size_t len);
+  bool write(const uint8_t *pairs, size_t len);
+  bool writeCtrl(uint8_t mask);
+  void configure(uint8_t mask);
+  bool sleep();
+  bool readHeaterSet();
+  void setHeaterConf(BME6xxMode opMode, uint16_t *temp, uint16_t *dur, uint16_t sharedHeatrDur, uint8_t profileLen);
+  bool selftestStep(uint16_t temp, uint16_t dur, BME6xxData &data);
+  void parseField(const uint8_t *buff, BME6xxData &data);
+
+  float calcTemperature(uint32_t tempAdc);
+  float calcPressure(uint32_t presAdc) const;
+  float calcHumidity(uint16_t humAdc) const;
+  float calcGasResistanceLow(uint16_t gasResAdc, uint8_t gasRange) const;
+  static float calcGasResistanceHigh(uint16_t gasResAdc, uint8_t gasRange);
+  uint8_t calcResHeat(uint16_t temp) const;
+  static uint8_t calcGasWait(uint16_t dur);
+  static uint8_t calcHeatrDurShared(uint16_t dur);
+
+  BME69xBus &bus;
+  BME6xxStatus status = BME6xxStatus::ERROR_DEV_NOT_FOUND;
+  uint32_t busTransactions = 0;
+
+  BME69xCalib calib = {};
+  float tFine = 0.0f;
+  bool isVariantHigh = false;
+
+  uint8_t ctrl[BME69X_LEN_CTRL] = {};            // CTRL_GAS_0 to CONFIG as last written, mode bits kept at sleep
+  uint8_t heaterSet[BME69X_LEN_HEATER_SET] = {}; // idac, res_heat and gas_wait per step, read back after each profile
+  uint8_t heaterPairs[BME69X_LEN_HEATER_PAIRS] = {}; // last profile write, an identical one is skipped
+  size_t heaterPairsLen = 0;
+  BME6xxOS os;
+  BME6xxMode lastOpMode = BME6xxMode::SLEEP;
+  bool isAwake = false; // a mode other than sleep was written and not seen to end yet
+
+  BME6xxData fields[BME69X_FIELD_COUNT] = {};
+  uint8_t nFields = 0;
+  uint8_t iFields = 0;
+};
+
+#endif
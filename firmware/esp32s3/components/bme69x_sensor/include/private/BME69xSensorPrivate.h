@@ -0,0 +1,148 @@
+#pragma once
+#ifndef BME69XSENSORPRIVATE_H
+#define BME69XSENSORPRIVATE_H
+
+#include <cstdint>
+
+#define BME69X_CHIP_ID 0x61U
+
+#define BME69X_REG_COEFF3      0x00U
+#define BME69X_REG_FIELD0      0x1DU
+#define BME69X_REG_IDAC_HEAT0  0x50U
+#define BME69X_REG_RES_HEAT0   0x5AU
+#define BME69X_REG_GAS_WAIT0   0x64U
+#define BME69X_REG_SHD_HEATR   0x6EU
+#define BME69X_REG_CTRL_GAS_0  0x70U
+#define BME69X_REG_CTRL_GAS_1  0x71U
+#define BME69X_REG_CTRL_HUM    0x72U
+#define BME69X_REG_CTRL_MEAS   0x74U
+#define BME69X_REG_CONFIG      0x75U
+#define BME69X_REG_UNIQUE_ID   0x83U
+#define BME69X_REG_COEFF1      0x8AU
+#define BME69X_REG_CHIP_ID     0xD0U
+#define BME69X_REG_SOFT_RESET  0xE0U
+#define BME69X_REG_COEFF2      0xE1U
+#define BME69X_REG_VARIANT_ID  0xF0U
+#define BME69X_SOFT_RESET_CMD  0xB6U
+#define BME69X_RESET_DELAY_US  10000U
+#define BME69X_POLL_DELAY_US   10000U
+#define BME69X_FORCED_TRIES    5U
+#define BME69X_SLEEP_TRIES     10U
+
+#define BME69X_CTRL_IDX(reg) ((reg) - BME69X_REG_CTRL_GAS_0)
+#define BME69X_CTRL_BIT(reg) (1U << BME69X_CTRL_IDX(reg))
+
+#define BME69X_LEN_COEFF1       23U
+#define BME69X_LEN_COEFF2       14U
+#define BME69X_LEN_COEFF3       5U
+#define BME69X_LEN_COEFF_ALL    (BME69X_LEN_COEFF1 + BME69X_LEN_COEFF2 + BME69X_LEN_COEFF3)
+#define BME69X_LEN_FIELD        17U
+#define BME69X_FIELD_COUNT      3U
+#define BME69X_LEN_CTRL         6U  /* CTRL_GAS_0 to CONFIG */
+#define BME69X_LEN_HEATER_SET   30U /* IDAC_HEAT0 to GAS_WAIT9 */
+#define BME69X_PROFILE_MAX      10U
+#define BME69X_LEN_HEATER_PAIRS ((BME69X_PROFILE_MAX * 2U + 3U) * 2U) /* steps, durations, shared duration, gas control */
+
+/* Index into the calibration read, COEFF1 then COEFF2 then COEFF3 */
+#define BME69X_IDX_T2_LSB         0U
+#define BME69X_IDX_T2_MSB         1U
+#define BME69X_IDX_T3             2U
+#define BME69X_IDX_P1_LSB         4U
+#define BME69X_IDX_P1_MSB         5U
+#define BME69X_IDX_P2_LSB         6U
+#define BME69X_IDX_P2_MSB         7U
+#define BME69X_IDX_P3             8U
+#define BME69X_IDX_P4_LSB         10U
+#define BME69X_IDX_P4_MSB         11U
+#define BME69X_IDX_P5_LSB         12U
+#define BME69X_IDX_P5_MSB         13U
+#define BME69X_IDX_P7             14U
+#define BME69X_IDX_P6             15U
+#define BME69X_IDX_P8_LSB         18U
+#define BME69X_IDX_P8_MSB         19U
+#define BME69X_IDX_P9_LSB         20U
+#define BME69X_IDX_P9_MSB         21U
+#define BME69X_IDX_P10            22U
+#define BME69X_IDX_H2_MSB         23U
+#define BME69X_IDX_H2_LSB         24U
+#define BME69X_IDX_H1_LSB         24U
+#define BME69X_IDX_H1_MSB         25U
+#define BME69X_IDX_H3             26U
+#define BME69X_IDX_H4             27U
+#define BME69X_IDX_H5             28U
+#define BME69X_IDX_H6             29U
+#define BME69X_IDX_H7             30U
+#define BME69X_IDX_T1_LSB         31U
+#define BME69X_IDX_T1_MSB         32U
+#define BME69X_IDX_GH2_LSB        33U
+#define BME69X_IDX_GH2_MSB        34U
+#define BME69X_IDX_GH1            35U
+#define BME69X_IDX_GH3            36U
+#define BME69X_IDX_RES_HEAT_VAL   37U
+#define BME69X_IDX_RES_HEAT_RANGE 39U
+#define BME69X_IDX_RANGE_SW_ERR   41U
+
+#define BME69X_MODE_MSK      0x03U
+#define BME69X_OST_MSK       0xE0U
+#define BME69X_OST_POS       5U
+#define BME69X_OSP_MSK       0x1CU
+#define BME69X_OSP_POS       2U
+#define BME69X_OSH_MSK       0x07U
+#define BME69X_FILTER_MSK    0x1CU
+#define BME69X_FILTER_POS    2U
+#define BME69X_ODR20_MSK     0xE0U
+#define BME69X_ODR20_POS     5U
+#define BME69X_ODR3_MSK      0x80U
+#define BME69X_ODR3_POS      7U
+#define BME69X_HCTRL_MSK     0x08U
+#define BME69X_HCTRL_POS     3U
+#define BME69X_NBCONV_MSK    0x0FU
+#define BME69X_RUN_GAS_MSK   0x30U
+#define BME69X_RUN_GAS_POS   4U
+#define BME69X_RUN_GAS_LOW   1U
+#define BME69X_RUN_GAS_HIGH  2U
+#define BME69X_GAS_INDEX_MSK 0x0FU
+#define BME69X_GAS_RANGE_MSK 0x0FU
+#define BME69X_RHRANGE_MSK   0x30U
+#define BME69X_RSERROR_MSK   0xF0U
+
+#define BME69X_HEATER_MAX_TEMP 400U
+#define BME69X_AMBIENT_TEMP    25
+
+/* Forced measurements of the self test, in the order of the Bosch API */
+#define BME69X_SELFTEST_HIGH_TEMP 350U
+#define BME69X_SELFTEST_LOW_TEMP  150U
+#define BME69X_SELFTEST_DUR1_MS   1000U
+#define BME69X_SELFTEST_DUR2_MS   2000U
+#define BME69X_SELFTEST_MEAS      6U
+
+struct BME69xCalib {
+  uint16_t par_h1;
+  uint16_t par_h2;
+  int8_t par_h3;
+  int8_t par_h4;
+  int8_t par_h5;
+  uint8_t par_h6;
+  int8_t par_h7;
+  int8_t par_gh1;
+  int16_t par_gh2;
+  int8_t par_gh3;
+  uint16_t par_t1;
+  int16_t par_t2;
+  int8_t par_t3;
+  uint16_t par_p1;
+  int16_t par_p2;
+  int8_t par_p3;
+  int16_t par_p4;
+  int16_t par_p5;
+  int8_t par_p6;
+  int8_t par_p7;
+  int16_t par_p8;
+  int16_t par_p9;
+  uint8_t par_p10;
+  uint8_t res_heat_range;
+  int8_t res_heat_val;
+  int8_t range_sw_err;
+};
+
+#endif
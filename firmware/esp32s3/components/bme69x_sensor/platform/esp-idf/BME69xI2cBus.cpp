@@ -0,0 +1,88 @@
+#include "esp_check.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "BME69xI2cBus.h"
+
+#define BME69X_I2C_TIMEOUT_MS     50
+#define BME69X_ARBITER_TIMEOUT_MS 200
+
+static const char *TAG = "bme69x_i2c_bus";
+
+BME69xI2cBus::~BME69xI2cBus() {
+  close();
+}
+
+esp_err_t
+BME69xI2cBus::open(i2c_master_bus_handle_t bus, uint8_t address, uint32_t freqHz, i2c_arbiter_handle arbiter,
+                   uint8_t priority) {
+  ESP_RETURN_ON_FALSE(bus, ESP_ERR_INVALID_ARG, TAG, "invalid bus");
+  ESP_RETURN_ON_FALSE(!dev, ESP_ERR_INVALID_STATE, TAG, "already open");
+
+  this->arbiter = arbiter;
+  this->priority = priority;
+
+  i2c_device_config_t dev_cfg = {
+      .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+      .device_address = address,
+      .scl_speed_hz = freqHz,
+  };
+  return i2c_master_bus_add_device(bus, &dev_cfg, &dev);
+}
+esp_err_t
+BME69xI2cBus::close() {
+  if (!dev)
+    return ESP_OK;
+  esp_err_t ret = i2c_master_bus_rm_device(dev);
+  dev = nullptr;
+  return ret;
+}
+
+esp_err_t
+BME69xI2cBus::read(uint8_t reg, uint8_t *data, size_t len) {
+  ESP_RETURN_ON_FALSE(dev, ESP_ERR_INVALID_STATE, TAG, "not open");
+  ESP_RETURN_ON_ERROR(acquire(), TAG, "bus busy");
+  esp_err_t ret = i2c_master_transmit_receive(dev, &reg, 1, data, len, BME69X_I2C_TIMEOUT_MS);
+  // Both address bytes of the repeated start and the register
+  release(ret == ESP_OK ? len + 3U : 0U);
+  return ret;
+}
+esp_err_t
+BME69xI2cBus::write(const uint8_t *pairs, size_t len) {
+  ESP_RETURN_ON_FALSE(dev, ESP_ERR_INVALID_STATE, TAG, "not open");
+  ESP_RETURN_ON_ERROR(acquire(), TAG, "bus busy");
+  esp_err_t ret = i2c_master_transmit(dev, pairs, len, BME69X_I2C_TIMEOUT_MS);
+  release(ret == ESP_OK ? len + 1U : 0U);
+  return ret;
+}
+
+/**
+ * Heater and conversion waits are milliseconds long, those go to the scheduler
+ */
+void
+BME69xI2cBus::delayUs(uint32_t us) {
+  if (us >= 1000U * portTICK_PERIOD_MS) {
+    vTaskDelay(pdMS_TO_TICKS((us + 999U) / 1000U));
+  } else {
+    esp_rom_delay_us(us);
+  }
+}
+uint64_t
+BME69xI2cBus::timeUs() {
+  return (uint64_t)esp_timer_get_time();
+}
+
+esp_err_t
+BME69xI2cBus::acquire() {
+  return arbiter ? i2c_arbiter_acquire(arbiter, priority, BME69X_ARBITER_TIMEOUT_MS) : ESP_OK;
+}
+void
+BME69xI2cBus::release(size_t bytes) {
+  if (arbiter) {
+    i2c_arbiter_count_bytes(arbiter, bytes);
+    i2c_arbiter_release(arbiter);
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef BME69XI2CBUS_H
+#define BME69XI2CBUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+#include "i2c_arbiter.h"
+
+#include "BME69xBus.h"
+
+/**
+ * BME69xBus on an i2c_master device, the bus may be shared with other devices and drivers. With an arbiter every
+ * transaction waits its turn at the given priority, the waits between them leave the bus to others.
+ */
+class BME69xI2cBus : public BME69xBus {
+public:
+  ~BME69xI2cBus() override;
+
+  esp_err_t open(i2c_master_bus_handle_t bus, uint8_t address, uint32_t freqHz, i2c_arbiter_handle arbiter = nullptr,
+                 uint8_t priority = 0);
+  esp_err_t close();
+
+  esp_err_t read(uint8_t reg, uint8_t *data, size_t len) override;
+  esp_err_t write(const uint8_t *pairs, size_t len) override;
+  void delayUs(uint32_t us) override;
+  uint64_t timeUs() override;
+
+private:
+  esp_err_t acquire();
+  void release(size_t bytes);
+
+  i2c_master_dev_handle_t dev = nullptr;
+  i2c_arbiter_handle arbiter = nullptr;
+  uint8_t priority = 0;
+};
+
+#endif
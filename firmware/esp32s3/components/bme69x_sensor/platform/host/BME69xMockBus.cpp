@@ -0,0 +1,48 @@
+#include <cstring>
+
+#include "BME69xMockBus.h"
+#include "private/BME69xSensorPrivate.h"
+
+esp_err_t
+BME69xMockBus::read(uint8_t reg, uint8_t *data, size_t len) {
+  if (isFailing || reg + len > sizeof(regs))
+    return ESP_FAIL;
+
+  reads++;
+  bytesRead += len;
+  if (reg <= BME69X_REG_CTRL_MEAS && reg + len > BME69X_REG_CTRL_MEAS && (regs[BME69X_REG_CTRL_MEAS] & BME69X_MODE_MSK)) {
+    if (measReads++ >= readsToSleep) {
+      regs[BME69X_REG_CTRL_MEAS] &= (uint8_t)~BME69X_MODE_MSK;
+      measReads = 0;
+    }
+  }
+  memcpy(data, &regs[reg], len);
+  return ESP_OK;
+}
+esp_err_t
+BME69xMockBus::write(const uint8_t *pairs, size_t len) {
+  if (isFailing || len == 0 || len % 2U != 0)
+    return ESP_FAIL;
+
+  writes++;
+  bytesWritten += len;
+  for (size_t i = 0; i < len; i += 2) {
+    if (pairs[i] == BME69X_REG_SOFT_RESET) {
+      if (pairs[i + 1] == BME69X_SOFT_RESET_CMD) {
+        memset(&regs[BME69X_REG_CTRL_GAS_0], 0, BME69X_LEN_CTRL);
+      }
+      continue;
+    }
+    regs[pairs[i]] = pairs[i + 1];
+  }
+  measReads = 0;
+  return ESP_OK;
+}
+void
+BME69xMockBus::delayUs(uint32_t us) {
+  nowUs += us;
+}
+uint64_t
+BME69xMockBus::timeUs() {
+  return nowUs;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef BME69XMOCKBUS_H
+#define BME69XMOCKBUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+#include "BME69xBus.h"
+
+/**
+ * Register file for host tests. Writes land in regs as the sensor would take them, a written measurement mode
+ * drops back to sleep after readsToSleep more reads of CTRL_MEAS. Delays only advance the clock.
+ */
+class BME69xMockBus : public BME69xBus {
+public:
+  esp_err_t read(uint8_t reg, uint8_t *data, size_t len) override;
+  esp_err_t write(const uint8_t *pairs, size_t len) override;
+  void delayUs(uint32_t us) override;
+  uint64_t timeUs() override;
+
+  uint8_t regs[256] = {};
+  uint8_t readsToSleep = 0;
+
+  uint32_t reads = 0;
+  uint32_t writes = 0;
+  uint32_t bytesRead = 0;
+  uint32_t bytesWritten = 0;
+  uint64_t nowUs = 0;
+
+  bool isFailing = false; // every transaction fails while set
+
+private:
+  uint8_t measReads = 0;
+};
+
+#endif
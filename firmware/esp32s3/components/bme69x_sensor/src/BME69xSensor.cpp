@@ -0,0 +1,622 @@
+#include <cstring>
+
+#include "esp_log.h"
+
+#include "BME69xSensor.h"
+
+static const char *TAG = "bme69x_sensor";
+
+BME69xSensor::BME69xSensor(BME69xBus &bus) : bus(bus) {
+}
+
+BME6xxStatus
+BME69xSensor::begin() {
+  busTransactions = 0;
+  lastOpMode = BME6xxMode::SLEEP;
+  nFields = iFields = 0;
+
+  bme6xxSoftReset();
+  if (status != BME6xxStatus::OK)
+    return status;
+
+  uint8_t chipId = 0;
+  if (!read(BME69X_REG_CHIP_ID, &chipId, 1))
+    return status;
+  if (chipId != BME69X_CHIP_ID) {
+    ESP_LOGE(TAG, "Unexpected chip id 0x%02x", chipId);
+    return status = BME6xxStatus::ERROR_DEV_NOT_FOUND;
+  }
+
+  uint8_t variant = 0;
+  if (!read(BME69X_REG_VARIANT_ID, &variant, 1))
+    return status;
+  isVariantHigh = variant != 0;
+
+  uint8_t coeff[BME69X_LEN_COEFF_ALL];
+  if (!read(BME69X_REG_COEFF1, coeff, BME69X_LEN_COEFF1) ||
+      !read(BME69X_REG_COEFF2, coeff + BME69X_LEN_COEFF1, BME69X_LEN_COEFF2) ||
+      !read(BME69X_REG_COEFF3, coeff + BME69X_LEN_COEFF1 + BME69X_LEN_COEFF2, BME69X_LEN_COEFF3))
+    return status;
+
+  calib.par_t1 = (uint16_t)((coeff[BME69X_IDX_T1_MSB] << 8) | coeff[BME69X_IDX_T1_LSB]);
+  calib.par_t2 = (int16_t)((coeff[BME69X_IDX_T2_MSB] << 8) | coeff[BME69X_IDX_T2_LSB]);
+  calib.par_t3 = (int8_t)coeff[BME69X_IDX_T3];
+
+  calib.par_p1 = (uint16_t)((coeff[BME69X_IDX_P1_MSB] << 8) | coeff[BME69X_IDX_P1_LSB]);
+  calib.par_p2 = (int16_t)((coeff[BME69X_IDX_P2_MSB] << 8) | coeff[BME69X_IDX_P2_LSB]);
+  calib.par_p3 = (int8_t)coeff[BME69X_IDX_P3];
+  calib.par_p4 = (int16_t)((coeff[BME69X_IDX_P4_MSB] << 8) | coeff[BME69X_IDX_P4_LSB]);
+  calib.par_p5 = (int16_t)((coeff[BME69X_IDX_P5_MSB] << 8) | coeff[BME69X_IDX_P5_LSB]);
+  calib.par_p6 = (int8_t)coeff[BME69X_IDX_P6];
+  calib.par_p7 = (int8_t)coeff[BME69X_IDX_P7];
+  calib.par_p8 = (int16_t)((coeff[BME69X_IDX_P8_MSB] << 8) | coeff[BME69X_IDX_P8_LSB]);
+  calib.par_p9 = (int16_t)((coeff[BME69X_IDX_P9_MSB] << 8) | coeff[BME69X_IDX_P9_LSB]);
+  calib.par_p10 = coeff[BME69X_IDX_P10];
+
+  // H1 and H2 share the middle byte, a nibble each
+  calib.par_h1 = (uint16_t)((coeff[BME69X_IDX_H1_MSB] << 4) | (coeff[BME69X_IDX_H1_LSB] & 0x0FU));
+  calib.par_h2 = (uint16_t)((coeff[BME69X_IDX_H2_MSB] << 4) | (coeff[BME69X_IDX_H2_LSB] >> 4));
+  calib.par_h3 = (int8_t)coeff[BME69X_IDX_H3];
+  calib.par_h4 = (int8_t)coeff[BME69X_IDX_H4];
+  calib.par_h5 = (int8_t)coeff[BME69X_IDX_H5];
+  calib.par_h6 = coeff[BME69X_IDX_H6];
+  calib.par_h7 = (int8_t)coeff[BME69X_IDX_H7];
+
+  calib.par_gh1 = (int8_t)coeff[BME69X_IDX_GH1];
+  calib.par_gh2 = (int16_t)((coeff[BME69X_IDX_GH2_MSB] << 8) | coeff[BME69X_IDX_GH2_LSB]);
+  calib.par_gh3 = (int8_t)coeff[BME69X_IDX_GH3];
+
+  calib.res_heat_range = (uint8_t)((coeff[BME69X_IDX_RES_HEAT_RANGE] & BME69X_RHRANGE_MSK) / 16U);
+  calib.res_heat_val = (int8_t)coeff[BME69X_IDX_RES_HEAT_VAL];
+  calib.range_sw_err = (int8_t)((int8_t)(coeff[BME69X_IDX_RANGE_SW_ERR] & BME69X_RSERROR_MSK) / 16);
+
+  ESP_LOGI(TAG, "BME69x, gas variant %s", isVariantHigh ? "high" : "low");
+  return status;
+}
+
+void
+BME69xSensor::bme6xxSetHeaterProf(uint16_t *temp, uint16_t *mul, uint16_t sharedHeatrDur, uint8_t profileLen) {
+  setHeaterConf(BME6xxMode::PARALLEL, temp, mul, sharedHeatrDur, profileLen);
+}
+void
+BME69xSensor::bme6xxSetHeaterProf(uint16_t temp, uint16_t dur) {
+  setHeaterConf(BME6xxMode::FORCED, &temp, &dur, 0, 1);
+}
+void
+BME69xSensor::bme6xxSetHeaterProfSeq(uint16_t *temp, uint16_t *dur, uint8_t profileLen) {
+  setHeaterConf(BME6xxMode::SEQUENTIAL, temp, dur, 0, profileLen);
+}
+
+uint32_t
+BME69xSensor::bme6xxGetMeasDur(BME6xxMode opMode) {
+  static const uint8_t osToMeasCycles[] = {0, 1, 2, 4, 8, 16};
+
+  if (opMode == BME6xxMode::SLEEP) {
+    opMode = lastOpMode;
+  }
+  uint32_t measCycles = osToMeasCycles[(uint8_t)os.temp] + osToMeasCycles[(uint8_t)os.pres] + osToMeasCycles[(uint8_t)os.hum];
+
+  // TPH conversions, switching between them and the gas conversion, all in us
+  uint32_t measDur = measCycles * 1963U + 477U * 4U + 477U * 5U;
+  if (opMode != BME6xxMode::PARALLEL) {
+    measDur += 1000U; // wake up
+  }
+  return measDur;
+}
+
+void
+BME69xSensor::bme6xxSetOS(BME6xxOversampling osTemp, BME6xxOversampling osPres, BME6xxOversampling osHum) {
+  BME6xxOS next;
+  next.temp = osTemp;
+  next.pres = osPres;
+  next.hum = osHum;
+  bme6xxSetOS(next);
+}
+void
+BME69xSensor::bme6xxSetOS(BME6xxOS &next) {
+  os = next;
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_HUM)] =
+      (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_HUM)] & ~BME69X_OSH_MSK) | (uint8_t)os.hum);
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] =
+      (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] & ~(BME69X_OST_MSK | BME69X_OSP_MSK)) |
+                ((uint8_t)os.temp << BME69X_OST_POS) | ((uint8_t)os.pres << BME69X_OSP_POS));
+  // The humidity setting only takes with the CTRL_MEAS write after it, the pairs go out in register order
+  configure(BME69X_CTRL_BIT(BME69X_REG_CTRL_HUM) | BME69X_CTRL_BIT(BME69X_REG_CTRL_MEAS));
+}
+void
+BME69xSensor::bme6xxSetFilter(BME6xxFilter filter) {
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CONFIG)] = (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CONFIG)] & ~BME69X_FILTER_MSK) |
+                                                       ((uint8_t)filter << BME69X_FILTER_POS));
+  configure(BME69X_CTRL_BIT(BME69X_REG_CONFIG));
+}
+void
+BME69xSensor::bme6xxSetSeqSleep(BME6xxODR odr) {
+  // ODR_NONE is the fourth bit alone, in CTRL_GAS_1
+  uint8_t odr20 = odr == BME6xxODR::ODR_NONE ? 0U : (uint8_t)odr;
+  uint8_t odr3 = odr == BME6xxODR::ODR_NONE ? 1U : 0U;
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CONFIG)] =
+      (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CONFIG)] & ~BME69X_ODR20_MSK) | (odr20 << BME69X_ODR20_POS));
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_1)] =
+      (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_1)] & ~BME69X_ODR3_MSK) | (odr3 << BME69X_ODR3_POS));
+  configure(BME69X_CTRL_BIT(BME69X_REG_CTRL_GAS_1) | BME69X_CTRL_BIT(BME69X_REG_CONFIG));
+}
+
+uint32_t
+BME69xSensor::bme6xxGetUniqueId() {
+  uint8_t id[4] = {};
+  status = BME6xxStatus::OK;
+  if (!read(BME69X_REG_UNIQUE_ID, id, sizeof(id)))
+    return 0;
+
+  uint32_t id1 = ((uint32_t)id[3] + ((uint32_t)id[2] << 8)) & 0x7FFFU;
+  return (id1 << 16) + ((uint32_t)id[1] << 8) + (uint32_t)id[0];
+}
+
+void
+BME69xSensor::bme6xxSetOpMode(BME6xxMode opMode) {
+  status = BME6xxStatus::OK;
+  if (!sleep())
+    return;
+  if (opMode != BME6xxMode::SLEEP) {
+    ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] =
+        (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] & ~BME69X_MODE_MSK) | (uint8_t)opMode);
+    if (!writeCtrl(BME69X_CTRL_BIT(BME69X_REG_CTRL_MEAS)))
+      return;
+    ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] &= (uint8_t)~BME69X_MODE_MSK;
+    isAwake = true;
+  }
+  lastOpMode = opMode;
+}
+
+BME6xxStatus
+BME69xSensor::bme6xxCheckStatus() {
+  return status;
+}
+
+uint8_t
+BME69xSensor::bme6xxFetchData() {
+  status = BME6xxStatus::OK;
+  nFields = 0;
+  iFields = 0;
+
+  if (lastOpMode == BME6xxMode::FORCED) {
+    uint8_t buff[BME69X_LEN_FIELD];
+    for (uint8_t tries = 0; tries < BME69X_FORCED_TRIES; ++tries) {
+      if (!read(BME69X_REG_FIELD0, buff, sizeof(buff)))
+        return 0;
+      if (buff[0] & BME6xxMask::NEW_DATA_MSK)
+        break;
+      bus.delayUs(BME69X_POLL_DELAY_US);
+    }
+    if (!(buff[0] & BME6xxMask::NEW_DATA_MSK)) {
+      status = BME6xxStatus::WARNING_NO_NEW_DATA;
+      return 0;
+    }
+    // A forced measurement that has delivered leaves the sensor asleep
+    isAwake = false;
+    parseField(buff, fields[0]);
+    nFields = 1;
+    return nFields;
+  }
+  if (lastOpMode != BME6xxMode::PARALLEL && lastOpMode != BME6xxMode::SEQUENTIAL) {
+    status = BME6xxStatus::WARNING_DEFINE_OP_MODE;
+    return 0;
+  }
+
+  // All three fields in one burst, the heater settings of each come from heaterSet instead of another read
+  uint8_t buff[BME69X_LEN_FIELD * BME69X_FIELD_COUNT];
+  if (!read(BME69X_REG_FIELD0, buff, sizeof(buff)))
+    return 0;
+
+  BME6xxData parsed[BME69X_FIELD_COUNT];
+  uint8_t order[BME69X_FIELD_COUNT] = {0, 1, 2};
+  for (uint8_t i = 0; i < BME69X_FIELD_COUNT; ++i) {
+    parseField(buff + i * BME69X_LEN_FIELD, parsed[i]);
+    if (parsed[i].status & BME6xxMask::NEW_DATA_MSK) {
+      nFields++;
+    }
+  }
+
+  // New fields first, oldest first among them. meas_index wraps at 256, a step back of up to 2 is a wrap.
+  for (uint8_t i = 0; i < BME69X_FIELD_COUNT - 1U; ++i) {
+    for (uint8_t j = i + 1U; j < BME69X_FIELD_COUNT; ++j) {
+      const BME6xxData &low = parsed[order[i]];
+      const BME6xxData &high = parsed[order[j]];
+      bool isSwapped = false;
+      if ((low.status & BME6xxMask::NEW_DATA_MSK) && (high.status & BME6xxMask::NEW_DATA_MSK)) {
+        int16_t diff = (int16_t)high.meas_index - (int16_t)low.meas_index;
+        isSwapped = (diff > -3 && diff < 0) || diff > 2;
+      } else {
+        isSwapped = (high.status & BME6xxMask::NEW_DATA_MSK) != 0;
+      }
+      if (isSwapped) {
+        uint8_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+      }
+    }
+  }
+  for (uint8_t i = 0; i < BME69X_FIELD_COUNT; ++i) {
+    fields[i] = parsed[order[i]];
+  }
+
+  if (nFields == 0) {
+    status = BME6xxStatus::WARNING_NO_NEW_DATA;
+  }
+  return nFields;
+}
+
+size_t
+BME69xSensor::bme6xxGetAllData(BME6xxData *dataOut, size_t maxLen) {
+  if (!dataOut) {
+    status = BME6xxStatus::ERROR_NULL_PTR;
+    return 0;
+  }
+  size_t len = nFields < maxLen ? nFields : maxLen;
+  for (size_t i = 0; i < len; ++i) {
+    dataOut[i] = fields[i];
+  }
+  return len;
+}
+size_t
+BME69xSensor::bme6xxGetData(BME6xxData &dataOut) {
+  if (lastOpMode == BME6xxMode::FORCED) {
+    dataOut = fields[0];
+    return 0;
+  }
+  if (nFields == 0)
+    return 0;
+
+  dataOut = fields[iFields];
+  iFields++;
+  // Stays on the last field once all were handed out
+  if (iFields >= nFields) {
+    iFields = (uint8_t)(nFields - 1U);
+    return 0;
+  }
+  return nFields - iFields;
+}
+
+void
+BME69xSensor::bme6xxSelftestCheck() {
+  BME6xxOS savedOs = os;
+  BME6xxData data[BME69X_SELFTEST_MEAS];
+
+  bme6xxSetOS(BME6xxOversampling::X2, BME6xxOversampling::X16, BME6xxOversampling::X1);
+  if (status != BME6xxStatus::OK)
+    return;
+
+  // The heater has to be able to reach the high step at all before it is cycled
+  bool isPassed = selftestStep(BME69X_SELFTEST_HIGH_TEMP, BME69X_SELFTEST_DUR1_MS, data[0]) && data[0].idac != 0x00U &&
+                  data[0].idac != 0xFFU && (data[0].status & BME6xxMask::GASM_VALID_MSK);
+  for (uint8_t i = 0; i < BME69X_SELFTEST_MEAS && isPassed; ++i) {
+    uint16_t temp = i % 2U == 0 ? BME69X_SELFTEST_HIGH_TEMP : BME69X_SELFTEST_LOW_TEMP;
+    isPassed = selftestStep(temp, BME69X_SELFTEST_DUR2_MS, data[i]) && (data[i].status & BME6xxMask::GASM_VALID_MSK);
+  }
+  if (isPassed) {
+    // Room conditions, and the sensing layer clearly hotter at the high steps than at the low ones
+    isPassed = data[0].temperature >= 0.0f && data[0].temperature <= 60.0f && data[0].pressure >= 90000.0f &&
+               data[0].pressure <= 110000.0f && data[0].humidity >= 20.0f && data[0].humidity <= 80.0f;
+    float centRes = (5.0f * (data[3].gas_resistance + data[5].gas_resistance)) / (2.0f * data[4].gas_resistance);
+    isPassed = isPassed && centRes >= 6.0f;
+  }
+
+  bme6xxSetOS(savedOs);
+  if (!isPassed && status == BME6xxStatus::OK) {
+    status = BME6xxStatus::ERROR_SELF_TEST;
+  }
+  ESP_LOGI(TAG, "Self test %s", status == BME6xxStatus::OK ? "passed" : "failed");
+}
+
+void
+BME69xSensor::bme6xxSoftReset() {
+  const uint8_t pairs[] = {BME69X_REG_SOFT_RESET, BME69X_SOFT_RESET_CMD};
+
+  status = BME6xxStatus::OK;
+  if (!write(pairs, sizeof(pairs)))
+    return;
+  bus.delayUs(BME69X_RESET_DELAY_US);
+  isAwake = false;
+  heaterPairsLen = 0;
+
+  // Back to the power on values, read once here and only written from then on
+  if (!read(BME69X_REG_CTRL_GAS_0, ctrl, sizeof(ctrl)) || !readHeaterSet())
+    return;
+  os.temp = (BME6xxOversampling)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] & BME69X_OST_MSK) >> BME69X_OST_POS);
+  os.pres = (BME6xxOversampling)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] & BME69X_OSP_MSK) >> BME69X_OSP_POS);
+  os.hum = (BME6xxOversampling)(ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_HUM)] & BME69X_OSH_MSK);
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_MEAS)] &= (uint8_t)~BME69X_MODE_MSK;
+}
+
+const char *
+BME69xSensor::bme6xxGetType() {
+  return "BME69x";
+}
+
+uint32_t
+BME69xSensor::transactions() const {
+  return busTransactions;
+}
+
+bool
+BME69xSensor::read(uint8_t reg, uint8_t *data, size_t len) {
+  busTransactions++;
+  if (bus.read(reg, data, len) != ESP_OK) {
+    status = BME6xxStatus::ERROR_COM_FAIL;
+    return false;
+  }
+  return true;
+}
+bool
+BME69xSensor::write(const uint8_t *pairs, size_t len) {
+  busTransactions++;
+  if (bus.write(pairs, len) != ESP_OK) {
+    status = BME6xxStatus::ERROR_COM_FAIL;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The shadowed control registers in mask, bit 0 for CTRL_GAS_0, as one write
+ */
+bool
+BME69xSensor::writeCtrl(uint8_t mask) {
+  uint8_t pairs[BME69X_LEN_CTRL * 2U];
+  size_t len = 0;
+  for (uint8_t i = 0; i < BME69X_LEN_CTRL; ++i) {
+    if (mask & (1U << i)) {
+      pairs[len++] = (uint8_t)(BME69X_REG_CTRL_GAS_0 + i);
+      pairs[len++] = ctrl[i];
+    }
+  }
+  return write(pairs, len);
+}
+
+/**
+ * Control registers only change in sleep mode, parallel and sequential mode carry on after
+ */
+void
+BME69xSensor::configure(uint8_t mask) {
+  status = BME6xxStatus::OK;
+  bool isRunning = isAwake && (lastOpMode == BME6xxMode::PARALLEL || lastOpMode == BME6xxMode::SEQUENTIAL);
+  if (!sleep() || !writeCtrl(mask))
+    return;
+  if (isRunning) {
+    bme6xxSetOpMode(lastOpMode);
+  }
+}
+
+/**
+ * Waits out a forced measurement or stops the running mode
+ */
+bool
+BME69xSensor::sleep() {
+  if (!isAwake)
+    return true;
+
+  for (uint8_t tries = 0; tries < BME69X_SLEEP_TRIES; ++tries) {
+    uint8_t meas = 0;
+    if (!read(BME69X_REG_CTRL_MEAS, &meas, 1))
+      return false;
+    if ((meas & BME69X_MODE_MSK) == 0) {
+      isAwake = false;
+      return true;
+    }
+    if (!writeCtrl(BME69X_CTRL_BIT(BME69X_REG_CTRL_MEAS)))
+      return false;
+    bus.delayUs(BME69X_POLL_DELAY_US);
+  }
+  ESP_LOGW(TAG, "Sensor did not go to sleep");
+  status = BME6xxStatus::ERROR_COM_FAIL;
+  return false;
+}
+
+bool
+BME69xSensor::readHeaterSet() {
+  return read(BME69X_REG_IDAC_HEAT0, heaterSet, sizeof(heaterSet));
+}
+
+/**
+ * Heater steps, their durations and the gas control go out in one write
+ */
+void
+BME69xSensor::setHeaterConf(BME6xxMode opMode, uint16_t *temp, uint16_t *dur, uint16_t sharedHeatrDur, uint8_t profileLen) {
+  status = BME6xxStatus::OK;
+  if (!temp || !dur) {
+    status = BME6xxStatus::ERROR_NULL_PTR;
+    return;
+  }
+  if (profileLen == 0 || profileLen > BME69X_PROFILE_MAX) {
+    status = BME6xxStatus::ERROR_INVALID_LENGTH;
+    return;
+  }
+  if (opMode == BME6xxMode::PARALLEL && sharedHeatrDur == 0) {
+    status = BME6xxStatus::WARNING_DEFINE_SHD_HEATR_DUR;
+    return;
+  }
+  uint8_t pairs[BME69X_LEN_HEATER_PAIRS];
+  size_t len = 0;
+  for (uint8_t i = 0; i < profileLen; ++i) {
+    pairs[len++] = (uint8_t)(BME69X_REG_RES_HEAT0 + i);
+    pairs[len++] = calcResHeat(temp[i]);
+  }
+  for (uint8_t i = 0; i < profileLen; ++i) {
+    // Parallel mode takes multipliers of the shared duration
+    pairs[len++] = (uint8_t)(BME69X_REG_GAS_WAIT0 + i);
+    pairs[len++] = opMode == BME6xxMode::PARALLEL ? (uint8_t)dur[i] : calcGasWait(dur[i]);
+  }
+  if (opMode == BME6xxMode::PARALLEL) {
+    pairs[len++] = BME69X_REG_SHD_HEATR;
+    pairs[len++] = calcHeatrDurShared(sharedHeatrDur);
+  }
+
+  uint8_t nbConv = opMode == BME6xxMode::FORCED ? 0U : profileLen;
+  uint8_t runGas = isVariantHigh ? BME69X_RUN_GAS_HIGH : BME69X_RUN_GAS_LOW;
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_0)] &= (uint8_t)~BME69X_HCTRL_MSK; // heater on
+  ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_1)] =
+      (uint8_t)((ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_1)] & ~(BME69X_NBCONV_MSK | BME69X_RUN_GAS_MSK)) | nbConv |
+                (runGas << BME69X_RUN_GAS_POS));
+  pairs[len++] = BME69X_REG_CTRL_GAS_0;
+  pairs[len++] = ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_0)];
+  pairs[len++] = BME69X_REG_CTRL_GAS_1;
+  pairs[len++] = ctrl[BME69X_CTRL_IDX(BME69X_REG_CTRL_GAS_1)];
+
+  // BSEC sets the same profile before every measurement, the sensor still holds it
+  if (len == heaterPairsLen && memcmp(pairs, heaterPairs, len) == 0)
+    return;
+  if (!sleep() || !write(pairs, len))
+    return;
+  memcpy(heaterPairs, pairs, len);
+  heaterPairsLen = len;
+  readHeaterSet();
+}
+
+bool
+BME69xSensor::selftestStep(uint16_t temp, uint16_t dur, BME6xxData &data) {
+  bme6xxSetHeaterProf(temp, dur);
+  bme6xxSetOpMode(BME6xxMode::FORCED);
+  if (status != BME6xxStatus::OK)
+    return false;
+  bus.delayUs(bme6xxGetMeasDur(BME6xxMode::FORCED) + (uint32_t)dur * 1000U);
+  if (bme6xxFetchData() == 0)
+    return false;
+  data = fields[0];
+  return true;
+}
+
+void
+BME69xSensor::parseField(const uint8_t *buff, BME6xxData &data) {
+  data.status = buff[0] & BME6xxMask::NEW_DATA_MSK;
+  data.gas_index = buff[0] & BME69X_GAS_INDEX_MSK;
+  data.meas_index = buff[1];
+
+  uint32_t presAdc = ((uint32_t)buff[2] << 12) | ((uint32_t)buff[3] << 4) | ((uint32_t)buff[4] >> 4);
+  uint32_t tempAdc = ((uint32_t)buff[5] << 12) | ((uint32_t)buff[6] << 4) | ((uint32_t)buff[7] >> 4);
+  uint16_t humAdc = (uint16_t)(((uint32_t)buff[8] << 8) | (uint32_t)buff[9]);
+  uint16_t gasResAdcLow = (uint16_t)(((uint32_t)buff[13] << 2) | ((uint32_t)buff[14] >> 6));
+  uint16_t gasResAdcHigh = (uint16_t)(((uint32_t)buff[15] << 2) | ((uint32_t)buff[16] >> 6));
+
+  // The gas valid and heater stable bits sit with the gas reading of the variant
+  uint8_t gasLsb = isVariantHigh ? buff[16] : buff[14];
+  data.status |= gasLsb & (BME6xxMask::GASM_VALID_MSK | BME6xxMask::HEAT_STAB_MSK);
+
+  uint8_t step = data.gas_index < BME69X_PROFILE_MAX ? data.gas_index : (uint8_t)(BME69X_PROFILE_MAX - 1U);
+  data.idac = heaterSet[step];
+  data.res_heat = heaterSet[BME69X_PROFILE_MAX + step];
+  data.gas_wait = heaterSet[BME69X_PROFILE_MAX * 2U + step];
+
+  // Temperature first, pressure and humidity use its t_fine
+  data.temperature = calcTemperature(tempAdc);
+  data.pressure = calcPressure(presAdc);
+  data.humidity = calcHumidity(humAdc);
+  data.gas_resistance = isVariantHigh ? calcGasResistanceHigh(gasResAdcHigh, gasLsb & BME69X_GAS_RANGE_MSK)
+                                      : calcGasResistanceLow(gasResAdcLow, gasLsb & BME69X_GAS_RANGE_MSK);
+  data.meas_timestamp = bus.timeUs();
+}
+
+float
+BME69xSensor::calcTemperature(uint32_t tempAdc) {
+  float var1 = (((float)tempAdc / 16384.0f) - ((float)calib.par_t1 / 1024.0f)) * (float)calib.par_t2;
+  float var2 = (((float)tempAdc / 131072.0f) - ((float)calib.par_t1 / 8192.0f)) *
+               (((float)tempAdc / 131072.0f) - ((float)calib.par_t1 / 8192.0f)) * ((float)calib.par_t3 * 16.0f);
+  tFine = var1 + var2;
+  return tFine / 5120.0f;
+}
+float
+BME69xSensor::calcPressure(uint32_t presAdc) const {
+  float var1 = (tFine / 2.0f) - 64000.0f;
+  float var2 = var1 * var1 * ((float)calib.par_p6 / 131072.0f);
+  var2 = var2 + (var1 * (float)calib.par_p5 * 2.0f);
+  var2 = (var2 / 4.0f) + ((float)calib.par_p4 * 65536.0f);
+  var1 = ((((float)calib.par_p3 * var1 * var1) / 16384.0f) + ((float)calib.par_p2 * var1)) / 524288.0f;
+  var1 = (1.0f + (var1 / 32768.0f)) * (float)calib.par_p1;
+  if ((int32_t)var1 == 0)
+    return 0.0f;
+
+  float pres = 1048576.0f - (float)presAdc;
+  pres = ((pres - (var2 / 4096.0f)) * 6250.0f) / var1;
+  var1 = ((float)calib.par_p9 * pres * pres) / 2147483648.0f;
+  var2 = pres * ((float)calib.par_p8 / 32768.0f);
+  float var3 = (pres / 256.0f) * (pres / 256.0f) * (pres / 256.0f) * ((float)calib.par_p10 / 131072.0f);
+  return pres + (var1 + var2 + var3 + ((float)calib.par_p7 * 128.0f)) / 16.0f;
+}
+float
+BME69xSensor::calcHumidity(uint16_t humAdc) const {
+  float tempComp = tFine / 5120.0f;
+  float var1 = (float)humAdc - (((float)calib.par_h1 * 16.0f) + (((float)calib.par_h3 / 2.0f) * tempComp));
+  float var2 = var1 * (((float)calib.par_h2 / 262144.0f) * (1.0f + (((float)calib.par_h4 / 16384.0f) * tempComp) +
+                                                             (((float)calib.par_h5 / 1048576.0f) * tempComp * tempComp)));
+  float var3 = (float)calib.par_h6 / 16384.0f;
+  float var4 = (float)calib.par_h7 / 2097152.0f;
+  float hum = var2 + ((var3 + (var4 * tempComp)) * var2 * var2);
+  if (hum > 100.0f)
+    return 100.0f;
+  if (hum < 0.0f)
+    return 0.0f;
+  return hum;
+}
+float
+BME69xSensor::calcGasResistanceLow(uint16_t gasResAdc, uint8_t gasRange) const {
+  static const float lookupK1Range[16] = {0.0f, 0.0f, 0.0f, 0.0f,  0.0f,  -1.0f, 0.0f, -0.8f,
+                                          0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f};
+  static const float lookupK2Range[16] = {0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f,
+                                          -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+  float var1 = 1340.0f + (5.0f * (float)calib.range_sw_err);
+  float var2 = var1 * (1.0f + lookupK1Range[gasRange] / 100.0f);
+  float var3 = 1.0f + (lookupK2Range[gasRange] / 100.0f);
+  return 1.0f / (var3 * 0.000000125f * (float)(1U << gasRange) * ((((float)gasResAdc - 512.0f) / var2) + 1.0f));
+}
+float
+BME69xSensor::calcGasResistanceHigh(uint16_t gasResAdc, uint8_t gasRange) {
+  uint32_t var1 = 262144U >> gasRange;
+  int32_t var2 = 4096 + ((int32_t)gasResAdc - 512) * 3;
+  return 1000000.0f * (float)var1 / (float)var2;
+}
+uint8_t
+BME69xSensor::calcResHeat(uint16_t temp) const {
+  if (temp > BME69X_HEATER_MAX_TEMP) {
+    temp = BME69X_HEATER_MAX_TEMP;
+  }
+  float var1 = ((float)calib.par_gh1 / 16.0f) + 49.0f;
+  float var2 = (((float)calib.par_gh2 / 32768.0f) * 0.0005f) + 0.00235f;
+  float var3 = (float)calib.par_gh3 / 1024.0f;
+  float var4 = var1 * (1.0f + (var2 * (float)temp));
+  float var5 = var4 + (var3 * (float)BME69X_AMBIENT_TEMP);
+  return (uint8_t)(3.4f * ((var5 * (4.0f / (4.0f + (float)calib.res_heat_range)) *
+                            (1.0f / (1.0f + ((float)calib.res_heat_val * 0.002f)))) -
+                           25.0f));
+}
+
+/**
+ * 6 bit mantissa and a 4^n multiplier, in ms
+ */
+uint8_t
+BME69xSensor::calcGasWait(uint16_t dur) {
+  if (dur >= 0xFC0U)
+    return 0xFFU;
+
+  uint8_t factor = 0;
+  while (dur > 0x3FU) {
+    dur = dur / 4U;
+    factor++;
+  }
+  return (uint8_t)(dur + factor * 64U);
+}
+/**
+ * Same encoding as calcGasWait in steps of 0.477 ms
+ */
+uint8_t
+BME69xSensor::calcHeatrDurShared(uint16_t dur) {
+  if (dur >= 0x783U)
+    return 0xFFU;
+
+  uint32_t durSteps = ((uint32_t)dur * 1000U) / 477U;
+  uint8_t factor = 0;
+  while (durSteps > 0x3FU) {
+    durSteps = durSteps >> 2;
+    factor++;
+  }
+  return (uint8_t)(durSteps + factor * 64U);
+}
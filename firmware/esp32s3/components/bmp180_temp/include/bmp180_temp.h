@@ -0,0 +1,41 @@
+#pragma once
+#ifndef BMP180_TEMP_H
+#define BMP180_TEMP_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "bmp180_temp_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bmp180_temp *bmp180_temp_handle;
+
+/**
+ * Checks the chip id and reads the calibration of the temperature channel, the pressure channel is left alone
+ */
+esp_err_t
+bmp180_temp_new(const struct bmp180_temp_config_t *temp_cfg, bmp180_temp_handle *out_temp);
+esp_err_t
+bmp180_temp_del(bmp180_temp_handle temp);
+
+/**
+ * Starts a conversion and returns right away, the bus stays free for other devices for out_wait_ms
+ */
+esp_err_t
+bmp180_temp_start(bmp180_temp_handle temp, uint32_t *out_wait_ms);
+
+/**
+ * ESP_ERR_NOT_FINISHED while the conversion runs, otherwise the temperature in degrees C, 0.1 C steps
+ */
+esp_err_t
+bmp180_temp_read(bmp180_temp_handle temp, float *out_temp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
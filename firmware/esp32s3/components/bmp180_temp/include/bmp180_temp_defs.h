@@ -0,0 +1,33 @@
+#pragma once
+#ifndef BMP180_TEMP_DEFS_H
+#define BMP180_TEMP_DEFS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Register access of the sensor, the transport is owned by the caller (Wire, i2c_master, ...). Reads start at reg and
+ * auto-increment. Writes send data as is, the register first.
+ */
+typedef esp_err_t (*bmp180_temp_read_fn)(void *user_ctx, uint8_t address, uint8_t reg, uint8_t *data, size_t len);
+typedef esp_err_t (*bmp180_temp_write_fn)(void *user_ctx, uint8_t address, const uint8_t *data, size_t len);
+
+struct bmp180_temp_config_t {
+  uint8_t address;
+
+  bmp180_temp_read_fn read;
+  bmp180_temp_write_fn write;
+  void *user_ctx;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
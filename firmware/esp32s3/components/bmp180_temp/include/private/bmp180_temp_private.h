@@ -0,0 +1,25 @@
+#pragma once
+#ifndef BMP180_TEMP_PRIVATE_H
+#define BMP180_TEMP_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMP180_TEMP_REG_AC5     0xB2U // AC5, AC6, then MC and MD two words further, all big endian
+#define BMP180_TEMP_REG_ID      0xD0U
+#define BMP180_TEMP_REG_CONTROL 0xF4U
+#define BMP180_TEMP_REG_OUT_MSB 0xF6U
+
+#define BMP180_TEMP_CALIB_LEN 14U // 0xB2 to 0xBF
+
+#define BMP180_TEMP_ID            0x55U
+#define BMP180_TEMP_CMD_TEMP      0x2EU
+#define BMP180_TEMP_CONTROL_SCO   0x20U // set while a conversion runs
+#define BMP180_TEMP_CONVERSION_MS 5U    // 4.5 ms at most
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
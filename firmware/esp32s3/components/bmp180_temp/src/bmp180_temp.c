@@ -0,0 +1,110 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "bmp180_temp.h"
+#include "private/bmp180_temp_private.h"
+
+struct bmp180_temp {
+  struct bmp180_temp_config_t cfg;
+
+  uint16_t ac5;
+  uint16_t ac6;
+  int16_t mc;
+  int16_t md;
+
+  bool is_converting;
+};
+
+static const char *TAG = "bmp180_temp";
+
+static esp_err_t
+read_reg(bmp180_temp_handle temp, uint8_t reg, uint8_t *data, size_t len);
+static uint16_t
+word_at(const uint8_t *data, size_t offset);
+
+esp_err_t
+bmp180_temp_new(const struct bmp180_temp_config_t *temp_cfg, bmp180_temp_handle *out_temp) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(temp_cfg && out_temp, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(temp_cfg->read && temp_cfg->write, ESP_ERR_INVALID_ARG, TAG, "no register access functions");
+
+  struct bmp180_temp *temp = calloc(1, sizeof(struct bmp180_temp));
+  ESP_RETURN_ON_FALSE(temp, ESP_ERR_NO_MEM, TAG, "failed to allocate bmp180");
+  temp->cfg = *temp_cfg;
+
+  uint8_t id = 0;
+  ESP_GOTO_ON_ERROR(read_reg(temp, BMP180_TEMP_REG_ID, &id, 1U), err, TAG, "failed to read the chip id");
+  ESP_GOTO_ON_FALSE(id == BMP180_TEMP_ID, ESP_ERR_NOT_FOUND, err, TAG, "unexpected chip id 0x%02x", id);
+
+  uint8_t calib[BMP180_TEMP_CALIB_LEN];
+  ESP_GOTO_ON_ERROR(read_reg(temp, BMP180_TEMP_REG_AC5, calib, sizeof(calib)), err, TAG, "failed to read the calibration");
+  temp->ac5 = word_at(calib, 0U);
+  temp->ac6 = word_at(calib, 2U);
+  temp->mc = (int16_t)word_at(calib, 10U);
+  temp->md = (int16_t)word_at(calib, 12U);
+  // An erased or missing EEPROM reads all zeros or all ones
+  ESP_GOTO_ON_FALSE(temp->ac5 != 0U && temp->ac5 != 0xFFFFU && temp->md != 0, ESP_ERR_INVALID_RESPONSE, err, TAG,
+                    "invalid calibration");
+
+  *out_temp = temp;
+  return ESP_OK;
+err:
+  free(temp);
+  return ret;
+}
+esp_err_t
+bmp180_temp_del(bmp180_temp_handle temp) {
+  ESP_RETURN_ON_FALSE(temp, ESP_ERR_INVALID_ARG, TAG, "invalid bmp180");
+
+  free(temp);
+  return ESP_OK;
+}
+
+esp_err_t
+bmp180_temp_start(bmp180_temp_handle temp, uint32_t *out_wait_ms) {
+  ESP_RETURN_ON_FALSE(temp && out_wait_ms, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  const uint8_t cmd[] = {BMP180_TEMP_REG_CONTROL, BMP180_TEMP_CMD_TEMP};
+  ESP_RETURN_ON_ERROR(temp->cfg.write(temp->cfg.user_ctx, temp->cfg.address, cmd, sizeof(cmd)), TAG,
+                      "failed to start a conversion");
+  temp->is_converting = true;
+
+  *out_wait_ms = BMP180_TEMP_CONVERSION_MS;
+  return ESP_OK;
+}
+
+/**
+ * Integer compensation of the datasheet, B5 and the result in 0.1 C
+ */
+esp_err_t
+bmp180_temp_read(bmp180_temp_handle temp, float *out_temp) {
+  ESP_RETURN_ON_FALSE(temp && out_temp, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(temp->is_converting, ESP_ERR_INVALID_STATE, TAG, "no conversion started");
+
+  // Control sits two registers before the result, one transaction brings both
+  uint8_t data[4];
+  ESP_RETURN_ON_ERROR(read_reg(temp, BMP180_TEMP_REG_CONTROL, data, sizeof(data)), TAG, "failed to read the result");
+  if (data[0] & BMP180_TEMP_CONTROL_SCO)
+    return ESP_ERR_NOT_FINISHED;
+  temp->is_converting = false;
+
+  int32_t ut = (int32_t)word_at(data, 2U);
+  int32_t x1 = ((ut - (int32_t)temp->ac6) * (int32_t)temp->ac5) >> 15;
+  int32_t x2 = ((int32_t)temp->mc * 2048) / (x1 + (int32_t)temp->md);
+  int32_t b5 = x1 + x2;
+  *out_temp = (float)((b5 + 8) >> 4) / 10.0f;
+  return ESP_OK;
+}
+
+static esp_err_t
+read_reg(bmp180_temp_handle temp, uint8_t reg, uint8_t *data, size_t len) {
+  return temp->cfg.read(temp->cfg.user_ctx, temp->cfg.address, reg, data, len);
+}
+static uint16_t
+word_at(const uint8_t *data, size_t offset) {
+  return (uint16_t)((data[offset] << 8U) | data[offset + 1U]);
+}
@@ -12,7 +12,16 @@ extern "C" {
 
 #define SENSOR_NAME_MAX_LEN   16
 #define SENSOR_FIELD_NAME_LEN 16
-#define SENSOR_MAX_FIELDS     5
+#define SENSOR_MAX_FIELDS     8
+
+/**
+ * Most bytes encode_sensor_payload writes: names at full length, every value a 64 bit integer and the head and break of
+ * both maps. Texts under 24 bytes have a one byte head, so sizeof of a key literal is its encoded size.
+ */
+#define SENSOR_CBOR_VALUE_MAX_SIZE 9U
+#define SENSOR_PAYLOAD_CBOR_MAX_SIZE                                                                                             \
+  (4U + sizeof("sensor") + SENSOR_NAME_MAX_LEN + sizeof("timestamp") + SENSOR_CBOR_VALUE_MAX_SIZE + sizeof("fields") +           \
+   SENSOR_MAX_FIELDS * (SENSOR_FIELD_NAME_LEN + SENSOR_CBOR_VALUE_MAX_SIZE))
 
 typedef enum {
   SENSOR_FIELD_DATATYPE_INVALID = 0,
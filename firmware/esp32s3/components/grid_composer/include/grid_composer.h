@@ -14,6 +14,12 @@ extern "C" {
 
 typedef struct grid_composer *grid_composer_handle;
 
+/**
+ * Called from the draw task after every frame (all descriptors drained from the queue in one go)
+ */
+typedef void (*grid_composer_frame_done_cb_t)(grid_composer_handle composer, const grid_composer_frame_stats *stats,
+                                              void *user_ctx);
+
 esp_err_t
 grid_composer_init(grid_composer_handle *out_composer);
 esp_err_t
@@ -22,6 +28,20 @@ grid_composer_del(grid_composer_handle composer);
 esp_err_t
 grid_composer_add_cell(grid_composer_handle composer, grid_composer_renderer *renderer);
 
+esp_err_t
+grid_composer_set_frame_done_cb(grid_composer_handle composer, grid_composer_frame_done_cb_t cb, void *user_ctx);
+
+/**
+ * Retained widgets, defined once and redrawn by the draw task only when their formatted value changes
+ */
+esp_err_t
+grid_composer_widget_add(grid_composer_handle composer, const grid_composer_widget_config *widget_cfg,
+                         grid_composer_widget_handle *out_widget);
+esp_err_t
+grid_composer_widget_set_value(grid_composer_widget_handle widget, float value);
+esp_err_t
+grid_composer_widget_set_text(grid_composer_widget_handle widget, const char *text);
+
 esp_err_t
 grid_composer_draw_queue_send(grid_composer_handle composer, const grid_composer_draw_descriptor *render_desc, uint32_t timeout_ms);
 
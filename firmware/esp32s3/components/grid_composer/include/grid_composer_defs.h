@@ -110,6 +110,20 @@ extern "C" {
                 }} }                                                                                                             \
   }
 
+#define GRID_COMPOSER_TEXT_WIDGET_CONFIG(_type, _row, _col, _box_x, _box_y, _box_w, _box_h, _x, _y, _v_align, _h_align,          \
+                                         _font, _format, _color, _bg_color)                                                      \
+  (grid_composer_widget_config) {                                                                                                \
+    .type = (_type), .cell_row = (_row), .cell_col = (_col),                                                                     \
+    .box = {.x = (_box_x), .y = (_box_y), .w = (_box_w), .h = (_box_h)}, .color = (_color), .bg_color = (_bg_color), .text = {   \
+      .x = (_x),                                                                                                                 \
+      .y = (_y),                                                                                                                 \
+      .v_align = (_v_align),                                                                                                     \
+      .h_align = (_h_align),                                                                                                     \
+      .font = (_font),                                                                                                           \
+      .format = (_format),                                                                                                       \
+    }                                                                                                                            \
+  }
+
 #define GRID_COMPOSER_CLEAR_DESCRIPTOR(_row, _col)                                                                               \
   (grid_composer_draw_descriptor) {                                                                                              \
     .cell_row = (_row), .cell_col = (_col), .draw_obj = {                                                                        \
@@ -118,13 +132,24 @@ extern "C" {
     }                                                                                                                            \
   }
 
+typedef struct grid_composer_widget *grid_composer_widget_handle;
+
 typedef enum {
   GRID_COMPOSER_CONTENT_INVALID = -1,
   GRID_COMPOSER_CONTENT_TEXT,
   GRID_COMPOSER_CONTENT_FIGURE,
   GRID_COMPOSER_CONTENT_CLEAR,
+  GRID_COMPOSER_CONTENT_WIDGET, // queued by the widget layer, not meant to be sent by hand
 } grid_composer_content_type;
 
+typedef enum {
+  GRID_COMPOSER_WIDGET_INVALID = -1,
+  GRID_COMPOSER_WIDGET_LABEL,     // static text, changed with grid_composer_widget_set_text
+  GRID_COMPOSER_WIDGET_VALUE,     // number formatted by the composer
+  GRID_COMPOSER_WIDGET_BAR,       // horizontal bar filled between min and max
+  GRID_COMPOSER_WIDGET_SPARKLINE, // the last N values as a polyline
+} grid_composer_widget_type;
+
 typedef enum {
   GRID_COMPOSER_FIGURE_INVALID = -1,
   GRID_COMPOSER_FIGURE_RECT,
@@ -208,6 +233,7 @@ typedef struct {
   union {
     grid_composer_figure_info figure;
     grid_composer_text_info text;
+    grid_composer_widget_handle widget;
   };
 } grid_composer_draw_obj_info;
 
@@ -220,6 +246,55 @@ typedef struct {
   grid_composer_draw_obj_info draw_obj;
 } grid_composer_draw_descriptor;
 
+typedef struct {
+  uint8_t draws;         // descriptors drawn in the frame
+  uint8_t cell_switches; // times the target cell changed, descriptors are grouped by cell to keep it low
+
+  uint8_t widgets_drawn;
+  uint8_t widgets_skipped; // updated, but the formatted value did not change
+} grid_composer_frame_stats;
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+} grid_composer_rect;
+
+/**
+ * A widget owns the box of its cell, the box is cleared before every redraw
+ */
+typedef struct {
+  grid_composer_widget_type type;
+  int8_t cell_row;
+  int8_t cell_col;
+  grid_composer_rect box;
+  uint16_t color;
+  uint16_t bg_color;
+
+  union {
+    struct {
+      int16_t x;
+      int16_t y;
+      grid_composer_v_align v_align;
+      grid_composer_h_align h_align;
+      const uint8_t *font;
+      const char *format; // label: initial text, value: printf format taking one double
+    } text;
+
+    struct {
+      float min;
+      float max;
+    } bar;
+
+    struct {
+      float min; // min == max scales to the samples in view
+      float max;
+      uint8_t points;
+    } sparkline;
+  };
+} grid_composer_widget_config;
+
 #ifdef __cplusplus
 }
 #endif
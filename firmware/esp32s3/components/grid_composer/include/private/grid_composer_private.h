@@ -17,6 +17,11 @@ extern "C" {
 #define GRID_COMPOSER_CELL_MAX_ROWS 2U
 #define GRID_COMPOSER_CELL_MAX_COLS 3U
 
+#define GRID_COMPOSER_WIDGET_MAX_COUNT            24U
+#define GRID_COMPOSER_WIDGET_TEXT_MAX_LEN         32U
+#define GRID_COMPOSER_WIDGET_SPARKLINE_MAX_POINTS 64U
+#define GRID_COMPOSER_WIDGET_QUEUE_TIMEOUT_MS     100U
+
 #ifdef __cplusplus
 }
 #endif
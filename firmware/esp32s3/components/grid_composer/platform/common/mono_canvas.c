@@ -0,0 +1,489 @@
+#include <string.h>
+
+#include "mono_canvas.h"
+
+#define SWAP_INT16(_a, _b)                                                                                                       \
+  do {                                                                                                                           \
+    int16_t _t = (_a);                                                                                                           \
+    (_a) = (_b);                                                                                                                 \
+    (_b) = _t;                                                                                                                   \
+  } while (0)
+
+static inline void
+mark_dirty(mono_canvas *canvas, uint8_t page, int16_t x0, int16_t x1);
+
+static inline void
+apply_mask(uint8_t *byte, uint8_t mask, uint16_t color);
+
+static void
+draw_circle_helper(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint8_t corners, uint16_t color);
+static void
+fill_circle_helper(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color);
+
+bool
+mono_canvas_init(mono_canvas *canvas, uint16_t width, uint16_t height, uint8_t *buffer) {
+  if (!canvas || !buffer || !width || !height)
+    return false;
+
+  uint8_t pages = (height + MONO_CANVAS_PAGE_HEIGHT - 1U) / MONO_CANVAS_PAGE_HEIGHT;
+  if (pages > MONO_CANVAS_MAX_PAGES)
+    return false;
+
+  canvas->width = width;
+  canvas->height = height;
+  canvas->pages = pages;
+  canvas->buffer = buffer;
+
+  memset(canvas->buffer, 0, MONO_CANVAS_BUFFER_SIZE(width, height));
+  mono_canvas_mark_dirty(canvas);
+  return true;
+}
+bool
+mono_canvas_wrap(mono_canvas *canvas, uint16_t width, uint16_t height, uint8_t *buffer) {
+  if (!canvas || !buffer || !width || !height)
+    return false;
+
+  uint8_t pages = (height + MONO_CANVAS_PAGE_HEIGHT - 1U) / MONO_CANVAS_PAGE_HEIGHT;
+  if (pages > MONO_CANVAS_MAX_PAGES)
+    return false;
+
+  canvas->width = width;
+  canvas->height = height;
+  canvas->pages = pages;
+  canvas->buffer = buffer;
+
+  mono_canvas_mark_clean(canvas);
+  return true;
+}
+
+void
+mono_canvas_fill(mono_canvas *canvas, uint16_t color) {
+  size_t size = MONO_CANVAS_BUFFER_SIZE(canvas->width, canvas->height);
+  if (color == MONO_CANVAS_COLOR_INVERSE) {
+    for (size_t i = 0; i < size; ++i) {
+      canvas->buffer[i] ^= 0xFFU;
+    }
+  } else {
+    memset(canvas->buffer, color ? 0xFFU : 0x00U, size);
+  }
+  mono_canvas_mark_dirty(canvas);
+}
+
+void
+mono_canvas_mark_clean(mono_canvas *canvas) {
+  for (uint8_t p = 0; p < MONO_CANVAS_MAX_PAGES; ++p) {
+    canvas->dirty[p].x0 = INT16_MAX;
+    canvas->dirty[p].x1 = -1;
+  }
+}
+void
+mono_canvas_mark_dirty(mono_canvas *canvas) {
+  mono_canvas_mark_clean(canvas);
+  for (uint8_t p = 0; p < canvas->pages; ++p) {
+    canvas->dirty[p].x0 = 0;
+    canvas->dirty[p].x1 = (int16_t)(canvas->width - 1U);
+  }
+}
+void
+mono_canvas_mark_dirty_span(mono_canvas *canvas, uint8_t page, int16_t x0, int16_t x1) {
+  if (page >= canvas->pages || x1 < x0)
+    return;
+
+  mark_dirty(canvas, page, x0 < 0 ? 0 : x0, x1 >= canvas->width ? (int16_t)(canvas->width - 1U) : x1);
+}
+bool
+mono_canvas_is_dirty(const mono_canvas *canvas) {
+  for (uint8_t p = 0; p < canvas->pages; ++p) {
+    if (canvas->dirty[p].x1 >= canvas->dirty[p].x0)
+      return true;
+  }
+  return false;
+}
+bool
+mono_canvas_page_dirty_span(const mono_canvas *canvas, uint8_t page, int16_t *out_x0, int16_t *out_x1) {
+  if (page >= canvas->pages || canvas->dirty[page].x1 < canvas->dirty[page].x0)
+    return false;
+
+  *out_x0 = canvas->dirty[page].x0;
+  *out_x1 = canvas->dirty[page].x1;
+  return true;
+}
+
+void
+mono_canvas_draw_pixel(mono_canvas *canvas, int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= canvas->width || y >= canvas->height)
+    return;
+
+  uint8_t page = (uint8_t)(y / MONO_CANVAS_PAGE_HEIGHT);
+  apply_mask(&canvas->buffer[page * canvas->width + x], (uint8_t)(1U << (y & 7)), color);
+  mark_dirty(canvas, page, x, x);
+}
+void
+mono_canvas_draw_hline(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, uint16_t color) {
+  mono_canvas_fill_rect(canvas, x, y, w, 1, color);
+}
+void
+mono_canvas_draw_vline(mono_canvas *canvas, int16_t x, int16_t y, int16_t h, uint16_t color) {
+  mono_canvas_fill_rect(canvas, x, y, 1, h, color);
+}
+void
+mono_canvas_draw_line(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+  if (x0 == x1) {
+    if (y0 > y1)
+      SWAP_INT16(y0, y1);
+    mono_canvas_draw_vline(canvas, x0, y0, y1 - y0 + 1, color);
+    return;
+  }
+  if (y0 == y1) {
+    if (x0 > x1)
+      SWAP_INT16(x0, x1);
+    mono_canvas_draw_hline(canvas, x0, y0, x1 - x0 + 1, color);
+    return;
+  }
+
+  bool steep = (y1 > y0 ? y1 - y0 : y0 - y1) > (x1 > x0 ? x1 - x0 : x0 - x1);
+  if (steep) {
+    SWAP_INT16(x0, y0);
+    SWAP_INT16(x1, y1);
+  }
+  if (x0 > x1) {
+    SWAP_INT16(x0, x1);
+    SWAP_INT16(y0, y1);
+  }
+
+  int16_t dx = x1 - x0;
+  int16_t dy = (y1 > y0) ? y1 - y0 : y0 - y1;
+  int16_t err = dx / 2;
+  int16_t ystep = (y0 < y1) ? 1 : -1;
+
+  for (; x0 <= x1; ++x0) {
+    if (steep) {
+      mono_canvas_draw_pixel(canvas, y0, x0, color);
+    } else {
+      mono_canvas_draw_pixel(canvas, x0, y0, color);
+    }
+    err -= dy;
+    if (err < 0) {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+void
+mono_canvas_draw_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (w <= 0 || h <= 0)
+    return;
+
+  mono_canvas_draw_hline(canvas, x, y, w, color);
+  if (h > 1)
+    mono_canvas_draw_hline(canvas, x, y + h - 1, w, color);
+  if (h > 2) {
+    mono_canvas_draw_vline(canvas, x, y + 1, h - 2, color);
+    if (w > 1)
+      mono_canvas_draw_vline(canvas, x + w - 1, y + 1, h - 2, color);
+  }
+}
+/**
+ * Works page by page with byte masks instead of pixel by pixel, clears and bars are the most frequent fills.
+ */
+void
+mono_canvas_fill_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (w <= 0 || h <= 0)
+    return;
+
+  int16_t x_end = x + w;
+  int16_t y_end = y + h;
+  if (x < 0)
+    x = 0;
+  if (y < 0)
+    y = 0;
+  if (x_end > (int16_t)canvas->width)
+    x_end = (int16_t)canvas->width;
+  if (y_end > (int16_t)canvas->height)
+    y_end = (int16_t)canvas->height;
+  if (x >= x_end || y >= y_end)
+    return;
+
+  uint8_t first_page = (uint8_t)(y / MONO_CANVAS_PAGE_HEIGHT);
+  uint8_t last_page = (uint8_t)((y_end - 1) / MONO_CANVAS_PAGE_HEIGHT);
+
+  for (uint8_t page = first_page; page <= last_page; ++page) {
+    int16_t page_y0 = (int16_t)(page * MONO_CANVAS_PAGE_HEIGHT);
+    uint8_t top = (y > page_y0) ? (uint8_t)(y - page_y0) : 0U;
+    uint8_t bottom = (y_end < page_y0 + (int16_t)MONO_CANVAS_PAGE_HEIGHT) ? (uint8_t)(y_end - page_y0) : 8U;
+    uint8_t mask = (uint8_t)((0xFFU << top) & (0xFFU >> (8U - bottom)));
+
+    uint8_t *row = &canvas->buffer[page * canvas->width];
+    for (int16_t cx = x; cx < x_end; ++cx) {
+      apply_mask(&row[cx], mask, color);
+    }
+    mark_dirty(canvas, page, x, x_end - 1);
+  }
+}
+void
+mono_canvas_draw_round_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+  int16_t max_radius = ((w < h) ? w : h) / 2;
+  if (r > max_radius)
+    r = max_radius;
+
+  mono_canvas_draw_hline(canvas, x + r, y, w - 2 * r, color);
+  mono_canvas_draw_hline(canvas, x + r, y + h - 1, w - 2 * r, color);
+  mono_canvas_draw_vline(canvas, x, y + r, h - 2 * r, color);
+  mono_canvas_draw_vline(canvas, x + w - 1, y + r, h - 2 * r, color);
+
+  draw_circle_helper(canvas, x + r, y + r, r, 1U, color);
+  draw_circle_helper(canvas, x + w - r - 1, y + r, r, 2U, color);
+  draw_circle_helper(canvas, x + w - r - 1, y + h - r - 1, r, 4U, color);
+  draw_circle_helper(canvas, x + r, y + h - r - 1, r, 8U, color);
+}
+void
+mono_canvas_fill_round_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+  int16_t max_radius = ((w < h) ? w : h) / 2;
+  if (r > max_radius)
+    r = max_radius;
+
+  mono_canvas_fill_rect(canvas, x + r, y, w - 2 * r, h, color);
+  fill_circle_helper(canvas, x + w - r - 1, y + r, r, 1U, h - 2 * r - 1, color);
+  fill_circle_helper(canvas, x + r, y + r, r, 2U, h - 2 * r - 1, color);
+}
+void
+mono_canvas_draw_circle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+  int16_t f = 1 - r;
+  int16_t ddf_x = 1;
+  int16_t ddf_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+
+  mono_canvas_draw_pixel(canvas, x0, y0 + r, color);
+  mono_canvas_draw_pixel(canvas, x0, y0 - r, color);
+  mono_canvas_draw_pixel(canvas, x0 + r, y0, color);
+  mono_canvas_draw_pixel(canvas, x0 - r, y0, color);
+
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddf_y += 2;
+      f += ddf_y;
+    }
+    x++;
+    ddf_x += 2;
+    f += ddf_x;
+
+    mono_canvas_draw_pixel(canvas, x0 + x, y0 + y, color);
+    mono_canvas_draw_pixel(canvas, x0 - x, y0 + y, color);
+    mono_canvas_draw_pixel(canvas, x0 + x, y0 - y, color);
+    mono_canvas_draw_pixel(canvas, x0 - x, y0 - y, color);
+    mono_canvas_draw_pixel(canvas, x0 + y, y0 + x, color);
+    mono_canvas_draw_pixel(canvas, x0 - y, y0 + x, color);
+    mono_canvas_draw_pixel(canvas, x0 + y, y0 - x, color);
+    mono_canvas_draw_pixel(canvas, x0 - y, y0 - x, color);
+  }
+}
+void
+mono_canvas_fill_circle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+  mono_canvas_draw_vline(canvas, x0, y0 - r, 2 * r + 1, color);
+  fill_circle_helper(canvas, x0, y0, r, 3U, 0, color);
+}
+void
+mono_canvas_draw_triangle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                          uint16_t color) {
+  mono_canvas_draw_line(canvas, x0, y0, x1, y1, color);
+  mono_canvas_draw_line(canvas, x1, y1, x2, y2, color);
+  mono_canvas_draw_line(canvas, x2, y2, x0, y0, color);
+}
+void
+mono_canvas_fill_triangle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                          uint16_t color) {
+  if (y0 > y1) {
+    SWAP_INT16(y0, y1);
+    SWAP_INT16(x0, x1);
+  }
+  if (y1 > y2) {
+    SWAP_INT16(y2, y1);
+    SWAP_INT16(x2, x1);
+  }
+  if (y0 > y1) {
+    SWAP_INT16(y0, y1);
+    SWAP_INT16(x0, x1);
+  }
+
+  if (y0 == y2) {
+    int16_t a = x0;
+    int16_t b = x0;
+    if (x1 < a)
+      a = x1;
+    else if (x1 > b)
+      b = x1;
+    if (x2 < a)
+      a = x2;
+    else if (x2 > b)
+      b = x2;
+    mono_canvas_draw_hline(canvas, a, y0, b - a + 1, color);
+    return;
+  }
+
+  int32_t dx01 = x1 - x0, dy01 = y1 - y0;
+  int32_t dx02 = x2 - x0, dy02 = y2 - y0;
+  int32_t dx12 = x2 - x1, dy12 = y2 - y1;
+  int32_t sa = 0, sb = 0;
+
+  int16_t last = (y1 == y2) ? y1 : y1 - 1;
+  int16_t y = y0;
+
+  for (; y <= last; ++y) {
+    int16_t a = x0 + sa / dy01;
+    int16_t b = x0 + sb / dy02;
+    sa += dx01;
+    sb += dx02;
+    if (a > b)
+      SWAP_INT16(a, b);
+    mono_canvas_draw_hline(canvas, a, y, b - a + 1, color);
+  }
+
+  sa = dx12 * (y - y1);
+  sb = dx02 * (y - y0);
+  for (; y <= y2; ++y) {
+    int16_t a = x1 + sa / dy12;
+    int16_t b = x0 + sb / dy02;
+    sa += dx12;
+    sb += dx02;
+    if (a > b)
+      SWAP_INT16(a, b);
+    mono_canvas_draw_hline(canvas, a, y, b - a + 1, color);
+  }
+}
+
+static inline void
+mark_dirty(mono_canvas *canvas, uint8_t page, int16_t x0, int16_t x1) {
+  if (x0 < canvas->dirty[page].x0)
+    canvas->dirty[page].x0 = x0;
+  if (x1 > canvas->dirty[page].x1)
+    canvas->dirty[page].x1 = x1;
+}
+
+static inline void
+apply_mask(uint8_t *byte, uint8_t mask, uint16_t color) {
+  switch (color) {
+  case MONO_CANVAS_COLOR_BLACK:
+    *byte &= (uint8_t)~mask;
+    break;
+  case MONO_CANVAS_COLOR_INVERSE:
+    *byte ^= mask;
+    break;
+  default:
+    *byte |= mask;
+    break;
+  }
+}
+
+void
+mono_canvas_blit(mono_canvas *canvas, int16_t x, int16_t y, uint16_t w, uint16_t h, const uint8_t *bitmap, uint16_t color) {
+  int16_t x0 = (x < 0) ? 0 : x;
+  int16_t x1 = ((int32_t)x + w > (int32_t)canvas->width) ? (int16_t)(canvas->width - 1U) : (int16_t)(x + w - 1);
+  if (x0 > x1 || !h)
+    return;
+
+  uint8_t src_pages = (uint8_t)((h + MONO_CANVAS_PAGE_HEIGHT - 1U) / MONO_CANVAS_PAGE_HEIGHT);
+  uint8_t last_page_mask = (canvas->height & 7U) ? (uint8_t)(0xFFU >> (8U - (canvas->height & 7U))) : 0xFFU;
+
+  for (uint8_t sp = 0; sp < src_pages; ++sp) {
+    // Arithmetic floor so glyphs hanging above the top edge still land on the right page
+    int16_t dst_y = (int16_t)(y + sp * MONO_CANVAS_PAGE_HEIGHT);
+    int16_t dst_page = (int16_t)((dst_y >= 0) ? dst_y / 8 : -((7 - dst_y) / 8));
+    uint8_t shift = (uint8_t)(dst_y - dst_page * 8);
+    bool lo_visible = dst_page >= 0 && dst_page < canvas->pages;
+    bool hi_visible = shift && dst_page + 1 >= 0 && dst_page + 1 < canvas->pages;
+    if (!lo_visible && !hi_visible)
+      continue;
+
+    uint8_t lo_mask = (dst_page == canvas->pages - 1) ? last_page_mask : 0xFFU;
+    uint8_t hi_mask = (dst_page + 1 == canvas->pages - 1) ? last_page_mask : 0xFFU;
+    const uint8_t *src = &bitmap[(size_t)sp * w + (x0 - x)];
+    for (int16_t cx = x0; cx <= x1; ++cx, ++src) {
+      if (!*src)
+        continue;
+      if (lo_visible)
+        apply_mask(&canvas->buffer[dst_page * canvas->width + cx], (uint8_t)(*src << shift) & lo_mask, color);
+      if (hi_visible)
+        apply_mask(&canvas->buffer[(dst_page + 1) * canvas->width + cx], (uint8_t)(*src >> (8U - shift)) & hi_mask, color);
+    }
+    if (lo_visible)
+      mark_dirty(canvas, (uint8_t)dst_page, x0, x1);
+    if (hi_visible)
+      mark_dirty(canvas, (uint8_t)(dst_page + 1), x0, x1);
+  }
+}
+
+static void
+draw_circle_helper(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint8_t corners, uint16_t color) {
+  int16_t f = 1 - r;
+  int16_t ddf_x = 1;
+  int16_t ddf_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddf_y += 2;
+      f += ddf_y;
+    }
+    x++;
+    ddf_x += 2;
+    f += ddf_x;
+    if (corners & 0x4U) {
+      mono_canvas_draw_pixel(canvas, x0 + x, y0 + y, color);
+      mono_canvas_draw_pixel(canvas, x0 + y, y0 + x, color);
+    }
+    if (corners & 0x2U) {
+      mono_canvas_draw_pixel(canvas, x0 + x, y0 - y, color);
+      mono_canvas_draw_pixel(canvas, x0 + y, y0 - x, color);
+    }
+    if (corners & 0x8U) {
+      mono_canvas_draw_pixel(canvas, x0 - y, y0 + x, color);
+      mono_canvas_draw_pixel(canvas, x0 - x, y0 + y, color);
+    }
+    if (corners & 0x1U) {
+      mono_canvas_draw_pixel(canvas, x0 - y, y0 - x, color);
+      mono_canvas_draw_pixel(canvas, x0 - x, y0 - y, color);
+    }
+  }
+}
+static void
+fill_circle_helper(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color) {
+  int16_t f = 1 - r;
+  int16_t ddf_x = 1;
+  int16_t ddf_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  int16_t px = x;
+  int16_t py = y;
+
+  delta++;
+
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddf_y += 2;
+      f += ddf_y;
+    }
+    x++;
+    ddf_x += 2;
+    f += ddf_x;
+    if (x < (y + 1)) {
+      if (corners & 1U)
+        mono_canvas_draw_vline(canvas, x0 + x, y0 - y, 2 * y + delta, color);
+      if (corners & 2U)
+        mono_canvas_draw_vline(canvas, x0 - x, y0 - y, 2 * y + delta, color);
+    }
+    if (y != py) {
+      if (corners & 1U)
+        mono_canvas_draw_vline(canvas, x0 + py, y0 - px, 2 * px + delta, color);
+      if (corners & 2U)
+        mono_canvas_draw_vline(canvas, x0 - py, y0 - px, 2 * px + delta, color);
+      py = y;
+    }
+    px = x;
+  }
+}
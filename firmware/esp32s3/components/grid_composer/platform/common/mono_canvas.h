@@ -0,0 +1,107 @@
+#pragma once
+#ifndef MONO_CANVAS_H
+#define MONO_CANVAS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MONO_CANVAS_PAGE_HEIGHT 8U
+#define MONO_CANVAS_MAX_PAGES   8U
+
+#define MONO_CANVAS_COLOR_BLACK   0U
+#define MONO_CANVAS_COLOR_WHITE   1U
+#define MONO_CANVAS_COLOR_INVERSE 2U
+
+#define MONO_CANVAS_BUFFER_SIZE(_w, _h) ((size_t)(_w) * (((_h) + MONO_CANVAS_PAGE_HEIGHT - 1U) / MONO_CANVAS_PAGE_HEIGHT))
+
+/**
+ * 1-bpp canvas laid out like SH1106/SSD1306 GDDRAM: every byte holds 8 vertical pixels of a page (LSB on top),
+ * so a page can be pushed to a panel without conversion. Columns touched since the last mono_canvas_mark_clean()
+ * are tracked per page.
+ */
+typedef struct {
+  uint16_t width;
+  uint16_t height;
+  uint8_t pages;
+  uint8_t *buffer;
+
+  struct {
+    int16_t x0;
+    int16_t x1;
+  } dirty[MONO_CANVAS_MAX_PAGES];
+} mono_canvas;
+
+bool
+mono_canvas_init(mono_canvas *canvas, uint16_t width, uint16_t height, uint8_t *buffer);
+/**
+ * Like mono_canvas_init but keeps the buffer content and starts clean, for drawing into a buffer owned by someone else
+ * (e.g. Adafruit_GrayOLED::getBuffer())
+ */
+bool
+mono_canvas_wrap(mono_canvas *canvas, uint16_t width, uint16_t height, uint8_t *buffer);
+
+void
+mono_canvas_fill(mono_canvas *canvas, uint16_t color);
+
+void
+mono_canvas_mark_clean(mono_canvas *canvas);
+void
+mono_canvas_mark_dirty(mono_canvas *canvas);
+/**
+ * Adds an inclusive column span of a page, e.g. to hand back what a failed transfer took
+ */
+void
+mono_canvas_mark_dirty_span(mono_canvas *canvas, uint8_t page, int16_t x0, int16_t x1);
+bool
+mono_canvas_is_dirty(const mono_canvas *canvas);
+/**
+ * @return false if the page has not been touched, otherwise its inclusive column span
+ */
+bool
+mono_canvas_page_dirty_span(const mono_canvas *canvas, uint8_t page, int16_t *out_x0, int16_t *out_x1);
+
+void
+mono_canvas_draw_pixel(mono_canvas *canvas, int16_t x, int16_t y, uint16_t color);
+void
+mono_canvas_draw_hline(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, uint16_t color);
+void
+mono_canvas_draw_vline(mono_canvas *canvas, int16_t x, int16_t y, int16_t h, uint16_t color);
+void
+mono_canvas_draw_line(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+void
+mono_canvas_draw_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void
+mono_canvas_fill_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void
+mono_canvas_draw_round_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+void
+mono_canvas_fill_round_rect(mono_canvas *canvas, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+void
+mono_canvas_draw_circle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint16_t color);
+void
+mono_canvas_fill_circle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t r, uint16_t color);
+/**
+ * Copies a bitmap in canvas layout (w bytes per page, LSB on top) to (x, y). Set bits are painted with color,
+ * clear bits leave the canvas untouched.
+ */
+void
+mono_canvas_blit(mono_canvas *canvas, int16_t x, int16_t y, uint16_t w, uint16_t h, const uint8_t *bitmap, uint16_t color);
+
+void
+mono_canvas_draw_triangle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                          uint16_t color);
+void
+mono_canvas_fill_triangle(mono_canvas *canvas, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                          uint16_t color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
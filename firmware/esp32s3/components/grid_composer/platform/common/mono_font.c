@@ -0,0 +1,252 @@
+#include <stddef.h>
+
+#include "mono_font.h"
+
+#define U8G2_FONT_HEADER_SIZE 23U
+#define MONO_FONT_NO_COLOR    0xFFFFU
+
+typedef struct {
+  const uint8_t *ptr;
+  uint8_t bit_pos;
+} bit_reader;
+
+static inline uint8_t
+read_unsigned(bit_reader *reader, uint8_t cnt);
+static inline int8_t
+read_signed(bit_reader *reader, uint8_t cnt);
+
+static inline uint16_t
+read_word(const uint8_t *ptr);
+
+static void
+draw_run(mono_canvas *canvas, const mono_font_glyph *glyph, int16_t x, int16_t y, uint16_t *px, uint16_t *py, uint16_t len,
+         uint16_t color);
+
+bool
+mono_font_load(mono_font_info *info, const uint8_t *font) {
+  if (!info || !font)
+    return false;
+
+  info->font = font;
+
+  info->glyph_cnt = font[0];
+  info->bbx_mode = font[1];
+  info->bits_per_0 = font[2];
+  info->bits_per_1 = font[3];
+  info->bits_per_char_width = font[4];
+  info->bits_per_char_height = font[5];
+  info->bits_per_char_x = font[6];
+  info->bits_per_char_y = font[7];
+  info->bits_per_delta_x = font[8];
+
+  info->max_char_width = (int8_t)font[9];
+  info->max_char_height = (int8_t)font[10];
+  info->x_offset = (int8_t)font[11];
+  info->y_offset = (int8_t)font[12];
+
+  info->ascent_A = (int8_t)font[13];
+  info->descent_g = (int8_t)font[14];
+  info->ascent_para = (int8_t)font[15];
+  info->descent_para = (int8_t)font[16];
+
+  info->start_pos_upper_A = read_word(&font[17]);
+  info->start_pos_lower_a = read_word(&font[19]);
+  info->start_pos_unicode = read_word(&font[21]);
+
+  return true;
+}
+
+bool
+mono_font_get_glyph(const mono_font_info *info, uint16_t encoding, mono_font_glyph *out_glyph) {
+  const uint8_t *ptr = info->font + U8G2_FONT_HEADER_SIZE;
+  const uint8_t *glyph_data = NULL;
+
+  if (encoding <= 0xFFU) {
+    if (encoding >= 'a') {
+      ptr += info->start_pos_lower_a;
+    } else if (encoding >= 'A') {
+      ptr += info->start_pos_upper_A;
+    }
+
+    for (;;) {
+      if (ptr[1] == 0U)
+        break;
+      if (ptr[0] == encoding) {
+        glyph_data = ptr + 2;
+        break;
+      }
+      ptr += ptr[1];
+    }
+  } else {
+    ptr += info->start_pos_unicode;
+    const uint8_t *lookup = ptr;
+    uint16_t e = 0;
+
+    do {
+      ptr += read_word(lookup);
+      e = read_word(lookup + 2);
+      lookup += 4;
+    } while (e < encoding);
+
+    for (;;) {
+      e = read_word(ptr);
+      if (e == 0U)
+        break;
+      if (e == encoding) {
+        glyph_data = ptr + 3;
+        break;
+      }
+      ptr += ptr[2];
+    }
+  }
+
+  if (!glyph_data)
+    return false;
+
+  bit_reader reader = {.ptr = glyph_data, .bit_pos = 0};
+  out_glyph->width = read_unsigned(&reader, info->bits_per_char_width);
+  out_glyph->height = read_unsigned(&reader, info->bits_per_char_height);
+  out_glyph->x_offset = read_signed(&reader, info->bits_per_char_x);
+  out_glyph->y_offset = read_signed(&reader, info->bits_per_char_y);
+  out_glyph->delta_x = read_signed(&reader, info->bits_per_delta_x);
+  out_glyph->data = reader.ptr;
+  out_glyph->bit_pos = reader.bit_pos;
+  out_glyph->bits_per_0 = info->bits_per_0;
+  out_glyph->bits_per_1 = info->bits_per_1;
+  return true;
+}
+
+uint16_t
+mono_font_utf8_next(const char **str) {
+  const uint8_t *s = (const uint8_t *)*str;
+  uint8_t c = s[0];
+
+  if (c == 0U)
+    return 0U;
+
+  if (c < 0x80U) {
+    *str += 1;
+    return c;
+  }
+  if ((c & 0xE0U) == 0xC0U && (s[1] & 0xC0U) == 0x80U) {
+    *str += 2;
+    return (uint16_t)(((c & 0x1FU) << 6) | (s[1] & 0x3FU));
+  }
+  if ((c & 0xF0U) == 0xE0U && (s[1] & 0xC0U) == 0x80U && (s[2] & 0xC0U) == 0x80U) {
+    *str += 3;
+    return (uint16_t)(((c & 0x0FU) << 12) | ((s[1] & 0x3FU) << 6) | (s[2] & 0x3FU));
+  }
+
+  *str += 1;
+  return MONO_FONT_INVALID_ENCODING;
+}
+
+int16_t
+mono_font_draw_glyph(mono_canvas *canvas, const mono_font_glyph *glyph, int16_t x, int16_t y, uint16_t color, bool solid) {
+  if (glyph->width == 0U)
+    return glyph->delta_x;
+
+  uint16_t bg_color = solid ? (color ? MONO_CANVAS_COLOR_BLACK : MONO_CANVAS_COLOR_WHITE) : MONO_FONT_NO_COLOR;
+  int16_t x0 = x + glyph->x_offset;
+  int16_t y0 = y - (glyph->height + glyph->y_offset);
+
+  bit_reader reader = {.ptr = glyph->data, .bit_pos = glyph->bit_pos};
+  uint16_t px = 0;
+  uint16_t py = 0;
+
+  for (;;) {
+    uint8_t a = read_unsigned(&reader, glyph->bits_per_0);
+    uint8_t b = read_unsigned(&reader, glyph->bits_per_1);
+    do {
+      draw_run(canvas, glyph, x0, y0, &px, &py, a, bg_color);
+      draw_run(canvas, glyph, x0, y0, &px, &py, b, color);
+    } while (read_unsigned(&reader, 1U) != 0U);
+
+    if (py >= glyph->height)
+      break;
+  }
+
+  return glyph->delta_x;
+}
+
+int16_t
+mono_font_draw_utf8(mono_canvas *canvas, const mono_font_info *info, int16_t x, int16_t y, const char *text, uint16_t color,
+                    bool solid) {
+  int16_t start_x = x;
+  uint16_t encoding = 0;
+  mono_font_glyph glyph;
+
+  while ((encoding = mono_font_utf8_next(&text)) != 0U) {
+    if (encoding == MONO_FONT_INVALID_ENCODING)
+      continue;
+    if (!mono_font_get_glyph(info, encoding, &glyph))
+      continue;
+    x += mono_font_draw_glyph(canvas, &glyph, x, y, color, solid);
+  }
+  return x - start_x;
+}
+
+int16_t
+mono_font_utf8_width(const mono_font_info *info, const char *text) {
+  int16_t width = 0;
+  uint16_t encoding = 0;
+  mono_font_glyph glyph;
+
+  while ((encoding = mono_font_utf8_next(&text)) != 0U) {
+    if (encoding == MONO_FONT_INVALID_ENCODING)
+      continue;
+    if (mono_font_get_glyph(info, encoding, &glyph))
+      width += glyph.delta_x;
+  }
+  return width;
+}
+
+static inline uint8_t
+read_unsigned(bit_reader *reader, uint8_t cnt) {
+  uint8_t bit_pos = reader->bit_pos;
+  uint16_t val = (uint16_t)(*reader->ptr >> bit_pos);
+  uint8_t bit_pos_plus_cnt = bit_pos + cnt;
+
+  if (bit_pos_plus_cnt >= 8U) {
+    reader->ptr++;
+    val |= (uint16_t)(*reader->ptr) << (8U - bit_pos);
+    bit_pos_plus_cnt -= 8U;
+  }
+  reader->bit_pos = bit_pos_plus_cnt;
+  return (uint8_t)(val & ((1U << cnt) - 1U));
+}
+static inline int8_t
+read_signed(bit_reader *reader, uint8_t cnt) {
+  int16_t val = (int16_t)read_unsigned(reader, cnt);
+  return (int8_t)(val - (int16_t)(1 << (cnt - 1U)));
+}
+
+static inline uint16_t
+read_word(const uint8_t *ptr) {
+  return (uint16_t)(((uint16_t)ptr[0] << 8) | ptr[1]);
+}
+
+static void
+draw_run(mono_canvas *canvas, const mono_font_glyph *glyph, int16_t x, int16_t y, uint16_t *px, uint16_t *py, uint16_t len,
+         uint16_t color) {
+  uint16_t lx = *px;
+  uint16_t ly = *py;
+
+  for (;;) {
+    uint16_t rem = glyph->width - lx;
+    uint16_t current = (len < rem) ? len : rem;
+
+    if (current && color != MONO_FONT_NO_COLOR)
+      mono_canvas_draw_hline(canvas, x + (int16_t)lx, y + (int16_t)ly, (int16_t)current, color);
+
+    if (len < rem)
+      break;
+    len -= rem;
+    lx = 0;
+    ly++;
+  }
+  lx += len;
+
+  *px = lx;
+  *py = ly;
+}
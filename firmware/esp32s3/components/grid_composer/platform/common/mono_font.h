@@ -0,0 +1,95 @@
+#pragma once
+#ifndef MONO_FONT_H
+#define MONO_FONT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mono_canvas.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MONO_FONT_INVALID_ENCODING 0xFFFFU
+
+/**
+ * Header of a U8g2 font (the `u8g2_font_*` arrays), decoded once so glyphs can be looked up without U8g2.
+ */
+typedef struct {
+  const uint8_t *font;
+
+  uint8_t glyph_cnt;
+  uint8_t bbx_mode;
+  uint8_t bits_per_0;
+  uint8_t bits_per_1;
+  uint8_t bits_per_char_width;
+  uint8_t bits_per_char_height;
+  uint8_t bits_per_char_x;
+  uint8_t bits_per_char_y;
+  uint8_t bits_per_delta_x;
+
+  int8_t max_char_width;
+  int8_t max_char_height;
+  int8_t x_offset;
+  int8_t y_offset;
+
+  int8_t ascent_A;
+  int8_t descent_g;
+  int8_t ascent_para;
+  int8_t descent_para;
+
+  uint16_t start_pos_upper_A;
+  uint16_t start_pos_lower_a;
+  uint16_t start_pos_unicode;
+} mono_font_info;
+
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+  int8_t x_offset;
+  int8_t y_offset;
+  int8_t delta_x;
+
+  /* RLE bitmap stream, positioned right after the glyph metrics */
+  const uint8_t *data;
+  uint8_t bit_pos;
+  uint8_t bits_per_0;
+  uint8_t bits_per_1;
+} mono_font_glyph;
+
+bool
+mono_font_load(mono_font_info *info, const uint8_t *font);
+
+bool
+mono_font_get_glyph(const mono_font_info *info, uint16_t encoding, mono_font_glyph *out_glyph);
+
+/**
+ * Decodes the next UTF-8 code point and advances *str. Returns 0 at the end of the string and
+ * MONO_FONT_INVALID_ENCODING for malformed or unsupported sequences.
+ */
+uint16_t
+mono_font_utf8_next(const char **str);
+
+/**
+ * Draws a glyph with its baseline origin at (x, y). With solid set, background bits of the glyph box are painted with
+ * the inverted color. Returns the horizontal advance.
+ */
+int16_t
+mono_font_draw_glyph(mono_canvas *canvas, const mono_font_glyph *glyph, int16_t x, int16_t y, uint16_t color, bool solid);
+
+int16_t
+mono_font_draw_utf8(mono_canvas *canvas, const mono_font_info *info, int16_t x, int16_t y, const char *text, uint16_t color,
+                    bool solid);
+
+/**
+ * Sum of glyph advances, same as U8g2's getUTF8Width()
+ */
+int16_t
+mono_font_utf8_width(const mono_font_info *info, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
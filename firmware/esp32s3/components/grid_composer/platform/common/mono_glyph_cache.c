@@ -0,0 +1,179 @@
+#include <string.h>
+
+#include "mono_glyph_cache.h"
+
+static inline uint32_t
+slot_hash(const uint8_t *font, uint16_t encoding);
+
+static int16_t
+draw_entry(mono_canvas *canvas, const mono_glyph_cache_entry *entry, int16_t x, int16_t y, uint16_t color, bool solid);
+
+bool
+mono_glyph_cache_init(mono_glyph_cache *cache, uint8_t *arena, size_t arena_size) {
+  if (!cache || !arena || !arena_size)
+    return false;
+
+  cache->arena = arena;
+  cache->arena_size = arena_size;
+  mono_glyph_cache_reset(cache);
+  return true;
+}
+void
+mono_glyph_cache_reset(mono_glyph_cache *cache) {
+  memset(cache->entries, 0, sizeof(cache->entries));
+  cache->arena_used = 0;
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->uncached = 0;
+}
+
+const mono_glyph_cache_entry *
+mono_glyph_cache_get(mono_glyph_cache *cache, const mono_font_info *info, uint16_t encoding) {
+  uint32_t slot = slot_hash(info->font, encoding);
+  mono_glyph_cache_entry *entry = NULL;
+
+  for (uint32_t probe = 0; probe < MONO_GLYPH_CACHE_SLOTS; ++probe, slot = (slot + 1U) & (MONO_GLYPH_CACHE_SLOTS - 1U)) {
+    mono_glyph_cache_entry *candidate = &cache->entries[slot];
+    if (!candidate->font) {
+      entry = candidate;
+      break;
+    }
+    if (candidate->font == info->font && candidate->encoding == encoding) {
+      cache->hits++;
+      return candidate;
+    }
+  }
+  if (!entry) {
+    cache->uncached++;
+    return NULL;
+  }
+
+  cache->misses++;
+
+  mono_font_glyph glyph;
+  if (!mono_font_get_glyph(info, encoding, &glyph)) {
+    entry->font = info->font;
+    entry->encoding = encoding;
+    entry->missing = true;
+    return entry;
+  }
+
+  size_t bitmap_size = MONO_CANVAS_BUFFER_SIZE(glyph.width, glyph.height);
+  uint8_t *bitmap = NULL;
+  if (bitmap_size) {
+    if (cache->arena_used + bitmap_size > cache->arena_size) {
+      cache->uncached++;
+      return NULL;
+    }
+
+    bitmap = &cache->arena[cache->arena_used];
+    mono_canvas glyph_canvas;
+    if (!mono_canvas_init(&glyph_canvas, glyph.width, glyph.height, bitmap)) {
+      cache->uncached++;
+      return NULL;
+    }
+    // Puts the top left corner of the glyph box at (0, 0)
+    mono_font_draw_glyph(&glyph_canvas, &glyph, (int16_t)-glyph.x_offset, (int16_t)(glyph.height + glyph.y_offset),
+                         MONO_CANVAS_COLOR_WHITE, false);
+    cache->arena_used += bitmap_size;
+  }
+
+  entry->font = info->font;
+  entry->encoding = encoding;
+  entry->missing = false;
+  entry->width = glyph.width;
+  entry->height = glyph.height;
+  entry->x_offset = glyph.x_offset;
+  entry->y_offset = glyph.y_offset;
+  entry->delta_x = glyph.delta_x;
+  entry->bitmap = bitmap;
+  return entry;
+}
+
+void
+mono_glyph_cache_preload(mono_glyph_cache *cache, const mono_font_info *info, const char *glyphs) {
+  uint16_t encoding = 0;
+
+  while ((encoding = mono_font_utf8_next(&glyphs)) != 0U) {
+    if (encoding != MONO_FONT_INVALID_ENCODING) {
+      mono_glyph_cache_get(cache, info, encoding);
+    }
+  }
+}
+
+int16_t
+mono_glyph_cache_draw_utf8(mono_glyph_cache *cache, mono_canvas *canvas, const mono_font_info *info, int16_t x, int16_t y,
+                           const char *text, uint16_t color, bool solid) {
+  // Inverting the foreground while painting the background needs the RLE runs, a blit over a filled box can't do it
+  if (solid && color == MONO_CANVAS_COLOR_INVERSE)
+    return mono_font_draw_utf8(canvas, info, x, y, text, color, solid);
+
+  int16_t start_x = x;
+  uint16_t encoding = 0;
+
+  while ((encoding = mono_font_utf8_next(&text)) != 0U) {
+    if (encoding == MONO_FONT_INVALID_ENCODING)
+      continue;
+
+    const mono_glyph_cache_entry *entry = mono_glyph_cache_get(cache, info, encoding);
+    if (entry) {
+      if (!entry->missing) {
+        x += draw_entry(canvas, entry, x, y, color, solid);
+      }
+      continue;
+    }
+
+    mono_font_glyph glyph;
+    if (mono_font_get_glyph(info, encoding, &glyph)) {
+      x += mono_font_draw_glyph(canvas, &glyph, x, y, color, solid);
+    }
+  }
+  return x - start_x;
+}
+int16_t
+mono_glyph_cache_utf8_width(mono_glyph_cache *cache, const mono_font_info *info, const char *text) {
+  int16_t width = 0;
+  uint16_t encoding = 0;
+
+  while ((encoding = mono_font_utf8_next(&text)) != 0U) {
+    if (encoding == MONO_FONT_INVALID_ENCODING)
+      continue;
+
+    const mono_glyph_cache_entry *entry = mono_glyph_cache_get(cache, info, encoding);
+    if (entry) {
+      width += entry->missing ? 0 : entry->delta_x;
+      continue;
+    }
+
+    mono_font_glyph glyph;
+    if (mono_font_get_glyph(info, encoding, &glyph)) {
+      width += glyph.delta_x;
+    }
+  }
+  return width;
+}
+
+static inline uint32_t
+slot_hash(const uint8_t *font, uint16_t encoding) {
+  uint32_t h = (uint32_t)(uintptr_t)font * 2654435761U;
+  h ^= (uint32_t)encoding * 40503U;
+  return (h ^ (h >> 16)) & (MONO_GLYPH_CACHE_SLOTS - 1U);
+}
+
+static int16_t
+draw_entry(mono_canvas *canvas, const mono_glyph_cache_entry *entry, int16_t x, int16_t y, uint16_t color, bool solid) {
+  if (!entry->width)
+    return entry->delta_x;
+
+  int16_t x0 = (int16_t)(x + entry->x_offset);
+  int16_t y0 = (int16_t)(y - (entry->height + entry->y_offset));
+
+  if (solid) {
+    uint16_t bg_color = color ? MONO_CANVAS_COLOR_BLACK : MONO_CANVAS_COLOR_WHITE;
+    mono_canvas_fill_rect(canvas, x0, y0, entry->width, entry->height, bg_color);
+  }
+  if (entry->bitmap) {
+    mono_canvas_blit(canvas, x0, y0, entry->width, entry->height, entry->bitmap, color);
+  }
+  return entry->delta_x;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef MONO_GLYPH_CACHE_H
+#define MONO_GLYPH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mono_canvas.h"
+#include "mono_font.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MONO_GLYPH_CACHE_SLOTS 128U // power of two
+
+typedef struct {
+  const uint8_t *font; // NULL marks a free slot
+  uint16_t encoding;
+  bool missing; // not part of the font, remembered so the lookup is not repeated
+
+  uint8_t width;
+  uint8_t height;
+  int8_t x_offset;
+  int8_t y_offset;
+  int8_t delta_x;
+
+  const uint8_t *bitmap; // canvas layout, NULL for blank glyphs
+} mono_glyph_cache_entry;
+
+/**
+ * Glyphs decoded once from U8g2 RLE into 1-bpp bitmaps in canvas layout, so drawing text is a blit per glyph and
+ * measuring it never touches the font. Bitmaps live in a caller provided arena (PSRAM is fine). Once the arena or the
+ * slots run out, the remaining glyphs are drawn straight from the font.
+ */
+typedef struct {
+  mono_glyph_cache_entry entries[MONO_GLYPH_CACHE_SLOTS];
+
+  uint8_t *arena;
+  size_t arena_size;
+  size_t arena_used;
+
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t uncached;
+} mono_glyph_cache;
+
+bool
+mono_glyph_cache_init(mono_glyph_cache *cache, uint8_t *arena, size_t arena_size);
+void
+mono_glyph_cache_reset(mono_glyph_cache *cache);
+
+/**
+ * Returns NULL if the glyph could not be cached, the caller falls back to mono_font
+ */
+const mono_glyph_cache_entry *
+mono_glyph_cache_get(mono_glyph_cache *cache, const mono_font_info *info, uint16_t encoding);
+
+/**
+ * Rasterizes every glyph of the UTF-8 string up front, e.g. "0123456789:" for the clock font
+ */
+void
+mono_glyph_cache_preload(mono_glyph_cache *cache, const mono_font_info *info, const char *glyphs);
+
+/**
+ * Same output as mono_font_draw_utf8 / mono_font_utf8_width
+ */
+int16_t
+mono_glyph_cache_draw_utf8(mono_glyph_cache *cache, mono_canvas *canvas, const mono_font_info *info, int16_t x, int16_t y,
+                           const char *text, uint16_t color, bool solid);
+int16_t
+mono_glyph_cache_utf8_width(mono_glyph_cache *cache, const mono_font_info *info, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
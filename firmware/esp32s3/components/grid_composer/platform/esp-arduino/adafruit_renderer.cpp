@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "esp_check.h"
 #include "esp_err.h"
 
@@ -7,6 +9,13 @@
 
 static const char *TAG = "adafruit_renderer";
 
+static esp_err_t
+display(adafruit_renderer_ctx *gfx_ctx, int x, int y, int w, int h);
+static esp_err_t
+draw_text_cached(adafruit_renderer_ctx *gfx_ctx, const grid_composer_text_info *info, uint16_t color, bool fill);
+static uint32_t
+window_bytes(Adafruit_GrayOLED *oled, int x, int y, int w, int h);
+
 esp_err_t
 adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint16_t color, bool fill) {
   ESP_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_ARG, TAG, "invalid gfx ctx");
@@ -16,9 +25,8 @@ adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint1
   ESP_RETURN_ON_FALSE(gfx_ctx->oled, ESP_ERR_INVALID_ARG, TAG, "invalid oled renderer");
   ESP_RETURN_ON_FALSE(gfx_ctx->tw, ESP_ERR_INVALID_ARG, TAG, "invalid tw object");
 
-  adafruit_pca_select(gfx_ctx->tw, gfx_ctx->idx);
-
   Adafruit_GrayOLED *oled = gfx_ctx->oled;
+  int x0, y0, x1, y1; // bounds of what was drawn, inclusive
 
   switch (info->type) {
   case GRID_COMPOSER_FIGURE_RECT:
@@ -27,6 +35,10 @@ adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint1
     } else {
       oled->drawRect(info->info.rect.x, info->info.rect.y, info->info.rect.w, info->info.rect.h, color);
     }
+    x0 = info->info.rect.x;
+    y0 = info->info.rect.y;
+    x1 = x0 + info->info.rect.w - 1;
+    y1 = y0 + info->info.rect.h - 1;
     break;
   case GRID_COMPOSER_FIGURE_ROUND_RECT:
     if (fill) {
@@ -36,6 +48,10 @@ adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint1
       oled->drawRoundRect(info->info.round_rect.x, info->info.round_rect.y, info->info.round_rect.w, info->info.round_rect.h,
                           info->info.round_rect.r, color);
     }
+    x0 = info->info.round_rect.x;
+    y0 = info->info.round_rect.y;
+    x1 = x0 + info->info.round_rect.w - 1;
+    y1 = y0 + info->info.round_rect.h - 1;
     break;
   case GRID_COMPOSER_FIGURE_CIRCLE:
     if (fill) {
@@ -43,6 +59,10 @@ adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint1
     } else {
       oled->drawCircle(info->info.circle.x0, info->info.circle.y0, info->info.circle.r, color);
     }
+    x0 = info->info.circle.x0 - info->info.circle.r;
+    y0 = info->info.circle.y0 - info->info.circle.r;
+    x1 = info->info.circle.x0 + info->info.circle.r;
+    y1 = info->info.circle.y0 + info->info.circle.r;
     break;
   case GRID_COMPOSER_FIGURE_TRIANGLE:
     if (fill) {
@@ -52,16 +72,23 @@ adafruit_gfx_draw_figure(void *ctx, const grid_composer_figure_info *info, uint1
       oled->drawTriangle(info->info.triangle.x0, info->info.triangle.y0, info->info.triangle.x1, info->info.triangle.x1,
                          info->info.triangle.x2, info->info.triangle.y2, color);
     }
+    x0 = std::min({info->info.triangle.x0, info->info.triangle.x1, info->info.triangle.x2});
+    y0 = std::min({info->info.triangle.y0, info->info.triangle.y1, info->info.triangle.y2});
+    x1 = std::max({info->info.triangle.x0, info->info.triangle.x1, info->info.triangle.x2});
+    y1 = std::max({info->info.triangle.y0, info->info.triangle.y1, info->info.triangle.y2});
     break;
   case GRID_COMPOSER_FIGURE_LINE:
     oled->drawLine(info->info.line.x0, info->info.line.y0, info->info.line.x1, info->info.line.y1, color);
+    x0 = std::min(info->info.line.x0, info->info.line.x1);
+    y0 = std::min(info->info.line.y0, info->info.line.y1);
+    x1 = std::max(info->info.line.x0, info->info.line.x1);
+    y1 = std::max(info->info.line.y0, info->info.line.y1);
     break;
   default:
     return ESP_ERR_INVALID_ARG;
   }
-  oled->display();
 
-  return ESP_OK;
+  return display(gfx_ctx, x0, y0, x1 - x0 + 1, y1 - y0 + 1);
 }
 esp_err_t
 adafruit_gfx_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill) {
@@ -72,7 +99,10 @@ adafruit_gfx_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t
   ESP_RETURN_ON_FALSE(gfx_ctx->oled, ESP_ERR_INVALID_ARG, TAG, "invalid oled renderer");
   ESP_RETURN_ON_FALSE(gfx_ctx->tw, ESP_ERR_INVALID_ARG, TAG, "invalid tw object");
 
-  adafruit_pca_select(gfx_ctx->tw, gfx_ctx->idx);
+  // GrayOLED keeps the same page layout as mono_canvas as long as the display is not rotated
+  if (gfx_ctx->glyph_cache && gfx_ctx->oled->getRotation() == 0) {
+    return draw_text_cached(gfx_ctx, info, color, fill);
+  }
 
   Adafruit_GrayOLED *oled = gfx_ctx->oled;
   U8G2_FOR_ADAFRUIT_GFX *gfx = gfx_ctx->u8g2;
@@ -121,9 +151,7 @@ adafruit_gfx_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t
 
   gfx->drawUTF8(x, y, info->text);
 
-  oled->display();
-
-  return ESP_OK;
+  return display(gfx_ctx, x, y - ascent, text_width, ascent - descent);
 }
 esp_err_t
 adafruit_gfx_clear(void *ctx) {
@@ -134,16 +162,13 @@ adafruit_gfx_clear(void *ctx) {
   ESP_RETURN_ON_FALSE(gfx_ctx->oled, ESP_ERR_INVALID_ARG, TAG, "invalid oled renderer");
   ESP_RETURN_ON_FALSE(gfx_ctx->tw, ESP_ERR_INVALID_ARG, TAG, "invalid tw object");
 
-  adafruit_pca_select(gfx_ctx->tw, gfx_ctx->idx);
-
   Adafruit_GrayOLED *oled = gfx_ctx->oled;
   U8G2_FOR_ADAFRUIT_GFX *gfx = gfx_ctx->u8g2;
 
   gfx->home();
 
   oled->clearDisplay();
-  oled->display();
-  return ESP_OK;
+  return display(gfx_ctx, 0, 0, oled->width(), oled->height());
 }
 
 void
@@ -151,7 +176,124 @@ adafruit_pca_select(TwoWire *tw, uint16_t i) {
   if (i > 7)
     return;
 
-  tw->beginTransmission(PCA1_ADDR);
-  tw->write(1 << i);
-  tw->endTransmission();
+  adafruit_pca_write(tw, PCA1_ADDR, (uint8_t)(1 << i));
+}
+
+esp_err_t
+adafruit_pca_write(void *user_ctx, uint8_t address, uint8_t ctrl) {
+  TwoWire *tw = (TwoWire *)user_ctx;
+
+  tw->beginTransmission(address);
+  tw->write(ctrl);
+  return tw->endTransmission() == 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * Same layout as adafruit_gfx_draw_text, glyphs are blitted straight into the GrayOLED buffer
+ */
+static esp_err_t
+draw_text_cached(adafruit_renderer_ctx *gfx_ctx, const grid_composer_text_info *info, uint16_t color, bool fill) {
+  Adafruit_GrayOLED *oled = gfx_ctx->oled;
+
+  mono_font_info font;
+  ESP_RETURN_ON_FALSE(mono_font_load(&font, info->font), ESP_ERR_INVALID_ARG, TAG, "invalid font");
+
+  mono_canvas canvas;
+  ESP_RETURN_ON_FALSE(mono_canvas_wrap(&canvas, (uint16_t)oled->width(), (uint16_t)oled->height(), oled->getBuffer()),
+                      ESP_ERR_INVALID_STATE, TAG, "no display buffer");
+
+  int ascent = font.ascent_A;
+  int descent = font.descent_g;
+
+  int text_width = mono_glyph_cache_utf8_width(gfx_ctx->glyph_cache, &font, info->text);
+  int x = info->x;
+  int y = info->y;
+
+  switch (info->h_align) {
+  case GRID_COMPOSER_H_ALIGN_LEFT:
+    break;
+  case GRID_COMPOSER_H_ALIGN_RIGHT:
+    x = canvas.width - text_width;
+    break;
+  case GRID_COMPOSER_H_ALIGN_CENTER:
+    x = (canvas.width - text_width) / 2;
+    break;
+  case GRID_COMPOSER_H_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+
+  switch (info->v_align) {
+  case GRID_COMPOSER_V_ALIGN_TOP:
+    y = ascent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_BOTTOM:
+    y = canvas.height + descent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_CENTER:
+    y = (canvas.height + ascent - descent) / 2;
+    break;
+  case GRID_COMPOSER_V_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+  ESP_RETURN_ON_FALSE(y >= 0 && x >= 0, ESP_ERR_INVALID_ARG, TAG, "negative cursor position not supported");
+
+  mono_glyph_cache_draw_utf8(gfx_ctx->glyph_cache, &canvas, &font, (int16_t)x, (int16_t)y, info->text, color, fill);
+
+  return display(gfx_ctx, x, y - ascent, text_width, ascent - descent);
+}
+
+/**
+ * Drawing only touches the RAM buffer, the mux and the bus are held just for the transfer. GrayOLED sends its dirty
+ * window in one call, so every display() is a single chunk for the arbiter. The window is not exposed, the bytes
+ * counted for the arbiter come from the bounds of what the caller drew instead.
+ */
+static esp_err_t
+display(adafruit_renderer_ctx *gfx_ctx, int x, int y, int w, int h) {
+  if (gfx_ctx->arbiter) {
+    ESP_RETURN_ON_ERROR(i2c_arbiter_acquire(gfx_ctx->arbiter, gfx_ctx->arbiter_priority, ADAFRUIT_RENDERER_BUS_TIMEOUT_MS), TAG,
+                        "I2C bus busy");
+  }
+
+  esp_err_t ret = ESP_OK;
+  if (gfx_ctx->mux) {
+    ret = pca9548a_mux_acquire(gfx_ctx->mux, (uint8_t)gfx_ctx->idx, ADAFRUIT_RENDERER_MUX_TIMEOUT_MS);
+  } else {
+    adafruit_pca_select(gfx_ctx->tw, gfx_ctx->idx);
+  }
+  if (ret == ESP_OK) {
+    gfx_ctx->oled->display();
+    if (gfx_ctx->arbiter) {
+      i2c_arbiter_count_bytes(gfx_ctx->arbiter, window_bytes(gfx_ctx->oled, x, y, w, h));
+    }
+    if (gfx_ctx->mux) {
+      ret = pca9548a_mux_release(gfx_ctx->mux);
+    }
+  } else {
+    ESP_LOGE(TAG, "failed to select mux channel %u", gfx_ctx->idx);
+  }
+
+  if (gfx_ctx->arbiter) {
+    i2c_arbiter_release(gfx_ctx->arbiter);
+  }
+  return ret;
+}
+
+/**
+ * What an SH110X display() puts on the wire for a window, a command transaction and the data of each page it spans
+ */
+static uint32_t
+window_bytes(Adafruit_GrayOLED *oled, int x, int y, int w, int h) {
+  int x0 = std::max(x, 0);
+  int y0 = std::max(y, 0);
+  int x1 = std::min(x + w, (int)oled->width()) - 1;
+  int y1 = std::min(y + h, (int)oled->height()) - 1;
+  if (x1 < x0 || y1 < y0)
+    return 0;
+
+  uint32_t pages = (uint32_t)(y1 / 8 - y0 / 8 + 1);
+  return pages * (ADAFRUIT_RENDERER_PAGE_BYTES + (uint32_t)(x1 - x0 + 1));
 }
@@ -12,6 +12,9 @@
 #include "U8g2_for_Adafruit_GFX.h"
 
 #include "grid_composer_defs.h"
+#include "i2c_arbiter.h"
+#include "mono_glyph_cache.h"
+#include "pca9548a_mux.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,6 +24,10 @@ typedef struct {
   U8G2_FOR_ADAFRUIT_GFX *u8g2;
   TwoWire *tw;
   uint16_t idx;
+  pca9548a_mux_handle mux; // optional, without it the channel is written on every display()
+  mono_glyph_cache *glyph_cache; // optional, can be shared by renderers drawn from the same task
+  i2c_arbiter_handle arbiter;    // optional, held over the mux select and the transfer of each display()
+  uint8_t arbiter_priority;
 } adafruit_renderer_ctx;
 
 esp_err_t
@@ -31,6 +38,11 @@ esp_err_t
 adafruit_gfx_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill);
 void
 adafruit_pca_select(TwoWire *tw, uint16_t i);
+/**
+ * pca9548a_mux_write_fn over Wire, user_ctx is a TwoWire *
+ */
+esp_err_t
+adafruit_pca_write(void *user_ctx, uint8_t address, uint8_t ctrl);
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,11 @@ extern "C" {
 
 #define PCA1_ADDR 0x70
 
+#define ADAFRUIT_RENDERER_MUX_TIMEOUT_MS 1000U
+#define ADAFRUIT_RENDERER_BUS_TIMEOUT_MS 1000U
+
+#define ADAFRUIT_RENDERER_PAGE_BYTES 7U // address, control and the three addressing commands plus the data header
+
 #ifdef __cplusplus
 }
 #endif
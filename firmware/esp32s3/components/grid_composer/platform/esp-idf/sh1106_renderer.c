@@ -0,0 +1,689 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "mono_canvas.h"
+#include "mono_font.h"
+#include "mono_glyph_cache.h"
+
+#include "pca9548a_mux.h"
+
+#include "sh1106_renderer_private.h"
+
+#include "sh1106_renderer.h"
+
+#define SH1106_RENDERER_IDLE_BIT (1 << 0)
+
+#define SH1106_RENDERER_MAX_WIDTH  128U
+#define SH1106_RENDERER_MAX_HEIGHT 64U
+
+struct page_span {
+  int16_t x0;
+  int16_t x1;
+};
+
+struct sh1106_renderer_bus {
+  i2c_master_bus_handle_t i2c_bus;
+  i2c_master_dev_handle_t mux_dev;
+  pca9548a_mux_handle mux;
+  esp_lcd_panel_io_handle_t io;
+  i2c_arbiter_handle arbiter;
+  uint8_t arbiter_priority;
+
+  SemaphoreHandle_t io_lock;
+  QueueHandle_t flush_queue;
+  TaskHandle_t flush_task_handle;
+
+  uint8_t renderer_count;
+
+  /* Shared by every panel on the bus, fonts repeat across panels */
+  SemaphoreHandle_t glyph_lock;
+  mono_glyph_cache *glyph_cache;
+  uint8_t *glyph_arena;
+
+  /* Only touched by the flush task, lets the draw side keep drawing while a transfer is on the wire */
+  uint8_t staging[MONO_CANVAS_BUFFER_SIZE(SH1106_RENDERER_MAX_WIDTH, SH1106_RENDERER_MAX_HEIGHT)];
+};
+
+struct sh1106_renderer {
+  sh1106_renderer_bus_handle bus;
+  uint8_t mux_channel;
+
+  mono_canvas canvas;
+  uint8_t *framebuffer;
+
+  SemaphoreHandle_t lock;
+  EventGroupHandle_t events;
+  bool queued;
+
+  sh1106_renderer_flush_done_cb_t on_flush_done;
+  void *user_ctx;
+};
+
+static const char *TAG = "sh1106_renderer";
+
+static void
+task_flush(void *arg);
+
+static esp_err_t
+queue_flush(sh1106_renderer_handle renderer);
+
+static esp_err_t
+transfer(sh1106_renderer_bus_handle bus, sh1106_renderer_handle renderer, const struct page_span *spans);
+
+static esp_err_t
+send_init_sequence(sh1106_renderer_bus_handle bus, uint8_t mux_channel);
+
+static esp_err_t
+bus_acquire(sh1106_renderer_bus_handle bus);
+static void
+bus_release(sh1106_renderer_bus_handle bus);
+static esp_err_t
+bus_yield(sh1106_renderer_bus_handle bus);
+static void
+bus_count(sh1106_renderer_bus_handle bus, size_t bytes);
+
+static esp_err_t
+mux_select(sh1106_renderer_bus_handle bus, uint8_t channel);
+static esp_err_t
+mux_write(void *user_ctx, uint8_t address, uint8_t ctrl);
+
+static esp_err_t
+flush_renderer(sh1106_renderer_bus_handle bus, sh1106_renderer_handle renderer, struct page_span *spans);
+static void
+order_by_channel(sh1106_renderer_bus_handle bus, sh1106_renderer_handle *pending, uint8_t pending_cnt);
+
+esp_err_t
+sh1106_renderer_bus_new(const struct sh1106_renderer_bus_config *bus_cfg, sh1106_renderer_bus_handle *out_bus) {
+  esp_err_t ret = ESP_OK;
+  struct sh1106_renderer_bus *bus = NULL;
+
+  ESP_GOTO_ON_FALSE(bus_cfg && out_bus && bus_cfg->i2c_bus, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+
+  bus = calloc(1, sizeof(struct sh1106_renderer_bus));
+  ESP_GOTO_ON_FALSE(bus, ESP_ERR_NO_MEM, err, TAG, "no memory for sh1106_renderer_bus");
+
+  bus->i2c_bus = bus_cfg->i2c_bus;
+  bus->arbiter = bus_cfg->arbiter;
+  bus->arbiter_priority = bus_cfg->arbiter_priority;
+
+  esp_lcd_panel_io_i2c_config_t io_cfg = {
+      .dev_addr = bus_cfg->panel_address,
+      .control_phase_bytes = 1,
+      .dc_bit_offset = 6,
+      .lcd_cmd_bits = 8,
+      .lcd_param_bits = 8,
+      .scl_speed_hz = bus_cfg->scl_speed_hz,
+  };
+  ESP_GOTO_ON_ERROR(esp_lcd_new_panel_io_i2c(bus->i2c_bus, &io_cfg, &bus->io), err, TAG, "failed to create panel io");
+
+  if (bus_cfg->mux_address != SH1106_RENDERER_NO_MUX) {
+    i2c_device_config_t mux_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = bus_cfg->mux_address,
+        .scl_speed_hz = bus_cfg->scl_speed_hz,
+    };
+    ESP_GOTO_ON_ERROR(i2c_master_bus_add_device(bus->i2c_bus, &mux_cfg, &bus->mux_dev), err, TAG, "failed to add mux device");
+
+    struct pca9548a_mux_config pca_cfg = {
+        .address = (uint8_t)bus_cfg->mux_address,
+        .write = mux_write,
+        .user_ctx = bus,
+    };
+    ESP_GOTO_ON_ERROR(pca9548a_mux_new(&pca_cfg, &bus->mux), err, TAG, "failed to create mux");
+  }
+
+  bus->io_lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(bus->io_lock, ESP_ERR_NO_MEM, err, TAG, "failed to create io lock");
+
+  bus->glyph_lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(bus->glyph_lock, ESP_ERR_NO_MEM, err, TAG, "failed to create glyph lock");
+  bus->glyph_cache = heap_caps_malloc_prefer(sizeof(mono_glyph_cache), 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  bus->glyph_arena = heap_caps_malloc_prefer(SH1106_RENDERER_GLYPH_ARENA_SIZE, 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  ESP_GOTO_ON_FALSE(bus->glyph_cache && bus->glyph_arena, ESP_ERR_NO_MEM, err, TAG, "no memory for the glyph cache");
+  mono_glyph_cache_init(bus->glyph_cache, bus->glyph_arena, SH1106_RENDERER_GLYPH_ARENA_SIZE);
+
+  bus->flush_queue = xQueueCreate(SH1106_RENDERER_MAX_PANELS, sizeof(sh1106_renderer_handle));
+  ESP_GOTO_ON_FALSE(bus->flush_queue, ESP_ERR_NO_MEM, err, TAG, "failed to create flush queue");
+
+  ESP_GOTO_ON_FALSE(xTaskCreatePinnedToCore(task_flush, "sh1106 flush tsk", SH1106_RENDERER_TASK_STACK, bus,
+                                            SH1106_RENDERER_TASK_PRIO, &bus->flush_task_handle,
+                                            SH1106_RENDERER_TASK_CORE) == pdTRUE,
+                    ESP_ERR_NO_MEM, err, TAG, "failed to create flush task");
+
+  *out_bus = bus;
+  return ESP_OK;
+err:
+  if (bus) {
+    if (bus->flush_queue)
+      vQueueDelete(bus->flush_queue);
+    if (bus->io_lock)
+      vSemaphoreDelete(bus->io_lock);
+    if (bus->glyph_lock)
+      vSemaphoreDelete(bus->glyph_lock);
+    free(bus->glyph_cache);
+    free(bus->glyph_arena);
+    if (bus->mux)
+      pca9548a_mux_del(bus->mux);
+    if (bus->mux_dev)
+      i2c_master_bus_rm_device(bus->mux_dev);
+    if (bus->io)
+      esp_lcd_panel_io_del(bus->io);
+    free(bus);
+  }
+  return ret;
+}
+esp_err_t
+sh1106_renderer_bus_del(sh1106_renderer_bus_handle bus) {
+  ESP_RETURN_ON_FALSE(bus, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(bus->renderer_count == 0U, ESP_ERR_INVALID_STATE, TAG, "delete all renderers on the bus first");
+
+  if (bus->flush_task_handle) {
+    vTaskDelete(bus->flush_task_handle);
+    bus->flush_task_handle = NULL;
+  }
+  vQueueDelete(bus->flush_queue);
+  vSemaphoreDelete(bus->io_lock);
+  vSemaphoreDelete(bus->glyph_lock);
+  free(bus->glyph_cache);
+  free(bus->glyph_arena);
+  if (bus->mux) {
+    pca9548a_mux_del(bus->mux);
+  }
+  if (bus->mux_dev) {
+    ESP_ERROR_CHECK_WITHOUT_ABORT(i2c_master_bus_rm_device(bus->mux_dev));
+  }
+  ESP_ERROR_CHECK_WITHOUT_ABORT(esp_lcd_panel_io_del(bus->io));
+
+  free(bus);
+  return ESP_OK;
+}
+
+esp_err_t
+sh1106_renderer_bus_get_mux(sh1106_renderer_bus_handle bus, pca9548a_mux_handle *out_mux) {
+  ESP_RETURN_ON_FALSE(bus && out_mux, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(bus->mux, ESP_ERR_NOT_SUPPORTED, TAG, "bus has no mux");
+
+  *out_mux = bus->mux;
+  return ESP_OK;
+}
+esp_err_t
+sh1106_renderer_bus_preload_glyphs(sh1106_renderer_bus_handle bus, const uint8_t *font, const char *glyphs) {
+  ESP_RETURN_ON_FALSE(bus && font && glyphs, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  mono_font_info info;
+  ESP_RETURN_ON_FALSE(mono_font_load(&info, font), ESP_ERR_INVALID_ARG, TAG, "invalid font");
+
+  xSemaphoreTake(bus->glyph_lock, portMAX_DELAY);
+  mono_glyph_cache_preload(bus->glyph_cache, &info, glyphs);
+  xSemaphoreGive(bus->glyph_lock);
+  return ESP_OK;
+}
+
+esp_err_t
+sh1106_renderer_new(const struct sh1106_renderer_config *renderer_cfg, sh1106_renderer_handle *out_renderer) {
+  esp_err_t ret = ESP_OK;
+  struct sh1106_renderer *renderer = NULL;
+
+  ESP_GOTO_ON_FALSE(renderer_cfg && out_renderer && renderer_cfg->bus, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+  ESP_GOTO_ON_FALSE(renderer_cfg->width <= SH1106_RENDERER_MAX_WIDTH && renderer_cfg->height <= SH1106_RENDERER_MAX_HEIGHT,
+                    ESP_ERR_INVALID_SIZE, err, TAG, "panel size not supported");
+  ESP_GOTO_ON_FALSE(renderer_cfg->bus->renderer_count < SH1106_RENDERER_MAX_PANELS, ESP_ERR_NO_MEM, err, TAG,
+                    "too many panels on a bus");
+
+  renderer = calloc(1, sizeof(struct sh1106_renderer));
+  ESP_GOTO_ON_FALSE(renderer, ESP_ERR_NO_MEM, err, TAG, "no memory for sh1106_renderer");
+
+  renderer->framebuffer = heap_caps_calloc(1, MONO_CANVAS_BUFFER_SIZE(renderer_cfg->width, renderer_cfg->height),
+                                           MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  ESP_GOTO_ON_FALSE(renderer->framebuffer, ESP_ERR_NO_MEM, err, TAG, "no memory for a framebuffer");
+  ESP_GOTO_ON_FALSE(mono_canvas_init(&renderer->canvas, renderer_cfg->width, renderer_cfg->height, renderer->framebuffer),
+                    ESP_ERR_INVALID_SIZE, err, TAG, "failed to init canvas");
+
+  renderer->lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(renderer->lock, ESP_ERR_NO_MEM, err, TAG, "failed to create renderer lock");
+  renderer->events = xEventGroupCreate();
+  ESP_GOTO_ON_FALSE(renderer->events, ESP_ERR_NO_MEM, err, TAG, "failed to create renderer event group");
+  xEventGroupSetBits(renderer->events, SH1106_RENDERER_IDLE_BIT);
+
+  renderer->bus = renderer_cfg->bus;
+  renderer->mux_channel = renderer_cfg->mux_channel;
+  renderer->on_flush_done = renderer_cfg->on_flush_done;
+  renderer->user_ctx = renderer_cfg->user_ctx;
+
+  ESP_GOTO_ON_ERROR(send_init_sequence(renderer->bus, renderer->mux_channel), err, TAG, "failed to init panel");
+
+  renderer->bus->renderer_count++;
+
+  // Panel RAM content is undefined after power up
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  ret = queue_flush(renderer);
+  xSemaphoreGive(renderer->lock);
+  ESP_GOTO_ON_ERROR(ret, err_registered, TAG, "failed to queue the initial flush");
+
+  *out_renderer = renderer;
+  return ESP_OK;
+err_registered:
+  renderer->bus->renderer_count--;
+err:
+  if (renderer) {
+    if (renderer->events)
+      vEventGroupDelete(renderer->events);
+    if (renderer->lock)
+      vSemaphoreDelete(renderer->lock);
+    if (renderer->framebuffer)
+      free(renderer->framebuffer);
+    free(renderer);
+  }
+  return ret;
+}
+esp_err_t
+sh1106_renderer_del(sh1106_renderer_handle renderer) {
+  ESP_RETURN_ON_FALSE(renderer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_ERROR(sh1106_renderer_wait_flush(renderer, SH1106_RENDERER_FLUSH_WAIT_MS), TAG,
+                      "pending flush did not complete");
+
+  renderer->bus->renderer_count--;
+
+  vEventGroupDelete(renderer->events);
+  vSemaphoreDelete(renderer->lock);
+  free(renderer->framebuffer);
+  free(renderer);
+  return ESP_OK;
+}
+
+esp_err_t
+sh1106_renderer_wait_flush(sh1106_renderer_handle renderer, uint32_t timeout_ms) {
+  ESP_RETURN_ON_FALSE(renderer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  EventBits_t bits =
+      xEventGroupWaitBits(renderer->events, SH1106_RENDERER_IDLE_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+  return (bits & SH1106_RENDERER_IDLE_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t
+sh1106_renderer_clear(void *ctx) {
+  ESP_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  sh1106_renderer_handle renderer = (sh1106_renderer_handle)ctx;
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  mono_canvas_fill(&renderer->canvas, MONO_CANVAS_COLOR_BLACK);
+  esp_err_t ret = queue_flush(renderer);
+  xSemaphoreGive(renderer->lock);
+
+  return ret;
+}
+esp_err_t
+sh1106_renderer_draw_figure(void *ctx, const grid_composer_figure_info *info, uint16_t color, bool fill) {
+  ESP_RETURN_ON_FALSE(ctx && info, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  sh1106_renderer_handle renderer = (sh1106_renderer_handle)ctx;
+  mono_canvas *canvas = &renderer->canvas;
+  esp_err_t ret = ESP_OK;
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  switch (info->type) {
+  case GRID_COMPOSER_FIGURE_RECT:
+    if (fill) {
+      mono_canvas_fill_rect(canvas, info->info.rect.x, info->info.rect.y, info->info.rect.w, info->info.rect.h, color);
+    } else {
+      mono_canvas_draw_rect(canvas, info->info.rect.x, info->info.rect.y, info->info.rect.w, info->info.rect.h, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_ROUND_RECT:
+    if (fill) {
+      mono_canvas_fill_round_rect(canvas, info->info.round_rect.x, info->info.round_rect.y, info->info.round_rect.w,
+                                  info->info.round_rect.h, info->info.round_rect.r, color);
+    } else {
+      mono_canvas_draw_round_rect(canvas, info->info.round_rect.x, info->info.round_rect.y, info->info.round_rect.w,
+                                  info->info.round_rect.h, info->info.round_rect.r, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_CIRCLE:
+    if (fill) {
+      mono_canvas_fill_circle(canvas, info->info.circle.x0, info->info.circle.y0, info->info.circle.r, color);
+    } else {
+      mono_canvas_draw_circle(canvas, info->info.circle.x0, info->info.circle.y0, info->info.circle.r, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_TRIANGLE:
+    if (fill) {
+      mono_canvas_fill_triangle(canvas, info->info.triangle.x0, info->info.triangle.y0, info->info.triangle.x1,
+                                info->info.triangle.y1, info->info.triangle.x2, info->info.triangle.y2, color);
+    } else {
+      mono_canvas_draw_triangle(canvas, info->info.triangle.x0, info->info.triangle.y0, info->info.triangle.x1,
+                                info->info.triangle.y1, info->info.triangle.x2, info->info.triangle.y2, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_LINE:
+    mono_canvas_draw_line(canvas, info->info.line.x0, info->info.line.y0, info->info.line.x1, info->info.line.y1, color);
+    break;
+  default:
+    ret = ESP_ERR_INVALID_ARG;
+    break;
+  }
+  if (ret == ESP_OK) {
+    ret = queue_flush(renderer);
+  }
+  xSemaphoreGive(renderer->lock);
+
+  return ret;
+}
+esp_err_t
+sh1106_renderer_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill) {
+  ESP_RETURN_ON_FALSE(ctx && info && info->text && info->font, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  sh1106_renderer_handle renderer = (sh1106_renderer_handle)ctx;
+  mono_canvas *canvas = &renderer->canvas;
+
+  mono_font_info font;
+  ESP_RETURN_ON_FALSE(mono_font_load(&font, info->font), ESP_ERR_INVALID_ARG, TAG, "invalid font");
+
+  int ascent = font.ascent_A;
+  int descent = font.descent_g;
+
+  sh1106_renderer_bus_handle bus = renderer->bus;
+
+  xSemaphoreTake(bus->glyph_lock, portMAX_DELAY);
+  int text_width = mono_glyph_cache_utf8_width(bus->glyph_cache, &font, info->text);
+  xSemaphoreGive(bus->glyph_lock);
+  int x = info->x;
+  int y = info->y;
+
+  switch (info->h_align) {
+  case GRID_COMPOSER_H_ALIGN_LEFT:
+    break;
+  case GRID_COMPOSER_H_ALIGN_RIGHT:
+    x = canvas->width - text_width;
+    break;
+  case GRID_COMPOSER_H_ALIGN_CENTER:
+    x = (canvas->width - text_width) / 2;
+    break;
+  case GRID_COMPOSER_H_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+
+  switch (info->v_align) {
+  case GRID_COMPOSER_V_ALIGN_TOP:
+    y = ascent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_BOTTOM:
+    y = canvas->height + descent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_CENTER:
+    y = (canvas->height + ascent - descent) / 2;
+    break;
+  case GRID_COMPOSER_V_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+  ESP_RETURN_ON_FALSE(y >= 0 && x >= 0, ESP_ERR_INVALID_ARG, TAG, "negative cursor position not supported");
+
+  xSemaphoreTake(bus->glyph_lock, portMAX_DELAY);
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  mono_glyph_cache_draw_utf8(bus->glyph_cache, canvas, &font, (int16_t)x, (int16_t)y, info->text, color, fill);
+  esp_err_t ret = queue_flush(renderer);
+  xSemaphoreGive(renderer->lock);
+  xSemaphoreGive(bus->glyph_lock);
+
+  return ret;
+}
+
+static void
+task_flush(void *arg) {
+  if (NULL == arg)
+    return;
+
+  struct sh1106_renderer_bus *bus = (struct sh1106_renderer_bus *)arg;
+  struct page_span spans[MONO_CANVAS_MAX_PAGES];
+  sh1106_renderer_handle pending[SH1106_RENDERER_MAX_PANELS];
+
+  for (;;) {
+    if (xQueueReceive(bus->flush_queue, &pending[0], portMAX_DELAY) != pdTRUE)
+      continue;
+
+    // Everything queued so far is one frame, flushed grouped by mux channel
+    uint8_t pending_cnt = 1;
+    while (pending_cnt < SH1106_RENDERER_MAX_PANELS && xQueueReceive(bus->flush_queue, &pending[pending_cnt], 0) == pdTRUE) {
+      pending_cnt++;
+    }
+    order_by_channel(bus, pending, pending_cnt);
+
+    bool is_failed = false;
+    for (uint8_t i = 0; i < pending_cnt; ++i) {
+      is_failed |= flush_renderer(bus, pending[i], spans) != ESP_OK;
+    }
+
+    if (bus->mux) {
+      pca9548a_mux_frame_end(bus->mux);
+    }
+    // The failed renderers are queued again, a panel that stays away is retried at this pace, not in a busy loop
+    if (is_failed) {
+      vTaskDelay(pdMS_TO_TICKS(SH1106_RENDERER_RETRY_MS));
+    }
+  }
+}
+
+/**
+ * The dirty spans are taken under the lock so drawing goes on during the transfer. A failed transfer hands them back,
+ * a retained widget is not drawn again and its region would otherwise stay stale.
+ */
+static esp_err_t
+flush_renderer(sh1106_renderer_bus_handle bus, sh1106_renderer_handle renderer, struct page_span *spans) {
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  const mono_canvas *canvas = &renderer->canvas;
+  for (uint8_t p = 0; p < MONO_CANVAS_MAX_PAGES; ++p) {
+    spans[p].x0 = 0;
+    spans[p].x1 = -1;
+    if (!mono_canvas_page_dirty_span(canvas, p, &spans[p].x0, &spans[p].x1))
+      continue;
+
+    size_t offset = (size_t)p * canvas->width + spans[p].x0;
+    memcpy(&bus->staging[offset], &canvas->buffer[offset], (size_t)(spans[p].x1 - spans[p].x0 + 1));
+  }
+  mono_canvas_mark_clean(&renderer->canvas);
+  renderer->queued = false;
+  xSemaphoreGive(renderer->lock);
+
+  esp_err_t ret = transfer(bus, renderer, spans);
+  if (ret != ESP_OK) {
+    ESP_LOGW(TAG, "flush failed on mux channel %u: %s", renderer->mux_channel, esp_err_to_name(ret));
+  }
+
+  if (renderer->on_flush_done) {
+    renderer->on_flush_done(renderer, ret, renderer->user_ctx);
+  }
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  if (ret != ESP_OK) {
+    for (uint8_t p = 0; p < MONO_CANVAS_MAX_PAGES; ++p) {
+      mono_canvas_mark_dirty_span(&renderer->canvas, p, spans[p].x0, spans[p].x1);
+    }
+    queue_flush(renderer);
+  }
+  if (!renderer->queued) {
+    xEventGroupSetBits(renderer->events, SH1106_RENDERER_IDLE_BIT);
+  }
+  xSemaphoreGive(renderer->lock);
+  return ret;
+}
+
+/**
+ * The renderer on the already selected channel goes first, the rest by channel so panels sharing one stay together
+ */
+static void
+order_by_channel(sh1106_renderer_bus_handle bus, sh1106_renderer_handle *pending, uint8_t pending_cnt) {
+  int8_t active = pca9548a_mux_get_channel(bus->mux);
+
+  for (uint8_t i = 1; i < pending_cnt; ++i) {
+    sh1106_renderer_handle renderer = pending[i];
+    int16_t key = (renderer->mux_channel == active) ? -1 : renderer->mux_channel;
+
+    uint8_t j = i;
+    for (; j > 0; --j) {
+      int16_t prev_key = (pending[j - 1]->mux_channel == active) ? -1 : pending[j - 1]->mux_channel;
+      if (prev_key <= key)
+        break;
+      pending[j] = pending[j - 1];
+    }
+    pending[j] = renderer;
+  }
+}
+
+/**
+ * Must be called with the renderer lock held. A renderer is queued at most once, draws that land before the flush task
+ * picks it up are merged into the same transfer.
+ */
+static esp_err_t
+queue_flush(sh1106_renderer_handle renderer) {
+  if (renderer->queued || !mono_canvas_is_dirty(&renderer->canvas))
+    return ESP_OK;
+
+  xEventGroupClearBits(renderer->events, SH1106_RENDERER_IDLE_BIT);
+  renderer->queued = true;
+
+  if (xQueueSend(renderer->bus->flush_queue, &renderer, 0) != pdTRUE) {
+    renderer->queued = false;
+    xEventGroupSetBits(renderer->events, SH1106_RENDERER_IDLE_BIT);
+    ESP_LOGE(TAG, "flush queue full");
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+static esp_err_t
+transfer(sh1106_renderer_bus_handle bus, sh1106_renderer_handle renderer, const struct page_span *spans) {
+  esp_err_t ret = ESP_OK;
+  uint16_t width = renderer->canvas.width;
+  bool is_held = false;
+  bool is_started = false;
+
+  xSemaphoreTake(bus->io_lock, portMAX_DELAY);
+  ESP_GOTO_ON_ERROR(bus_acquire(bus), out, TAG, "I2C bus busy");
+  is_held = true;
+  ESP_GOTO_ON_ERROR(mux_select(bus, renderer->mux_channel), out, TAG, "failed to select mux channel");
+
+  for (uint8_t p = 0; p < MONO_CANVAS_MAX_PAGES; ++p) {
+    if (spans[p].x1 < spans[p].x0)
+      continue;
+
+    // A page is a chunk, sensors waiting on the bus go in between. Only this task selects the mux, it stays as it was.
+    if (is_started) {
+      ret = bus_yield(bus);
+      is_held = ret == ESP_OK;
+      ESP_GOTO_ON_ERROR(ret, out, TAG, "I2C bus busy");
+    }
+    is_started = true;
+
+    uint16_t col = (uint16_t)spans[p].x0 + SH1106_RENDERER_COLUMN_OFFSET;
+    uint8_t col_params[] = {
+        (uint8_t)(SH1106_CMD_SET_COL_LOW | (col & 0x0FU)),
+        (uint8_t)(SH1106_CMD_SET_COL_HIGH | (col >> 4)),
+    };
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_param(bus->io, SH1106_CMD_SET_PAGE_ADDR | p, col_params, sizeof(col_params)), out,
+                      TAG, "failed to set page address");
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_color(bus->io, -1, &bus->staging[(size_t)p * width + spans[p].x0],
+                                                (size_t)(spans[p].x1 - spans[p].x0 + 1)),
+                      out, TAG, "failed to send page data");
+    // Two transactions, the page and column commands then the data
+    bus_count(bus, 2U * SH1106_RENDERER_TX_OVERHEAD + 3U + (size_t)(spans[p].x1 - spans[p].x0 + 1));
+  }
+out:
+  if (is_held) {
+    bus_release(bus);
+  }
+  xSemaphoreGive(bus->io_lock);
+  return ret;
+}
+
+static esp_err_t
+send_init_sequence(sh1106_renderer_bus_handle bus, uint8_t mux_channel) {
+  esp_err_t ret = ESP_OK;
+
+  static const struct {
+    uint8_t cmd;
+    uint8_t param;
+    uint8_t param_len;
+  } init_cmds[] = {
+      {SH1106_CMD_DISPLAY_OFF, 0x00U, 0U},
+      {SH1106_CMD_SET_CLOCK_DIV, 0x80U, 1U},
+      {SH1106_CMD_SET_MULTIPLEX, 0x3FU, 1U},
+      {SH1106_CMD_SET_DISPLAY_OFFSET, 0x00U, 1U},
+      {SH1106_CMD_SET_START_LINE, 0x00U, 0U},
+      {SH1106_CMD_DCDC, 0x8BU, 1U},
+      {SH1106_CMD_SEG_REMAP, 0x00U, 0U},
+      {SH1106_CMD_COM_SCAN_DEC, 0x00U, 0U},
+      {SH1106_CMD_SET_COM_PINS, 0x12U, 1U},
+      {SH1106_CMD_SET_CONTRAST, 0xFFU, 1U},
+      {SH1106_CMD_SET_PRECHARGE, 0x1FU, 1U},
+      {SH1106_CMD_SET_VCOM_DETECT, 0x40U, 1U},
+      {SH1106_CMD_SET_VPP_9V, 0x00U, 0U},
+      {SH1106_CMD_NORMAL_DISPLAY, 0x00U, 0U},
+      {SH1106_CMD_DISPLAY_RESUME, 0x00U, 0U},
+      {SH1106_CMD_DISPLAY_ON, 0x00U, 0U},
+  };
+
+  xSemaphoreTake(bus->io_lock, portMAX_DELAY);
+  ESP_GOTO_ON_ERROR(bus_acquire(bus), out_unlock, TAG, "I2C bus busy");
+  ESP_GOTO_ON_ERROR(mux_select(bus, mux_channel), out, TAG, "failed to select mux channel");
+
+  for (size_t i = 0; i < sizeof(init_cmds) / sizeof(init_cmds[0]); ++i) {
+    ESP_GOTO_ON_ERROR(esp_lcd_panel_io_tx_param(bus->io, init_cmds[i].cmd, init_cmds[i].param_len ? &init_cmds[i].param : NULL,
+                                                init_cmds[i].param_len),
+                      out, TAG, "failed to send init command 0x%02x", init_cmds[i].cmd);
+    bus_count(bus, SH1106_RENDERER_TX_OVERHEAD + 1U + init_cmds[i].param_len);
+  }
+out:
+  bus_release(bus);
+out_unlock:
+  xSemaphoreGive(bus->io_lock);
+  return ret;
+}
+
+static esp_err_t
+bus_acquire(sh1106_renderer_bus_handle bus) {
+  return bus->arbiter ? i2c_arbiter_acquire(bus->arbiter, bus->arbiter_priority, SH1106_RENDERER_BUS_WAIT_MS) : ESP_OK;
+}
+static void
+bus_release(sh1106_renderer_bus_handle bus) {
+  if (bus->arbiter) {
+    i2c_arbiter_release(bus->arbiter);
+  }
+}
+static esp_err_t
+bus_yield(sh1106_renderer_bus_handle bus) {
+  return bus->arbiter ? i2c_arbiter_yield(bus->arbiter, SH1106_RENDERER_BUS_WAIT_MS) : ESP_OK;
+}
+static void
+bus_count(sh1106_renderer_bus_handle bus, size_t bytes) {
+  if (bus->arbiter) {
+    i2c_arbiter_count_bytes(bus->arbiter, (uint32_t)bytes);
+  }
+}
+
+static esp_err_t
+mux_select(sh1106_renderer_bus_handle bus, uint8_t channel) {
+  if (!bus->mux)
+    return ESP_OK;
+  return pca9548a_mux_select(bus->mux, channel);
+}
+static esp_err_t
+mux_write(void *user_ctx, uint8_t address, uint8_t ctrl) {
+  struct sh1106_renderer_bus *bus = (struct sh1106_renderer_bus *)user_ctx;
+  esp_err_t ret = i2c_master_transmit(bus->mux_dev, &ctrl, 1, SH1106_RENDERER_I2C_TIMEOUT_MS);
+  bus_count(bus, ret == ESP_OK ? 2U : 0U);
+  return ret;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef SH1106_RENDERER_H
+#define SH1106_RENDERER_H
+
+#include "esp_err.h"
+
+#include "driver/i2c_master.h"
+
+#include "grid_composer_defs.h"
+#include "i2c_arbiter.h"
+#include "pca9548a_mux.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SH1106_RENDERER_NO_MUX 0U
+
+typedef struct sh1106_renderer_bus *sh1106_renderer_bus_handle;
+typedef struct sh1106_renderer *sh1106_renderer_handle;
+
+/**
+ * Called from the bus transfer task once a flush of the renderer has been put on the wire (or failed).
+ */
+typedef void (*sh1106_renderer_flush_done_cb_t)(sh1106_renderer_handle renderer, esp_err_t result, void *user_ctx);
+
+/**
+ * One transfer engine per I2C bus, shared by all panels behind the same PCA9548A.
+ * The bus must be owned by the i2c_master driver, it cannot share a port with Arduino Wire.
+ */
+struct sh1106_renderer_bus_config {
+  i2c_master_bus_handle_t i2c_bus;
+  uint32_t scl_speed_hz;
+  uint16_t panel_address;
+  uint16_t mux_address; // SH1106_RENDERER_NO_MUX if panels are wired directly
+
+  i2c_arbiter_handle arbiter; // optional, a flush then gives the bus up between pages to more urgent clients
+  uint8_t arbiter_priority;
+};
+
+struct sh1106_renderer_config {
+  sh1106_renderer_bus_handle bus;
+  uint8_t mux_channel;
+  uint16_t width;
+  uint16_t height;
+
+  sh1106_renderer_flush_done_cb_t on_flush_done;
+  void *user_ctx;
+};
+
+esp_err_t
+sh1106_renderer_bus_new(const struct sh1106_renderer_bus_config *bus_cfg, sh1106_renderer_bus_handle *out_bus);
+esp_err_t
+sh1106_renderer_bus_del(sh1106_renderer_bus_handle bus);
+
+/**
+ * The bus owns the mux, a frame is everything the flush task drained from its queue in one go
+ */
+esp_err_t
+sh1106_renderer_bus_get_mux(sh1106_renderer_bus_handle bus, pca9548a_mux_handle *out_mux);
+
+/**
+ * Rasterizes the glyphs into the bus glyph cache ahead of the first draw, otherwise they are cached on first use
+ */
+esp_err_t
+sh1106_renderer_bus_preload_glyphs(sh1106_renderer_bus_handle bus, const uint8_t *font, const char *glyphs);
+
+/**
+ * Allocates the framebuffer and runs the panel init sequence synchronously
+ */
+esp_err_t
+sh1106_renderer_new(const struct sh1106_renderer_config *renderer_cfg, sh1106_renderer_handle *out_renderer);
+esp_err_t
+sh1106_renderer_del(sh1106_renderer_handle renderer);
+
+/**
+ * Blocks until every queued flush of the renderer has been transferred
+ */
+esp_err_t
+sh1106_renderer_wait_flush(sh1106_renderer_handle renderer, uint32_t timeout_ms);
+
+/**
+ * grid_composer_renderer callbacks, ctx is a sh1106_renderer_handle.
+ * They only rasterize into RAM and queue the touched columns, the transfer runs on the bus task.
+ */
+esp_err_t
+sh1106_renderer_clear(void *ctx);
+esp_err_t
+sh1106_renderer_draw_figure(void *ctx, const grid_composer_figure_info *info, uint16_t color, bool fill);
+esp_err_t
+sh1106_renderer_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
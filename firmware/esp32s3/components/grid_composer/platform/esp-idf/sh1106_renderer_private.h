@@ -0,0 +1,47 @@
+#pragma once
+#ifndef SH1106_RENDERER_PRIVATE_H
+#define SH1106_RENDERER_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SH1106_RENDERER_MAX_PANELS     8U
+#define SH1106_RENDERER_COLUMN_OFFSET  2U // 132 column GDDRAM, 128 visible
+#define SH1106_RENDERER_I2C_TIMEOUT_MS 100U
+#define SH1106_RENDERER_FLUSH_WAIT_MS  1000U
+#define SH1106_RENDERER_BUS_WAIT_MS    1000U
+#define SH1106_RENDERER_RETRY_MS       500U // pause after a frame with a failed flush, the failed spans are queued again
+#define SH1106_RENDERER_TX_OVERHEAD    2U // address and control byte of every panel transaction
+
+#define SH1106_RENDERER_GLYPH_ARENA_SIZE 8192U // enough for the clock digits and a couple of text fonts
+
+#define SH1106_RENDERER_TASK_STACK 3072U
+#define SH1106_RENDERER_TASK_PRIO  19U
+#define SH1106_RENDERER_TASK_CORE  1U
+
+#define SH1106_CMD_DISPLAY_OFF        0xAEU
+#define SH1106_CMD_DISPLAY_ON         0xAFU
+#define SH1106_CMD_SET_CLOCK_DIV      0xD5U
+#define SH1106_CMD_SET_MULTIPLEX      0xA8U
+#define SH1106_CMD_SET_DISPLAY_OFFSET 0xD3U
+#define SH1106_CMD_SET_START_LINE     0x40U
+#define SH1106_CMD_DCDC               0xADU
+#define SH1106_CMD_SEG_REMAP          0xA1U
+#define SH1106_CMD_COM_SCAN_DEC       0xC8U
+#define SH1106_CMD_SET_COM_PINS       0xDAU
+#define SH1106_CMD_SET_CONTRAST       0x81U
+#define SH1106_CMD_SET_PRECHARGE      0xD9U
+#define SH1106_CMD_SET_VCOM_DETECT    0xDBU
+#define SH1106_CMD_NORMAL_DISPLAY     0xA6U
+#define SH1106_CMD_DISPLAY_RESUME     0xA4U
+#define SH1106_CMD_SET_PAGE_ADDR      0xB0U
+#define SH1106_CMD_SET_COL_LOW        0x00U
+#define SH1106_CMD_SET_COL_HIGH       0x10U
+#define SH1106_CMD_SET_VPP_9V         0x33U
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
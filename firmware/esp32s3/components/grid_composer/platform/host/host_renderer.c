@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "mono_canvas.h"
+#include "mono_font.h"
+#include "mono_glyph_cache.h"
+
+#include "host_renderer_private.h"
+
+#include "host_renderer.h"
+
+struct host_renderer {
+  struct host_renderer_config cfg;
+
+  mono_canvas canvas;
+  uint8_t *framebuffer;
+
+  SemaphoreHandle_t lock;
+  host_renderer_stats stats;
+};
+
+static const char *TAG = "host_renderer";
+
+static uint64_t
+now_ns(void);
+static void
+account_draw(host_renderer_handle renderer, uint64_t start_ns);
+
+esp_err_t
+host_renderer_new(const struct host_renderer_config *renderer_cfg, host_renderer_handle *out_renderer) {
+  esp_err_t ret = ESP_OK;
+  struct host_renderer *renderer = NULL;
+
+  ESP_RETURN_ON_FALSE(renderer_cfg && out_renderer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(renderer_cfg->width && renderer_cfg->width <= HOST_RENDERER_MAX_WIDTH && renderer_cfg->height &&
+                          renderer_cfg->height <= HOST_RENDERER_MAX_HEIGHT,
+                      ESP_ERR_INVALID_ARG, TAG, "unsupported panel size %ux%u", renderer_cfg->width, renderer_cfg->height);
+
+  renderer = calloc(1, sizeof(struct host_renderer));
+  ESP_RETURN_ON_FALSE(renderer, ESP_ERR_NO_MEM, TAG, "failed to allocate renderer");
+
+  renderer->cfg = *renderer_cfg;
+  renderer->framebuffer = calloc(1, MONO_CANVAS_BUFFER_SIZE(renderer_cfg->width, renderer_cfg->height));
+  ESP_GOTO_ON_FALSE(renderer->framebuffer, ESP_ERR_NO_MEM, err, TAG, "failed to allocate framebuffer");
+  mono_canvas_init(&renderer->canvas, renderer_cfg->width, renderer_cfg->height, renderer->framebuffer);
+  mono_canvas_mark_clean(&renderer->canvas);
+
+  renderer->lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(renderer->lock, ESP_ERR_NO_MEM, err, TAG, "failed to create renderer lock");
+
+  *out_renderer = renderer;
+  return ESP_OK;
+err:
+  free(renderer->framebuffer);
+  free(renderer);
+  return ret;
+}
+esp_err_t
+host_renderer_del(host_renderer_handle renderer) {
+  ESP_RETURN_ON_FALSE(renderer, ESP_ERR_INVALID_ARG, TAG, "invalid renderer");
+
+  vSemaphoreDelete(renderer->lock);
+  free(renderer->framebuffer);
+  free(renderer);
+  return ESP_OK;
+}
+
+esp_err_t
+host_renderer_clear(void *ctx) {
+  ESP_RETURN_ON_FALSE(ctx, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  host_renderer_handle renderer = (host_renderer_handle)ctx;
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  uint64_t start_ns = now_ns();
+  mono_canvas_fill(&renderer->canvas, MONO_CANVAS_COLOR_BLACK);
+  account_draw(renderer, start_ns);
+  xSemaphoreGive(renderer->lock);
+
+  return ESP_OK;
+}
+esp_err_t
+host_renderer_draw_figure(void *ctx, const grid_composer_figure_info *info, uint16_t color, bool fill) {
+  ESP_RETURN_ON_FALSE(ctx && info, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  host_renderer_handle renderer = (host_renderer_handle)ctx;
+  mono_canvas *canvas = &renderer->canvas;
+  esp_err_t ret = ESP_OK;
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  uint64_t start_ns = now_ns();
+  switch (info->type) {
+  case GRID_COMPOSER_FIGURE_RECT:
+    if (fill) {
+      mono_canvas_fill_rect(canvas, info->info.rect.x, info->info.rect.y, info->info.rect.w, info->info.rect.h, color);
+    } else {
+      mono_canvas_draw_rect(canvas, info->info.rect.x, info->info.rect.y, info->info.rect.w, info->info.rect.h, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_ROUND_RECT:
+    if (fill) {
+      mono_canvas_fill_round_rect(canvas, info->info.round_rect.x, info->info.round_rect.y, info->info.round_rect.w,
+                                  info->info.round_rect.h, info->info.round_rect.r, color);
+    } else {
+      mono_canvas_draw_round_rect(canvas, info->info.round_rect.x, info->info.round_rect.y, info->info.round_rect.w,
+                                  info->info.round_rect.h, info->info.round_rect.r, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_CIRCLE:
+    if (fill) {
+      mono_canvas_fill_circle(canvas, info->info.circle.x0, info->info.circle.y0, info->info.circle.r, color);
+    } else {
+      mono_canvas_draw_circle(canvas, info->info.circle.x0, info->info.circle.y0, info->info.circle.r, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_TRIANGLE:
+    if (fill) {
+      mono_canvas_fill_triangle(canvas, info->info.triangle.x0, info->info.triangle.y0, info->info.triangle.x1,
+                                info->info.triangle.y1, info->info.triangle.x2, info->info.triangle.y2, color);
+    } else {
+      mono_canvas_draw_triangle(canvas, info->info.triangle.x0, info->info.triangle.y0, info->info.triangle.x1,
+                                info->info.triangle.y1, info->info.triangle.x2, info->info.triangle.y2, color);
+    }
+    break;
+  case GRID_COMPOSER_FIGURE_LINE:
+    mono_canvas_draw_line(canvas, info->info.line.x0, info->info.line.y0, info->info.line.x1, info->info.line.y1, color);
+    break;
+  default:
+    ret = ESP_ERR_INVALID_ARG;
+    break;
+  }
+  account_draw(renderer, start_ns);
+  xSemaphoreGive(renderer->lock);
+
+  return ret;
+}
+esp_err_t
+host_renderer_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill) {
+  ESP_RETURN_ON_FALSE(ctx && info && info->text && info->font, ESP_ERR_INVALID_ARG, TAG, "invalid renderer ctx");
+  host_renderer_handle renderer = (host_renderer_handle)ctx;
+  mono_canvas *canvas = &renderer->canvas;
+  mono_glyph_cache *glyph_cache = renderer->cfg.glyph_cache;
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  uint64_t start_ns = now_ns();
+
+  mono_font_info font;
+  if (!mono_font_load(&font, info->font)) {
+    xSemaphoreGive(renderer->lock);
+    ESP_LOGE(TAG, "invalid font");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  int ascent = font.ascent_A;
+  int descent = font.descent_g;
+
+  int text_width = glyph_cache ? mono_glyph_cache_utf8_width(glyph_cache, &font, info->text)
+                               : mono_font_utf8_width(&font, info->text);
+  int x = info->x;
+  int y = info->y;
+
+  switch (info->h_align) {
+  case GRID_COMPOSER_H_ALIGN_LEFT:
+    break;
+  case GRID_COMPOSER_H_ALIGN_RIGHT:
+    x = canvas->width - text_width;
+    break;
+  case GRID_COMPOSER_H_ALIGN_CENTER:
+    x = (canvas->width - text_width) / 2;
+    break;
+  case GRID_COMPOSER_H_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+
+  switch (info->v_align) {
+  case GRID_COMPOSER_V_ALIGN_TOP:
+    y = ascent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_BOTTOM:
+    y = canvas->height + descent;
+    break;
+  case GRID_COMPOSER_V_ALIGN_CENTER:
+    y = (canvas->height + ascent - descent) / 2;
+    break;
+  case GRID_COMPOSER_V_ALIGN_NONE:
+    break;
+  default:
+    ESP_LOGE(TAG, "alignment not supported");
+  }
+  if (y < 0 || x < 0) {
+    xSemaphoreGive(renderer->lock);
+    ESP_LOGE(TAG, "negative cursor position not supported");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  if (glyph_cache) {
+    mono_glyph_cache_draw_utf8(glyph_cache, canvas, &font, (int16_t)x, (int16_t)y, info->text, color, fill);
+  } else {
+    mono_font_draw_utf8(canvas, &font, (int16_t)x, (int16_t)y, info->text, color, fill);
+  }
+  account_draw(renderer, start_ns);
+  xSemaphoreGive(renderer->lock);
+
+  return ESP_OK;
+}
+
+esp_err_t
+host_renderer_get_stats(host_renderer_handle renderer, host_renderer_stats *out_stats) {
+  ESP_RETURN_ON_FALSE(renderer && out_stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  *out_stats = renderer->stats;
+  xSemaphoreGive(renderer->lock);
+  return ESP_OK;
+}
+esp_err_t
+host_renderer_reset_stats(host_renderer_handle renderer) {
+  ESP_RETURN_ON_FALSE(renderer, ESP_ERR_INVALID_ARG, TAG, "invalid renderer");
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  memset(&renderer->stats, 0, sizeof(renderer->stats));
+  xSemaphoreGive(renderer->lock);
+  return ESP_OK;
+}
+
+esp_err_t
+host_renderer_dump_pbm(host_renderer_handle renderer, const char *path) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(renderer && path, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  FILE *file = fopen(path, "wb");
+  ESP_RETURN_ON_FALSE(file, ESP_FAIL, TAG, "failed to open %s", path);
+
+  xSemaphoreTake(renderer->lock, portMAX_DELAY);
+  const mono_canvas *canvas = &renderer->canvas;
+  uint16_t row_bytes = (uint16_t)((canvas->width + 7U) / 8U);
+  uint8_t row[(HOST_RENDERER_MAX_WIDTH + 7U) / 8U];
+
+  ESP_GOTO_ON_FALSE(fprintf(file, "P4\n%u %u\n", canvas->width, canvas->height) > 0, ESP_FAIL, out, TAG, "failed to write %s",
+                    path);
+  for (uint16_t y = 0; y < canvas->height; ++y) {
+    memset(row, 0, row_bytes);
+    const uint8_t *page = &canvas->buffer[(size_t)(y / MONO_CANVAS_PAGE_HEIGHT) * canvas->width];
+    for (uint16_t x = 0; x < canvas->width; ++x) {
+      bool lit = page[x] & (1U << (y % MONO_CANVAS_PAGE_HEIGHT));
+      // PBM 1 is black
+      if (!lit) {
+        row[x / 8U] |= (uint8_t)(0x80U >> (x % 8U));
+      }
+    }
+    ESP_GOTO_ON_FALSE(fwrite(row, 1, row_bytes, file) == row_bytes, ESP_FAIL, out, TAG, "failed to write %s", path);
+  }
+out:
+  xSemaphoreGive(renderer->lock);
+  fclose(file);
+  return ret;
+}
+
+static uint64_t
+now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Must be called with the renderer lock held, the dirty spans are what a flush right after the draw would have sent
+ */
+static void
+account_draw(host_renderer_handle renderer, uint64_t start_ns) {
+  host_renderer_stats *stats = &renderer->stats;
+  mono_canvas *canvas = &renderer->canvas;
+
+  uint64_t elapsed_ns = now_ns() - start_ns;
+  stats->draws++;
+  stats->draw_ns += elapsed_ns;
+  if (elapsed_ns > stats->draw_ns_max) {
+    stats->draw_ns_max = (uint32_t)elapsed_ns;
+  }
+
+  if (!mono_canvas_is_dirty(canvas))
+    return;
+
+  stats->flushes++;
+  for (uint8_t p = 0; p < canvas->pages; ++p) {
+    int16_t x0 = 0;
+    int16_t x1 = (int16_t)(canvas->width - 1U);
+    if (!renderer->cfg.full_flush && !mono_canvas_page_dirty_span(canvas, p, &x0, &x1))
+      continue;
+
+    stats->page_writes++;
+    stats->bus_bytes += HOST_RENDERER_PAGE_CMD_BYTES + HOST_RENDERER_PAGE_DATA_OVERHEAD + (uint64_t)(x1 - x0 + 1);
+  }
+  mono_canvas_mark_clean(canvas);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef HOST_RENDERER_H
+#define HOST_RENDERER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "grid_composer_defs.h"
+#include "mono_glyph_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_renderer *host_renderer_handle;
+
+/**
+ * Framebuffer only backend for the linux target, draws with the same mono_canvas/mono_font code as sh1106_renderer
+ */
+struct host_renderer_config {
+  uint16_t width;
+  uint16_t height;
+
+  bool full_flush;               // account every flush as a whole frame (Adafruit display()), otherwise dirty spans only
+  mono_glyph_cache *glyph_cache; // optional, not locked, all renderers sharing it must be drawn from one task
+};
+
+typedef struct {
+  uint32_t draws; // renderer calls, one per descriptor (a widget redraw can take several)
+  uint64_t draw_ns;
+  uint32_t draw_ns_max;
+
+  uint32_t flushes;     // one per draw that changed pixels, the panel would have been written right after it
+  uint32_t page_writes; // page address + data transfers
+  uint64_t bus_bytes;   // I2C bytes the panel would have received, address and control bytes included
+} host_renderer_stats;
+
+esp_err_t
+host_renderer_new(const struct host_renderer_config *renderer_cfg, host_renderer_handle *out_renderer);
+esp_err_t
+host_renderer_del(host_renderer_handle renderer);
+
+/**
+ * grid_composer_renderer callbacks, ctx is a host_renderer_handle
+ */
+esp_err_t
+host_renderer_clear(void *ctx);
+esp_err_t
+host_renderer_draw_figure(void *ctx, const grid_composer_figure_info *info, uint16_t color, bool fill);
+esp_err_t
+host_renderer_draw_text(void *ctx, const grid_composer_text_info *info, uint16_t color, bool fill);
+
+esp_err_t
+host_renderer_get_stats(host_renderer_handle renderer, host_renderer_stats *out_stats);
+esp_err_t
+host_renderer_reset_stats(host_renderer_handle renderer);
+
+/**
+ * Writes the framebuffer as a binary PBM (P4), lit pixels come out white like on the panel
+ */
+esp_err_t
+host_renderer_dump_pbm(host_renderer_handle renderer, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
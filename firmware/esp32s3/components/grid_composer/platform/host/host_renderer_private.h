@@ -0,0 +1,20 @@
+#pragma once
+#ifndef HOST_RENDERER_PRIVATE_H
+#define HOST_RENDERER_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_RENDERER_MAX_WIDTH  128U
+#define HOST_RENDERER_MAX_HEIGHT 64U
+
+/* Same transfers as sh1106_renderer: address + control + page/column commands, then address + control + page data */
+#define HOST_RENDERER_PAGE_CMD_BYTES     5U
+#define HOST_RENDERER_PAGE_DATA_OVERHEAD 2U
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
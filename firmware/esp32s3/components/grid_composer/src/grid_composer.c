@@ -1,8 +1,13 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "esp_check.h"
 #include "esp_err.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 #include "grid_composer.h"
@@ -19,10 +24,41 @@ struct grid_composer_cell_dev {
   grid_composer_renderer renderer;
 };
 
+struct grid_composer_widget {
+  grid_composer_widget_config cfg;
+  grid_composer_handle composer;
+
+  /* Written by the setters, guarded by the composer widget lock */
+  bool pending;
+  bool force_redraw;
+  float value;
+  char text[GRID_COMPOSER_WIDGET_TEXT_MAX_LEN];
+  float *samples;
+  uint8_t samples_head;
+  uint8_t samples_cnt;
+
+  /* What is on the panel, only touched by the draw task */
+  bool drawn;
+  char rendered_text[GRID_COMPOSER_WIDGET_TEXT_MAX_LEN];
+  int16_t rendered_fill;
+  int16_t *rendered_ys;
+  uint8_t rendered_cnt;
+};
+
 struct grid_composer {
   struct grid_composer_cell_dev *cell_devices[GRID_COMPOSER_CELL_MAX_ROWS][GRID_COMPOSER_CELL_MAX_COLS];
   QueueHandle_t draw_queue;
   TaskHandle_t draw_update_task_handle;
+
+  grid_composer_draw_descriptor frame[GRID_COMPOSER_DRAW_QUEUE_MAX_ITEMS];
+  int16_t last_cell;
+
+  grid_composer_frame_done_cb_t on_frame_done;
+  void *frame_done_ctx;
+
+  SemaphoreHandle_t widget_lock;
+  struct grid_composer_widget *widgets[GRID_COMPOSER_WIDGET_MAX_COUNT];
+  uint8_t widget_cnt;
 };
 
 static const char *TAG = "grid_composer_module";
@@ -35,9 +71,26 @@ task_draw_update(void *arg);
 static esp_err_t
 draw(struct grid_composer_cell_dev *cell_dev, const grid_composer_draw_obj_info *draw_obj, bool clear_before);
 
+static esp_err_t
+draw_widget(struct grid_composer *composer, struct grid_composer_cell_dev *cell_dev, struct grid_composer_widget *widget,
+            grid_composer_frame_stats *stats);
+static void
+force_redraw(struct grid_composer *composer, struct grid_composer_widget *widget);
+static esp_err_t
+render_widget(struct grid_composer_cell_dev *cell_dev, const struct grid_composer_widget *widget);
+static esp_err_t
+queue_widget(struct grid_composer_widget *widget);
+static bool
+rects_overlap(const grid_composer_rect *a, const grid_composer_rect *b);
+
 static esp_err_t
 push_cell(grid_composer_handle composer, struct grid_composer_cell_dev *cell_dev);
 
+static void
+group_by_cell(grid_composer_draw_descriptor *frame, uint8_t frame_len, int16_t first_cell);
+static inline int16_t
+cell_index(const grid_composer_draw_descriptor *draw_desc);
+
 static bool
 validate_renderer(const grid_composer_renderer *renderer);
 
@@ -45,6 +98,10 @@ esp_err_t
 grid_composer_init(grid_composer_handle *out_composer) {
   esp_err_t ret = ESP_OK;
 
+  grid_composer_instance.last_cell = -1;
+  grid_composer_instance.widget_lock = xSemaphoreCreateMutex();
+  ESP_RETURN_ON_FALSE(grid_composer_instance.widget_lock, ESP_ERR_NO_MEM, TAG, "failed to create widget lock");
+
   grid_composer_instance.draw_queue = xQueueCreate(GRID_COMPOSER_DRAW_QUEUE_MAX_ITEMS, sizeof(grid_composer_draw_descriptor));
 
   ESP_RETURN_ON_FALSE(grid_composer_instance.draw_queue, ESP_ERR_NO_MEM, TAG, "failed to create draw queue, not enough memory");
@@ -78,6 +135,19 @@ grid_composer_del(grid_composer_handle composer) {
     }
   }
 
+  for (uint8_t i = 0; i < composer->widget_cnt; ++i) {
+    free(composer->widgets[i]->samples);
+    free(composer->widgets[i]->rendered_ys);
+    free(composer->widgets[i]);
+    composer->widgets[i] = NULL;
+  }
+  composer->widget_cnt = 0;
+
+  if (composer->widget_lock) {
+    vSemaphoreDelete(composer->widget_lock);
+    composer->widget_lock = NULL;
+  }
+
   if (composer->draw_queue) {
     vQueueDelete(composer->draw_queue);
     composer->draw_queue = NULL;
@@ -91,6 +161,111 @@ grid_composer_del(grid_composer_handle composer) {
   return ESP_OK;
 }
 
+esp_err_t
+grid_composer_set_frame_done_cb(grid_composer_handle composer, grid_composer_frame_done_cb_t cb, void *user_ctx) {
+  ESP_RETURN_ON_FALSE(composer, ESP_ERR_INVALID_ARG, TAG, "invalid composer");
+
+  composer->frame_done_ctx = user_ctx;
+  composer->on_frame_done = cb;
+  return ESP_OK;
+}
+
+esp_err_t
+grid_composer_widget_add(grid_composer_handle composer, const grid_composer_widget_config *widget_cfg,
+                         grid_composer_widget_handle *out_widget) {
+  esp_err_t ret = ESP_OK;
+  struct grid_composer_widget *widget = NULL;
+
+  ESP_RETURN_ON_FALSE(composer && widget_cfg && out_widget, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(widget_cfg->cell_row >= 0 && widget_cfg->cell_row < (int8_t)GRID_COMPOSER_CELL_MAX_ROWS &&
+                          widget_cfg->cell_col >= 0 && widget_cfg->cell_col < (int8_t)GRID_COMPOSER_CELL_MAX_COLS &&
+                          composer->cell_devices[widget_cfg->cell_row][widget_cfg->cell_col],
+                      ESP_ERR_INVALID_ARG, TAG, "no cell device for the widget");
+  ESP_RETURN_ON_FALSE(widget_cfg->box.w > 0 && widget_cfg->box.h > 0, ESP_ERR_INVALID_ARG, TAG, "invalid widget box");
+  ESP_RETURN_ON_FALSE(composer->widget_cnt < GRID_COMPOSER_WIDGET_MAX_COUNT, ESP_ERR_NO_MEM, TAG, "too many widgets");
+
+  switch (widget_cfg->type) {
+  case GRID_COMPOSER_WIDGET_LABEL:
+  case GRID_COMPOSER_WIDGET_VALUE:
+    ESP_RETURN_ON_FALSE(widget_cfg->text.font && widget_cfg->text.format, ESP_ERR_INVALID_ARG, TAG,
+                        "text widget needs a font and a format");
+    break;
+  case GRID_COMPOSER_WIDGET_BAR:
+    ESP_RETURN_ON_FALSE(widget_cfg->bar.max > widget_cfg->bar.min, ESP_ERR_INVALID_ARG, TAG, "invalid bar range");
+    break;
+  case GRID_COMPOSER_WIDGET_SPARKLINE:
+    ESP_RETURN_ON_FALSE(widget_cfg->sparkline.points >= 2U &&
+                            widget_cfg->sparkline.points <= GRID_COMPOSER_WIDGET_SPARKLINE_MAX_POINTS,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid sparkline point count");
+    break;
+  default:
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  widget = calloc(1, sizeof(struct grid_composer_widget));
+  ESP_RETURN_ON_FALSE(widget, ESP_ERR_NO_MEM, TAG, "failed to allocate a widget");
+
+  widget->cfg = *widget_cfg;
+  widget->composer = composer;
+
+  if (widget_cfg->type == GRID_COMPOSER_WIDGET_SPARKLINE) {
+    widget->samples = calloc(widget_cfg->sparkline.points, sizeof(float));
+    widget->rendered_ys = calloc(widget_cfg->sparkline.points, sizeof(int16_t));
+    ESP_GOTO_ON_FALSE(widget->samples && widget->rendered_ys, ESP_ERR_NO_MEM, err, TAG, "failed to allocate sparkline");
+  }
+
+  xSemaphoreTake(composer->widget_lock, portMAX_DELAY);
+  composer->widgets[composer->widget_cnt++] = widget;
+  xSemaphoreGive(composer->widget_lock);
+
+  // Labels have content from the start, the rest waits for its first value
+  if (widget_cfg->type == GRID_COMPOSER_WIDGET_LABEL) {
+    ESP_RETURN_ON_ERROR(grid_composer_widget_set_text(widget, widget_cfg->text.format), TAG, "failed to queue a label");
+  }
+
+  *out_widget = widget;
+  return ESP_OK;
+err:
+  free(widget->samples);
+  free(widget->rendered_ys);
+  free(widget);
+  return ret;
+}
+
+esp_err_t
+grid_composer_widget_set_value(grid_composer_widget_handle widget, float value) {
+  ESP_RETURN_ON_FALSE(widget, ESP_ERR_INVALID_ARG, TAG, "invalid widget");
+  ESP_RETURN_ON_FALSE(widget->cfg.type != GRID_COMPOSER_WIDGET_LABEL, ESP_ERR_INVALID_ARG, TAG, "labels take text");
+
+  xSemaphoreTake(widget->composer->widget_lock, portMAX_DELAY);
+  widget->value = value;
+  if (widget->cfg.type == GRID_COMPOSER_WIDGET_SPARKLINE) {
+    widget->samples[widget->samples_head] = value;
+    widget->samples_head = (uint8_t)((widget->samples_head + 1U) % widget->cfg.sparkline.points);
+    if (widget->samples_cnt < widget->cfg.sparkline.points) {
+      widget->samples_cnt++;
+    }
+  }
+  bool was_pending = widget->pending;
+  widget->pending = true;
+  xSemaphoreGive(widget->composer->widget_lock);
+
+  return was_pending ? ESP_OK : queue_widget(widget);
+}
+esp_err_t
+grid_composer_widget_set_text(grid_composer_widget_handle widget, const char *text) {
+  ESP_RETURN_ON_FALSE(widget && text, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(widget->cfg.type == GRID_COMPOSER_WIDGET_LABEL, ESP_ERR_INVALID_ARG, TAG, "only labels take text");
+
+  xSemaphoreTake(widget->composer->widget_lock, portMAX_DELAY);
+  snprintf(widget->text, sizeof(widget->text), "%s", text);
+  bool was_pending = widget->pending;
+  widget->pending = true;
+  xSemaphoreGive(widget->composer->widget_lock);
+
+  return was_pending ? ESP_OK : queue_widget(widget);
+}
+
 esp_err_t
 grid_composer_draw_queue_send(grid_composer_handle composer, const grid_composer_draw_descriptor *draw_desc,
                               uint32_t timeout_ms) {
@@ -131,16 +306,47 @@ task_draw_update(void *arg) {
 
   struct grid_composer *grid_composer_inst = (struct grid_composer *)arg;
 
-  grid_composer_draw_descriptor draw_desc;
+  grid_composer_draw_descriptor *frame = grid_composer_inst->frame;
   for (;;) {
-    if (xQueueReceive(grid_composer_inst->draw_queue, &draw_desc, portMAX_DELAY) == pdTRUE) {
-      if (draw_desc.cell_row >= GRID_COMPOSER_CELL_MAX_ROWS || draw_desc.cell_col >= GRID_COMPOSER_CELL_MAX_COLS) {
+    if (xQueueReceive(grid_composer_inst->draw_queue, &frame[0], portMAX_DELAY) != pdTRUE)
+      continue;
+
+    // Whatever is already queued joins the frame, so each cell (mux channel) is visited once
+    uint8_t frame_len = 1;
+    while (frame_len < GRID_COMPOSER_DRAW_QUEUE_MAX_ITEMS &&
+           xQueueReceive(grid_composer_inst->draw_queue, &frame[frame_len], 0) == pdTRUE) {
+      frame_len++;
+    }
+    group_by_cell(frame, frame_len, grid_composer_inst->last_cell);
+
+    grid_composer_frame_stats stats = {0};
+    for (uint8_t i = 0; i < frame_len; ++i) {
+      const grid_composer_draw_descriptor *draw_desc = &frame[i];
+      if (draw_desc->cell_row < 0 || draw_desc->cell_row >= (int8_t)GRID_COMPOSER_CELL_MAX_ROWS || draw_desc->cell_col < 0 ||
+          draw_desc->cell_col >= (int8_t)GRID_COMPOSER_CELL_MAX_COLS) {
         ESP_LOGE(TAG, "invalid cell row or column idx");
         continue;
       }
-      // SUGGESTION: Use locks?
-      ESP_ERROR_CHECK_WITHOUT_ABORT(draw(grid_composer_inst->cell_devices[draw_desc.cell_row][draw_desc.cell_col],
-                                         &draw_desc.draw_obj, draw_desc.clear_before));
+
+      int16_t cell = cell_index(draw_desc);
+      if (cell != grid_composer_inst->last_cell) {
+        stats.cell_switches++;
+        grid_composer_inst->last_cell = cell;
+      }
+      stats.draws++;
+
+      struct grid_composer_cell_dev *cell_dev = grid_composer_inst->cell_devices[draw_desc->cell_row][draw_desc->cell_col];
+      if (draw_desc->draw_obj.content_type == GRID_COMPOSER_CONTENT_WIDGET) {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(draw_widget(grid_composer_inst, cell_dev, draw_desc->draw_obj.widget, &stats));
+        continue;
+      }
+
+      // Renderers given an I2C arbiter wait for the bus there, behind the sensors
+      ESP_ERROR_CHECK_WITHOUT_ABORT(draw(cell_dev, &draw_desc->draw_obj, draw_desc->clear_before));
+    }
+
+    if (grid_composer_inst->on_frame_done) {
+      grid_composer_inst->on_frame_done(grid_composer_inst, &stats, grid_composer_inst->frame_done_ctx);
     }
     // vTaskDelay(pdMS_TO_TICKS((uint32_t)(1000 / GRID_COMPOSER_DRAW_TASK_UPDATE_RATE)));
   }
@@ -179,6 +385,216 @@ draw(struct grid_composer_cell_dev *cell_dev, const grid_composer_draw_obj_info
   return ESP_OK;
 }
 
+/**
+ * Formats the latest value and compares it to what is on the panel, unchanged widgets cost no renderer calls.
+ * Clearing the box can cut into overlapping widgets of the same cell, those are drawn again on top. A widget that
+ * failed to draw is drawn in full with its next update, whether its content changed or not.
+ */
+static esp_err_t
+draw_widget(struct grid_composer *composer, struct grid_composer_cell_dev *cell_dev, struct grid_composer_widget *widget,
+            grid_composer_frame_stats *stats) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(cell_dev && widget, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  const grid_composer_widget_config *cfg = &widget->cfg;
+  char text[GRID_COMPOSER_WIDGET_TEXT_MAX_LEN];
+  float samples[GRID_COMPOSER_WIDGET_SPARKLINE_MAX_POINTS];
+  uint8_t samples_cnt = 0;
+  float value = 0.0f;
+
+  xSemaphoreTake(composer->widget_lock, portMAX_DELAY);
+  bool changed = widget->force_redraw || !widget->drawn;
+  widget->pending = false;
+  widget->force_redraw = false;
+  value = widget->value;
+  memcpy(text, widget->text, sizeof(text));
+  if (cfg->type == GRID_COMPOSER_WIDGET_SPARKLINE) {
+    // Oldest first
+    samples_cnt = widget->samples_cnt;
+    uint8_t start = (uint8_t)((widget->samples_head + cfg->sparkline.points - samples_cnt) % cfg->sparkline.points);
+    for (uint8_t i = 0; i < samples_cnt; ++i) {
+      samples[i] = widget->samples[(start + i) % cfg->sparkline.points];
+    }
+  }
+  xSemaphoreGive(composer->widget_lock);
+
+  switch (cfg->type) {
+  case GRID_COMPOSER_WIDGET_LABEL:
+    changed |= strcmp(text, widget->rendered_text) != 0;
+    memcpy(widget->rendered_text, text, sizeof(text));
+    break;
+  case GRID_COMPOSER_WIDGET_VALUE:
+    snprintf(text, sizeof(text), cfg->text.format, (double)value);
+    changed |= strcmp(text, widget->rendered_text) != 0;
+    memcpy(widget->rendered_text, text, sizeof(text));
+    break;
+  case GRID_COMPOSER_WIDGET_BAR: {
+    float ratio = (value - cfg->bar.min) / (cfg->bar.max - cfg->bar.min);
+    ratio = (ratio < 0.0f) ? 0.0f : (ratio > 1.0f ? 1.0f : ratio);
+    int16_t fill = (int16_t)(ratio * (float)(cfg->box.w - 2) + 0.5f);
+    changed |= fill != widget->rendered_fill;
+    widget->rendered_fill = fill;
+    break;
+  }
+  case GRID_COMPOSER_WIDGET_SPARKLINE: {
+    float min = cfg->sparkline.min;
+    float max = cfg->sparkline.max;
+    if (max <= min && samples_cnt) {
+      min = max = samples[0];
+      for (uint8_t i = 1; i < samples_cnt; ++i) {
+        min = (samples[i] < min) ? samples[i] : min;
+        max = (samples[i] > max) ? samples[i] : max;
+      }
+    }
+    float span = (max > min) ? (max - min) : 1.0f;
+
+    changed |= samples_cnt != widget->rendered_cnt;
+    for (uint8_t i = 0; i < samples_cnt; ++i) {
+      float ratio = (samples[i] - min) / span;
+      ratio = (ratio < 0.0f) ? 0.0f : (ratio > 1.0f ? 1.0f : ratio);
+      int16_t y = (int16_t)(cfg->box.y + cfg->box.h - 1 - (int16_t)(ratio * (float)(cfg->box.h - 1) + 0.5f));
+      changed |= y != widget->rendered_ys[i];
+      widget->rendered_ys[i] = y;
+    }
+    widget->rendered_cnt = samples_cnt;
+    break;
+  }
+  default:
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  if (!changed) {
+    stats->widgets_skipped++;
+    return ESP_OK;
+  }
+
+  grid_composer_figure_info box = {
+      .type = GRID_COMPOSER_FIGURE_RECT,
+      .info.rect = {.x = cfg->box.x, .y = cfg->box.y, .w = cfg->box.w, .h = cfg->box.h},
+  };
+  // The cache already holds the new content, so a failed draw has to be forced again
+  ESP_GOTO_ON_ERROR(cell_dev->renderer.draw_figure(cell_dev->renderer.user_ctx, &box, cfg->bg_color, true), err, TAG,
+                    "failed to clear a widget");
+  ESP_GOTO_ON_ERROR(render_widget(cell_dev, widget), err, TAG, "failed to draw a widget");
+  widget->drawn = true;
+  stats->widgets_drawn++;
+
+  // Widgets are only ever added, the ones counted under the lock stay where they are
+  xSemaphoreTake(composer->widget_lock, portMAX_DELAY);
+  uint8_t widget_cnt = composer->widget_cnt;
+  xSemaphoreGive(composer->widget_lock);
+  for (uint8_t i = 0; i < widget_cnt; ++i) {
+    struct grid_composer_widget *other = composer->widgets[i];
+    if (other == widget || !other->drawn || other->cfg.cell_row != cfg->cell_row || other->cfg.cell_col != cfg->cell_col)
+      continue;
+    if (rects_overlap(&other->cfg.box, &cfg->box) && render_widget(cell_dev, other) != ESP_OK) {
+      ESP_LOGE(TAG, "failed to draw an overlapping widget");
+      force_redraw(composer, other);
+      ret = ESP_FAIL;
+    }
+  }
+  return ret;
+err:
+  force_redraw(composer, widget);
+  return ret;
+}
+
+static void
+force_redraw(struct grid_composer *composer, struct grid_composer_widget *widget) {
+  xSemaphoreTake(composer->widget_lock, portMAX_DELAY);
+  widget->force_redraw = true;
+  xSemaphoreGive(composer->widget_lock);
+}
+
+static esp_err_t
+render_widget(struct grid_composer_cell_dev *cell_dev, const struct grid_composer_widget *widget) {
+  const grid_composer_widget_config *cfg = &widget->cfg;
+  const grid_composer_renderer *renderer = &cell_dev->renderer;
+
+  switch (cfg->type) {
+  case GRID_COMPOSER_WIDGET_LABEL:
+  case GRID_COMPOSER_WIDGET_VALUE: {
+    grid_composer_text_info text = {
+        .x = cfg->text.x,
+        .y = cfg->text.y,
+        .v_align = cfg->text.v_align,
+        .h_align = cfg->text.h_align,
+        .text = widget->rendered_text,
+        .font = cfg->text.font,
+    };
+    return renderer->draw_text(renderer->user_ctx, &text, cfg->color, false);
+  }
+  case GRID_COMPOSER_WIDGET_BAR: {
+    grid_composer_figure_info rect = {
+        .type = GRID_COMPOSER_FIGURE_RECT,
+        .info.rect = {.x = cfg->box.x, .y = cfg->box.y, .w = cfg->box.w, .h = cfg->box.h},
+    };
+    ESP_RETURN_ON_ERROR(renderer->draw_figure(renderer->user_ctx, &rect, cfg->color, false), TAG, "failed to draw bar frame");
+    if (widget->rendered_fill <= 0)
+      return ESP_OK;
+
+    rect.info.rect.x = cfg->box.x + 1;
+    rect.info.rect.y = cfg->box.y + 1;
+    rect.info.rect.w = widget->rendered_fill;
+    rect.info.rect.h = cfg->box.h - 2;
+    return renderer->draw_figure(renderer->user_ctx, &rect, cfg->color, true);
+  }
+  case GRID_COMPOSER_WIDGET_SPARKLINE: {
+    grid_composer_figure_info line = {.type = GRID_COMPOSER_FIGURE_LINE};
+    int16_t step_div = (int16_t)(cfg->sparkline.points - 1U);
+
+    if (widget->rendered_cnt == 1U) {
+      line.info.line.x0 = line.info.line.x1 = cfg->box.x;
+      line.info.line.y0 = line.info.line.y1 = widget->rendered_ys[0];
+      return renderer->draw_figure(renderer->user_ctx, &line, cfg->color, false);
+    }
+    for (uint8_t i = 1; i < widget->rendered_cnt; ++i) {
+      line.info.line.x0 = (int16_t)(cfg->box.x + (i - 1) * (cfg->box.w - 1) / step_div);
+      line.info.line.y0 = widget->rendered_ys[i - 1];
+      line.info.line.x1 = (int16_t)(cfg->box.x + i * (cfg->box.w - 1) / step_div);
+      line.info.line.y1 = widget->rendered_ys[i];
+      ESP_RETURN_ON_ERROR(renderer->draw_figure(renderer->user_ctx, &line, cfg->color, false), TAG,
+                          "failed to draw sparkline");
+    }
+    return ESP_OK;
+  }
+  default:
+    return ESP_ERR_INVALID_ARG;
+  }
+}
+
+/**
+ * Called without the widget lock (the draw task needs it to drain the queue) after the setter claimed the pending flag.
+ * A widget sits in the draw queue at most once, updates that land before the draw task gets to it are merged.
+ */
+static esp_err_t
+queue_widget(struct grid_composer_widget *widget) {
+  grid_composer_draw_descriptor draw_desc = {
+      .cell_row = widget->cfg.cell_row,
+      .cell_col = widget->cfg.cell_col,
+      .clear_before = false,
+      .draw_obj =
+          {
+              .content_type = GRID_COMPOSER_CONTENT_WIDGET,
+              .widget = widget,
+          },
+  };
+  if (xQueueSend(widget->composer->draw_queue, &draw_desc, pdMS_TO_TICKS(GRID_COMPOSER_WIDGET_QUEUE_TIMEOUT_MS)) != pdTRUE) {
+    // The value is kept, the next update queues it again
+    xSemaphoreTake(widget->composer->widget_lock, portMAX_DELAY);
+    widget->pending = false;
+    xSemaphoreGive(widget->composer->widget_lock);
+    ESP_LOGW(TAG, "failed to queue a widget update");
+    return ESP_ERR_TIMEOUT;
+  }
+  return ESP_OK;
+}
+
+static bool
+rects_overlap(const grid_composer_rect *a, const grid_composer_rect *b) {
+  return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
 static esp_err_t
 push_cell(grid_composer_handle composer, struct grid_composer_cell_dev *cell_dev) {
   ESP_RETURN_ON_FALSE(composer && cell_dev, ESP_ERR_INVALID_ARG, TAG, "invalid args");
@@ -202,6 +618,38 @@ validate_renderer(const grid_composer_renderer *renderer) {
   return renderer->clear && renderer->draw_figure && renderer->draw_text;
 }
 
+/**
+ * Stable insertion sort by cell, the cell drawn last goes first since its channel is still selected.
+ * Order within a cell is kept, draws on one panel depend on each other (clear, then text).
+ */
+static void
+group_by_cell(grid_composer_draw_descriptor *frame, uint8_t frame_len, int16_t first_cell) {
+  grid_composer_draw_descriptor draw_desc;
+
+  for (uint8_t i = 1; i < frame_len; ++i) {
+    int16_t key = cell_index(&frame[i]);
+    key = (key == first_cell) ? -1 : key;
+
+    uint8_t j = i;
+    for (; j > 0; --j) {
+      int16_t prev_key = cell_index(&frame[j - 1]);
+      prev_key = (prev_key == first_cell) ? -1 : prev_key;
+      if (prev_key <= key)
+        break;
+    }
+    if (j == i)
+      continue;
+
+    draw_desc = frame[i];
+    memmove(&frame[j + 1], &frame[j], (size_t)(i - j) * sizeof(grid_composer_draw_descriptor));
+    frame[j] = draw_desc;
+  }
+}
+static inline int16_t
+cell_index(const grid_composer_draw_descriptor *draw_desc) {
+  return (int16_t)(draw_desc->cell_row * GRID_COMPOSER_CELL_MAX_COLS + draw_desc->cell_col);
+}
+
 // esp_err_t
 // grid_composer_pop_cell(grid_composer_handle composer) {
 //   ESP_RETURN_ON_FALSE(composer, ESP_ERR_INVALID_ARG, TAG, "invalid composer");
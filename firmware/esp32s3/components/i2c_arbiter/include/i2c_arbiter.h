@@ -0,0 +1,55 @@
+#pragma once
+#ifndef I2C_ARBITER_H
+#define I2C_ARBITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "i2c_arbiter_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct i2c_arbiter *i2c_arbiter_handle;
+
+/**
+ * One per bus, every client of the bus goes through it whatever driver it runs on (Wire, i2c_master, esp_lcd)
+ */
+esp_err_t
+i2c_arbiter_new(const struct i2c_arbiter_config *arbiter_cfg, i2c_arbiter_handle *out_arbiter);
+esp_err_t
+i2c_arbiter_del(i2c_arbiter_handle arbiter);
+
+/**
+ * Waits until the bus is free and no client of a higher priority is waiting for it. Not recursive, must be paired
+ * with i2c_arbiter_release from the same task.
+ */
+esp_err_t
+i2c_arbiter_acquire(i2c_arbiter_handle arbiter, uint8_t priority, uint32_t timeout_ms);
+esp_err_t
+i2c_arbiter_release(i2c_arbiter_handle arbiter);
+
+/**
+ * Between the chunks of a long transfer. Returns right away if no more urgent client waits, otherwise hands the bus
+ * over and queues up again behind it. On a timeout the bus is no longer held.
+ */
+esp_err_t
+i2c_arbiter_yield(i2c_arbiter_handle arbiter, uint32_t timeout_ms);
+
+/**
+ * Called by the holder after a transfer, address and register bytes included
+ */
+esp_err_t
+i2c_arbiter_count_bytes(i2c_arbiter_handle arbiter, uint32_t bytes);
+
+esp_err_t
+i2c_arbiter_get_stats(i2c_arbiter_handle arbiter, i2c_arbiter_stats *out_stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef I2C_ARBITER_DEFS_H
+#define I2C_ARBITER_DEFS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_ARBITER_PRIO_COUNT   4U // 0 is served last, I2C_ARBITER_PRIO_COUNT - 1 first
+#define I2C_ARBITER_WAIT_BUCKETS 5U // under 100 us, 1 ms, 10 ms, 100 ms and beyond
+
+struct i2c_arbiter_config {
+  const char *name; // for the logs
+};
+
+/**
+ * Since the stats were last reset. A wait runs from the request to the bus being handed over, a yield that gave the
+ * bus away counts as a new request.
+ */
+typedef struct {
+  uint64_t window_us;
+  uint64_t busy_us;     // held by a client, utilization is busy_us / window_us
+  uint64_t bytes;       // moved on the wire as reported by the clients, throughput is bytes / window_us
+  uint32_t preemptions; // yields that handed the bus to a more urgent client
+  uint32_t timeouts;
+
+  uint32_t acquisitions[I2C_ARBITER_PRIO_COUNT];
+  uint32_t max_wait_us[I2C_ARBITER_PRIO_COUNT];
+  uint32_t wait_hist[I2C_ARBITER_PRIO_COUNT][I2C_ARBITER_WAIT_BUCKETS];
+} i2c_arbiter_stats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
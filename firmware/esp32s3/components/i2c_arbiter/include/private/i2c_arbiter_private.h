@@ -0,0 +1,15 @@
+#pragma once
+#ifndef I2C_ARBITER_PRIVATE_H
+#define I2C_ARBITER_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_ARBITER_MAX_WAITERS 8U // per priority, one per task that can wait at it
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,229 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#include "i2c_arbiter.h"
+#include "private/i2c_arbiter_private.h"
+
+struct i2c_arbiter {
+  struct i2c_arbiter_config cfg;
+
+  SemaphoreHandle_t lock; // guards everything below
+  // Waiters of a priority block on its gate, a give hands the bus to one of them while it stays held
+  SemaphoreHandle_t gates[I2C_ARBITER_PRIO_COUNT];
+  uint8_t waiting[I2C_ARBITER_PRIO_COUNT];
+
+  bool is_held;
+  uint8_t holder_priority;
+  uint64_t held_since_us;
+
+  i2c_arbiter_stats stats;
+  uint64_t stats_since_us;
+};
+
+static const char *TAG = "i2c_arbiter";
+
+static esp_err_t
+wait_turn(i2c_arbiter_handle arbiter, uint8_t priority, uint32_t timeout_ms, uint64_t request_us);
+static void
+hand_over(i2c_arbiter_handle arbiter, uint64_t now_us);
+static void
+record_wait(i2c_arbiter_handle arbiter, uint8_t priority, uint64_t request_us, uint64_t now_us);
+
+esp_err_t
+i2c_arbiter_new(const struct i2c_arbiter_config *arbiter_cfg, i2c_arbiter_handle *out_arbiter) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(arbiter_cfg && out_arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  struct i2c_arbiter *arbiter = calloc(1, sizeof(struct i2c_arbiter));
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_NO_MEM, TAG, "failed to allocate arbiter");
+
+  arbiter->cfg = *arbiter_cfg;
+  arbiter->lock = xSemaphoreCreateMutex();
+  ESP_GOTO_ON_FALSE(arbiter->lock, ESP_ERR_NO_MEM, err, TAG, "failed to create arbiter lock");
+  for (uint8_t i = 0; i < I2C_ARBITER_PRIO_COUNT; ++i) {
+    arbiter->gates[i] = xSemaphoreCreateCounting(I2C_ARBITER_MAX_WAITERS, 0);
+    ESP_GOTO_ON_FALSE(arbiter->gates[i], ESP_ERR_NO_MEM, err, TAG, "failed to create gate %u", i);
+  }
+  arbiter->stats_since_us = (uint64_t)esp_timer_get_time();
+
+  *out_arbiter = arbiter;
+  return ESP_OK;
+err:
+  for (uint8_t i = 0; i < I2C_ARBITER_PRIO_COUNT; ++i) {
+    if (arbiter->gates[i])
+      vSemaphoreDelete(arbiter->gates[i]);
+  }
+  if (arbiter->lock)
+    vSemaphoreDelete(arbiter->lock);
+  free(arbiter);
+  return ret;
+}
+esp_err_t
+i2c_arbiter_del(i2c_arbiter_handle arbiter) {
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid arbiter");
+  ESP_RETURN_ON_FALSE(!arbiter->is_held, ESP_ERR_INVALID_STATE, TAG, "%s is held", arbiter->cfg.name);
+
+  for (uint8_t i = 0; i < I2C_ARBITER_PRIO_COUNT; ++i) {
+    vSemaphoreDelete(arbiter->gates[i]);
+  }
+  vSemaphoreDelete(arbiter->lock);
+  free(arbiter);
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_arbiter_acquire(i2c_arbiter_handle arbiter, uint8_t priority, uint32_t timeout_ms) {
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid arbiter");
+  ESP_RETURN_ON_FALSE(priority < I2C_ARBITER_PRIO_COUNT, ESP_ERR_INVALID_ARG, TAG, "invalid priority %u", priority);
+
+  uint64_t request_us = (uint64_t)esp_timer_get_time();
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  if (!arbiter->is_held) {
+    // Nobody waits on a free bus, a release with waiters hands it over instead of freeing it
+    arbiter->is_held = true;
+    arbiter->holder_priority = priority;
+    arbiter->held_since_us = request_us;
+    record_wait(arbiter, priority, request_us, request_us);
+    xSemaphoreGive(arbiter->lock);
+    return ESP_OK;
+  }
+  return wait_turn(arbiter, priority, timeout_ms, request_us);
+}
+esp_err_t
+i2c_arbiter_release(i2c_arbiter_handle arbiter) {
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid arbiter");
+
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  if (!arbiter->is_held) {
+    xSemaphoreGive(arbiter->lock);
+    ESP_LOGE(TAG, "%s released while free", arbiter->cfg.name);
+    return ESP_ERR_INVALID_STATE;
+  }
+  hand_over(arbiter, (uint64_t)esp_timer_get_time());
+  xSemaphoreGive(arbiter->lock);
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_arbiter_yield(i2c_arbiter_handle arbiter, uint32_t timeout_ms) {
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid arbiter");
+
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  uint8_t priority = arbiter->holder_priority;
+  bool is_wanted = false;
+  for (uint8_t i = priority + 1U; i < I2C_ARBITER_PRIO_COUNT; ++i) {
+    is_wanted |= arbiter->waiting[i] > 0;
+  }
+  if (!arbiter->is_held || !is_wanted) {
+    xSemaphoreGive(arbiter->lock);
+    return arbiter->is_held ? ESP_OK : ESP_ERR_INVALID_STATE;
+  }
+
+  uint64_t now_us = (uint64_t)esp_timer_get_time();
+  arbiter->stats.preemptions++;
+  hand_over(arbiter, now_us);
+  return wait_turn(arbiter, priority, timeout_ms, now_us);
+}
+
+esp_err_t
+i2c_arbiter_count_bytes(i2c_arbiter_handle arbiter, uint32_t bytes) {
+  ESP_RETURN_ON_FALSE(arbiter, ESP_ERR_INVALID_ARG, TAG, "invalid arbiter");
+
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  arbiter->stats.bytes += bytes;
+  xSemaphoreGive(arbiter->lock);
+  return ESP_OK;
+}
+
+esp_err_t
+i2c_arbiter_get_stats(i2c_arbiter_handle arbiter, i2c_arbiter_stats *out_stats, bool reset) {
+  ESP_RETURN_ON_FALSE(arbiter && out_stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  uint64_t now_us = (uint64_t)esp_timer_get_time();
+  *out_stats = arbiter->stats;
+  out_stats->window_us = now_us - arbiter->stats_since_us;
+  if (arbiter->is_held) {
+    // The ongoing hold so far, the rest of it goes to the next window
+    out_stats->busy_us += now_us - arbiter->held_since_us;
+  }
+  if (reset) {
+    memset(&arbiter->stats, 0, sizeof(arbiter->stats));
+    arbiter->stats_since_us = now_us;
+    arbiter->held_since_us = now_us;
+  }
+  xSemaphoreGive(arbiter->lock);
+  return ESP_OK;
+}
+
+/**
+ * Called with the lock held, returns with it given back and the bus held on ESP_OK
+ */
+static esp_err_t
+wait_turn(i2c_arbiter_handle arbiter, uint8_t priority, uint32_t timeout_ms, uint64_t request_us) {
+  arbiter->waiting[priority]++;
+  xSemaphoreGive(arbiter->lock);
+
+  bool is_handed = xSemaphoreTake(arbiter->gates[priority], pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+
+  xSemaphoreTake(arbiter->lock, portMAX_DELAY);
+  // A hand over may have come between the timeout and the lock, the gate then still holds it
+  if (!is_handed && xSemaphoreTake(arbiter->gates[priority], 0) != pdTRUE) {
+    arbiter->waiting[priority]--;
+    arbiter->stats.timeouts++;
+    xSemaphoreGive(arbiter->lock);
+    ESP_LOGW(TAG, "%s: priority %u timed out after %" PRIu32 " ms", arbiter->cfg.name, priority, timeout_ms);
+    return ESP_ERR_TIMEOUT;
+  }
+
+  uint64_t now_us = (uint64_t)esp_timer_get_time();
+  arbiter->holder_priority = priority;
+  arbiter->held_since_us = now_us;
+  record_wait(arbiter, priority, request_us, now_us);
+  xSemaphoreGive(arbiter->lock);
+  return ESP_OK;
+}
+
+/**
+ * Called with the lock held, the most urgent waiter gets the bus, FIFO within a priority as FreeRTOS wakes the longest
+ * waiting task of equal task priority first
+ */
+static void
+hand_over(i2c_arbiter_handle arbiter, uint64_t now_us) {
+  arbiter->stats.busy_us += now_us - arbiter->held_since_us;
+
+  for (uint8_t i = I2C_ARBITER_PRIO_COUNT; i-- > 0;) {
+    if (arbiter->waiting[i] == 0)
+      continue;
+    // Still held, only by someone else from here on
+    arbiter->waiting[i]--;
+    arbiter->held_since_us = now_us;
+    xSemaphoreGive(arbiter->gates[i]);
+    return;
+  }
+  arbiter->is_held = false;
+}
+
+static void
+record_wait(i2c_arbiter_handle arbiter, uint8_t priority, uint64_t request_us, uint64_t now_us) {
+  uint64_t wait_us = now_us - request_us;
+  uint8_t bucket = 0;
+  for (uint64_t bound_us = 100U; bucket < I2C_ARBITER_WAIT_BUCKETS - 1U && wait_us >= bound_us; bound_us *= 10U) {
+    bucket++;
+  }
+
+  i2c_arbiter_stats *stats = &arbiter->stats;
+  stats->acquisitions[priority]++;
+  stats->wait_hist[priority][bucket]++;
+  if (wait_us > stats->max_wait_us[priority]) {
+    stats->max_wait_us[priority] = wait_us > UINT32_MAX ? UINT32_MAX : (uint32_t)wait_us;
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef PCA9548A_MUX_H
+#define PCA9548A_MUX_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "pca9548a_mux_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pca9548a_mux *pca9548a_mux_handle;
+
+/**
+ * The active channel starts as PCA9548A_MUX_CHANNEL_UNKNOWN, so the first select always writes
+ */
+esp_err_t
+pca9548a_mux_new(const struct pca9548a_mux_config *mux_cfg, pca9548a_mux_handle *out_mux);
+esp_err_t
+pca9548a_mux_del(pca9548a_mux_handle mux);
+
+/**
+ * Selects the channel, the control register is only written if a different channel is active
+ */
+esp_err_t
+pca9548a_mux_select(pca9548a_mux_handle mux, uint8_t channel);
+esp_err_t
+pca9548a_mux_deselect(pca9548a_mux_handle mux);
+
+/**
+ * Locks the mux and selects the channel, so a whole transaction runs on it.
+ * Must be paired with pca9548a_mux_release.
+ */
+esp_err_t
+pca9548a_mux_acquire(pca9548a_mux_handle mux, uint8_t channel, uint32_t timeout_ms);
+esp_err_t
+pca9548a_mux_release(pca9548a_mux_handle mux);
+
+/**
+ * For drivers that wrote the control register on their own or after a bus reset
+ */
+esp_err_t
+pca9548a_mux_invalidate(pca9548a_mux_handle mux);
+
+/**
+ * Returns the cached channel, PCA9548A_MUX_CHANNEL_NONE or PCA9548A_MUX_CHANNEL_UNKNOWN
+ */
+int8_t
+pca9548a_mux_get_channel(pca9548a_mux_handle mux);
+
+/**
+ * Closes the current frame, its counters become the "last frame" stats
+ */
+esp_err_t
+pca9548a_mux_frame_end(pca9548a_mux_handle mux);
+esp_err_t
+pca9548a_mux_get_stats(pca9548a_mux_handle mux, pca9548a_mux_stats *out_last_frame, pca9548a_mux_stats *out_total);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
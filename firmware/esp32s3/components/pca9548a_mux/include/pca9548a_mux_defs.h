@@ -0,0 +1,40 @@
+#pragma once
+#ifndef PCA9548A_MUX_DEFS_H
+#define PCA9548A_MUX_DEFS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCA9548A_MUX_CHANNEL_COUNT   8U
+#define PCA9548A_MUX_CHANNEL_NONE    (-1)
+#define PCA9548A_MUX_CHANNEL_UNKNOWN (-2)
+
+/**
+ * Writes the control register of the mux, the transport is owned by the caller (Wire, i2c_master, ...)
+ */
+typedef esp_err_t (*pca9548a_mux_write_fn)(void *user_ctx, uint8_t address, uint8_t ctrl);
+
+struct pca9548a_mux_config {
+  uint8_t address;
+
+  pca9548a_mux_write_fn write;
+  void *user_ctx;
+};
+
+typedef struct {
+  uint32_t select_requests; // every select call, cached or not
+  uint32_t writes;          // control register writes that went on the wire
+  uint32_t writes_saved;    // select calls served from the cache
+  uint32_t write_failures;
+} pca9548a_mux_stats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+#ifndef PCA9548A_MUX_PRIVATE_H
+#define PCA9548A_MUX_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCA9548A_MUX_CTRL_NONE 0x00U
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "pca9548a_mux.h"
+#include "private/pca9548a_mux_private.h"
+
+struct pca9548a_mux {
+  struct pca9548a_mux_config cfg;
+
+  SemaphoreHandle_t lock; // recursive, select can be called while the mux is acquired
+  int8_t channel;
+
+  pca9548a_mux_stats frame;
+  pca9548a_mux_stats last_frame;
+  pca9548a_mux_stats total;
+};
+
+static const char *TAG = "pca9548a_mux";
+
+static esp_err_t
+write_ctrl(pca9548a_mux_handle mux, int8_t channel);
+
+esp_err_t
+pca9548a_mux_new(const struct pca9548a_mux_config *mux_cfg, pca9548a_mux_handle *out_mux) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(mux_cfg && out_mux, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(mux_cfg->write, ESP_ERR_INVALID_ARG, TAG, "no write function");
+
+  struct pca9548a_mux *mux = calloc(1, sizeof(struct pca9548a_mux));
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_NO_MEM, TAG, "failed to allocate mux");
+
+  mux->lock = xSemaphoreCreateRecursiveMutex();
+  ESP_GOTO_ON_FALSE(mux->lock, ESP_ERR_NO_MEM, err, TAG, "failed to create mux lock");
+
+  mux->cfg = *mux_cfg;
+  mux->channel = PCA9548A_MUX_CHANNEL_UNKNOWN;
+
+  *out_mux = mux;
+  return ESP_OK;
+err:
+  free(mux);
+  return ret;
+}
+esp_err_t
+pca9548a_mux_del(pca9548a_mux_handle mux) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+
+  vSemaphoreDelete(mux->lock);
+  free(mux);
+  return ESP_OK;
+}
+
+esp_err_t
+pca9548a_mux_select(pca9548a_mux_handle mux, uint8_t channel) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+  ESP_RETURN_ON_FALSE(channel < PCA9548A_MUX_CHANNEL_COUNT, ESP_ERR_INVALID_ARG, TAG, "invalid channel %u", channel);
+
+  xSemaphoreTakeRecursive(mux->lock, portMAX_DELAY);
+  esp_err_t ret = write_ctrl(mux, (int8_t)channel);
+  xSemaphoreGiveRecursive(mux->lock);
+  return ret;
+}
+esp_err_t
+pca9548a_mux_deselect(pca9548a_mux_handle mux) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+
+  xSemaphoreTakeRecursive(mux->lock, portMAX_DELAY);
+  esp_err_t ret = write_ctrl(mux, PCA9548A_MUX_CHANNEL_NONE);
+  xSemaphoreGiveRecursive(mux->lock);
+  return ret;
+}
+
+esp_err_t
+pca9548a_mux_acquire(pca9548a_mux_handle mux, uint8_t channel, uint32_t timeout_ms) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+  ESP_RETURN_ON_FALSE(channel < PCA9548A_MUX_CHANNEL_COUNT, ESP_ERR_INVALID_ARG, TAG, "invalid channel %u", channel);
+  ESP_RETURN_ON_FALSE(xSemaphoreTakeRecursive(mux->lock, pdMS_TO_TICKS(timeout_ms)) == pdTRUE, ESP_ERR_TIMEOUT, TAG,
+                      "timed out waiting for the mux");
+
+  esp_err_t ret = write_ctrl(mux, (int8_t)channel);
+  if (ret != ESP_OK) {
+    xSemaphoreGiveRecursive(mux->lock);
+  }
+  return ret;
+}
+esp_err_t
+pca9548a_mux_release(pca9548a_mux_handle mux) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+  ESP_RETURN_ON_FALSE(xSemaphoreGiveRecursive(mux->lock) == pdTRUE, ESP_ERR_INVALID_STATE, TAG, "mux not acquired");
+  return ESP_OK;
+}
+
+esp_err_t
+pca9548a_mux_invalidate(pca9548a_mux_handle mux) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+
+  xSemaphoreTakeRecursive(mux->lock, portMAX_DELAY);
+  mux->channel = PCA9548A_MUX_CHANNEL_UNKNOWN;
+  xSemaphoreGiveRecursive(mux->lock);
+  return ESP_OK;
+}
+
+int8_t
+pca9548a_mux_get_channel(pca9548a_mux_handle mux) {
+  if (!mux)
+    return PCA9548A_MUX_CHANNEL_UNKNOWN;
+  return mux->channel;
+}
+
+esp_err_t
+pca9548a_mux_frame_end(pca9548a_mux_handle mux) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+
+  xSemaphoreTakeRecursive(mux->lock, portMAX_DELAY);
+  mux->last_frame = mux->frame;
+  memset(&mux->frame, 0, sizeof(mux->frame));
+  xSemaphoreGiveRecursive(mux->lock);
+  return ESP_OK;
+}
+esp_err_t
+pca9548a_mux_get_stats(pca9548a_mux_handle mux, pca9548a_mux_stats *out_last_frame, pca9548a_mux_stats *out_total) {
+  ESP_RETURN_ON_FALSE(mux, ESP_ERR_INVALID_ARG, TAG, "invalid mux");
+
+  xSemaphoreTakeRecursive(mux->lock, portMAX_DELAY);
+  if (out_last_frame) {
+    *out_last_frame = mux->last_frame;
+  }
+  if (out_total) {
+    *out_total = mux->total;
+  }
+  xSemaphoreGiveRecursive(mux->lock);
+  return ESP_OK;
+}
+
+static esp_err_t
+write_ctrl(pca9548a_mux_handle mux, int8_t channel) {
+  mux->frame.select_requests++;
+  mux->total.select_requests++;
+
+  if (mux->channel == channel) {
+    mux->frame.writes_saved++;
+    mux->total.writes_saved++;
+    return ESP_OK;
+  }
+
+  uint8_t ctrl = (channel == PCA9548A_MUX_CHANNEL_NONE) ? PCA9548A_MUX_CTRL_NONE : (uint8_t)(1U << channel);
+  esp_err_t ret = mux->cfg.write(mux->cfg.user_ctx, mux->cfg.address, ctrl);
+
+  mux->frame.writes++;
+  mux->total.writes++;
+  if (ret != ESP_OK) {
+    // the register may or may not have latched, force a write on the next select
+    mux->channel = PCA9548A_MUX_CHANNEL_UNKNOWN;
+    mux->frame.write_failures++;
+    mux->total.write_failures++;
+    ESP_LOGW(TAG, "failed to write mux control register: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  mux->channel = channel;
+  return ESP_OK;
+}
@@ -0,0 +1,253 @@
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "private/sound_meter_private.h"
+#include "sound_acoustics.h"
+
+/* IEC 61672 A-weighting pole frequencies */
+static const double a_weighting_poles_hz[] = {20.598997, 107.65265, 737.86223, 12194.217};
+
+static const char *TAG = "sound_acoustics";
+
+static void
+set_biquad(sound_biquad *biquad, double b0, double b1, double b2, double a1, double a2);
+static double
+biquad_gain(const sound_biquad *biquad, double omega);
+static double
+a_weighting_db(double freq_hz);
+static void
+scan_envelope(sound_acoustics *acoustics, const float *envelope, uint32_t len, sound_acoustics_accum *accum);
+static inline float
+mean_square_to_db(const sound_acoustics *acoustics, double mean_square);
+
+esp_err_t
+sound_acoustics_init(sound_acoustics *acoustics, const struct sound_meter_config_t *meter_cfg) {
+  ESP_RETURN_ON_FALSE(acoustics && meter_cfg && meter_cfg->sample_rate_hz && meter_cfg->mv_per_pa > 0.0f,
+                      ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  memset(acoustics, 0, sizeof(sound_acoustics));
+  uint32_t sample_rate_hz = meter_cfg->sample_rate_hz;
+  uint16_t level_interval_ms = meter_cfg->level_interval_ms ? meter_cfg->level_interval_ms : SOUND_METER_LEVEL_INTERVAL_MS;
+  double fs = (double)sample_rate_hz;
+
+  double r = exp(-2.0 * M_PI * SOUND_METER_DC_BLOCK_HZ / fs);
+  set_biquad(&acoustics->weighting[0], 1.0, -1.0, 0.0, -r, 0.0);
+
+  // Bilinear transform of the analog poles, the four zeros at 0 Hz land on z = 1 and the two extra on z = -1
+  double p[4];
+  for (uint8_t i = 0; i < 4U; ++i) {
+    double w = 2.0 * M_PI * a_weighting_poles_hz[i];
+    p[i] = (2.0 * fs - w) / (2.0 * fs + w);
+  }
+  set_biquad(&acoustics->weighting[1], 1.0, -2.0, 1.0, -2.0 * p[0], p[0] * p[0]);
+  set_biquad(&acoustics->weighting[2], 1.0, -2.0, 1.0, -(p[1] + p[2]), p[1] * p[2]);
+  set_biquad(&acoustics->weighting[3], 1.0, 2.0, 1.0, -2.0 * p[3], p[3] * p[3]);
+
+  // Gain from the analog curve at a frequency well below Nyquist, at 1 kHz itself the 2 kHz rate has its zeros
+  double ref_hz = fs / 8.0 < 1000.0 ? fs / 8.0 : 1000.0;
+  double omega = 2.0 * M_PI * ref_hz / fs;
+  double gain = pow(10.0, a_weighting_db(ref_hz) / 20.0);
+  for (uint8_t i = 1; i < SOUND_ACOUSTICS_SECTIONS; ++i) {
+    gain /= biquad_gain(&acoustics->weighting[i], omega);
+  }
+  for (uint8_t i = 0; i < 3U; ++i) {
+    acoustics->weighting[SOUND_ACOUSTICS_SECTIONS - 1U].coef[i] *= (float)gain;
+  }
+
+  double alpha = 1.0 - exp(-1.0 / (fs * SOUND_METER_FAST_TAU_S));
+  set_biquad(&acoustics->fast, alpha, 0.0, 0.0, -(1.0 - alpha), 0.0);
+
+  // The mean squares come in fixed point mV
+  acoustics->level_offset_db =
+      (float)(-20.0 * log10(meter_cfg->mv_per_pa * SOUND_METER_REF_PRESSURE_PA * (1U << meter_cfg->sample_frac_bits)));
+  acoustics->level_interval = (uint32_t)((uint64_t)sample_rate_hz * level_interval_ms / 1000U);
+  if (!acoustics->level_interval) {
+    acoustics->level_interval = 1U;
+  }
+  acoustics->level_countdown = acoustics->level_interval;
+  acoustics->settle_countdown = (uint32_t)((uint64_t)sample_rate_hz * SOUND_METER_SETTLE_MS / 1000U);
+
+  acoustics->chunk_samples = SOUND_METER_CHUNK_SAMPLES;
+  acoustics->weighted = sound_dsp_calloc(acoustics->chunk_samples, sizeof(float));
+  acoustics->envelope = sound_dsp_calloc(acoustics->chunk_samples, sizeof(float));
+  if (!acoustics->weighted || !acoustics->envelope) {
+    sound_acoustics_deinit(acoustics);
+    ESP_LOGE(TAG, "failed to allocate acoustics buffers");
+    return ESP_ERR_NO_MEM;
+  }
+
+  if (meter_cfg->fft_size) {
+    esp_err_t ret = sound_spectrum_init(&acoustics->spectrum, sample_rate_hz, meter_cfg->fft_size,
+                                        meter_cfg->bands_per_octave ? meter_cfg->bands_per_octave : 1U);
+    if (ret != ESP_OK) {
+      sound_acoustics_deinit(acoustics);
+      return ret;
+    }
+    acoustics->has_spectrum = true;
+  }
+  return ESP_OK;
+}
+void
+sound_acoustics_deinit(sound_acoustics *acoustics) {
+  sound_dsp_free(acoustics->weighted);
+  sound_dsp_free(acoustics->envelope);
+  acoustics->weighted = NULL;
+  acoustics->envelope = NULL;
+
+  if (acoustics->has_spectrum) {
+    sound_spectrum_deinit(&acoustics->spectrum);
+    acoustics->has_spectrum = false;
+  }
+}
+
+void
+sound_acoustics_process(sound_acoustics *acoustics, const uint16_t *samples_mv, uint32_t count, int32_t dc_offset_mv,
+                        sound_acoustics_accum *accum) {
+  float *weighted = acoustics->weighted;
+  float *envelope = acoustics->envelope;
+
+  while (count) {
+    uint32_t len = count < acoustics->chunk_samples ? count : acoustics->chunk_samples;
+
+    for (uint32_t i = 0; i < len; ++i) {
+      weighted[i] = (float)((int32_t)samples_mv[i] - dc_offset_mv);
+    }
+    uint32_t start = 0;
+    if (acoustics->settle_countdown) {
+      start = acoustics->settle_countdown < len ? acoustics->settle_countdown : len;
+      acoustics->settle_countdown -= start;
+    }
+
+    sound_dsp_biquad(weighted, weighted, len, &acoustics->weighting[0]);
+    if (acoustics->has_spectrum && start < len) {
+      sound_spectrum_feed(&acoustics->spectrum, &weighted[start], len - start, &accum->spectrum);
+    }
+    for (uint8_t i = 1; i < SOUND_ACOUSTICS_SECTIONS; ++i) {
+      sound_dsp_biquad(weighted, weighted, len, &acoustics->weighting[i]);
+    }
+    sound_dsp_square(weighted, envelope, len);
+    sound_dsp_biquad(envelope, envelope, len, &acoustics->fast);
+
+    if (start < len) {
+      accum->energy += sound_dsp_energy(&weighted[start], len - start);
+      accum->samples += len - start;
+      scan_envelope(acoustics, &envelope[start], len - start, accum);
+    }
+
+    samples_mv += len;
+    count -= len;
+  }
+}
+
+void
+sound_acoustics_accum_clear(sound_acoustics_accum *accum) {
+  memset(accum, 0, sizeof(sound_acoustics_accum));
+}
+void
+sound_acoustics_accum_merge(sound_acoustics_accum *into, const sound_acoustics_accum *from) {
+  into->energy += from->energy;
+  into->samples += from->samples;
+  into->fast_max = from->fast_max > into->fast_max ? from->fast_max : into->fast_max;
+  into->level_count += from->level_count;
+  for (uint32_t i = 0; i < SOUND_ACOUSTICS_LEVEL_BINS; ++i) {
+    into->level_bins[i] += from->level_bins[i];
+  }
+  sound_spectrum_accum_merge(&into->spectrum, &from->spectrum);
+}
+
+void
+sound_acoustics_levels(const sound_acoustics *acoustics, const sound_acoustics_accum *accum,
+                       sound_meter_window_t *out_window) {
+  out_window->laeq_db = accum->samples ? mean_square_to_db(acoustics, accum->energy / accum->samples) : 0.0f;
+  out_window->lafmax_db = accum->samples ? mean_square_to_db(acoustics, accum->fast_max) : 0.0f;
+  out_window->la90_db = 0.0f;
+
+  // Exceeded 90 % of the time, the 10th percentile of the sampled Fast levels
+  uint32_t below = (uint32_t)((uint64_t)accum->level_count * SOUND_METER_LA90_PERCENTILE / 100U);
+  uint32_t seen = 0;
+  for (uint32_t i = 0; i < SOUND_ACOUSTICS_LEVEL_BINS && accum->level_count; ++i) {
+    seen += accum->level_bins[i];
+    if (seen > below) {
+      out_window->la90_db = ((float)i + 0.5f) * SOUND_ACOUSTICS_BIN_DB;
+      break;
+    }
+  }
+
+  if (acoustics->has_spectrum) {
+    const sound_spectrum_accum *spectrum = &accum->spectrum;
+    out_window->band_count = acoustics->spectrum.band_count;
+    for (uint8_t i = 0; i < acoustics->spectrum.band_count; ++i) {
+      out_window->band_db[i] =
+          spectrum->frames ? mean_square_to_db(acoustics, spectrum->band_energy[i] / spectrum->frames) : 0.0f;
+    }
+  }
+}
+
+static void
+set_biquad(sound_biquad *biquad, double b0, double b1, double b2, double a1, double a2) {
+  biquad->coef[0] = (float)b0;
+  biquad->coef[1] = (float)b1;
+  biquad->coef[2] = (float)b2;
+  biquad->coef[3] = (float)a1;
+  biquad->coef[4] = (float)a2;
+  biquad->w[0] = 0.0f;
+  biquad->w[1] = 0.0f;
+}
+static double
+biquad_gain(const sound_biquad *biquad, double omega) {
+  const float *c = biquad->coef;
+  double re1 = cos(omega), im1 = -sin(omega);
+  double re2 = cos(2.0 * omega), im2 = -sin(2.0 * omega);
+
+  double num_re = c[0] + c[1] * re1 + c[2] * re2;
+  double num_im = c[1] * im1 + c[2] * im2;
+  double den_re = 1.0 + c[3] * re1 + c[4] * re2;
+  double den_im = c[3] * im1 + c[4] * im2;
+  return sqrt((num_re * num_re + num_im * num_im) / (den_re * den_re + den_im * den_im));
+}
+/**
+ * Analog A-weighting in dB, 0 at 1 kHz
+ */
+static double
+a_weighting_db(double freq_hz) {
+  double f2 = freq_hz * freq_hz;
+  double p1 = a_weighting_poles_hz[0] * a_weighting_poles_hz[0];
+  double p2 = a_weighting_poles_hz[1] * a_weighting_poles_hz[1];
+  double p3 = a_weighting_poles_hz[2] * a_weighting_poles_hz[2];
+  double p4 = a_weighting_poles_hz[3] * a_weighting_poles_hz[3];
+
+  double ra = p4 * f2 * f2 / ((f2 + p1) * sqrt((f2 + p2) * (f2 + p3)) * (f2 + p4));
+  return 20.0 * log10(ra) + 2.0;
+}
+
+static void
+scan_envelope(sound_acoustics *acoustics, const float *envelope, uint32_t len, sound_acoustics_accum *accum) {
+  float fast_max = accum->fast_max;
+  for (uint32_t i = 0; i < len; ++i) {
+    fast_max = envelope[i] > fast_max ? envelope[i] : fast_max;
+  }
+  accum->fast_max = fast_max;
+
+  uint32_t i = 0;
+  while (acoustics->level_countdown <= len - i) {
+    i += acoustics->level_countdown;
+    acoustics->level_countdown = acoustics->level_interval;
+
+    int32_t bin = (int32_t)(mean_square_to_db(acoustics, envelope[i - 1U]) / SOUND_ACOUSTICS_BIN_DB);
+    bin = bin < 0 ? 0 : bin >= (int32_t)SOUND_ACOUSTICS_LEVEL_BINS ? (int32_t)SOUND_ACOUSTICS_LEVEL_BINS - 1 : bin;
+    accum->level_bins[bin]++;
+    accum->level_count++;
+  }
+  acoustics->level_countdown -= len - i;
+}
+static inline float
+mean_square_to_db(const sound_acoustics *acoustics, double mean_square) {
+  if (mean_square <= SOUND_METER_MIN_MEAN_SQUARE)
+    return 0.0f;
+
+  float db = 10.0f * log10f((float)mean_square) + acoustics->level_offset_db;
+  return db > 0.0f ? db : 0.0f;
+}
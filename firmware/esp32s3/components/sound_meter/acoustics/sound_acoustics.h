@@ -0,0 +1,80 @@
+#pragma once
+#ifndef SOUND_ACOUSTICS_H
+#define SOUND_ACOUSTICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sound_dsp.h"
+#include "sound_meter_defs.h"
+#include "sound_spectrum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOUND_ACOUSTICS_SECTIONS   4U   // DC blocker and the three A-weighting biquads
+#define SOUND_ACOUSTICS_LEVEL_BINS 256U // 0.5 dB each, 0 to 128 dB SPL
+#define SOUND_ACOUSTICS_BIN_DB     0.5f
+
+/**
+ * A-weighted signal chain: DC blocker, A-weighting cascade, then the squared signal through the Fast (125 ms)
+ * exponential time weighting. The Fast level is sampled every level interval for the percentiles.
+ * The band spectrum, when configured, taps the signal after the DC blocker.
+ */
+typedef struct {
+  sound_biquad weighting[SOUND_ACOUSTICS_SECTIONS];
+  sound_biquad fast;
+
+  float *weighted; // one chunk of A-weighted samples
+  float *envelope; // their squares, then the Fast envelope
+  uint32_t chunk_samples;
+
+  float level_offset_db; // mean square in mV^2 -> dB SPL
+  uint32_t level_interval;
+  uint32_t level_countdown;
+  uint32_t settle_countdown; // filter transients after start are kept out of the levels
+
+  bool has_spectrum;
+  sound_spectrum spectrum;
+} sound_acoustics;
+
+typedef struct {
+  double energy; // sum of squared A-weighted mV
+  uint32_t samples;
+  float fast_max; // largest Fast envelope value, mV^2
+
+  uint32_t level_count;
+  uint32_t level_bins[SOUND_ACOUSTICS_LEVEL_BINS];
+
+  sound_spectrum_accum spectrum;
+} sound_acoustics_accum;
+
+esp_err_t
+sound_acoustics_init(sound_acoustics *acoustics, const struct sound_meter_config_t *meter_cfg);
+void
+sound_acoustics_deinit(sound_acoustics *acoustics);
+
+void
+sound_acoustics_process(sound_acoustics *acoustics, const uint16_t *samples_mv, uint32_t count, int32_t dc_offset_mv,
+                        sound_acoustics_accum *accum);
+
+void
+sound_acoustics_accum_clear(sound_acoustics_accum *accum);
+void
+sound_acoustics_accum_merge(sound_acoustics_accum *into, const sound_acoustics_accum *from);
+
+/**
+ * LAeq, LAFmax, LA90 and the band levels of the window in dB SPL, 0 when nothing was accumulated
+ */
+void
+sound_acoustics_levels(const sound_acoustics *acoustics, const sound_acoustics_accum *accum,
+                       sound_meter_window_t *out_window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
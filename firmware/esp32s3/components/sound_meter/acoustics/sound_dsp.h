@@ -0,0 +1,65 @@
+#pragma once
+#ifndef SOUND_DSP_H
+#define SOUND_DSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * esp-dsp layout: b0 b1 b2 a1 a2 with a0 = 1, direct form II state
+ */
+typedef struct {
+  float coef[5];
+  float w[2];
+} sound_biquad;
+
+/**
+ * Block kernels of the acoustics stage, esp-dsp on the chip and plain C on the host.
+ * Buffers come from sound_dsp_calloc so the vector paths can use aligned loads.
+ */
+void *
+sound_dsp_calloc(size_t count, size_t size);
+void
+sound_dsp_free(void *ptr);
+
+void
+sound_dsp_biquad(const float *input, float *output, uint32_t len, sound_biquad *biquad);
+/**
+ * Sum of squares
+ */
+float
+sound_dsp_energy(const float *input, uint32_t len);
+void
+sound_dsp_square(const float *input, float *output, uint32_t len);
+/**
+ * output[i * out_step] = input1[i] * input2[i], a step of 2 fills one half of an interleaved complex buffer
+ */
+void
+sound_dsp_mul(const float *input1, const float *input2, float *output, uint32_t len, uint32_t out_step);
+
+/**
+ * Radix-2 complex FFT of n interleaved re/im pairs, in place with the result in natural order.
+ * The twiddle tables are shared by every caller and stay allocated, init only grows them.
+ */
+esp_err_t
+sound_dsp_fft_init(uint32_t n);
+void
+sound_dsp_fft(float *data, uint32_t n);
+
+/**
+ * Free running counter for benchmarks, CPU cycles on the chip and nanoseconds on the host
+ */
+uint32_t
+sound_dsp_ticks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
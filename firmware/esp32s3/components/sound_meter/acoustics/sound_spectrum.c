@@ -0,0 +1,236 @@
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "private/sound_meter_private.h"
+#include "sound_dsp.h"
+#include "sound_spectrum.h"
+
+#define SOUND_SPECTRUM_TABLE_BANDS SOUND_METER_MAX_BANDS // 25 Hz to 10 kHz in thirds of an octave
+#define SOUND_SPECTRUM_TABLE_FIRST (-16)                 // mid-band at 1 kHz * 10^(k / 10) from this k
+
+/* IEC 61260 nominal mid-band frequencies, written so they can go into payload field names */
+static const char *const band_names[SOUND_SPECTRUM_TABLE_BANDS] = {
+    "25",  "31_5", "40",  "50",  "63",   "80",  "100", "125",  "160", "200", "250", "315", "400", "500",
+    "630", "800",  "1k",  "1k25", "1k6", "2k",  "2k5", "3k15", "4k",  "5k",  "6k3", "8k",  "10k",
+};
+
+static const char *TAG = "sound_spectrum";
+
+static void
+band_edges(uint8_t bands_per_octave, uint8_t table_index, double *out_centre_hz, double *out_lower_hz,
+           double *out_upper_hz);
+static void
+transform_pair(sound_spectrum *spectrum, sound_spectrum_accum *accum);
+
+esp_err_t
+sound_spectrum_init(sound_spectrum *spectrum, uint32_t sample_rate_hz, uint16_t fft_size, uint8_t bands_per_octave) {
+  ESP_RETURN_ON_FALSE(spectrum && sample_rate_hz, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(fft_size >= SOUND_METER_MIN_FFT_SIZE && fft_size <= SOUND_METER_MAX_FFT_SIZE &&
+                          !(fft_size & (fft_size - 1U)),
+                      ESP_ERR_INVALID_ARG, TAG, "FFT size %u is not a power of two in range", fft_size);
+  ESP_RETURN_ON_FALSE(bands_per_octave == 1U || bands_per_octave == 3U, ESP_ERR_INVALID_ARG, TAG,
+                      "only whole and third octave bands");
+
+  memset(spectrum, 0, sizeof(sound_spectrum));
+  spectrum->fft_size = fft_size;
+  spectrum->bands_per_octave = bands_per_octave;
+
+  double bin_hz = (double)sample_rate_hz / fft_size;
+  uint8_t step = 3U / bands_per_octave;
+  for (uint8_t i = (bands_per_octave == 1U ? 1U : 0U); i < SOUND_SPECTRUM_TABLE_BANDS; i += step) {
+    double centre_hz, lower_hz, upper_hz;
+    band_edges(bands_per_octave, i, &centre_hz, &lower_hz, &upper_hz);
+    // Hann leaks DC into the first bin, in narrow bands a tone spills into the neighbours
+    if (lower_hz < 1.5 * bin_hz || upper_hz - lower_hz < SOUND_METER_MIN_BAND_BINS * bin_hz)
+      continue;
+    if (upper_hz > sample_rate_hz / 2.0)
+      break;
+
+    if (!spectrum->band_count) {
+      spectrum->first_band = i;
+    }
+    // Bin k covers (k - 0.5, k + 0.5) * bin_hz, the edge bins count with the part inside the band
+    double lower_bin = lower_hz / bin_hz;
+    double upper_bin = upper_hz / bin_hz;
+    sound_spectrum_band *band = &spectrum->bands[spectrum->band_count++];
+    band->first_bin = (uint16_t)floor(lower_bin + 0.5);
+    band->last_bin = (uint16_t)floor(upper_bin + 0.5);
+    if (band->first_bin == band->last_bin) {
+      band->first_weight = (float)(upper_bin - lower_bin);
+      band->last_weight = 0.0f;
+    } else {
+      band->first_weight = (float)(band->first_bin + 0.5 - lower_bin);
+      band->last_weight = (float)(upper_bin - (band->last_bin - 0.5));
+    }
+  }
+  ESP_RETURN_ON_FALSE(spectrum->band_count, ESP_ERR_INVALID_ARG, TAG, "no band fits %u bins at %" PRIu32 " Hz", fft_size,
+                      sample_rate_hz);
+
+  ESP_RETURN_ON_ERROR(sound_dsp_fft_init(fft_size), TAG, "failed to set up the FFT");
+  spectrum->window = sound_dsp_calloc(fft_size, sizeof(float));
+  spectrum->frames = sound_dsp_calloc(fft_size + fft_size / 2U, sizeof(float));
+  spectrum->spectrum = sound_dsp_calloc(2U * fft_size, sizeof(float));
+  spectrum->power = sound_dsp_calloc(fft_size / 2U + 1U, sizeof(float));
+  if (!spectrum->window || !spectrum->frames || !spectrum->spectrum || !spectrum->power) {
+    sound_spectrum_deinit(spectrum);
+    ESP_LOGE(TAG, "failed to allocate spectrum buffers");
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Periodic Hann, overlapped by half it sums to a constant so every sample weighs the same
+  double window_energy = 0.0;
+  for (uint32_t i = 0; i < fft_size; ++i) {
+    double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / fft_size);
+    spectrum->window[i] = (float)w;
+    window_energy += w * w;
+  }
+  spectrum->power_scale = (float)(1.0 / (fft_size * window_energy));
+  return ESP_OK;
+}
+void
+sound_spectrum_deinit(sound_spectrum *spectrum) {
+  sound_dsp_free(spectrum->window);
+  sound_dsp_free(spectrum->frames);
+  sound_dsp_free(spectrum->spectrum);
+  sound_dsp_free(spectrum->power);
+  spectrum->window = NULL;
+  spectrum->frames = NULL;
+  spectrum->spectrum = NULL;
+  spectrum->power = NULL;
+}
+
+void
+sound_spectrum_feed(sound_spectrum *spectrum, const float *samples, uint32_t len, sound_spectrum_accum *accum) {
+  uint32_t hop = spectrum->fft_size / 2U;
+  uint32_t pair_len = spectrum->fft_size + hop;
+
+  while (len) {
+    uint32_t take = pair_len - spectrum->filled;
+    take = len < take ? len : take;
+    memcpy(&spectrum->frames[spectrum->filled], samples, take * sizeof(float));
+    spectrum->filled += take;
+    samples += take;
+    len -= take;
+
+    if (spectrum->filled == pair_len) {
+      transform_pair(spectrum, accum);
+      // The last half frame opens the next pair
+      memmove(spectrum->frames, &spectrum->frames[spectrum->fft_size], hop * sizeof(float));
+      spectrum->filled = hop;
+    }
+  }
+}
+
+void
+sound_spectrum_accum_clear(sound_spectrum_accum *accum) {
+  memset(accum, 0, sizeof(sound_spectrum_accum));
+}
+void
+sound_spectrum_accum_merge(sound_spectrum_accum *into, const sound_spectrum_accum *from) {
+  for (uint32_t i = 0; i < SOUND_METER_MAX_BANDS; ++i) {
+    into->band_energy[i] += from->band_energy[i];
+  }
+  into->frames += from->frames;
+}
+
+esp_err_t
+sound_spectrum_get_band(const sound_spectrum *spectrum, uint8_t band, sound_meter_band_t *out_band) {
+  ESP_RETURN_ON_FALSE(band < spectrum->band_count, ESP_ERR_INVALID_ARG, TAG, "invalid band %u", band);
+
+  uint8_t table_index = spectrum->first_band + band * (3U / spectrum->bands_per_octave);
+  double centre_hz, lower_hz, upper_hz;
+  band_edges(spectrum->bands_per_octave, table_index, &centre_hz, &lower_hz, &upper_hz);
+
+  *out_band = (sound_meter_band_t){
+      .name = band_names[table_index],
+      .centre_hz = (float)centre_hz,
+      .lower_hz = (float)lower_hz,
+      .upper_hz = (float)upper_hz,
+  };
+  return ESP_OK;
+}
+
+esp_err_t
+sound_spectrum_benchmark(uint16_t fft_size, uint32_t frames, uint32_t *out_ticks_per_frame) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(frames && out_ticks_per_frame, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  sound_spectrum spectrum;
+  sound_spectrum_accum accum;
+  float *noise = NULL;
+  ESP_RETURN_ON_ERROR(sound_spectrum_init(&spectrum, SOUND_METER_BENCH_RATE_HZ, fft_size, 3U), TAG,
+                      "failed to set up the spectrum");
+  sound_spectrum_accum_clear(&accum);
+
+  uint32_t hop = fft_size / 2U;
+  noise = sound_dsp_calloc(hop, sizeof(float));
+  ESP_GOTO_ON_FALSE(noise, ESP_ERR_NO_MEM, err, TAG, "failed to allocate the benchmark input");
+  uint32_t seed = 1U;
+  for (uint32_t i = 0; i < hop; ++i) {
+    seed = seed * 1664525U + 1013904223U;
+    noise[i] = (float)(seed >> 8U) / (float)(1U << 24U) - 0.5f;
+  }
+
+  // Fill the first half frame outside the timing, from then on every hop completes a frame
+  sound_spectrum_feed(&spectrum, noise, hop, &accum);
+  uint32_t start = sound_dsp_ticks();
+  for (uint32_t i = 0; i < frames; ++i) {
+    sound_spectrum_feed(&spectrum, noise, hop, &accum);
+  }
+  *out_ticks_per_frame = (sound_dsp_ticks() - start) / frames;
+
+err:
+  sound_dsp_free(noise);
+  sound_spectrum_deinit(&spectrum);
+  return ret;
+}
+
+static void
+band_edges(uint8_t bands_per_octave, uint8_t table_index, double *out_centre_hz, double *out_lower_hz,
+           double *out_upper_hz) {
+  // Base ten octaves as in IEC 61260, the edges sit half a band either side of the exact mid-band frequency
+  double centre_hz = 1000.0 * pow(10.0, (SOUND_SPECTRUM_TABLE_FIRST + table_index) / 10.0);
+  double half_band = pow(10.0, 3.0 / (20.0 * bands_per_octave));
+  *out_centre_hz = centre_hz;
+  *out_lower_hz = centre_hz / half_band;
+  *out_upper_hz = centre_hz * half_band;
+}
+
+static void
+transform_pair(sound_spectrum *spectrum, sound_spectrum_accum *accum) {
+  uint32_t n = spectrum->fft_size;
+  float *z = spectrum->spectrum;
+  float *power = spectrum->power;
+
+  sound_dsp_mul(spectrum->frames, spectrum->window, &z[0], n, 2U);
+  sound_dsp_mul(&spectrum->frames[n / 2U], spectrum->window, &z[1], n, 2U);
+  sound_dsp_fft(z, n);
+
+  // With z = a + jb for real a and b, 2A[k] = Z[k] + conj(Z[n - k]) and 2jB[k] = Z[k] - conj(Z[n - k])
+  for (uint32_t k = 0; k <= n / 2U; ++k) {
+    uint32_t m = (n - k) & (n - 1U);
+    float ar = z[2U * k] + z[2U * m];
+    float ai = z[2U * k + 1U] - z[2U * m + 1U];
+    float br = z[2U * k] - z[2U * m];
+    float bi = z[2U * k + 1U] + z[2U * m + 1U];
+    float one_sided = (k && k < n / 2U) ? 2.0f : 1.0f;
+    power[k] = (ar * ar + ai * ai + br * br + bi * bi) * 0.25f * one_sided * spectrum->power_scale;
+  }
+
+  for (uint8_t b = 0; b < spectrum->band_count; ++b) {
+    const sound_spectrum_band *band = &spectrum->bands[b];
+    float energy = power[band->first_bin] * band->first_weight;
+    for (uint32_t k = band->first_bin + 1U; k < band->last_bin; ++k) {
+      energy += power[k];
+    }
+    if (band->last_bin > band->first_bin) {
+      energy += power[band->last_bin] * band->last_weight;
+    }
+    accum->band_energy[b] += energy;
+  }
+  accum->frames += 2U;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef SOUND_SPECTRUM_H
+#define SOUND_SPECTRUM_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sound_meter_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint16_t first_bin;
+  uint16_t last_bin;
+  float first_weight; // share of the edge bins that falls inside the band
+  float last_weight;
+} sound_spectrum_band;
+
+/**
+ * Hann windowed FFT frames with 50 % overlap. Frames go through the FFT in pairs, one as the real and one as the
+ * imaginary part, and the one-sided power of each is split into fractional octave bands.
+ */
+typedef struct {
+  uint32_t fft_size;
+  float *window;
+  float *frames;   // one and a half frames of samples, the second frame starts halfway through the first
+  float *spectrum; // fft_size interleaved complex values
+  float *power;    // one-sided power per bin, both frames summed
+  uint32_t filled;
+  float power_scale; // |X|^2 -> mean square, 1 / (N * sum(w^2))
+
+  uint8_t bands_per_octave;
+  uint8_t first_band; // index into the nominal band table
+  uint8_t band_count;
+  sound_spectrum_band bands[SOUND_METER_MAX_BANDS];
+} sound_spectrum;
+
+typedef struct {
+  double band_energy[SOUND_METER_MAX_BANDS]; // mean square per frame summed over the frames
+  uint32_t frames;
+} sound_spectrum_accum;
+
+/**
+ * Keeps the bands that lie below Nyquist, clear of the DC bins and a few bins wide
+ */
+esp_err_t
+sound_spectrum_init(sound_spectrum *spectrum, uint32_t sample_rate_hz, uint16_t fft_size, uint8_t bands_per_octave);
+void
+sound_spectrum_deinit(sound_spectrum *spectrum);
+
+/**
+ * Samples without DC, a frame pair counts toward the accumulator it completes in
+ */
+void
+sound_spectrum_feed(sound_spectrum *spectrum, const float *samples, uint32_t len, sound_spectrum_accum *accum);
+
+void
+sound_spectrum_accum_clear(sound_spectrum_accum *accum);
+void
+sound_spectrum_accum_merge(sound_spectrum_accum *into, const sound_spectrum_accum *from);
+
+esp_err_t
+sound_spectrum_get_band(const sound_spectrum *spectrum, uint8_t band, sound_meter_band_t *out_band);
+
+/**
+ * Runs frames of noise through a spectrum of the given size, see sound_dsp_ticks for the unit
+ */
+esp_err_t
+sound_spectrum_benchmark(uint16_t fft_size, uint32_t frames, uint32_t *out_ticks_per_frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
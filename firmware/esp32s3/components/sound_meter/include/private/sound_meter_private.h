@@ -0,0 +1,28 @@
+#pragma once
+#ifndef SOUND_METER_PRIVATE_H
+#define SOUND_METER_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOUND_METER_MAX_SAMPLE_RATE_HZ 100000U
+
+#define SOUND_METER_CHUNK_SAMPLES         256U // A-weighting runs over blocks of at most this many samples
+#define SOUND_METER_LEVEL_INTERVAL_MS     100U
+#define SOUND_METER_SETTLE_MS             500U
+#define SOUND_METER_DC_BLOCK_HZ           5.0
+#define SOUND_METER_FAST_TAU_S            0.125
+#define SOUND_METER_REF_PRESSURE_PA       20e-6
+#define SOUND_METER_LA90_PERCENTILE       10U
+#define SOUND_METER_MIN_MEAN_SQUARE       1e-12
+#define SOUND_METER_MIN_FFT_SIZE          64U
+#define SOUND_METER_MAX_FFT_SIZE          4096U
+#define SOUND_METER_BENCH_RATE_HZ         16000U
+#define SOUND_METER_MIN_BAND_BINS         3.0 // a Hann main lobe is four bins wide, narrower bands lose the edges of a tone
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
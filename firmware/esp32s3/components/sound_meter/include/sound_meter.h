@@ -0,0 +1,64 @@
+#pragma once
+#ifndef SOUND_METER_H
+#define SOUND_METER_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "sound_meter_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sound_meter *sound_meter_handle;
+
+esp_err_t
+sound_meter_new(const struct sound_meter_config_t *meter_cfg, sound_meter_handle *out_meter);
+esp_err_t
+sound_meter_del(sound_meter_handle meter);
+
+/**
+ * Drops the open window and starts a new one at now_us
+ */
+esp_err_t
+sound_meter_reset(sound_meter_handle meter, uint64_t now_us);
+
+/**
+ * Accumulates a block of millivolt samples, meant to be called for every block the ADC stream hands out.
+ * frames_dropped is what the driver reported lost since the previous block.
+ */
+void
+sound_meter_feed(sound_meter_handle meter, const uint16_t *samples_mv, uint32_t count, uint32_t frames_dropped);
+
+/**
+ * Closes the open window at now_us and starts the next one
+ */
+esp_err_t
+sound_meter_close_window(sound_meter_handle meter, uint64_t now_us, sound_meter_window_t *out_window);
+
+/**
+ * Totals since the meter was created, as one window
+ */
+esp_err_t
+sound_meter_get_totals(sound_meter_handle meter, sound_meter_window_t *out_totals);
+
+/**
+ * Describes band_db[band] of the windows, ESP_ERR_INVALID_ARG past the bands the meter reports
+ */
+esp_err_t
+sound_meter_get_band(sound_meter_handle meter, uint8_t band, sound_meter_band_t *out_band);
+
+/**
+ * Time per 50 % overlapped frame of the band analysis at the given FFT size, to size the FFT against the CPU budget.
+ * CPU cycles on the chip, nanoseconds on the linux target.
+ */
+esp_err_t
+sound_meter_benchmark_spectrum(uint16_t fft_size, uint32_t frames, uint32_t *out_ticks_per_frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef SOUND_METER_DEFS_H
+#define SOUND_METER_DEFS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SOUND_METER_MAX_BANDS 27U // third octaves from 25 Hz to 10 kHz
+
+struct sound_meter_config_t {
+  uint32_t sample_rate_hz; // rate the ADC was configured with, the coverage is measured against it
+  uint16_t dc_offset_mv;   // bias of the microphone output, subtracted before squaring
+  uint8_t sample_frac_bits; // fed samples are mV * 2^sample_frac_bits, adc_module_block_t::frac_bits
+
+  float mv_per_pa;            // microphone and amplifier sensitivity, 0 leaves the A-weighted levels out
+  uint16_t level_interval_ms; // how often the Fast level is sampled for LA90, 0 for the default
+
+  uint16_t fft_size;        // power of two from 64 to 4096, 0 leaves the band levels out, needs mv_per_pa
+  uint8_t bands_per_octave; // 1 or 3
+};
+
+/**
+ * One band of the spectrum, name is the nominal mid-band frequency usable in field names, e.g. "31_5" or "1k"
+ */
+typedef struct {
+  const char *name;
+  float centre_hz;
+  float lower_hz;
+  float upper_hz;
+} sound_meter_band_t;
+
+/**
+ * Statistics of one closed window. Coverage is the share of the samples the ADC produced in the window that were
+ * actually seen, frames straddling the window edges can push the raw ratio slightly above 1 so it is clamped.
+ */
+typedef struct {
+  float rms_mv;
+  uint16_t peak_mv; // largest deviation from the DC offset
+  uint16_t min_mv;
+  uint16_t max_mv;
+
+  uint32_t samples;
+  uint32_t expected_samples;
+  uint32_t frames_dropped;
+  uint32_t duration_ms;
+  float coverage;
+
+  float laeq_db;   // A-weighted equivalent level
+  float lafmax_db; // loudest A-weighted Fast level
+  float la90_db;   // A-weighted Fast level exceeded 90 % of the time, the background
+
+  uint8_t band_count;
+  float band_db[SOUND_METER_MAX_BANDS]; // unweighted equivalent level per band, lowest band first
+} sound_meter_window_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_dsp.h"
+#include "esp_heap_caps.h"
+
+#include "sound_dsp.h"
+
+#define SOUND_DSP_ALIGNMENT 16U
+
+static const char *TAG = "sound_dsp";
+
+static uint32_t fft_table_size;
+
+void *
+sound_dsp_calloc(size_t count, size_t size) {
+  return heap_caps_aligned_calloc(SOUND_DSP_ALIGNMENT, count, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+void
+sound_dsp_free(void *ptr) {
+  heap_caps_free(ptr);
+}
+
+void
+sound_dsp_biquad(const float *input, float *output, uint32_t len, sound_biquad *biquad) {
+  dsps_biquad_f32(input, output, (int)len, biquad->coef, biquad->w);
+}
+float
+sound_dsp_energy(const float *input, uint32_t len) {
+  float energy = 0.0f;
+  dsps_dotprod_f32(input, input, &energy, (int)len);
+  return energy;
+}
+void
+sound_dsp_square(const float *input, float *output, uint32_t len) {
+  dsps_mul_f32(input, input, output, (int)len, 1, 1, 1);
+}
+void
+sound_dsp_mul(const float *input1, const float *input2, float *output, uint32_t len, uint32_t out_step) {
+  dsps_mul_f32(input1, input2, output, (int)len, 1, 1, (int)out_step);
+}
+
+esp_err_t
+sound_dsp_fft_init(uint32_t n) {
+  ESP_RETURN_ON_FALSE(n <= CONFIG_DSP_MAX_FFT_SIZE, ESP_ERR_INVALID_SIZE, TAG, "FFT size %lu above CONFIG_DSP_MAX_FFT_SIZE",
+                      n);
+  if (n <= fft_table_size)
+    return ESP_OK;
+
+  // esp-dsp keeps a single table and ignores init once it exists, a larger size needs it rebuilt
+  if (fft_table_size) {
+    dsps_fft2r_deinit_fc32();
+  }
+  ESP_RETURN_ON_ERROR(dsps_fft2r_init_fc32(NULL, (int)n), TAG, "failed to build the FFT tables");
+  fft_table_size = n;
+  return ESP_OK;
+}
+void
+sound_dsp_fft(float *data, uint32_t n) {
+  dsps_fft2r_fc32(data, (int)n);
+  dsps_bit_rev_fc32(data, (int)n);
+}
+
+uint32_t
+sound_dsp_ticks(void) {
+  return esp_cpu_get_cycle_count();
+}
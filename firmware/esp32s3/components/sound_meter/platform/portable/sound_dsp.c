@@ -0,0 +1,133 @@
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_check.h"
+
+#include "sound_dsp.h"
+
+static const char *TAG = "sound_dsp";
+
+static float *fft_table; // cos, sin of 2 pi k / n for k < n / 2
+static uint32_t fft_table_size;
+
+static void
+bit_reverse(float *data, uint32_t n);
+
+void *
+sound_dsp_calloc(size_t count, size_t size) {
+  return calloc(count, size);
+}
+void
+sound_dsp_free(void *ptr) {
+  free(ptr);
+}
+
+/**
+ * Same recursion as dsps_biquad_f32_ansi, so both builds produce the same numbers
+ */
+void
+sound_dsp_biquad(const float *input, float *output, uint32_t len, sound_biquad *biquad) {
+  const float *coef = biquad->coef;
+  float w0 = biquad->w[0];
+  float w1 = biquad->w[1];
+
+  for (uint32_t i = 0; i < len; ++i) {
+    float d0 = input[i] - coef[3] * w0 - coef[4] * w1;
+    output[i] = coef[0] * d0 + coef[1] * w0 + coef[2] * w1;
+    w1 = w0;
+    w0 = d0;
+  }
+  biquad->w[0] = w0;
+  biquad->w[1] = w1;
+}
+float
+sound_dsp_energy(const float *input, uint32_t len) {
+  float energy = 0.0f;
+
+  for (uint32_t i = 0; i < len; ++i) {
+    energy += input[i] * input[i];
+  }
+  return energy;
+}
+void
+sound_dsp_square(const float *input, float *output, uint32_t len) {
+  for (uint32_t i = 0; i < len; ++i) {
+    output[i] = input[i] * input[i];
+  }
+}
+void
+sound_dsp_mul(const float *input1, const float *input2, float *output, uint32_t len, uint32_t out_step) {
+  for (uint32_t i = 0; i < len; ++i) {
+    output[i * out_step] = input1[i] * input2[i];
+  }
+}
+
+esp_err_t
+sound_dsp_fft_init(uint32_t n) {
+  if (n <= fft_table_size)
+    return ESP_OK;
+
+  float *table = malloc(n * sizeof(float));
+  ESP_RETURN_ON_FALSE(table, ESP_ERR_NO_MEM, TAG, "failed to allocate the FFT tables");
+  for (uint32_t k = 0; k < n / 2U; ++k) {
+    table[2U * k] = (float)cos(2.0 * M_PI * k / n);
+    table[2U * k + 1U] = (float)sin(2.0 * M_PI * k / n);
+  }
+  free(fft_table);
+  fft_table = table;
+  fft_table_size = n;
+  return ESP_OK;
+}
+/**
+ * Iterative decimation in time, twiddles taken from the table at the stride of the largest size
+ */
+void
+sound_dsp_fft(float *data, uint32_t n) {
+  bit_reverse(data, n);
+
+  for (uint32_t half = 1U; half < n; half <<= 1U) {
+    uint32_t stride = fft_table_size / (2U * half);
+    for (uint32_t start = 0; start < n; start += 2U * half) {
+      for (uint32_t k = 0; k < half; ++k) {
+        float wr = fft_table[2U * k * stride];
+        float wi = -fft_table[2U * k * stride + 1U];
+        float *a = &data[2U * (start + k)];
+        float *b = &data[2U * (start + k + half)];
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+uint32_t
+sound_dsp_ticks(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+static void
+bit_reverse(float *data, uint32_t n) {
+  for (uint32_t i = 1U, j = 0; i < n; ++i) {
+    uint32_t bit = n >> 1U;
+    for (; j & bit; bit >>= 1U) {
+      j ^= bit;
+    }
+    j ^= bit;
+
+    if (i < j) {
+      float re = data[2U * i];
+      float im = data[2U * i + 1U];
+      data[2U * i] = data[2U * j];
+      data[2U * i + 1U] = data[2U * j + 1U];
+      data[2U * j] = re;
+      data[2U * j + 1U] = im;
+    }
+  }
+}
@@ -0,0 +1,185 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+
+#include "private/sound_meter_private.h"
+#include "sound_acoustics.h"
+#include "sound_meter.h"
+#include "stream_stats.h"
+
+typedef struct {
+  stream_stats_t level; // samples around the DC offset
+  uint32_t frames_dropped;
+  uint64_t duration_us;
+
+  sound_acoustics_accum acoustics;
+} sound_meter_accum;
+
+struct sound_meter {
+  struct sound_meter_config_t cfg;
+
+  bool has_acoustics;
+  sound_acoustics acoustics;
+
+  uint64_t window_start_us;
+  sound_meter_accum window;
+  sound_meter_accum totals;
+};
+
+static const char *TAG = "sound_meter";
+
+static void
+accum_clear(sound_meter_accum *accum);
+static void
+accum_merge(sound_meter_accum *into, const sound_meter_accum *from);
+static void
+accum_to_window(const struct sound_meter *meter, const sound_meter_accum *accum, sound_meter_window_t *out_window);
+
+esp_err_t
+sound_meter_new(const struct sound_meter_config_t *meter_cfg, sound_meter_handle *out_meter) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(meter_cfg && out_meter, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(meter_cfg->sample_rate_hz && meter_cfg->sample_rate_hz <= SOUND_METER_MAX_SAMPLE_RATE_HZ,
+                      ESP_ERR_INVALID_ARG, TAG, "invalid sample rate %" PRIu32, meter_cfg->sample_rate_hz);
+  ESP_RETURN_ON_FALSE(!meter_cfg->fft_size || meter_cfg->mv_per_pa > 0.0f, ESP_ERR_INVALID_ARG, TAG,
+                      "band levels need mv_per_pa");
+  ESP_RETURN_ON_FALSE((uint32_t)meter_cfg->dc_offset_mv << meter_cfg->sample_frac_bits <= UINT16_MAX, ESP_ERR_INVALID_ARG,
+                      TAG, "%u fraction bits do not fit the samples", meter_cfg->sample_frac_bits);
+
+  struct sound_meter *meter = calloc(1, sizeof(struct sound_meter));
+  ESP_RETURN_ON_FALSE(meter, ESP_ERR_NO_MEM, TAG, "failed to allocate sound meter");
+
+  meter->cfg = *meter_cfg;
+  accum_clear(&meter->window);
+  accum_clear(&meter->totals);
+
+  if (meter_cfg->mv_per_pa > 0.0f) {
+    ESP_GOTO_ON_ERROR(sound_acoustics_init(&meter->acoustics, meter_cfg), err, TAG, "failed to set up the A-weighting");
+    meter->has_acoustics = true;
+  }
+
+  *out_meter = meter;
+  return ESP_OK;
+err:
+  free(meter);
+  return ret;
+}
+esp_err_t
+sound_meter_del(sound_meter_handle meter) {
+  ESP_RETURN_ON_FALSE(meter, ESP_ERR_INVALID_ARG, TAG, "invalid sound meter");
+
+  if (meter->has_acoustics) {
+    sound_acoustics_deinit(&meter->acoustics);
+  }
+  free(meter);
+  return ESP_OK;
+}
+
+esp_err_t
+sound_meter_reset(sound_meter_handle meter, uint64_t now_us) {
+  ESP_RETURN_ON_FALSE(meter, ESP_ERR_INVALID_ARG, TAG, "invalid sound meter");
+
+  accum_clear(&meter->window);
+  meter->window_start_us = now_us;
+  return ESP_OK;
+}
+
+void
+sound_meter_feed(sound_meter_handle meter, const uint16_t *samples_mv, uint32_t count, uint32_t frames_dropped) {
+  sound_meter_accum *window = &meter->window;
+  int32_t dc_offset = (int32_t)meter->cfg.dc_offset_mv << meter->cfg.sample_frac_bits;
+
+  stream_stats_add_u16(&window->level, samples_mv, count, dc_offset);
+  window->frames_dropped += frames_dropped;
+
+  if (meter->has_acoustics) {
+    sound_acoustics_process(&meter->acoustics, samples_mv, count, dc_offset, &window->acoustics);
+  }
+}
+
+esp_err_t
+sound_meter_close_window(sound_meter_handle meter, uint64_t now_us, sound_meter_window_t *out_window) {
+  ESP_RETURN_ON_FALSE(meter && out_window, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  meter->window.duration_us = now_us > meter->window_start_us ? now_us - meter->window_start_us : 0U;
+  accum_to_window(meter, &meter->window, out_window);
+  accum_merge(&meter->totals, &meter->window);
+
+  accum_clear(&meter->window);
+  meter->window_start_us = now_us;
+  return ESP_OK;
+}
+
+esp_err_t
+sound_meter_get_totals(sound_meter_handle meter, sound_meter_window_t *out_totals) {
+  ESP_RETURN_ON_FALSE(meter && out_totals, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  accum_to_window(meter, &meter->totals, out_totals);
+  return ESP_OK;
+}
+
+esp_err_t
+sound_meter_get_band(sound_meter_handle meter, uint8_t band, sound_meter_band_t *out_band) {
+  ESP_RETURN_ON_FALSE(meter && out_band, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(meter->has_acoustics && meter->acoustics.has_spectrum, ESP_ERR_INVALID_STATE, TAG,
+                      "band levels not configured");
+
+  return sound_spectrum_get_band(&meter->acoustics.spectrum, band, out_band);
+}
+
+esp_err_t
+sound_meter_benchmark_spectrum(uint16_t fft_size, uint32_t frames, uint32_t *out_ticks_per_frame) {
+  return sound_spectrum_benchmark(fft_size, frames, out_ticks_per_frame);
+}
+
+static void
+accum_clear(sound_meter_accum *accum) {
+  stream_stats_reset(&accum->level);
+  accum->frames_dropped = 0U;
+  accum->duration_us = 0U;
+  sound_acoustics_accum_clear(&accum->acoustics);
+}
+static void
+accum_merge(sound_meter_accum *into, const sound_meter_accum *from) {
+  stream_stats_merge(&into->level, &from->level);
+  into->frames_dropped += from->frames_dropped;
+  into->duration_us += from->duration_us;
+  sound_acoustics_accum_merge(&into->acoustics, &from->acoustics);
+}
+static void
+accum_to_window(const struct sound_meter *meter, const sound_meter_accum *accum, sound_meter_window_t *out_window) {
+  uint64_t expected = (accum->duration_us * meter->cfg.sample_rate_hz + 500000ULL) / 1000000ULL;
+  int32_t dc_offset = meter->cfg.dc_offset_mv;
+  uint8_t frac_bits = meter->cfg.sample_frac_bits;
+  stream_stats_result_t level;
+  stream_stats_get(&accum->level, &level);
+
+  *out_window = (sound_meter_window_t){
+      .samples = (uint32_t)level.count,
+      .expected_samples = expected > UINT32_MAX ? UINT32_MAX : (uint32_t)expected,
+      .frames_dropped = accum->frames_dropped,
+      .duration_ms = (uint32_t)(accum->duration_us / 1000ULL),
+  };
+  if (!level.count)
+    return;
+
+  // Back to whole millivolts, rounded
+  int32_t rounding = frac_bits ? 1 << (frac_bits - 1U) : 0;
+  int32_t peak = level.max > -level.min ? level.max : -level.min;
+
+  out_window->rms_mv = level.rms / (float)(1U << frac_bits);
+  out_window->peak_mv = (uint16_t)(peak > 0 ? (peak + rounding) >> frac_bits : 0);
+  out_window->min_mv = (uint16_t)(((level.min + rounding) >> frac_bits) + dc_offset);
+  out_window->max_mv = (uint16_t)(((level.max + rounding) >> frac_bits) + dc_offset);
+  out_window->coverage = expected ? (float)out_window->samples / (float)expected : 1.0f;
+  if (out_window->coverage > 1.0f) {
+    out_window->coverage = 1.0f;
+  }
+
+  if (meter->has_acoustics) {
+    sound_acoustics_levels(&meter->acoustics, &accum->acoustics, out_window);
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef STATE_STORE_PRIVATE_H
+#define STATE_STORE_PRIVATE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATE_STORE_MAGIC      0x54535453UL // "STST"
+#define STATE_STORE_SLOT_COUNT 2U
+#define STATE_STORE_NO_SLOT    0xFFU
+
+/**
+ * Leads every slot, the CRC covers the header up to it and the blob after it
+ */
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t len;
+  uint32_t sequence; // one up per write, the larger one of the two slots is the newer
+  uint32_t crc;
+} state_store_header_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
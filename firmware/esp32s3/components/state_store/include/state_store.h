@@ -0,0 +1,53 @@
+#pragma once
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "state_store_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct state_store *state_store_handle;
+
+/**
+ * Opens the namespace and finds the newest valid slot, nvs_flash_init must have run
+ */
+esp_err_t
+state_store_new(const struct state_store_config_t *store_cfg, state_store_handle *out_store);
+esp_err_t
+state_store_del(state_store_handle store);
+
+/**
+ * Newest slot whose version, length and CRC check out. ESP_ERR_NOT_FOUND when neither does.
+ */
+esp_err_t
+state_store_load(state_store_handle store, uint8_t *data, size_t data_len, size_t *out_len);
+
+/**
+ * Writes the blob over the older slot, so a reset in the middle of a write still leaves the newer one to load.
+ * out_written, if given, is false for a save dropped as unchanged or too early, which still returns ESP_OK.
+ */
+esp_err_t
+state_store_save(state_store_handle store, const uint8_t *data, size_t len, uint64_t now_us, bool *out_written);
+
+/**
+ * Invalidates both slots, e.g. after the sensor was replaced
+ */
+esp_err_t
+state_store_erase(state_store_handle store);
+
+esp_err_t
+state_store_get_stats(state_store_handle store, state_store_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
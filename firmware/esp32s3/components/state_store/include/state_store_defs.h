@@ -0,0 +1,33 @@
+#pragma once
+#ifndef STATE_STORE_DEFS_H
+#define STATE_STORE_DEFS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STATE_STORE_KEY_MAX_LEN 14U // NVS keys hold 15 characters, the slot index is appended
+
+struct state_store_config_t {
+  const char *namespace_name;
+  const char *key;  // two slots, <key>0 and <key>1
+  uint16_t version; // format of the blob, slots of any other version are ignored
+  uint16_t max_len; // largest blob saved or loaded
+
+  uint32_t min_interval_ms; // saves closer together than this are dropped, bounds the flash wear, 0 for none
+};
+
+typedef struct {
+  uint32_t writes;
+  uint32_t skipped_unchanged; // same blob as the newest slot
+  uint32_t skipped_early;     // within min_interval_ms of the previous write
+  uint32_t write_failures;
+} state_store_stats_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
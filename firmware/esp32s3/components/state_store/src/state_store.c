@@ -0,0 +1,235 @@
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+
+#include "private/state_store_private.h"
+#include "state_store.h"
+
+struct state_store {
+  struct state_store_config_t cfg;
+  char keys[STATE_STORE_SLOT_COUNT][STATE_STORE_KEY_MAX_LEN + 2U];
+  nvs_handle_t nvs;
+
+  uint8_t *buffer; // one slot, header and blob
+  size_t buffer_len;
+
+  uint8_t newest_slot; // STATE_STORE_NO_SLOT while neither is valid
+  uint32_t newest_sequence;
+  uint16_t newest_len;
+  uint32_t newest_data_crc; // of the blob alone, a save of the same blob is dropped
+
+  bool has_written;
+  uint64_t last_write_us;
+
+  state_store_stats_t stats;
+};
+
+static const char *TAG = "state_store";
+
+static esp_err_t
+read_slot(state_store_handle store, uint8_t slot, state_store_header_t *out_header);
+static uint32_t
+slot_crc(const state_store_header_t *header, const uint8_t *data);
+
+esp_err_t
+state_store_new(const struct state_store_config_t *store_cfg, state_store_handle *out_store) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(store_cfg && store_cfg->namespace_name && store_cfg->key && out_store, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid argument");
+  ESP_RETURN_ON_FALSE(strlen(store_cfg->key) > 0 && strlen(store_cfg->key) <= STATE_STORE_KEY_MAX_LEN, ESP_ERR_INVALID_ARG,
+                      TAG, "key must have 1 to %u characters", STATE_STORE_KEY_MAX_LEN);
+  ESP_RETURN_ON_FALSE(store_cfg->max_len > 0, ESP_ERR_INVALID_ARG, TAG, "zero max_len");
+
+  struct state_store *store = calloc(1, sizeof(struct state_store));
+  ESP_RETURN_ON_FALSE(store, ESP_ERR_NO_MEM, TAG, "failed to allocate state store");
+
+  store->cfg = *store_cfg;
+  store->newest_slot = STATE_STORE_NO_SLOT;
+  for (uint8_t i = 0; i < STATE_STORE_SLOT_COUNT; ++i) {
+    snprintf(store->keys[i], sizeof(store->keys[i]), "%s%u", store_cfg->key, i);
+  }
+
+  store->buffer_len = sizeof(state_store_header_t) + store_cfg->max_len;
+  store->buffer = malloc(store->buffer_len);
+  ESP_GOTO_ON_FALSE(store->buffer, ESP_ERR_NO_MEM, err, TAG, "failed to allocate %zu bytes", store->buffer_len);
+
+  ESP_GOTO_ON_ERROR(nvs_open(store_cfg->namespace_name, NVS_READWRITE, &store->nvs), err, TAG, "failed to open %s",
+                    store_cfg->namespace_name);
+
+  for (uint8_t i = 0; i < STATE_STORE_SLOT_COUNT; ++i) {
+    state_store_header_t header;
+    if (read_slot(store, i, &header) != ESP_OK)
+      continue;
+    if (store->newest_slot == STATE_STORE_NO_SLOT || (int32_t)(header.sequence - store->newest_sequence) > 0) {
+      store->newest_slot = i;
+      store->newest_sequence = header.sequence;
+      store->newest_len = header.len;
+      store->newest_data_crc = esp_rom_crc32_le(0, store->buffer + sizeof(header), header.len);
+    }
+  }
+  if (store->newest_slot != STATE_STORE_NO_SLOT) {
+    ESP_LOGI(TAG, "%s: newest state in slot %u, write %" PRIu32, store_cfg->key, store->newest_slot, store->newest_sequence);
+  }
+
+  *out_store = store;
+  return ESP_OK;
+err:
+  free(store->buffer);
+  free(store);
+  return ret;
+}
+esp_err_t
+state_store_del(state_store_handle store) {
+  ESP_RETURN_ON_FALSE(store, ESP_ERR_INVALID_ARG, TAG, "invalid state store");
+
+  nvs_close(store->nvs);
+  free(store->buffer);
+  free(store);
+  return ESP_OK;
+}
+
+esp_err_t
+state_store_load(state_store_handle store, uint8_t *data, size_t data_len, size_t *out_len) {
+  ESP_RETURN_ON_FALSE(store && data && out_len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  if (store->newest_slot == STATE_STORE_NO_SLOT)
+    return ESP_ERR_NOT_FOUND;
+
+  // Read again, the slot found at start up may have gone bad since, then the other one is the fallback
+  state_store_header_t header;
+  uint8_t slot = store->newest_slot;
+  if (read_slot(store, slot, &header) != ESP_OK) {
+    slot = (uint8_t)(slot ^ 1U);
+    ESP_RETURN_ON_FALSE(read_slot(store, slot, &header) == ESP_OK, ESP_ERR_NOT_FOUND, TAG, "%s: no valid slot left",
+                        store->cfg.key);
+    // Saves go over the bad slot from now on, and compare against what this one holds
+    store->newest_slot = slot;
+    store->newest_sequence = header.sequence;
+    store->newest_len = header.len;
+    store->newest_data_crc = esp_rom_crc32_le(0, store->buffer + sizeof(header), header.len);
+  }
+  ESP_RETURN_ON_FALSE(header.len <= data_len, ESP_ERR_INVALID_SIZE, TAG, "%s: %u byte state does not fit %zu bytes",
+                      store->cfg.key, header.len, data_len);
+
+  memcpy(data, store->buffer + sizeof(header), header.len);
+  *out_len = header.len;
+  return ESP_OK;
+}
+
+esp_err_t
+state_store_save(state_store_handle store, const uint8_t *data, size_t len, uint64_t now_us, bool *out_written) {
+  ESP_RETURN_ON_FALSE(store && data && len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(len <= store->cfg.max_len, ESP_ERR_INVALID_SIZE, TAG, "%zu byte state over max_len", len);
+  if (out_written) {
+    *out_written = false;
+  }
+
+  if (store->has_written && now_us - store->last_write_us < (uint64_t)store->cfg.min_interval_ms * 1000ULL) {
+    store->stats.skipped_early++;
+    return ESP_OK;
+  }
+
+  uint32_t data_crc = esp_rom_crc32_le(0, data, len);
+  if (store->newest_slot != STATE_STORE_NO_SLOT && len == store->newest_len && data_crc == store->newest_data_crc) {
+    store->stats.skipped_unchanged++;
+    return ESP_OK;
+  }
+
+  state_store_header_t header = {
+      .magic = STATE_STORE_MAGIC,
+      .version = store->cfg.version,
+      .len = (uint16_t)len,
+      .sequence = store->newest_slot == STATE_STORE_NO_SLOT ? 0U : store->newest_sequence + 1U,
+      .crc = 0,
+  };
+  header.crc = slot_crc(&header, data);
+
+  uint8_t slot = store->newest_slot == STATE_STORE_NO_SLOT ? 0U : (uint8_t)(store->newest_slot ^ 1U);
+  memcpy(store->buffer, &header, sizeof(header));
+  memcpy(store->buffer + sizeof(header), data, len);
+  esp_err_t ret = nvs_set_blob(store->nvs, store->keys[slot], store->buffer, sizeof(header) + len);
+  if (ret == ESP_OK) {
+    ret = nvs_commit(store->nvs);
+  }
+  if (ret != ESP_OK) {
+    // The newer slot was not touched, it stays the one to load
+    store->stats.write_failures++;
+    ESP_LOGW(TAG, "%s: failed to write slot %u: %s", store->cfg.key, slot, esp_err_to_name(ret));
+    return ret;
+  }
+
+  store->newest_slot = slot;
+  store->newest_sequence = header.sequence;
+  store->newest_len = header.len;
+  store->newest_data_crc = data_crc;
+  store->has_written = true;
+  store->last_write_us = now_us;
+  store->stats.writes++;
+  if (out_written) {
+    *out_written = true;
+  }
+  return ESP_OK;
+}
+
+esp_err_t
+state_store_erase(state_store_handle store) {
+  ESP_RETURN_ON_FALSE(store, ESP_ERR_INVALID_ARG, TAG, "invalid state store");
+
+  for (uint8_t i = 0; i < STATE_STORE_SLOT_COUNT; ++i) {
+    esp_err_t ret = nvs_erase_key(store->nvs, store->keys[i]);
+    ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_NVS_NOT_FOUND, ret, TAG, "failed to erase %s", store->keys[i]);
+  }
+  ESP_RETURN_ON_ERROR(nvs_commit(store->nvs), TAG, "failed to commit");
+  store->newest_slot = STATE_STORE_NO_SLOT;
+  return ESP_OK;
+}
+
+esp_err_t
+state_store_get_stats(state_store_handle store, state_store_stats_t *out_stats) {
+  ESP_RETURN_ON_FALSE(store && out_stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  *out_stats = store->stats;
+  return ESP_OK;
+}
+
+/**
+ * Slot into the buffer, ESP_OK only if it is complete and of the configured version
+ */
+static esp_err_t
+read_slot(state_store_handle store, uint8_t slot, state_store_header_t *out_header) {
+  size_t len = store->buffer_len;
+  esp_err_t ret = nvs_get_blob(store->nvs, store->keys[slot], store->buffer, &len);
+  if (ret != ESP_OK)
+    return ret == ESP_ERR_NVS_INVALID_LENGTH ? ESP_ERR_INVALID_SIZE : ESP_ERR_NOT_FOUND;
+  if (len < sizeof(state_store_header_t))
+    return ESP_ERR_INVALID_SIZE;
+
+  state_store_header_t header;
+  memcpy(&header, store->buffer, sizeof(header));
+  if (header.magic != STATE_STORE_MAGIC || header.len != len - sizeof(header))
+    return ESP_ERR_INVALID_SIZE;
+  if (header.version != store->cfg.version) {
+    ESP_LOGW(TAG, "%s: slot %u holds version %u, expected %u", store->cfg.key, slot, header.version, store->cfg.version);
+    return ESP_ERR_INVALID_VERSION;
+  }
+  if (slot_crc(&header, store->buffer + sizeof(header)) != header.crc) {
+    ESP_LOGW(TAG, "%s: slot %u fails its CRC", store->cfg.key, slot);
+    return ESP_ERR_INVALID_CRC;
+  }
+
+  *out_header = header;
+  return ESP_OK;
+}
+
+static uint32_t
+slot_crc(const state_store_header_t *header, const uint8_t *data) {
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(state_store_header_t, crc));
+  return esp_rom_crc32_le(crc, data, header->len);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#ifndef STREAM_STATS_PRIVATE_H
+#define STREAM_STATS_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_STATS_CHUNK_LEN 4096U // pending sums of squares stay below 2^54 for values within STREAM_STATS_VALUE_MAX
+#define STREAM_STATS_ONE       (1LL << STREAM_STATS_FRAC_BITS)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+
+#include <stdint.h>
+
+#include "stream_stats_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void
+stream_stats_reset(stream_stats_t *stats);
+
+/**
+ * Updates run on integers only, exact sums around the first value of every chunk that are folded into the running
+ * state once per chunk, so neither the call size nor single pushes cost any rounding
+ */
+void
+stream_stats_push(stream_stats_t *stats, int32_t value);
+void
+stream_stats_add(stream_stats_t *stats, const int32_t *values, uint32_t count);
+/**
+ * Same as stream_stats_add for unsigned 16 bit samples, offset is subtracted from each of them first
+ */
+void
+stream_stats_add_u16(stream_stats_t *stats, const uint16_t *values, uint32_t count, int32_t offset);
+
+/**
+ * Combines the statistics of from into into, as if into had seen the values of both
+ */
+void
+stream_stats_merge(stream_stats_t *into, const stream_stats_t *from);
+
+void
+stream_stats_get(const stream_stats_t *stats, stream_stats_result_t *out_result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
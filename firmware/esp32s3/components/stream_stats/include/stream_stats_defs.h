@@ -0,0 +1,50 @@
+#pragma once
+#ifndef STREAM_STATS_DEFS_H
+#define STREAM_STATS_DEFS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_STATS_FRAC_BITS 8U
+#define STREAM_STATS_VALUE_MAX (1L << 20) // magnitude the values have to stay within, scale inputs to fit
+
+/**
+ * Running count, mean and sum of squared deviations (Welford's M2) in fixed point with STREAM_STATS_FRAC_BITS
+ * fraction bits. Zeroed or reset state is an empty window, two states merge into the statistics of both.
+ * M2 holds count * variance up to 2^56, e.g. 2^34 samples of a 12 bit signal, and saturates beyond.
+ */
+typedef struct {
+  uint64_t count; // folded into mean_q and m2_q, pending samples not included
+  int64_t mean_q;
+  uint64_t m2_q;
+  int32_t min;
+  int32_t max;
+
+  // Up to a chunk of samples kept as exact sums around the first of them, folded in once the chunk is full
+  int32_t pending_ref;
+  uint32_t pending_count;
+  int64_t pending_sum;
+  uint64_t pending_sum_sq;
+} stream_stats_t;
+
+/**
+ * Population statistics of a state, all 0 when it is empty
+ */
+typedef struct {
+  uint64_t count;
+  float mean;
+  float variance;
+  float stddev;
+  float rms; // about 0, sqrt(mean^2 + variance)
+  int32_t min;
+  int32_t max;
+} stream_stats_result_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,233 @@
+#include <math.h>
+#include <string.h>
+
+#include "private/stream_stats_private.h"
+#include "stream_stats.h"
+
+static void
+accumulate(stream_stats_t *stats, uint32_t count, int32_t ref, int64_t sum_d, uint64_t sum_d2, int32_t min, int32_t max);
+static void
+fold_pending(stream_stats_t *stats);
+static void
+merge_moments(stream_stats_t *stats, uint64_t count, int64_t mean_q, uint64_t m2_q);
+static uint64_t
+mul_div_u64(uint64_t a, uint64_t b, uint64_t c);
+
+void
+stream_stats_reset(stream_stats_t *stats) {
+  memset(stats, 0, sizeof(stream_stats_t));
+}
+
+void
+stream_stats_push(stream_stats_t *stats, int32_t value) {
+  accumulate(stats, 1U, value, 0, 0U, value, value);
+}
+void
+stream_stats_add(stream_stats_t *stats, const int32_t *values, uint32_t count) {
+  while (count) {
+    uint32_t room = STREAM_STATS_CHUNK_LEN - stats->pending_count;
+    uint32_t len = count < room ? count : room;
+    int32_t ref = values[0];
+    int32_t min = ref;
+    int32_t max = ref;
+    int64_t sum_d = 0;
+    uint64_t sum_d2 = 0;
+
+    for (uint32_t i = 0; i < len; ++i) {
+      int32_t value = values[i];
+      int32_t d = value - ref;
+      sum_d += d;
+      sum_d2 += (uint64_t)((int64_t)d * d);
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    accumulate(stats, len, ref, sum_d, sum_d2, min, max);
+
+    values += len;
+    count -= len;
+  }
+}
+void
+stream_stats_add_u16(stream_stats_t *stats, const uint16_t *values, uint32_t count, int32_t offset) {
+  while (count) {
+    uint32_t room = STREAM_STATS_CHUNK_LEN - stats->pending_count;
+    uint32_t len = count < room ? count : room;
+    int32_t ref = values[0];
+    uint16_t min = values[0];
+    uint16_t max = values[0];
+    int32_t sum_d = 0; // |d| < 2^16 over a chunk of 2^12 samples
+    uint64_t sum_d2 = 0;
+
+    for (uint32_t i = 0; i < len; ++i) {
+      uint16_t value = values[i];
+      int32_t d = (int32_t)value - ref;
+      sum_d += d;
+      sum_d2 += (uint32_t)d * (uint32_t)d; // d^2 < 2^32, wraps back to the right value
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    accumulate(stats, len, ref - offset, sum_d, sum_d2, (int32_t)min - offset, (int32_t)max - offset);
+
+    values += len;
+    count -= len;
+  }
+}
+
+void
+stream_stats_merge(stream_stats_t *into, const stream_stats_t *from) {
+  stream_stats_t folded = *from;
+  fold_pending(&folded);
+  if (!folded.count)
+    return;
+
+  fold_pending(into);
+  if (!into->count) {
+    *into = folded;
+    return;
+  }
+  into->min = folded.min < into->min ? folded.min : into->min;
+  into->max = folded.max > into->max ? folded.max : into->max;
+  merge_moments(into, folded.count, folded.mean_q, folded.m2_q);
+}
+
+void
+stream_stats_get(const stream_stats_t *stats_in, stream_stats_result_t *out_result) {
+  memset(out_result, 0, sizeof(stream_stats_result_t));
+  stream_stats_t folded = *stats_in;
+  fold_pending(&folded);
+  const stream_stats_t *stats = &folded;
+  if (!stats->count)
+    return;
+
+  double mean = (double)stats->mean_q / STREAM_STATS_ONE;
+  double variance = (double)stats->m2_q / STREAM_STATS_ONE / (double)stats->count;
+  out_result->count = stats->count;
+  out_result->mean = (float)mean;
+  out_result->variance = (float)variance;
+  out_result->stddev = (float)sqrt(variance);
+  out_result->rms = (float)sqrt(mean * mean + variance);
+  out_result->min = stats->min;
+  out_result->max = stats->max;
+}
+
+/**
+ * Moves the sums of a chunk around ref onto the pending reference, folding the pending samples first when they are full
+ */
+static void
+accumulate(stream_stats_t *stats, uint32_t count, int32_t ref, int64_t sum_d, uint64_t sum_d2, int32_t min, int32_t max) {
+  if (!stats->count && !stats->pending_count) {
+    stats->min = min;
+    stats->max = max;
+  } else {
+    stats->min = min < stats->min ? min : stats->min;
+    stats->max = max > stats->max ? max : stats->max;
+  }
+
+  if (!stats->pending_count) {
+    stats->pending_ref = ref;
+  }
+  // sum (d + s)^2 = sum d^2 + 2 s sum d + n s^2, every term stays within the 2^54 of a full chunk
+  int64_t shift = (int64_t)ref - stats->pending_ref;
+  stats->pending_sum += sum_d + (int64_t)count * shift;
+  stats->pending_sum_sq += sum_d2 + (uint64_t)(2 * shift * sum_d + (int64_t)count * shift * shift);
+  stats->pending_count += count;
+
+  if (stats->pending_count >= STREAM_STATS_CHUNK_LEN) {
+    fold_pending(stats);
+  }
+}
+/**
+ * Mean and M2 of the pending samples from their exact sums, then merged like any other window
+ */
+static void
+fold_pending(stream_stats_t *stats) {
+  uint32_t count = stats->pending_count;
+  if (!count)
+    return;
+
+  int64_t sum_d = stats->pending_sum;
+  uint64_t sum_d2 = stats->pending_sum_sq;
+  uint64_t abs_sum = sum_d < 0 ? (uint64_t)-sum_d : (uint64_t)sum_d;
+  uint64_t mean_shift = (abs_sum * STREAM_STATS_ONE + count / 2U) / count;
+  int64_t mean_q = (int64_t)stats->pending_ref * STREAM_STATS_ONE + (sum_d < 0 ? -(int64_t)mean_shift : (int64_t)mean_shift);
+  uint64_t m2_q = sum_d2 * STREAM_STATS_ONE - mul_div_u64(abs_sum * STREAM_STATS_ONE, abs_sum, count);
+  m2_q = m2_q > sum_d2 * STREAM_STATS_ONE ? 0U : m2_q; // rounding up a zero spread
+
+  stats->pending_count = 0;
+  stats->pending_sum = 0;
+  stats->pending_sum_sq = 0;
+  merge_moments(stats, count, mean_q, m2_q);
+}
+/**
+ * Chan et al. pairwise update, Welford's step generalised to a batch:
+ * mean += delta * n_b / n and M2 += M2_b + delta^2 * n_a * n_b / n
+ */
+static void
+merge_moments(stream_stats_t *stats, uint64_t count, int64_t mean_q, uint64_t m2_q) {
+  if (!stats->count) {
+    stats->count = count;
+    stats->mean_q = mean_q;
+    stats->m2_q = m2_q;
+    return;
+  }
+
+  uint64_t count_a = stats->count;
+  uint64_t total = count_a + count;
+  int64_t delta = mean_q - stats->mean_q;
+  uint64_t abs_delta = delta < 0 ? (uint64_t)-delta : (uint64_t)delta;
+
+  uint64_t shift = mul_div_u64(abs_delta, count, total);
+  stats->mean_q += delta < 0 ? -(int64_t)shift : (int64_t)shift;
+
+  // Means stay within 2^28 in fixed point, so the square of their distance fits before dropping the extra fraction
+  uint64_t delta_sq = (abs_delta * abs_delta) >> STREAM_STATS_FRAC_BITS;
+  uint64_t spread;
+  if (!((count_a | count) >> 32U)) {
+    spread = mul_div_u64(delta_sq, count_a * count, total);
+  } else {
+    uint64_t larger = count_a > count ? count_a : count;
+    uint64_t smaller = count_a > count ? count : count_a;
+    spread = mul_div_u64(delta_sq, larger, total) * smaller;
+  }
+  // Past the capacity the spread sticks at the top instead of wrapping
+  uint64_t m2_sum = stats->m2_q + m2_q;
+  m2_sum = m2_sum < m2_q ? UINT64_MAX : m2_sum;
+  stats->m2_q = m2_sum + spread < m2_sum ? UINT64_MAX : m2_sum + spread;
+  stats->count = total;
+}
+/**
+ * a * b / c rounded to nearest through a 128 bit product, saturates when the result does not fit 64 bits
+ */
+static uint64_t
+mul_div_u64(uint64_t a, uint64_t b, uint64_t c) {
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32U;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32U;
+  uint64_t p0 = a_lo * b_lo;
+  uint64_t p1 = a_lo * b_hi;
+  uint64_t p2 = a_hi * b_lo;
+  uint64_t mid = (p0 >> 32U) + (uint32_t)p1 + (uint32_t)p2;
+  uint64_t lo = (mid << 32U) | (uint32_t)p0;
+  uint64_t hi = a_hi * b_hi + (p1 >> 32U) + (p2 >> 32U) + (mid >> 32U);
+
+  // Truncating every merge would drag the mean toward zero over a long run of small updates
+  lo += c / 2U;
+  hi += lo < c / 2U;
+  if (!hi)
+    return lo / c;
+  if (hi >= c)
+    return UINT64_MAX;
+
+  // Shift and subtract, the remainder stays below c
+  uint64_t quotient = 0;
+  for (uint8_t i = 0; i < 64U; ++i) {
+    uint64_t carry = hi >> 63U;
+    hi = (hi << 1U) | (lo >> 63U);
+    lo <<= 1U;
+    quotient <<= 1U;
+    if (carry || hi >= c) {
+      hi -= c;
+      quotient |= 1U;
+    }
+  }
+  return quotient;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#ifndef TEMP_FUSION_PRIVATE_H
+#define TEMP_FUSION_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMP_FUSION_GATE_SIGMA  5.0f   // innovations beyond this many standard deviations are dropped
+#define TEMP_FUSION_GATE_LIMIT  3U     // ... unless this many in a row were, then the filter follows them
+#define TEMP_FUSION_INITIAL_VAR 100.0f // of the room temperature before the first reading, 10 C either way
+#define TEMP_FUSION_S_PER_H     3600.0f
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef TEMP_FUSION_H
+#define TEMP_FUSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "temp_fusion_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void
+temp_fusion_init(temp_fusion_t *fusion, const temp_fusion_config_t *cfg);
+
+/**
+ * Folds in one reading of the self heated sensor or of the reference. A reading older than the newest one is taken
+ * as if it were of that time, the cached reference is usually a little behind.
+ */
+void
+temp_fusion_push_sensor(temp_fusion_t *fusion, float temp, uint64_t timestamp_us);
+void
+temp_fusion_push_ref(temp_fusion_t *fusion, float temp, uint64_t timestamp_us);
+
+/**
+ * false until the first reading
+ */
+bool
+temp_fusion_get(const temp_fusion_t *fusion, temp_fusion_result_t *out_result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef TEMP_FUSION_DEFS_H
+#define TEMP_FUSION_DEFS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Noise of the two sensors and how fast the room and the self heating may move, all in degrees C. The drifts are the
+ * standard deviation of a random walk after an hour, the filter trusts fresh readings more the larger they are.
+ */
+typedef struct {
+  float sensor_noise; // the self heated sensor, read often
+  float ref_noise;    // the reference, read rarely but not heated by the board
+
+  float temp_drift_per_h;
+  float heating_drift_per_h;
+
+  float initial_heating; // how much warmer the sensor is expected to read before the reference has said otherwise
+  float initial_heating_stddev;
+} temp_fusion_config_t;
+
+/**
+ * Room temperature and self heating of the sensor as the two states of a Kalman filter. The sensor reads their sum,
+ * the reference the room temperature alone. Zeroed state has seen no reading yet.
+ */
+typedef struct {
+  temp_fusion_config_t cfg;
+
+  bool is_started;
+  uint64_t timestamp_us; // of the newest reading folded in
+  float temp;
+  float heating;
+  float p_tt; // covariance of the two
+  float p_th;
+  float p_hh;
+
+  uint32_t sensor_updates;
+  uint32_t ref_updates;
+  uint32_t rejected; // readings too far from the estimate to be believed
+  uint8_t rejected_run;
+} temp_fusion_t;
+
+typedef struct {
+  float temp;
+  float heating;
+  float temp_stddev;
+} temp_fusion_result_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+#include <math.h>
+#include <string.h>
+
+#include "private/temp_fusion_private.h"
+#include "temp_fusion.h"
+
+static void
+push(temp_fusion_t *fusion, float temp, uint64_t timestamp_us, float heating_gain, float noise);
+static void
+predict(temp_fusion_t *fusion, uint64_t timestamp_us);
+
+void
+temp_fusion_init(temp_fusion_t *fusion, const temp_fusion_config_t *cfg) {
+  memset(fusion, 0, sizeof(temp_fusion_t));
+  fusion->cfg = *cfg;
+}
+
+void
+temp_fusion_push_sensor(temp_fusion_t *fusion, float temp, uint64_t timestamp_us) {
+  push(fusion, temp, timestamp_us, 1.0f, fusion->cfg.sensor_noise);
+}
+void
+temp_fusion_push_ref(temp_fusion_t *fusion, float temp, uint64_t timestamp_us) {
+  push(fusion, temp, timestamp_us, 0.0f, fusion->cfg.ref_noise);
+}
+
+bool
+temp_fusion_get(const temp_fusion_t *fusion, temp_fusion_result_t *out_result) {
+  if (!fusion->is_started)
+    return false;
+
+  out_result->temp = fusion->temp;
+  out_result->heating = fusion->heating;
+  out_result->temp_stddev = sqrtf(fusion->p_tt);
+  return true;
+}
+
+/**
+ * Scalar Kalman update, the reading is temp + heating_gain * heating
+ */
+static void
+push(temp_fusion_t *fusion, float temp, uint64_t timestamp_us, float heating_gain, float noise) {
+  float a = heating_gain;
+
+  if (!fusion->is_started) {
+    // The first reading sets the room temperature as far as the expected self heating allows
+    fusion->is_started = true;
+    fusion->timestamp_us = timestamp_us;
+    fusion->heating = fusion->cfg.initial_heating;
+    fusion->temp = temp - a * fusion->heating;
+    fusion->p_tt = TEMP_FUSION_INITIAL_VAR;
+    fusion->p_th = 0.0f;
+    fusion->p_hh = fusion->cfg.initial_heating_stddev * fusion->cfg.initial_heating_stddev;
+  } else {
+    predict(fusion, timestamp_us);
+  }
+
+  float innovation = temp - (fusion->temp + a * fusion->heating);
+  if (fusion->rejected_run >= TEMP_FUSION_GATE_LIMIT) {
+    // Readings that keep disagreeing are a real step, the room temperature starts over from them
+    fusion->p_tt += TEMP_FUSION_INITIAL_VAR;
+    fusion->rejected_run = 0;
+  }
+
+  // H * P, the covariance of the reading with each state
+  float c_t = fusion->p_tt + a * fusion->p_th;
+  float c_h = fusion->p_th + a * fusion->p_hh;
+  float s = c_t + a * c_h + noise * noise;
+  if (innovation * innovation > TEMP_FUSION_GATE_SIGMA * TEMP_FUSION_GATE_SIGMA * s) {
+    fusion->rejected++;
+    fusion->rejected_run++;
+    return;
+  }
+  fusion->rejected_run = 0;
+
+  float k_t = c_t / s;
+  float k_h = c_h / s;
+  fusion->temp += k_t * innovation;
+  fusion->heating += k_h * innovation;
+  fusion->p_tt -= k_t * c_t;
+  fusion->p_th -= k_t * c_h;
+  fusion->p_hh -= k_h * c_h;
+
+  if (a != 0.0f) {
+    fusion->sensor_updates++;
+  } else {
+    fusion->ref_updates++;
+  }
+}
+
+/**
+ * Both states are random walks, their variance grows with the time since the newest reading
+ */
+static void
+predict(temp_fusion_t *fusion, uint64_t timestamp_us) {
+  if (timestamp_us <= fusion->timestamp_us)
+    return;
+
+  float dt_h = (float)(timestamp_us - fusion->timestamp_us) / (TEMP_FUSION_S_PER_H * 1000000.0f);
+  fusion->timestamp_us = timestamp_us;
+  fusion->p_tt += fusion->cfg.temp_drift_per_h * fusion->cfg.temp_drift_per_h * dt_h;
+  fusion->p_hh += fusion->cfg.heating_drift_per_h * fusion->cfg.heating_drift_per_h * dt_h;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef TSL2591_ALS_PRIVATE_H
+#define TSL2591_ALS_PRIVATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TSL2591_ALS_CMD         0xA0U // command bit with a normal, auto-incrementing transaction
+#define TSL2591_ALS_CMD_CLEAR   0xE7U // special function clearing the ALS and no persist interrupts
+#define TSL2591_ALS_REG_ENABLE  0x00U
+#define TSL2591_ALS_REG_CONTROL 0x01U
+#define TSL2591_ALS_REG_AILTL   0x04U
+#define TSL2591_ALS_REG_PERSIST 0x0CU
+#define TSL2591_ALS_REG_ID      0x12U
+#define TSL2591_ALS_REG_STATUS  0x13U
+#define TSL2591_ALS_REG_C0DATAL 0x14U
+
+#define TSL2591_ALS_ID 0x50U
+
+#define TSL2591_ALS_ENABLE_OFF  0x00U
+#define TSL2591_ALS_ENABLE_PON  0x01U
+#define TSL2591_ALS_ENABLE_AEN  0x02U
+#define TSL2591_ALS_ENABLE_AIEN 0x10U
+
+#define TSL2591_ALS_STATUS_AVALID 0x01U
+
+#define TSL2591_ALS_MAX_COUNT_100MS 36863U // the 100 ms integration counts to 0x8FFF, every longer one to 0xFFFF
+#define TSL2591_ALS_MAX_COUNT       65535U
+
+#define TSL2591_ALS_LUX_DF           408.0f // device factor of the datasheet lux equation
+#define TSL2591_ALS_WAIT_MARGIN_PCT  10U    // the internal oscillator may run this much slow
+#define TSL2591_ALS_DEFAULT_HEADROOM 0.5f
+#define TSL2591_ALS_MIN_WINDOW_COUNT 16U    // thresholds stay at least this far from the count, noise in the dark stays in
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
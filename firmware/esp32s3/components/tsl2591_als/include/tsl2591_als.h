@@ -0,0 +1,67 @@
+#pragma once
+#ifndef TSL2591_ALS_H
+#define TSL2591_ALS_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "tsl2591_als_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct tsl2591_als *tsl2591_als_handle;
+
+/**
+ * Checks the device id and leaves the sensor powered down until the first tsl2591_als_start
+ */
+esp_err_t
+tsl2591_als_new(const struct tsl2591_als_config_t *als_cfg, tsl2591_als_handle *out_als);
+esp_err_t
+tsl2591_als_del(tsl2591_als_handle als);
+
+/**
+ * Powers the sensor up on the current gain and integration time and returns right away. out_wait_ms is how long the
+ * conversion takes with margin for the oscillator, the bus stays free for other devices meanwhile.
+ */
+esp_err_t
+tsl2591_als_start(tsl2591_als_handle als, uint32_t *out_wait_ms);
+
+/**
+ * ESP_ERR_NOT_FINISHED while the ALS valid bit is not set yet. Otherwise reads both channels, powers the sensor down and
+ * with auto_range picks the gain and integration time of the next conversion from the headroom of this one.
+ */
+esp_err_t
+tsl2591_als_read(tsl2591_als_handle als, tsl2591_als_reading_t *out_reading);
+
+/**
+ * Keeps the sensor converting on the current range and asserts its interrupt pin once persist conversions in a row
+ * leave the window, the reading's visible count scaled to the range +- window as a share of it. The pin stays low until
+ * the next tsl2591_als_read, which ends the armed conversions like a one-shot one and clears it.
+ */
+esp_err_t
+tsl2591_als_arm(tsl2591_als_handle als, const tsl2591_als_reading_t *reading, float window, tsl2591_als_persist_t persist);
+
+/**
+ * Setting the next conversion starts with, auto ranging carries on from it
+ */
+esp_err_t
+tsl2591_als_set_range(tsl2591_als_handle als, tsl2591_als_gain_t gain, tsl2591_als_atime_t atime);
+esp_err_t
+tsl2591_als_get_range(tsl2591_als_handle als, tsl2591_als_gain_t *out_gain, tsl2591_als_atime_t *out_atime);
+
+/**
+ * Integration time in ms and gain factor, e.g. for logging a reading
+ */
+uint32_t
+tsl2591_als_atime_ms(tsl2591_als_atime_t atime);
+float
+tsl2591_als_gain_factor(tsl2591_als_gain_t gain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
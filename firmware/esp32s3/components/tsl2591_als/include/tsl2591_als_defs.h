@@ -0,0 +1,92 @@
+#pragma once
+#ifndef TSL2591_ALS_DEFS_H
+#define TSL2591_ALS_DEFS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  TSL2591_ALS_GAIN_1X,
+  TSL2591_ALS_GAIN_25X,
+  TSL2591_ALS_GAIN_428X,
+  TSL2591_ALS_GAIN_9876X,
+  TSL2591_ALS_GAIN_MAX,
+} tsl2591_als_gain_t;
+
+typedef enum {
+  TSL2591_ALS_ATIME_100MS,
+  TSL2591_ALS_ATIME_200MS,
+  TSL2591_ALS_ATIME_300MS,
+  TSL2591_ALS_ATIME_400MS,
+  TSL2591_ALS_ATIME_500MS,
+  TSL2591_ALS_ATIME_600MS,
+  TSL2591_ALS_ATIME_MAX,
+} tsl2591_als_atime_t;
+
+/**
+ * Consecutive out of window conversions before the threshold interrupt fires, register values of the persist filter
+ */
+typedef enum {
+  TSL2591_ALS_PERSIST_EVERY, // every conversion, in window or not
+  TSL2591_ALS_PERSIST_ANY,
+  TSL2591_ALS_PERSIST_2,
+  TSL2591_ALS_PERSIST_3,
+  TSL2591_ALS_PERSIST_5,
+  TSL2591_ALS_PERSIST_10,
+  TSL2591_ALS_PERSIST_15,
+  TSL2591_ALS_PERSIST_20,
+  TSL2591_ALS_PERSIST_25,
+  TSL2591_ALS_PERSIST_30,
+  TSL2591_ALS_PERSIST_35,
+  TSL2591_ALS_PERSIST_40,
+  TSL2591_ALS_PERSIST_45,
+  TSL2591_ALS_PERSIST_50,
+  TSL2591_ALS_PERSIST_55,
+  TSL2591_ALS_PERSIST_60,
+  TSL2591_ALS_PERSIST_MAX,
+} tsl2591_als_persist_t;
+
+/**
+ * Register access of the sensor, the transport is owned by the caller (Wire, i2c_master, ...). Reads start at reg and
+ * auto-increment, so both channels come in one transaction. Writes send data as is, the command byte first.
+ */
+typedef esp_err_t (*tsl2591_als_read_fn)(void *user_ctx, uint8_t address, uint8_t reg, uint8_t *data, size_t len);
+typedef esp_err_t (*tsl2591_als_write_fn)(void *user_ctx, uint8_t address, const uint8_t *data, size_t len);
+
+struct tsl2591_als_config_t {
+  uint8_t address;
+
+  tsl2591_als_read_fn read;
+  tsl2591_als_write_fn write;
+  void *user_ctx;
+
+  tsl2591_als_gain_t gain;   // first conversion, kept as is without auto_range
+  tsl2591_als_atime_t atime;
+
+  bool auto_range;
+  tsl2591_als_atime_t max_atime; // longest integration auto ranging may pick, bounds the time to a reading
+  float headroom;                // share of the full scale the next conversion aims its visible channel at, 0 for 0.5
+};
+
+typedef struct {
+  uint16_t full; // channel 0, visible and infrared
+  uint16_t ir;   // channel 1
+  tsl2591_als_gain_t gain;
+  tsl2591_als_atime_t atime;
+
+  bool saturated; // a channel hit its full scale, lux is not valid
+  float lux;
+} tsl2591_als_reading_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
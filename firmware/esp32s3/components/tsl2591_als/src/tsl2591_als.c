@@ -0,0 +1,280 @@
+#include <stdlib.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "private/tsl2591_als_private.h"
+#include "tsl2591_als.h"
+
+struct tsl2591_als {
+  struct tsl2591_als_config_t cfg;
+
+  tsl2591_als_gain_t gain;
+  tsl2591_als_atime_t atime;
+  int16_t control; // last value written to the control register, -1 before the first write
+
+  bool is_converting;
+  bool is_armed;
+};
+
+static const float gain_factors[TSL2591_ALS_GAIN_MAX] = {1.0f, 25.0f, 428.0f, 9876.0f};
+
+static const char *TAG = "tsl2591_als";
+
+static esp_err_t
+write_reg(tsl2591_als_handle als, uint8_t reg, uint8_t value);
+static esp_err_t
+write_control(tsl2591_als_handle als);
+static esp_err_t
+read_reg(tsl2591_als_handle als, uint8_t reg, uint8_t *data, size_t len);
+static uint16_t
+max_count(tsl2591_als_atime_t atime);
+static float
+sensitivity(tsl2591_als_gain_t gain, tsl2591_als_atime_t atime);
+static void
+pick_range(tsl2591_als_handle als, const tsl2591_als_reading_t *reading);
+
+esp_err_t
+tsl2591_als_new(const struct tsl2591_als_config_t *als_cfg, tsl2591_als_handle *out_als) {
+  esp_err_t ret = ESP_OK;
+  ESP_RETURN_ON_FALSE(als_cfg && out_als, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(als_cfg->read && als_cfg->write, ESP_ERR_INVALID_ARG, TAG, "no register access functions");
+  ESP_RETURN_ON_FALSE(als_cfg->gain < TSL2591_ALS_GAIN_MAX && als_cfg->atime < TSL2591_ALS_ATIME_MAX, ESP_ERR_INVALID_ARG,
+                      TAG, "invalid gain or integration time");
+  ESP_RETURN_ON_FALSE(!als_cfg->auto_range || als_cfg->max_atime < TSL2591_ALS_ATIME_MAX, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid longest integration time");
+  ESP_RETURN_ON_FALSE(als_cfg->headroom >= 0.0f && als_cfg->headroom < 1.0f, ESP_ERR_INVALID_ARG, TAG,
+                      "headroom out of range");
+
+  struct tsl2591_als *als = calloc(1, sizeof(struct tsl2591_als));
+  ESP_RETURN_ON_FALSE(als, ESP_ERR_NO_MEM, TAG, "failed to allocate tsl2591");
+
+  als->cfg = *als_cfg;
+  if (als->cfg.headroom == 0.0f) {
+    als->cfg.headroom = TSL2591_ALS_DEFAULT_HEADROOM;
+  }
+  als->gain = als_cfg->gain;
+  als->atime = als_cfg->atime;
+  als->control = -1;
+
+  uint8_t id = 0;
+  ESP_GOTO_ON_ERROR(read_reg(als, TSL2591_ALS_REG_ID, &id, 1U), err, TAG, "failed to read the device id");
+  ESP_GOTO_ON_FALSE(id == TSL2591_ALS_ID, ESP_ERR_NOT_FOUND, err, TAG, "unexpected device id 0x%02x", id);
+  ESP_GOTO_ON_ERROR(write_reg(als, TSL2591_ALS_REG_ENABLE, TSL2591_ALS_ENABLE_OFF), err, TAG, "failed to power down");
+
+  *out_als = als;
+  return ESP_OK;
+err:
+  free(als);
+  return ret;
+}
+esp_err_t
+tsl2591_als_del(tsl2591_als_handle als) {
+  ESP_RETURN_ON_FALSE(als, ESP_ERR_INVALID_ARG, TAG, "invalid tsl2591");
+
+  write_reg(als, TSL2591_ALS_REG_ENABLE, TSL2591_ALS_ENABLE_OFF);
+  free(als);
+  return ESP_OK;
+}
+
+esp_err_t
+tsl2591_als_start(tsl2591_als_handle als, uint32_t *out_wait_ms) {
+  ESP_RETURN_ON_FALSE(als && out_wait_ms, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  ESP_RETURN_ON_ERROR(write_control(als), TAG, "failed to set gain and integration time");
+  ESP_RETURN_ON_ERROR(write_reg(als, TSL2591_ALS_REG_ENABLE, TSL2591_ALS_ENABLE_PON | TSL2591_ALS_ENABLE_AEN), TAG,
+                      "failed to start a conversion");
+  als->is_converting = true;
+  als->is_armed = false;
+
+  uint32_t atime_ms = tsl2591_als_atime_ms(als->atime);
+  *out_wait_ms = atime_ms + atime_ms * TSL2591_ALS_WAIT_MARGIN_PCT / 100U;
+  return ESP_OK;
+}
+
+esp_err_t
+tsl2591_als_read(tsl2591_als_handle als, tsl2591_als_reading_t *out_reading) {
+  ESP_RETURN_ON_FALSE(als && out_reading, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(als->is_converting, ESP_ERR_INVALID_STATE, TAG, "no conversion started");
+
+  uint8_t status = 0;
+  ESP_RETURN_ON_ERROR(read_reg(als, TSL2591_ALS_REG_STATUS, &status, 1U), TAG, "failed to read the status");
+  if (!(status & TSL2591_ALS_STATUS_AVALID))
+    return ESP_ERR_NOT_FINISHED;
+
+  uint8_t data[4];
+  ESP_RETURN_ON_ERROR(read_reg(als, TSL2591_ALS_REG_C0DATAL, data, sizeof(data)), TAG, "failed to read the channels");
+  ESP_RETURN_ON_ERROR(write_reg(als, TSL2591_ALS_REG_ENABLE, TSL2591_ALS_ENABLE_OFF), TAG, "failed to power down");
+  if (als->is_armed) {
+    uint8_t clear = TSL2591_ALS_CMD_CLEAR;
+    ESP_RETURN_ON_ERROR(als->cfg.write(als->cfg.user_ctx, als->cfg.address, &clear, 1U), TAG,
+                        "failed to clear the interrupt");
+  }
+  als->is_converting = false;
+  als->is_armed = false;
+
+  tsl2591_als_reading_t reading = {
+      .full = (uint16_t)(data[0] | (data[1] << 8U)),
+      .ir = (uint16_t)(data[2] | (data[3] << 8U)),
+      .gain = als->gain,
+      .atime = als->atime,
+  };
+  uint16_t full_scale = max_count(reading.atime);
+  reading.saturated = reading.full >= full_scale || reading.ir >= full_scale;
+  if (!reading.saturated && reading.full > 0U) {
+    // Datasheet lux equation as the Adafruit library has it, counts per lux scale with gain and integration time
+    float full = (float)reading.full;
+    float ir = (float)reading.ir;
+    float cpl = sensitivity(reading.gain, reading.atime) / TSL2591_ALS_LUX_DF;
+    reading.lux = (full - ir) * (1.0f - ir / full) / cpl;
+  }
+
+  if (als->cfg.auto_range) {
+    pick_range(als, &reading);
+  }
+
+  *out_reading = reading;
+  return ESP_OK;
+}
+
+esp_err_t
+tsl2591_als_arm(tsl2591_als_handle als, const tsl2591_als_reading_t *reading, float window, tsl2591_als_persist_t persist) {
+  ESP_RETURN_ON_FALSE(als && reading, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+  ESP_RETURN_ON_FALSE(window > 0.0f && persist < TSL2591_ALS_PERSIST_MAX, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid window or persist filter");
+  ESP_RETURN_ON_FALSE(!reading->saturated, ESP_ERR_INVALID_STATE, TAG, "no window around a saturated reading");
+
+  // Auto ranging may have moved on from the reading's range, the thresholds are counts of the range armed
+  float full_scale = (float)max_count(als->atime);
+  float count = (float)reading->full * sensitivity(als->gain, als->atime) / sensitivity(reading->gain, reading->atime);
+  float delta = count * window > TSL2591_ALS_MIN_WINDOW_COUNT ? count * window : TSL2591_ALS_MIN_WINDOW_COUNT;
+  uint16_t low = count - delta > 0.0f ? (uint16_t)(count - delta) : 0U;
+  uint16_t high = count + delta < full_scale ? (uint16_t)(count + delta) : (uint16_t)full_scale;
+
+  uint8_t thresholds[] = {
+      TSL2591_ALS_CMD | TSL2591_ALS_REG_AILTL, (uint8_t)low, (uint8_t)(low >> 8U), (uint8_t)high, (uint8_t)(high >> 8U),
+  };
+  uint8_t clear = TSL2591_ALS_CMD_CLEAR;
+  ESP_RETURN_ON_ERROR(write_control(als), TAG, "failed to set gain and integration time");
+  ESP_RETURN_ON_ERROR(als->cfg.write(als->cfg.user_ctx, als->cfg.address, thresholds, sizeof(thresholds)), TAG,
+                      "failed to set the thresholds");
+  ESP_RETURN_ON_ERROR(write_reg(als, TSL2591_ALS_REG_PERSIST, (uint8_t)persist), TAG, "failed to set the persist filter");
+  ESP_RETURN_ON_ERROR(als->cfg.write(als->cfg.user_ctx, als->cfg.address, &clear, 1U), TAG,
+                      "failed to clear the interrupt");
+  ESP_RETURN_ON_ERROR(write_reg(als, TSL2591_ALS_REG_ENABLE,
+                                TSL2591_ALS_ENABLE_PON | TSL2591_ALS_ENABLE_AEN | TSL2591_ALS_ENABLE_AIEN),
+                      TAG, "failed to start armed conversions");
+  als->is_converting = true;
+  als->is_armed = true;
+
+  ESP_LOGD(TAG, "armed %u..%u counts at %.0fx %lu ms", low, high, gain_factors[als->gain], tsl2591_als_atime_ms(als->atime));
+  return ESP_OK;
+}
+
+esp_err_t
+tsl2591_als_set_range(tsl2591_als_handle als, tsl2591_als_gain_t gain, tsl2591_als_atime_t atime) {
+  ESP_RETURN_ON_FALSE(als, ESP_ERR_INVALID_ARG, TAG, "invalid tsl2591");
+  ESP_RETURN_ON_FALSE(gain < TSL2591_ALS_GAIN_MAX && atime < TSL2591_ALS_ATIME_MAX, ESP_ERR_INVALID_ARG, TAG,
+                      "invalid gain or integration time");
+
+  als->gain = gain;
+  als->atime = atime;
+  return ESP_OK;
+}
+esp_err_t
+tsl2591_als_get_range(tsl2591_als_handle als, tsl2591_als_gain_t *out_gain, tsl2591_als_atime_t *out_atime) {
+  ESP_RETURN_ON_FALSE(als && out_gain && out_atime, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+  *out_gain = als->gain;
+  *out_atime = als->atime;
+  return ESP_OK;
+}
+
+uint32_t
+tsl2591_als_atime_ms(tsl2591_als_atime_t atime) {
+  return 100U * ((uint32_t)atime + 1U);
+}
+float
+tsl2591_als_gain_factor(tsl2591_als_gain_t gain) {
+  return gain < TSL2591_ALS_GAIN_MAX ? gain_factors[gain] : 0.0f;
+}
+
+static esp_err_t
+write_reg(tsl2591_als_handle als, uint8_t reg, uint8_t value) {
+  uint8_t data[] = {TSL2591_ALS_CMD | reg, value};
+  return als->cfg.write(als->cfg.user_ctx, als->cfg.address, data, sizeof(data));
+}
+/**
+ * Gain and integration time, only written when they changed since the last conversion
+ */
+static esp_err_t
+write_control(tsl2591_als_handle als) {
+  uint8_t control = (uint8_t)((als->gain << 4U) | als->atime);
+  if (als->control == control)
+    return ESP_OK;
+
+  ESP_RETURN_ON_ERROR(write_reg(als, TSL2591_ALS_REG_CONTROL, control), TAG, "failed to write control");
+  als->control = control;
+  return ESP_OK;
+}
+static esp_err_t
+read_reg(tsl2591_als_handle als, uint8_t reg, uint8_t *data, size_t len) {
+  return als->cfg.read(als->cfg.user_ctx, als->cfg.address, TSL2591_ALS_CMD | reg, data, len);
+}
+
+static uint16_t
+max_count(tsl2591_als_atime_t atime) {
+  return atime == TSL2591_ALS_ATIME_100MS ? TSL2591_ALS_MAX_COUNT_100MS : TSL2591_ALS_MAX_COUNT;
+}
+
+/**
+ * Counts per unit of light, gain times integration time in ms
+ */
+static float
+sensitivity(tsl2591_als_gain_t gain, tsl2591_als_atime_t atime) {
+  return gain_factors[gain] * (float)tsl2591_als_atime_ms(atime);
+}
+
+/**
+ * The most sensitive setting whose expected visible count stays within the headroom. A saturated reading says nothing
+ * about how far over it went, so it only steps one gain down, or to the shortest integration at the lowest gain.
+ */
+static void
+pick_range(tsl2591_als_handle als, const tsl2591_als_reading_t *reading) {
+  if (reading->saturated) {
+    if (reading->gain > TSL2591_ALS_GAIN_1X) {
+      als->gain = (tsl2591_als_gain_t)(reading->gain - 1);
+    } else {
+      als->atime = TSL2591_ALS_ATIME_100MS;
+    }
+    if (als->atime > als->cfg.max_atime) {
+      als->atime = als->cfg.max_atime;
+    }
+    return;
+  }
+
+  float rate = (float)reading->full / sensitivity(reading->gain, reading->atime);
+  tsl2591_als_gain_t best_gain = TSL2591_ALS_GAIN_1X;
+  tsl2591_als_atime_t best_atime = TSL2591_ALS_ATIME_100MS;
+  float best_sensitivity = 0.0f;
+  for (uint8_t gain = 0; gain < TSL2591_ALS_GAIN_MAX; ++gain) {
+    for (uint8_t atime = 0; atime <= als->cfg.max_atime; ++atime) {
+      float candidate = sensitivity((tsl2591_als_gain_t)gain, (tsl2591_als_atime_t)atime);
+      if (rate * candidate > als->cfg.headroom * (float)max_count((tsl2591_als_atime_t)atime))
+        continue;
+      if (candidate > best_sensitivity) {
+        best_gain = (tsl2591_als_gain_t)gain;
+        best_atime = (tsl2591_als_atime_t)atime;
+        best_sensitivity = candidate;
+      }
+    }
+  }
+
+  if (best_gain != als->gain || best_atime != als->atime) {
+    ESP_LOGD(TAG, "range %.0fx %lu ms -> %.0fx %lu ms at %u counts", gain_factors[als->gain],
+             tsl2591_als_atime_ms(als->atime), gain_factors[best_gain], tsl2591_als_atime_ms(best_atime), reading->full);
+  }
+  als->gain = best_gain;
+  als->atime = best_atime;
+}
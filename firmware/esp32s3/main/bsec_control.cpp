@@ -0,0 +1,40 @@
+#include "BSEC3.h"
+
+#include "bsec_control.h"
+
+static int64_t next_call_ns;
+static uint32_t heater_on_ms;
+
+extern "C" {
+bsec_library_return_t
+__real_bsec_sensor_control(void *inst, const int64_t time_stamp, bsec_bme_settings_t *sensor_settings);
+
+bsec_library_return_t
+__wrap_bsec_sensor_control(void *inst, const int64_t time_stamp, bsec_bme_settings_t *sensor_settings) {
+  bsec_library_return_t ret = __real_bsec_sensor_control(inst, time_stamp, sensor_settings);
+  // Whatever came of the call, the wrapper goes by these settings until the next one
+  next_call_ns = sensor_settings->next_call;
+
+  // Forced and sequential steps are in milliseconds. Parallel steps count a shared duration, none of the profiles uses it.
+  heater_on_ms = 0;
+  if (ret >= BSEC_OK && sensor_settings->trigger_measurement && sensor_settings->run_gas) {
+    if (sensor_settings->heater_profile_len == 0) {
+      heater_on_ms = sensor_settings->heater_duration;
+    }
+    for (uint8_t i = 0; i < sensor_settings->heater_profile_len; ++i) {
+      heater_on_ms += sensor_settings->heater_duration_profile[i];
+    }
+  }
+  return ret;
+}
+}
+
+uint64_t
+bsec_control_next_call_us(void) {
+  return next_call_ns > 0 ? (uint64_t)(next_call_ns / 1000LL) : 0ULL;
+}
+
+uint32_t
+bsec_control_heater_on_ms(void) {
+  return heater_on_ms;
+}
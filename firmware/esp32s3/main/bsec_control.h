@@ -0,0 +1,25 @@
+#pragma once
+#ifndef BSEC_CONTROL_H
+#define BSEC_CONTROL_H
+
+#include <stdint.h>
+
+/**
+ * BSEC3 keeps the bsec_bme_settings_t of its sensor control calls to itself. The link wraps bsec_sensor_control, see
+ * main/CMakeLists.txt, and these read the settings of the latest call on the wrapper's clock, esp_timer based like
+ * esp_timer_get_time. Only the task that runs the wrapper may call them.
+ */
+
+/**
+ * BSEC's next_call, 0 before the first call
+ */
+uint64_t
+bsec_control_next_call_us(void);
+
+/**
+ * Heater time of the measurement the latest call triggered, 0 for one without gas
+ */
+uint32_t
+bsec_control_heater_on_ms(void);
+
+#endif
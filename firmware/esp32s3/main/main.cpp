@@ -6,6 +6,9 @@
 
 #include "soc/gpio_num.h"
 
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+
 #include "bootloader_random.h"
 #include "esp_check.h"
 #include "esp_heap_caps.h"
@@ -24,27 +27,38 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 
-#include "Adafruit_TSL2591.h"
-
+#include "BME69xI2cBus.h"
+#include "BME69xSensor.h"
 #include "BSEC3.h"
-#include "bme69xLibrary.h"
 #include "bsecConfig/bsec_iaq.h"
-
-#include "Adafruit_BMP085.h"
+#include "bme69xLibrary.h"
 
 #include "DHT.h"
 
 #include "adafruit_renderer.h"
+
+#include "bmp180_temp.h"
 #include "grid_composer.h"
+#include "i2c_arbiter.h"
+#include "mono_canvas.h"
+#include "pca9548a_mux.h"
+#include "sh1106_renderer.h"
 
 #include "cbor_sensor_encoder.h"
 
 #include "adc_module.h"
+#include "adc_trace.h"
 #include "mqtt_module.h"
 #include "sntp_module.h"
+#include "sound_meter.h"
+#include "state_store.h"
+#include "stream_stats.h"
+#include "temp_fusion.h"
+#include "tsl2591_als.h"
 #include "wifi_module.h"
 
 #include "app_errors.h"
+#include "bsec_control.h"
 
 #define SENSOR_ID "clock1"
 
@@ -56,25 +70,82 @@
 #define I2C_SDA_BUS1  GPIO_NUM_4
 #define I2C_FREQ_BUS1 400000U
 
+/* Bus each device is wired to, a display flush is kilobytes that would otherwise queue up the sensors behind it */
+#define I2C_BUS_BME690  0U
+#define I2C_BUS_BMP180  0U
+#define I2C_BUS_TSL2591 0U
+#define I2C_BUS_DISPLAY 1U /* the PCA9548A and the SH1106 panels behind it */
+#define I2C_BUS_COUNT   2U
+#define I2C_WIRE(bus)   ((bus) == 0U ? &Wire : &Wire1)
+
+#define I2C_PRIO_DISPLAY 0U /* flushes give the bus up between chunks to anything above */
+#define I2C_PRIO_SENSOR  1U /* TSL2591 and the BMP180 reference */
+#define I2C_PRIO_BSEC    3U /* BME690, a late BSEC call costs a measurement */
+#define I2C_WAIT_MS      200U
+
 #define ADC_SOUND_SENSOR_DATA_PIN            GPIO_NUM_6
 #define ADC_SOUND_SENSOR_DATA_BITWIDTH       12U
 #define ADC_SOUND_SENSOR_PERFORM_CALIBRATION 1U
 #define ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ     2000U
-#define ADC_SOUND_SENSOR_READ_SAMPLES        25U
+#define ADC_SOUND_SENSOR_OVERSAMPLING        16U /* 32 kHz conversions, about 2 more effective bits for quiet rooms */
+#define ADC_SOUND_SENSOR_OVERSAMPLING_BENCH  0U /* logs the decimation cost per output sample at boot */
+#define ADC_SOUND_SENSOR_STREAM_BLOCKS       2U
+#define ADC_SOUND_SENSOR_BLOCK_TIMEOUT_MS    1000U
 #define ADC_SOUND_SENSOR_DC_OFFSET_MV        1650U
-#define ADC_SOUND_SENSOR_TASK_PERIOD_MS      100U
 #define ADC_SOUND_SENSOR_MINMAX_PERIOD_MS    3600U * 1000U * 1U
+#define ADC_SOUND_SENSOR_MINMAX_SCALE        100.0f /* RMS kept in 0.01 mV, 1650 mV full scale fits stream_stats */
 #define ADC_SOUND_SENSOR_CALC_PERIOD_MS      4000U
 #define ADC_SOUND_SENSOR_REPORT_PERIOD_MS    4000U
+#define ADC_SOUND_SENSOR_MIN_COVERAGE        0.99f
+#define ADC_SOUND_SENSOR_MV_PER_PA           158.0f /* MAX4466 at 25x behind a -44 dBV/Pa electret, calibrate against a meter */
+#define ADC_SOUND_SENSOR_LEVEL_INTERVAL_MS   100U
+#define ADC_SOUND_SENSOR_FFT_SIZE            512U /* 3.9 Hz bins at 2 kHz, the 31.5 Hz octave spans almost six */
+#define ADC_SOUND_SENSOR_BANDS_PER_OCTAVE    1U
+#define ADC_SOUND_SENSOR_FFT_BENCHMARK       0U /* logs the cost per FFT size at boot, keeps 16 kB of FFT tables */
+#define ADC_SOUND_SENSOR_FFT_BENCH_FRAMES    64U
+#define ADC_SOUND_SENSOR_TRACE               0U /* streams the calibrated samples to MQTT_TRACE_TOPIC, about 4 kB/s */
 
 #define TSL2591_TASK_PERIOD_MS   2800U
 #define TSL2591_MINMAX_PERIOD_MS 3600U * 1000U * 1U
+#define TSL2591_MINMAX_SCALE     10.0f /* kept in deci-lux, the sensor tops out at 88000 lux */
 #define TSL2591_REPORT_PERIOD_MS 2800U
 #define TSL2591_I2C_ADDRESS      0x29U
-
-#define AIR_QUALITY_TASK_PERIOD_MS   (uint32_t)(1000.0f / (BSEC_SAMPLE_RATE_LP * 2.0f))
+#define TSL2591_MAX_ATIME        TSL2591_ALS_ATIME_400MS /* longest integration auto ranging may pick */
+#define TSL2591_HEADROOM         0.5f
+#define TSL2591_POLL_MS          10U
+#define TSL2591_POLL_LIMIT       20U /* polls after the expected end of a conversion before it is abandoned */
+#define TSL2591_EVENT_DRIVEN     1U /* reports when the light leaves a window around the last reading, INT wired */
+#define TSL2591_INT_PIN          GPIO_NUM_5
+#define TSL2591_EVENT_WINDOW     0.2f /* share of the visible count either way, a lamp or a passing cloud leaves it */
+#define TSL2591_EVENT_PERSIST    TSL2591_ALS_PERSIST_2
+#define TSL2591_HEARTBEAT_MS     60000U /* report period while the light stays in the window */
+
+#define AIR_QUALITY_CALL_PERIOD_MS   (uint32_t)(1000.0f / BSEC_SAMPLE_RATE_LP + 0.5f) /* spacing of BSEC's next_call */
+#define AIR_QUALITY_CALL_MARGIN_MS   2U /* past the deadline, so the wrapper's own clock agrees the call is due */
+#define AIR_QUALITY_RETRY_MS         5U /* doubles per early wakeup up to AIR_QUALITY_LATE_MS, never past BSEC's deadline */
+#define AIR_QUALITY_LATE_MS          100U /* a call this far past its deadline counts as late */
+#define AIR_QUALITY_TIMING_REPORT_MS 600000U
 #define AIR_QUALITY_REPORT_PERIOD_MS (uint32_t)(1000.0f / (BSEC_SAMPLE_RATE_LP * 2.0f))
 #define BME690_I2C_ADDRESS           0x76U
+#define BMP180_I2C_ADDRESS           0x77U /* fixed in the chip */
+#define BME690_NATIVE_DRIVER         1U /* BME69xSensor as an i2c_master device, 0: the Arduino BME69x library */
+
+#define BMP180_TASK_PERIOD_MS 30000U /* reference of the temperature fusion */
+
+#define TEMP_FUSION_BME690_NOISE       0.05f
+#define TEMP_FUSION_BMP180_NOISE       0.15f /* 0.1 C steps */
+#define TEMP_FUSION_TEMP_DRIFT_H       1.0f
+#define TEMP_FUSION_HEATING_DRIFT_H    0.2f /* the Wi-Fi and the displays move the board's heat */
+#define TEMP_FUSION_INITIAL_HEATING    0.0f /* BSEC's heat compensation already takes the expected part off */
+#define TEMP_FUSION_INITIAL_HEATING_SD 2.0f
+
+#define BSEC_STATE_PERSIST         1U /* restores the calibration at boot, IAQ accuracy comes back in seconds, not hours */
+#define BSEC_STATE_NVS_NAMESPACE   "bsec"
+#define BSEC_STATE_NVS_KEY         "state"
+#define BSEC_STATE_VERSION         1U /* bump with the BSEC library or config, states saved before are then ignored */
+#define BSEC_STATE_MIN_ACCURACY    3U /* only a calibrated state is worth keeping over the saved one */
+#define BSEC_STATE_SAVE_PERIOD_MS  (6U * 3600U * 1000U) /* after the first save of a boot, as in the Bosch examples */
+#define BSEC_STATE_MIN_INTERVAL_MS (3600U * 1000U) /* bounds the flash wear, whatever asks for a save */
 
 #define SH1106_1_IDX          0U
 #define SH1106_2_IDX          1U
@@ -84,6 +155,14 @@
 #define SH1106_SCREEN_HEIGHT  64U
 #define SH1106_OLED_RESET     -1
 #define SH1106_SCREEN_ADDRESS 0x3CU
+#define SH1106_MUX_ADDRESS    0x70U
+
+#define DISPLAY_GLYPH_ARENA_SIZE 8192U
+#define DISPLAY_CLOCK_GLYPHS     "0123456789:"
+
+/* 1: flush the panels from a task of their own through esp_lcd, on the i2c_master bus under the Wire of I2C_BUS_DISPLAY,
+ * 0: Adafruit over that Wire, blocking the draw task for every transfer */
+#define DISPLAY_USE_ESP_LCD_RENDERER 1U
 
 #define SNTP_SERVER_1         "sth1.ntp.se"
 #define SNTP_SYNC_WAIT_MS     40000U
@@ -99,19 +178,73 @@
 #define MQTT_USERNAME         "esp32_1"
 #define MQTT_PASSWORD         "Test12345"
 #define MQTT_DATA_OUT_TOPIC   "/IoT-Clock-RoomMonitor/DEVICE_OUT/DATA"
+#define MQTT_CTRL_IN_TOPIC    "/IoT-Clock-RoomMonitor/DEVICE_IN/CTRL"
 #define MQTT_BUFFER_COUNT     3U
 #define MQTT_MAX_MESSAGE_SIZE 2048U
+#define MQTT_TRACE_TOPIC        "/IoT-Clock-RoomMonitor/DEVICE_OUT/ADC_TRACE"
+#define MQTT_TRACE_BUFFER_COUNT 4U
 
-#define DATA_AGGREGATION_MAX_PAYLOADS       15U
-#define DATA_AGGREGATION_CBOR_OVERHEAD_COEF 1.2f /* Assuming 20% overhead */
+#define DATA_AGGREGATION_MAX_PAYLOADS 15U
+/* Heads and breaks of the outer map, the "data" map and the sensor array, keys, and SENSOR_ID below 24 characters */
+#define DATA_AGGREGATION_CBOR_HEAD_SIZE                                                                                          \
+  (5U + sizeof("data") + sizeof("deviceId") + sizeof(SENSOR_ID) + sizeof("sensor_data"))
+#define DATA_AGGREGATION_MAX_MESSAGE_SIZE                                                                                        \
+  (DATA_AGGREGATION_CBOR_HEAD_SIZE + DATA_AGGREGATION_MAX_PAYLOADS * SENSOR_PAYLOAD_CBOR_MAX_SIZE)
 
 #define TASK_QUEUE_SEND_TIMEOUT_MS 1000U
 
 typedef struct {
-  uint8_t buffer[(uint32_t)(MQTT_MAX_MESSAGE_SIZE * DATA_AGGREGATION_CBOR_OVERHEAD_COEF)];
+  uint8_t buffer[DATA_AGGREGATION_MAX_MESSAGE_SIZE]; // fits DATA_AGGREGATION_MAX_PAYLOADS of the largest payload
   uint32_t length;
 } mqtt_message;
 
+typedef struct {
+  const char *name;
+  gpio_num_t sda;
+  gpio_num_t scl;
+  uint32_t freq_hz;
+} i2c_bus_layout;
+
+typedef struct {
+  const char *name;
+  uint8_t address;
+  uint8_t bus;
+} i2c_device_layout;
+
+typedef struct {
+  float temp;
+  uint64_t timestamp_us;
+} bmp180_sample;
+
+/**
+ * user_ctx of i2c_client_read_reg and i2c_client_write, a device of its own on the i2c_master bus whatever runs the
+ * rest of it. Each transaction waits its turn on the bus at the priority.
+ */
+typedef struct {
+  i2c_master_dev_handle_t dev;
+  i2c_arbiter_handle arbiter;
+  uint8_t priority;
+} i2c_client;
+
+#if ADC_SOUND_SENSOR_TRACE
+typedef struct {
+  uint8_t buffer[MQTT_MAX_MESSAGE_SIZE];
+  uint32_t length;
+} trace_message;
+#endif
+
+/**
+ * Min and max over the last one to two periods, the finished period is kept so a fresh one never reports a
+ * single value
+ */
+typedef struct {
+  stream_stats_t previous;
+  stream_stats_t current;
+  uint64_t period_start_us;
+  uint64_t period_us;
+  float scale; // values are stored as integers in 1 / scale units
+} minmax_window;
+
 extern const uint8_t client_crt_start[] asm("_binary_client_crt_start");
 extern const uint8_t client_crt_end[] asm("_binary_client_crt_end");
 extern const uint8_t client_key_start[] asm("_binary_client_key_start");
@@ -119,19 +252,51 @@ extern const uint8_t client_key_end[] asm("_binary_client_key_end");
 extern const uint8_t root_cert_pem_start[] asm("_binary_rootCA_pem_start");
 extern const uint8_t root_cert_pem_end[] asm("_binary_rootCA_pem_end");
 
-Adafruit_BMP085 bmp180;
-
+const i2c_bus_layout i2c_buses[I2C_BUS_COUNT] = {
+    {"i2c_bus0", I2C_SDA_BUS0, I2C_SCL_BUS0, I2C_FREQ_BUS0},
+    {"i2c_bus1", I2C_SDA_BUS1, I2C_SCL_BUS1, I2C_FREQ_BUS1},
+};
+// Checked at boot, the panels are behind the mux and answer only on its channel
+const i2c_device_layout i2c_devices[] = {
+    {"BME690", BME690_I2C_ADDRESS, I2C_BUS_BME690},
+    {"BMP180", BMP180_I2C_ADDRESS, I2C_BUS_BMP180},
+    {"TSL2591", TSL2591_I2C_ADDRESS, I2C_BUS_TSL2591},
+    {"PCA9548A", SH1106_MUX_ADDRESS, I2C_BUS_DISPLAY},
+};
+i2c_arbiter_handle i2c_arbiters[I2C_BUS_COUNT]; // one per bus, the two buses run side by side
+i2c_master_bus_handle_t i2c_master_buses[I2C_BUS_COUNT]; // the one under Wire where the Arduino core runs it
+
+bmp180_temp_handle bmp180;
+i2c_client bmp180_client;
+QueueHandle_t bmp180_queue; // the newest reading, taken by the air quality task
+
+#if BME690_NATIVE_DRIVER
+BME69xI2cBus bme690_bus;
+BME69xSensor bme690(bme690_bus);
+#else
 BME69x bme690;
+#endif
 BSEC3 bme690_bsec;
+uint8_t bsec_state_buffer[BSEC_MAX_STATE_BLOB_SIZE]; // init_bsec, then only the air quality task
+#if BSEC_STATE_PERSIST
+state_store_handle bsec_state_store;
+#endif
 
-Adafruit_TSL2591 tsl2591;
+tsl2591_als_handle tsl2591;
+i2c_client tsl2591_client;
 
 adc_dev_handle adc_sound_sens;
-
-Adafruit_SH1106G sh1106_1 = Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, &Wire, SH1106_OLED_RESET);
-Adafruit_SH1106G sh1106_2 = Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, &Wire, SH1106_OLED_RESET);
-Adafruit_SH1106G sh1106_3 = Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, &Wire, SH1106_OLED_RESET);
-Adafruit_SH1106G sh1106_4 = Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, &Wire, SH1106_OLED_RESET);
+sound_meter_handle sound_meter;
+
+#if !DISPLAY_USE_ESP_LCD_RENDERER
+Adafruit_SH1106G sh1106_1 =
+    Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, I2C_WIRE(I2C_BUS_DISPLAY), SH1106_OLED_RESET);
+Adafruit_SH1106G sh1106_2 =
+    Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, I2C_WIRE(I2C_BUS_DISPLAY), SH1106_OLED_RESET);
+Adafruit_SH1106G sh1106_3 =
+    Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, I2C_WIRE(I2C_BUS_DISPLAY), SH1106_OLED_RESET);
+Adafruit_SH1106G sh1106_4 =
+    Adafruit_SH1106G(SH1106_SCREEN_WIDTH, SH1106_SCREEN_HEIGHT, I2C_WIRE(I2C_BUS_DISPLAY), SH1106_OLED_RESET);
 
 U8G2_FOR_ADAFRUIT_GFX u8g2_1;
 U8G2_FOR_ADAFRUIT_GFX u8g2_2;
@@ -143,15 +308,35 @@ adafruit_renderer_ctx ad_ctx_1;
 adafruit_renderer_ctx ad_ctx_2;
 adafruit_renderer_ctx ad_ctx_3;
 adafruit_renderer_ctx ad_ctx_4;
+mono_glyph_cache *display_glyph_cache;
+#endif
+
+#if DISPLAY_USE_ESP_LCD_RENDERER
+sh1106_renderer_bus_handle sh1106_bus;
+sh1106_renderer_handle sh1106_renderers[4];
+#endif
+pca9548a_mux_handle display_mux;
 
 grid_composer_handle grid_composer;
 
+grid_composer_widget_handle air_temp_widget;
+grid_composer_widget_handle air_humid_widget;
+grid_composer_widget_handle air_iaq_widget;
+grid_composer_widget_handle lux_widget;
+grid_composer_widget_handle lux_min_widget;
+grid_composer_widget_handle lux_max_widget;
+grid_composer_widget_handle sound_laeq_widget;
+grid_composer_widget_handle sound_la90_widget;
+grid_composer_widget_handle sound_lafmax_widget;
+grid_composer_widget_handle clock_widget;
+
 mqtt_module_handle mqtt_module;
 
 uint64_t boot_to_utc_offset_us;
 
 TaskHandle_t task_sound_sampling_handle;
 TaskHandle_t task_air_quality_sampling_handle;
+TaskHandle_t task_bmp180_sampling_handle;
 TaskHandle_t task_tsl2591_sampling_handle;
 TaskHandle_t task_sntp_sampling_handle;
 
@@ -166,10 +351,25 @@ QueueHandle_t mqtt_filled_queue;
 
 mqtt_message mqtt_buffers[MQTT_BUFFER_COUNT];
 
+#if ADC_SOUND_SENSOR_TRACE
+TaskHandle_t task_trace_sending_handle;
+
+QueueHandle_t trace_free_queue;
+QueueHandle_t trace_filled_queue;
+
+trace_message trace_buffers[MQTT_TRACE_BUFFER_COUNT];
+trace_message *trace_current; // being filled by the sound task
+uint32_t trace_frames_missed; // blocks that found no free buffer, reported with the next record
+#endif
+
 static const char *TAG = "clock_room_monitor_app";
 
 esp_err_t
 init_i2c();
+void
+check_i2c_devices();
+esp_err_t
+i2c_client_open(i2c_client *client, uint8_t bus, uint8_t address, uint8_t priority);
 
 esp_err_t
 init_bme690();
@@ -185,6 +385,8 @@ esp_err_t
 init_sh1106_n();
 esp_err_t
 init_grid();
+esp_err_t
+init_widgets();
 
 esp_err_t
 init_wifi();
@@ -198,7 +400,13 @@ task_sound_sampling(void *arg);
 void
 task_air_quality_sampling(void *arg);
 void
+task_bmp180_sampling(void *arg);
+void
 task_tsl2591_sampling(void *arg);
+#if TSL2591_EVENT_DRIVEN
+void IRAM_ATTR
+on_tsl2591_interrupt(void *arg);
+#endif
 void
 task_sntp_sampling(void *arg);
 
@@ -207,11 +415,37 @@ task_sensor_data_aggregation(void *arg);
 
 void
 task_mqtt_sending(void *arg);
+#if ADC_SOUND_SENSOR_TRACE
+void
+task_trace_sending(void *arg);
+void
+trace_capture(const adc_module_block_t *block, uint64_t timestamp_us);
+#endif
 esp_err_t
 mqtt_data_event_handler(mqtt_module_handle mqtt_module, int32_t event_id, esp_mqtt_event_handle_t event_handle);
+void
+on_grid_frame_done(grid_composer_handle composer, const grid_composer_frame_stats *stats, void *user_ctx);
+
+esp_err_t
+i2c_client_read_reg(void *user_ctx, uint8_t address, uint8_t reg, uint8_t *data, size_t len);
+esp_err_t
+i2c_client_write(void *user_ctx, uint8_t address, const uint8_t *data, size_t len);
+
+void
+send_i2c_bus_stats(sensor_payload_t *payload, const char *name, i2c_arbiter_handle arbiter, uint64_t timestamp_us);
+void
+send_boot_report(uint64_t main_us, uint64_t drivers_us);
+
+void
+minmax_window_init(minmax_window *window, uint64_t period_us, float scale, uint64_t now_us);
+void
+minmax_window_push(minmax_window *window, float value, uint64_t now_us);
+void
+minmax_window_get(const minmax_window *window, float *out_min, float *out_max);
 
 extern "C" void
 app_main() {
+  uint64_t main_us = (uint64_t)esp_timer_get_time();
   // initArduino();
   vTaskDelay(pdMS_TO_TICKS(1000));
 
@@ -233,6 +467,7 @@ app_main() {
   bootloader_random_disable();
 
   init_i2c();
+  check_i2c_devices();
 
   init_bme690();
   init_bsec();
@@ -245,6 +480,8 @@ app_main() {
 
   init_sh1106_n();
   init_grid();
+  init_widgets();
+  uint64_t drivers_us = (uint64_t)esp_timer_get_time();
 
   init_wifi();
 
@@ -276,16 +513,36 @@ app_main() {
   }
 
   xTaskCreatePinnedToCore(task_mqtt_sending, "mqtt tsk", 8196U, NULL, 9, &task_mqtt_sending_handle, 1U);
-  xTaskCreatePinnedToCore(task_sensor_data_aggregation, "aggr tsk", 6144U, NULL, 8, &task_sensor_data_aggregation_handle, 0U);
+#if ADC_SOUND_SENSOR_TRACE
+  trace_free_queue = xQueueCreate(MQTT_TRACE_BUFFER_COUNT, sizeof(trace_message *));
+  trace_filled_queue = xQueueCreate(MQTT_TRACE_BUFFER_COUNT, sizeof(trace_message *));
+  if (NULL == trace_free_queue || NULL == trace_filled_queue) {
+    ESP_LOGE(TAG, "Failed to initialize the trace queues");
+    return;
+  }
+  for (int i = 0; i < MQTT_TRACE_BUFFER_COUNT; ++i) {
+    trace_message *msg = &trace_buffers[i];
+    xQueueSend(trace_free_queue, &msg, 0);
+  }
+  // Below every sensor task, a trace that cannot keep up loses whole blocks and says so in frames_dropped
+  xTaskCreatePinnedToCore(task_trace_sending, "trace tsk", 4096U, NULL, 4, &task_trace_sending_handle, 1U);
+#endif
+  xTaskCreatePinnedToCore(task_sensor_data_aggregation, "aggr tsk", 8192U, NULL, 8, &task_sensor_data_aggregation_handle, 0U);
 
   xTaskCreatePinnedToCore(task_air_quality_sampling, "air_quality tsk", 3144U, NULL, 6, &task_air_quality_sampling_handle, 0U);
+  if (bmp180_queue) {
+    // Below the sensor tasks, the reference may wait, a BSEC call may not
+    xTaskCreatePinnedToCore(task_bmp180_sampling, "bmp180 tsk", 2048U, NULL, 5, &task_bmp180_sampling_handle, 0U);
+  }
   vTaskDelay(pdMS_TO_TICKS(10U * (task_jitter_random[0] & 0x00000001)));
   xTaskCreatePinnedToCore(task_tsl2591_sampling, "tsl2591 tsk", 3144U, NULL, 6, &task_tsl2591_sampling_handle, 0U);
   vTaskDelay(pdMS_TO_TICKS(10U * (task_jitter_random[1] & 0x00000001)));
-  xTaskCreatePinnedToCore(task_sound_sampling, "sound tsk", 3144U, NULL, 6, &task_sound_sampling_handle, 0U);
+  xTaskCreatePinnedToCore(task_sound_sampling, "sound tsk", 4096U, NULL, 6, &task_sound_sampling_handle, 0U);
   vTaskDelay(pdMS_TO_TICKS(10U * (task_jitter_random[2] & 0x00000001)));
   xTaskCreatePinnedToCore(task_sntp_sampling, "sntp tsk", 3144U, NULL, 6, &task_sntp_sampling_handle, 0U);
 
+  send_boot_report(main_us, drivers_us);
+
   for (;;) {
     char *task_buffer = (char *)pvPortMalloc(2048);
     if (task_buffer == NULL) {
@@ -306,17 +563,44 @@ esp_err_t
 init_i2c() {
   esp_err_t ret = ESP_OK;
 
-  Wire.end();
-
-  ESP_RETURN_ON_FALSE(Wire.begin(I2C_SDA_BUS0, I2C_SCL_BUS0, I2C_FREQ_BUS0), ESP_ERR_MAIN_APP_I2C_FAIL, TAG,
-                      "Failed to initialize I2C bus 0");
-
-  ESP_RETURN_ON_FALSE(Wire1.begin(I2C_SDA_BUS1, I2C_SCL_BUS1, I2C_FREQ_BUS1), ESP_ERR_MAIN_APP_I2C_FAIL, TAG,
-                      "Failed to initialize I2C bus 1");
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; ++bus) {
+    const i2c_bus_layout *layout = &i2c_buses[bus];
+    struct i2c_arbiter_config arbiter_cfg = {
+        .name = layout->name,
+    };
+    ESP_RETURN_ON_ERROR(i2c_arbiter_new(&arbiter_cfg, &i2c_arbiters[bus]), TAG, "Failed to create I2C bus %u arbiter", bus);
+
+    TwoWire *tw = I2C_WIRE(bus);
+    tw->end();
+    ESP_RETURN_ON_FALSE(tw->begin(layout->sda, layout->scl, layout->freq_hz), ESP_ERR_MAIN_APP_I2C_FAIL, TAG,
+                        "Failed to initialize I2C bus %u", bus);
+    // The Arduino core runs Wire on the i2c_master driver, native devices and esp_lcd join that bus as devices of their own
+    i2c_master_buses[bus] = (i2c_master_bus_handle_t)i2cBusHandle(bus);
+    ESP_RETURN_ON_FALSE(i2c_master_buses[bus], ESP_ERR_MAIN_APP_I2C_FAIL, TAG, "No i2c_master bus behind Wire %u", bus);
+  }
 
   ESP_LOGI(TAG, "Initialized I2C");
   return ret;
 }
+/**
+ * A device wired to another bus than the topology says fails its init with a bare NACK, this names the bus it is on.
+ * Before any task uses the buses, so without the arbiters.
+ */
+void
+check_i2c_devices() {
+  for (size_t i = 0; i < sizeof(i2c_devices) / sizeof(i2c_devices[0]); ++i) {
+    const i2c_device_layout *device = &i2c_devices[i];
+    if (i2c_master_probe(i2c_master_buses[device->bus], device->address, I2C_WAIT_MS) == ESP_OK)
+      continue;
+
+    uint8_t other_bus = device->bus == 0U ? 1U : 0U;
+    if (i2c_master_probe(i2c_master_buses[other_bus], device->address, I2C_WAIT_MS) == ESP_OK) {
+      ESP_LOGE(TAG, "%s answers on I2C bus %u, the topology puts it on bus %u", device->name, other_bus, device->bus);
+    } else {
+      ESP_LOGW(TAG, "%s not found at 0x%02x on either I2C bus", device->name, device->address);
+    }
+  }
+}
 
 esp_err_t
 init_bsec() {
@@ -331,6 +615,33 @@ init_bsec() {
   ESP_RETURN_ON_FALSE(bme690_bsec.setConfig(bsec_config_iaq), ESP_ERR_MAIN_APP_BME690_BSEC_FAIL, TAG,
                       "Failed to load BSEC config file, code: %i", bme690_bsec.status);
 
+#if BSEC_STATE_PERSIST
+  struct state_store_config_t state_cfg = {
+      .namespace_name = BSEC_STATE_NVS_NAMESPACE,
+      .key = BSEC_STATE_NVS_KEY,
+      .version = BSEC_STATE_VERSION,
+      .max_len = BSEC_MAX_STATE_BLOB_SIZE,
+      .min_interval_ms = BSEC_STATE_MIN_INTERVAL_MS,
+  };
+  // Persistence is optional, without the store BSEC starts from scratch on every boot as before
+  esp_err_t state_ret = state_store_new(&state_cfg, &bsec_state_store);
+  if (state_ret != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to open BSEC state store, running without it: %s", esp_err_to_name(state_ret));
+    bsec_state_store = NULL;
+  }
+
+  // A missing or refused state only costs the calibration, BSEC starts from scratch as before
+  size_t state_len = 0;
+  if (bsec_state_store &&
+      state_store_load(bsec_state_store, bsec_state_buffer, sizeof(bsec_state_buffer), &state_len) == ESP_OK) {
+    if (bme690_bsec.setState(bsec_state_buffer)) {
+      ESP_LOGI(TAG, "Restored BSEC state, %u bytes", state_len);
+    } else {
+      ESP_LOGW(TAG, "BSEC refused the saved state, code: %i", bme690_bsec.status);
+    }
+  }
+#endif
+
   bsecVirtualSensor bme690_bsec_sensor_outputs[] = {
       BSEC_OUTPUT_IAQ,
 
@@ -353,9 +664,19 @@ esp_err_t
 init_bme690() {
   esp_err_t ret = ESP_OK;
 
-  bme690.begin(BME690_I2C_ADDRESS, Wire);
+#if BME690_NATIVE_DRIVER
+  ESP_RETURN_ON_ERROR(bme690_bus.open(i2c_master_buses[I2C_BUS_BME690], BME690_I2C_ADDRESS, i2c_buses[I2C_BUS_BME690].freq_hz,
+                                      i2c_arbiters[I2C_BUS_BME690], I2C_PRIO_BSEC),
+                      TAG, "Failed to add BME690 to I2C bus %u", I2C_BUS_BME690);
+
+  BME6xxStatus status = bme690.begin();
+  ESP_RETURN_ON_FALSE(status == BME6xxStatus::OK, ESP_ERR_MAIN_APP_BME690_FAIL, TAG,
+                      "Failed to initialize BME690 sensor, code: %i", (int)status);
+#else
+  bme690.begin(BME690_I2C_ADDRESS, *I2C_WIRE(I2C_BUS_BME690));
   ESP_RETURN_ON_FALSE(bme690.status == BME69X_OK, ESP_ERR_MAIN_APP_BME690_FAIL, TAG,
                       "Failed to initialize BME690 sensor, code: %i", bme690.status);
+#endif
 
   ESP_LOGI(TAG, "Initialized BME690");
 
@@ -365,8 +686,20 @@ esp_err_t
 init_bmp180() {
   esp_err_t ret = ESP_OK;
 
-  ESP_RETURN_ON_FALSE(bmp180.begin(BMP085_ULTRAHIGHRES, &Wire), ESP_ERR_MAIN_APP_BMP180_FAIL, TAG,
+  ESP_RETURN_ON_ERROR(i2c_client_open(&bmp180_client, I2C_BUS_BMP180, BMP180_I2C_ADDRESS, I2C_PRIO_SENSOR), TAG,
+                      "Failed to add BMP180 to I2C bus %u", I2C_BUS_BMP180);
+  struct bmp180_temp_config_t temp_cfg = {
+      .address = BMP180_I2C_ADDRESS,
+      .read = i2c_client_read_reg,
+      .write = i2c_client_write,
+      .user_ctx = &bmp180_client,
+  };
+  ESP_RETURN_ON_FALSE(bmp180_temp_new(&temp_cfg, &bmp180) == ESP_OK, ESP_ERR_MAIN_APP_BMP180_FAIL, TAG,
                       "Failed to initialize BMP180 sensor");
+
+  // Without it the BMP180 task is not started and the fusion runs on the BME690 alone
+  bmp180_queue = xQueueCreate(1U, sizeof(bmp180_sample));
+  ESP_RETURN_ON_FALSE(bmp180_queue, ESP_ERR_NO_MEM, TAG, "Failed to create the BMP180 queue");
   ESP_LOGI(TAG, "Initialized BMP180");
 
   return ret;
@@ -382,9 +715,48 @@ init_adc_sound_sensor() {
   };
   adc_dev_cont_config_t adc_cont_cfg = {
       .sample_freq_hz = ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ,
+      .oversampling = ADC_SOUND_SENSOR_OVERSAMPLING,
   };
   ESP_RETURN_ON_ERROR(adc_module_init_dev_continuous(&adc_dev_cfg, &adc_cont_cfg, &adc_sound_sens), TAG,
                       "Failed to initialize an adc device");
+  uint8_t sample_frac_bits = 0U;
+  ESP_RETURN_ON_ERROR(adc_module_get_frac_bits(adc_sound_sens, &sample_frac_bits), TAG, "Failed to get the sample format");
+  adc_dev_stream_config_t adc_stream_cfg = {
+      .block_count = ADC_SOUND_SENSOR_STREAM_BLOCKS,
+  };
+  ESP_RETURN_ON_ERROR(adc_module_stream_init(adc_sound_sens, &adc_stream_cfg), TAG, "Failed to initialize an adc stream");
+
+  struct sound_meter_config_t sound_meter_cfg = {
+      .sample_rate_hz = ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ,
+      .dc_offset_mv = ADC_SOUND_SENSOR_DC_OFFSET_MV,
+      .sample_frac_bits = sample_frac_bits,
+      .mv_per_pa = ADC_SOUND_SENSOR_MV_PER_PA,
+      .level_interval_ms = ADC_SOUND_SENSOR_LEVEL_INTERVAL_MS,
+      .fft_size = ADC_SOUND_SENSOR_FFT_SIZE,
+      .bands_per_octave = ADC_SOUND_SENSOR_BANDS_PER_OCTAVE,
+  };
+  ESP_RETURN_ON_ERROR(sound_meter_new(&sound_meter_cfg, &sound_meter), TAG, "Failed to create a sound meter");
+
+#if ADC_SOUND_SENSOR_FFT_BENCHMARK
+  // Cost of the band analysis per FFT size, a 50 % overlap runs 2 * rate / size frames a second
+  for (uint16_t fft_size = 64U; fft_size <= 4096U; fft_size <<= 1U) {
+    uint32_t cycles = 0U;
+    if (sound_meter_benchmark_spectrum(fft_size, ADC_SOUND_SENSOR_FFT_BENCH_FRAMES, &cycles) == ESP_OK) {
+      float load = (float)cycles * 2.0f * ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ / fft_size / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e4f);
+      ESP_LOGI(TAG, "Sound FFT %u: %lu cycles/frame, %.3f%% of a core at %u Hz", fft_size, cycles, load,
+               ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ);
+    }
+  }
+#endif
+#if ADC_SOUND_SENSOR_OVERSAMPLING_BENCH
+  uint32_t decimation_cycles = 0U;
+  if (adc_module_benchmark_oversampling(ADC_SOUND_SENSOR_OVERSAMPLING, ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ,
+                                        &decimation_cycles) == ESP_OK) {
+    float load = (float)decimation_cycles * ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e4f);
+    ESP_LOGI(TAG, "Sound decimation %ux: %lu cycles/sample, %.3f%% of a core at %u Hz", ADC_SOUND_SENSOR_OVERSAMPLING,
+             decimation_cycles, load, ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ);
+  }
+#endif
   ESP_RETURN_ON_ERROR(adc_module_enable_dev(adc_sound_sens), TAG, "Failed to enable an adc device");
   ESP_LOGI(TAG, "Initialized an analogue sound sensor");
   return ret;
@@ -392,33 +764,105 @@ init_adc_sound_sensor() {
 esp_err_t
 init_tsl2591() {
   esp_err_t ret = ESP_OK;
-  ESP_RETURN_ON_FALSE(tsl2591.begin(&Wire, TSL2591_I2C_ADDRESS), ESP_ERR_MAIN_APP_TSL2591_FAIL, TAG,
+
+  ESP_RETURN_ON_ERROR(i2c_client_open(&tsl2591_client, I2C_BUS_TSL2591, TSL2591_I2C_ADDRESS, I2C_PRIO_SENSOR), TAG,
+                      "Failed to add TSL2591 to I2C bus %u", I2C_BUS_TSL2591);
+  struct tsl2591_als_config_t als_cfg = {
+      .address = TSL2591_I2C_ADDRESS,
+      .read = i2c_client_read_reg,
+      .write = i2c_client_write,
+      .user_ctx = &tsl2591_client,
+      .gain = TSL2591_ALS_GAIN_428X,
+      .atime = TSL2591_ALS_ATIME_400MS,
+      .auto_range = true,
+      .max_atime = TSL2591_MAX_ATIME,
+      .headroom = TSL2591_HEADROOM,
+  };
+  ESP_RETURN_ON_FALSE(tsl2591_als_new(&als_cfg, &tsl2591) == ESP_OK, ESP_ERR_MAIN_APP_TSL2591_FAIL, TAG,
                       "Failed to initialize TSL2591 sensor");
-  tsl2591.setGain(TSL2591_GAIN_HIGH);
-  tsl2591.setTiming(TSL2591_INTEGRATIONTIME_400MS);
+
+#if TSL2591_EVENT_DRIVEN
+  // INT is open drain and active low, it stays low until the task reads the sensor
+  gpio_config_t int_cfg = {
+      .pin_bit_mask = 1ULL << TSL2591_INT_PIN,
+      .mode = GPIO_MODE_INPUT,
+      .pull_up_en = GPIO_PULLUP_ENABLE,
+      .pull_down_en = GPIO_PULLDOWN_DISABLE,
+      .intr_type = GPIO_INTR_NEGEDGE,
+  };
+  ESP_RETURN_ON_ERROR(gpio_config(&int_cfg), TAG, "Failed to configure TSL2591 interrupt pin");
+  ret = gpio_install_isr_service(0);
+  ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "Failed to install GPIO ISR service");
+  ret = ESP_OK;
+  ESP_RETURN_ON_ERROR(gpio_isr_handler_add(TSL2591_INT_PIN, on_tsl2591_interrupt, NULL), TAG,
+                      "Failed to add TSL2591 interrupt handler");
+#endif
   ESP_LOGI(TAG, "Initialized TSL2591 sensor");
   return ret;
 }
+#if DISPLAY_USE_ESP_LCD_RENDERER
+esp_err_t
+init_sh1106_n() {
+  esp_err_t ret = ESP_OK;
+
+  sh1106_renderer_bus_config bus_cfg = {
+      .i2c_bus = i2c_master_buses[I2C_BUS_DISPLAY],
+      .scl_speed_hz = i2c_buses[I2C_BUS_DISPLAY].freq_hz,
+      .panel_address = SH1106_SCREEN_ADDRESS,
+      .mux_address = SH1106_MUX_ADDRESS,
+      .arbiter = i2c_arbiters[I2C_BUS_DISPLAY],
+      .arbiter_priority = I2C_PRIO_DISPLAY,
+  };
+  ESP_RETURN_ON_ERROR(sh1106_renderer_bus_new(&bus_cfg, &sh1106_bus), TAG, "Failed to initialize SH1106 bus");
+  ESP_RETURN_ON_ERROR(sh1106_renderer_bus_get_mux(sh1106_bus, &display_mux), TAG, "Failed to get display mux");
+
+  const uint8_t mux_channels[] = {SH1106_1_IDX, SH1106_2_IDX, SH1106_3_IDX, SH1106_4_IDX};
+  for (uint8_t i = 0; i < sizeof(mux_channels); ++i) {
+    sh1106_renderer_config renderer_cfg = {
+        .bus = sh1106_bus,
+        .mux_channel = mux_channels[i],
+        .width = SH1106_SCREEN_WIDTH,
+        .height = SH1106_SCREEN_HEIGHT,
+        .on_flush_done = NULL,
+        .user_ctx = NULL,
+    };
+    ESP_RETURN_ON_FALSE(sh1106_renderer_new(&renderer_cfg, &sh1106_renderers[i]) == ESP_OK, ESP_ERR_MAIN_APP_SH1106_DISPLAY_FAIL,
+                        TAG, "Failed to initialize SH1106 num %u", i + 1U);
+    ESP_LOGI(TAG, "Initialized SH1106 num %u", i + 1U);
+  }
+  ESP_RETURN_ON_ERROR(sh1106_renderer_bus_preload_glyphs(sh1106_bus, u8g2_font_logisoso22_tn, DISPLAY_CLOCK_GLYPHS), TAG,
+                      "Failed to preload clock glyphs");
+
+  return ret;
+}
+#else
 esp_err_t
 init_sh1106_n() {
   esp_err_t ret = ESP_OK;
 
-  adafruit_pca_select(&Wire, SH1106_1_IDX);
+  struct pca9548a_mux_config mux_cfg = {
+      .address = SH1106_MUX_ADDRESS,
+      .write = adafruit_pca_write,
+      .user_ctx = I2C_WIRE(I2C_BUS_DISPLAY),
+  };
+  ESP_RETURN_ON_ERROR(pca9548a_mux_new(&mux_cfg, &display_mux), TAG, "Failed to initialize display mux");
+
+  ESP_RETURN_ON_ERROR(pca9548a_mux_select(display_mux, SH1106_1_IDX), TAG, "Failed to select SH1106 num 1");
   ESP_RETURN_ON_FALSE(sh1106_1.begin(SH1106_SCREEN_ADDRESS, true), ESP_ERR_MAIN_APP_SH1106_DISPLAY_FAIL, TAG,
                       "Failed to initialize SH1106 num 1");
   ESP_LOGI(TAG, "Initialized SH1106 num 1");
 
-  adafruit_pca_select(&Wire, SH1106_2_IDX);
+  ESP_RETURN_ON_ERROR(pca9548a_mux_select(display_mux, SH1106_2_IDX), TAG, "Failed to select SH1106 num 2");
   ESP_RETURN_ON_FALSE(sh1106_2.begin(SH1106_SCREEN_ADDRESS, true), ESP_ERR_MAIN_APP_SH1106_DISPLAY_FAIL, TAG,
                       "Failed to initialize SH1106 num 2");
   ESP_LOGI(TAG, "Initialized SH1106 num 2");
 
-  adafruit_pca_select(&Wire, SH1106_3_IDX);
+  ESP_RETURN_ON_ERROR(pca9548a_mux_select(display_mux, SH1106_3_IDX), TAG, "Failed to select SH1106 num 3");
   ESP_RETURN_ON_FALSE(sh1106_3.begin(SH1106_SCREEN_ADDRESS, true), ESP_ERR_MAIN_APP_SH1106_DISPLAY_FAIL, TAG,
                       "Failed to initialize SH1106 num 3");
   ESP_LOGI(TAG, "Initialized SH1106 num 3");
 
-  adafruit_pca_select(&Wire, SH1106_4_IDX);
+  ESP_RETURN_ON_ERROR(pca9548a_mux_select(display_mux, SH1106_4_IDX), TAG, "Failed to select SH1106 num 4");
   ESP_RETURN_ON_FALSE(sh1106_4.begin(SH1106_SCREEN_ADDRESS, true), ESP_ERR_MAIN_APP_SH1106_DISPLAY_FAIL, TAG,
                       "Failed to initialize SH1106 num 4");
   ESP_LOGI(TAG, "Initialized SH1106 num 4");
@@ -437,15 +881,68 @@ init_sh1106_n() {
 
   return ret;
 }
+#endif
+#if DISPLAY_USE_ESP_LCD_RENDERER
+esp_err_t
+init_grid() {
+  esp_err_t ret = ESP_OK;
+
+  ESP_RETURN_ON_ERROR(grid_composer_init(&grid_composer), TAG, "Failed to initialize grid composer");
+  ESP_RETURN_ON_ERROR(grid_composer_set_frame_done_cb(grid_composer, on_grid_frame_done, NULL), TAG,
+                      "Failed to set grid frame callback");
+
+  for (uint8_t i = 0; i < sizeof(sh1106_renderers) / sizeof(sh1106_renderers[0]); ++i) {
+    grid_composer_renderer renderer = {
+        .user_ctx = sh1106_renderers[i],
+        .draw_text = sh1106_renderer_draw_text,
+        .draw_figure = sh1106_renderer_draw_figure,
+        .clear = sh1106_renderer_clear,
+    };
+    ESP_RETURN_ON_ERROR(grid_composer_add_cell(grid_composer, &renderer), TAG, "Failed to add a cell device %u", i + 1U);
+    sh1106_renderer_clear(sh1106_renderers[i]);
+  }
+
+  return ret;
+}
+#else
+esp_err_t
+init_glyph_cache() {
+  esp_err_t ret = ESP_OK;
+
+  // Only touched from the grid draw task, shared by all four panels
+  display_glyph_cache = (mono_glyph_cache *)heap_caps_calloc(1, sizeof(mono_glyph_cache), MALLOC_CAP_SPIRAM);
+  uint8_t *arena = (uint8_t *)heap_caps_malloc(DISPLAY_GLYPH_ARENA_SIZE, MALLOC_CAP_SPIRAM);
+  ESP_GOTO_ON_FALSE(display_glyph_cache && arena, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate glyph cache");
+  mono_glyph_cache_init(display_glyph_cache, arena, DISPLAY_GLYPH_ARENA_SIZE);
+
+  mono_font_info clock_font;
+  if (mono_font_load(&clock_font, u8g2_font_logisoso22_tn)) {
+    mono_glyph_cache_preload(display_glyph_cache, &clock_font, DISPLAY_CLOCK_GLYPHS);
+  }
+  return ESP_OK;
+err:
+  heap_caps_free(display_glyph_cache);
+  heap_caps_free(arena);
+  display_glyph_cache = NULL;
+  return ret;
+}
 esp_err_t
 init_grid() {
   esp_err_t ret = ESP_OK;
 
+  if (init_glyph_cache() != ESP_OK) {
+    ESP_LOGW(TAG, "Drawing text without the glyph cache");
+  }
+
   ad_ctx_1 = {
       .oled = &sh1106_1,
       .u8g2 = &u8g2_1,
-      .tw = &Wire,
+      .tw = I2C_WIRE(I2C_BUS_DISPLAY),
       .idx = SH1106_1_IDX,
+      .mux = display_mux,
+      .glyph_cache = display_glyph_cache,
+      .arbiter = i2c_arbiters[I2C_BUS_DISPLAY],
+      .arbiter_priority = I2C_PRIO_DISPLAY,
   };
 
   grid_composer_renderer renderer1 = {
@@ -458,8 +955,12 @@ init_grid() {
   ad_ctx_2 = {
       .oled = &sh1106_2,
       .u8g2 = &u8g2_2,
-      .tw = &Wire,
+      .tw = I2C_WIRE(I2C_BUS_DISPLAY),
       .idx = SH1106_2_IDX,
+      .mux = display_mux,
+      .glyph_cache = display_glyph_cache,
+      .arbiter = i2c_arbiters[I2C_BUS_DISPLAY],
+      .arbiter_priority = I2C_PRIO_DISPLAY,
 
   };
   grid_composer_renderer renderer2 = {
@@ -472,8 +973,12 @@ init_grid() {
   ad_ctx_3 = {
       .oled = &sh1106_3,
       .u8g2 = &u8g2_3,
-      .tw = &Wire,
+      .tw = I2C_WIRE(I2C_BUS_DISPLAY),
       .idx = SH1106_3_IDX,
+      .mux = display_mux,
+      .glyph_cache = display_glyph_cache,
+      .arbiter = i2c_arbiters[I2C_BUS_DISPLAY],
+      .arbiter_priority = I2C_PRIO_DISPLAY,
   };
   grid_composer_renderer renderer3 = {
       .user_ctx = &ad_ctx_3,
@@ -485,8 +990,12 @@ init_grid() {
   ad_ctx_4 = {
       .oled = &sh1106_4,
       .u8g2 = &u8g2_4,
-      .tw = &Wire,
+      .tw = I2C_WIRE(I2C_BUS_DISPLAY),
       .idx = SH1106_4_IDX,
+      .mux = display_mux,
+      .glyph_cache = display_glyph_cache,
+      .arbiter = i2c_arbiters[I2C_BUS_DISPLAY],
+      .arbiter_priority = I2C_PRIO_DISPLAY,
   };
   grid_composer_renderer renderer4 = {
       .user_ctx = &ad_ctx_4,
@@ -496,6 +1005,8 @@ init_grid() {
   };
 
   ESP_RETURN_ON_ERROR(grid_composer_init(&grid_composer), TAG, "Failed to initialize grid composer");
+  ESP_RETURN_ON_ERROR(grid_composer_set_frame_done_cb(grid_composer, on_grid_frame_done, NULL), TAG,
+                      "Failed to set grid frame callback");
 
   ESP_RETURN_ON_ERROR(grid_composer_add_cell(grid_composer, &renderer1), TAG, "Failed to add a cell device 1");
   ESP_RETURN_ON_ERROR(grid_composer_add_cell(grid_composer, &renderer2), TAG, "Failed to add a cell device 2");
@@ -509,6 +1020,64 @@ init_grid() {
 
   return ret;
 }
+#endif
+esp_err_t
+init_widgets() {
+  esp_err_t ret = ESP_OK;
+
+  /* Three text rows per sensor cell, boxes cover the glyphs of u8g2_font_7x14_tf at each alignment */
+  struct {
+    grid_composer_widget_handle *widget;
+    grid_composer_widget_config cfg;
+  } widgets[] = {
+      {&air_temp_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 0, 128, 16, 0, 0,
+                                                          GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                          u8g2_font_7x14_tf, "Temperature:%.1f",
+                                                          MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&air_humid_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 24, 128, 20, 0, 24,
+                                                           GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                           u8g2_font_7x14_tf, "Humidity:%.1f",
+                                                           MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&air_iaq_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 48, 128, 16, 0, 48,
+                                                         GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "IAQ Index:%.1f",
+                                                         MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&lux_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 0, 128, 16, 0, 0,
+                                                     GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, u8g2_font_7x14_tf,
+                                                     "Lux:%.4f", MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&lux_min_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 24, 128, 20, 0, 24,
+                                                         GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "Min:%.4f",
+                                                         MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&lux_max_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 48, 128, 16, 0, 48,
+                                                         GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "Max:%.4f",
+                                                         MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&sound_laeq_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 0, 128, 16, 0, 0,
+                                                            GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                            u8g2_font_7x14_tf, "LAeq:%.1f dB",
+                                                            MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&sound_la90_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 24, 128, 20, 0, 24,
+                                                            GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                            u8g2_font_7x14_tf, "LA90:%.1f dB",
+                                                            MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&sound_lafmax_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 48, 128, 16, 0, 48,
+                                                              GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                              u8g2_font_7x14_tf, "LAFmax:%.1f dB",
+                                                              MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&clock_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_LABEL, 1, 0, 0, 0, 128, 64, 0, 0,
+                                                       GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_CENTER,
+                                                       u8g2_font_logisoso22_tn, "",
+                                                       MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+  };
+
+  for (uint8_t i = 0; i < sizeof(widgets) / sizeof(widgets[0]); ++i) {
+    ESP_RETURN_ON_ERROR(grid_composer_widget_add(grid_composer, &widgets[i].cfg, widgets[i].widget), TAG,
+                        "Failed to add widget %u", i);
+  }
+
+  return ret;
+}
 
 esp_err_t
 init_wifi() {
@@ -589,7 +1158,7 @@ init_mqtt() {
   };
   ESP_ERROR_CHECK_WITHOUT_ABORT(mqtt_module_set_session_cfg(mqtt_module, &sesh_cfg));
   ESP_ERROR_CHECK_WITHOUT_ABORT(mqtt_module_connect(mqtt_module, 15000));
-  ESP_ERROR_CHECK_WITHOUT_ABORT(mqtt_module_subscribe(mqtt_module, "/IoT-Clock-RoomMonitor/DEVICE_IN/CTRL", 0));
+  ESP_ERROR_CHECK_WITHOUT_ABORT(mqtt_module_subscribe(mqtt_module, MQTT_CTRL_IN_TOPIC, 0));
 
   ESP_LOGI(TAG, "Initialized MQTT module");
   return ret;
@@ -601,62 +1170,66 @@ task_sound_sampling(void *arg) {
   strncpy(payload.sensor, "sound_sens", SENSOR_NAME_MAX_LEN - 1);
   payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
 
-  uint32_t adc_data[ADC_SOUND_SENSOR_READ_SAMPLES];
-
-  uint32_t samples_read = 0U;
+  sensor_payload_t bands_payload;
+  strncpy(bands_payload.sensor, "sound_bands", SENSOR_NAME_MAX_LEN - 1);
+  bands_payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
 
-  char rms_text[32];
-  char max_text[32];
-  char min_text[32];
   float rms = 0.0f;
   float max_rms = 0.0f;
   float min_rms = 0.0f;
-  float max_rms_temp = -FLT_MAX;
-  float min_rms_temp = FLT_MAX;
-
-  uint32_t accumulator_value = 0ULL;
-  uint32_t values_count = 0ULL;
+  float coverage = 0.0f;
+  float laeq = 0.0f;
+  float lafmax = 0.0f;
+  float la90 = 0.0f;
+  uint8_t band_count = 0U;
+  float band_db[SOUND_METER_MAX_BANDS];
 
   uint64_t prev_calc_timestamp_us = 0ULL;
-  uint64_t prev_minmax_timestamp_us = 0ULL;
   uint64_t prev_report_timestamp_us = 0ULL;
 
   uint64_t calc_period_us = ADC_SOUND_SENSOR_CALC_PERIOD_MS * 1000ULL;
-  uint64_t minmax_period_us = ADC_SOUND_SENSOR_MINMAX_PERIOD_MS * 1000ULL;
   uint64_t report_period_us = ADC_SOUND_SENSOR_REPORT_PERIOD_MS * 1000ULL;
 
-  uint64_t delay_ms = (uint64_t)ADC_SOUND_SENSOR_TASK_PERIOD_MS;
-  for (;;) {
-    ESP_ERROR_CHECK_WITHOUT_ABORT(adc_module_get_data(adc_sound_sens, ADC_SOUND_SENSOR_READ_SAMPLES, adc_data, &samples_read));
+  prev_calc_timestamp_us = (uint64_t)esp_timer_get_time();
+  ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_reset(sound_meter, prev_calc_timestamp_us));
 
-    for (uint16_t i = 0; i < samples_read; ++i) {
-      int v = adc_data[i] - ADC_SOUND_SENSOR_DC_OFFSET_MV;
-      accumulator_value += v * v;
-    }
-    values_count += samples_read;
+  minmax_window rms_minmax;
+  minmax_window_init(&rms_minmax, ADC_SOUND_SENSOR_MINMAX_PERIOD_MS * 1000ULL, ADC_SOUND_SENSOR_MINMAX_SCALE,
+                     prev_calc_timestamp_us);
 
+  for (;;) {
+    // Woken by the ADC driver once per conversion frame, every sample of it goes into the meter
+    adc_module_block_t *block = NULL;
+    if (adc_module_stream_borrow(adc_sound_sens, &block, ADC_SOUND_SENSOR_BLOCK_TIMEOUT_MS) != ESP_OK) {
+      ESP_LOGW(TAG, "No samples from the sound sensor");
+      continue;
+    }
     uint64_t curr_timestamp_us = (uint64_t)esp_timer_get_time();
+    sound_meter_feed(sound_meter, block->samples, block->count, block->frames_dropped);
+#if ADC_SOUND_SENSOR_TRACE
+    trace_capture(block, curr_timestamp_us);
+#endif
+    ESP_ERROR_CHECK_WITHOUT_ABORT(adc_module_stream_return(adc_sound_sens, block));
+
     if ((curr_timestamp_us - prev_calc_timestamp_us) >= calc_period_us) {
       prev_calc_timestamp_us = curr_timestamp_us;
 
-      rms = (values_count) ? sqrt(accumulator_value / values_count) : 0.0f;
-
-      max_rms_temp = max(rms, max_rms_temp);
-      min_rms_temp = min(rms, min_rms_temp);
-
-      samples_read = 0U;
-      accumulator_value = 0U;
-      values_count = 0U;
-    }
-
-    if ((curr_timestamp_us - prev_minmax_timestamp_us) >= minmax_period_us) {
-      prev_minmax_timestamp_us = curr_timestamp_us;
-
-      max_rms = max(max_rms_temp, max_rms);
-      min_rms = min(min_rms_temp, min_rms);
+      sound_meter_window_t window;
+      ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_close_window(sound_meter, curr_timestamp_us, &window));
+      rms = window.rms_mv;
+      coverage = window.coverage;
+      laeq = window.laeq_db;
+      lafmax = window.lafmax_db;
+      la90 = window.la90_db;
+      band_count = window.band_count;
+      memcpy(band_db, window.band_db, sizeof(band_db));
+      if (coverage < ADC_SOUND_SENSOR_MIN_COVERAGE) {
+        ESP_LOGW(TAG, "Sound window saw %lu of %lu samples, %lu frames dropped", window.samples, window.expected_samples,
+                 window.frames_dropped);
+      }
 
-      max_rms_temp = -FLT_MAX;
-      min_rms_temp = FLT_MAX;
+      minmax_window_push(&rms_minmax, rms, curr_timestamp_us);
+      minmax_window_get(&rms_minmax, &min_rms, &max_rms);
     }
 
     if ((curr_timestamp_us - prev_report_timestamp_us) >= report_period_us) {
@@ -684,7 +1257,27 @@ task_sound_sampling(void *arg) {
       payload.fields[3].type = SENSOR_FIELD_DATATYPE_UINT;
       payload.fields[3].value.u = (uint64_t)(ADC_SOUND_SENSOR_MINMAX_PERIOD_MS / 1000ULL);
 
-      payload.field_count = 4U;
+      strncpy(payload.fields[4].name, "coverage", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[4].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[4].type = SENSOR_FIELD_DATATYPE_FLOAT;
+      payload.fields[4].value.f = coverage;
+
+      strncpy(payload.fields[5].name, "laeq", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[5].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[5].type = SENSOR_FIELD_DATATYPE_FLOAT;
+      payload.fields[5].value.f = laeq;
+
+      strncpy(payload.fields[6].name, "lafmax", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[6].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[6].type = SENSOR_FIELD_DATATYPE_FLOAT;
+      payload.fields[6].value.f = lafmax;
+
+      strncpy(payload.fields[7].name, "la90", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[7].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[7].type = SENSOR_FIELD_DATATYPE_FLOAT;
+      payload.fields[7].value.f = la90;
+
+      payload.field_count = 8U;
 
       if (xQueueSend(data_aggregation_queue_handle, &payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
         ESP_LOGE(TAG, "Failed sending from sound sensor task");
@@ -692,25 +1285,28 @@ task_sound_sampling(void *arg) {
         ESP_LOGI(TAG, "Sent data from sound sensor task");
       }
 
-      snprintf(rms_text, sizeof(rms_text), "Sound RMS:%.1f", rms);
-      grid_composer_draw_descriptor draw_desc_lux = GRID_COMPOSER_TEXT_DESCRIPTOR(
-          0U, 2U, 0U, 0U, GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, rms_text, u8g2_font_7x14_tf, SH110X_WHITE, true);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_lux, 1000U));
-
-      snprintf(min_text, sizeof(min_text), "Min:%.1f", min_rms);
-      grid_composer_draw_descriptor draw_desc_min =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 2U, 0U, 24U, GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT, min_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_min, 1000U));
-
-      snprintf(max_text, sizeof(max_text), "Max:%.1f", max_rms);
-      grid_composer_draw_descriptor draw_desc_max =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 2U, 0U, 48U, GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT, max_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_max, 1000U));
-    }
+      // Unweighted octave levels, one field per band named after its mid-band frequency
+      bands_payload.timestamp = payload.timestamp;
+      bands_payload.field_count = 0U;
+      for (uint8_t b = 0; b < band_count && bands_payload.field_count < SENSOR_MAX_FIELDS; ++b) {
+        sound_meter_band_t band;
+        if (sound_meter_get_band(sound_meter, b, &band) != ESP_OK)
+          break;
+
+        sensor_field_t *field = &bands_payload.fields[bands_payload.field_count++];
+        snprintf(field->name, SENSOR_FIELD_NAME_LEN, "lz_%s", band.name);
+        field->type = SENSOR_FIELD_DATATYPE_FLOAT;
+        field->value.f = band_db[b];
+      }
+      if (bands_payload.field_count &&
+          xQueueSend(data_aggregation_queue_handle, &bands_payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed sending sound bands");
+      }
 
-    vTaskDelay(pdMS_TO_TICKS(delay_ms));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(sound_laeq_widget, laeq));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(sound_la90_widget, la90));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(sound_lafmax_widget, lafmax));
+    }
   }
 }
 void
@@ -720,47 +1316,83 @@ task_tsl2591_sampling(void *arg) {
   strncpy(payload.sensor, "tsl2591", SENSOR_NAME_MAX_LEN - 1);
   payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
 
-  char lux_text[32];
-  char max_text[32];
-  char min_text[32];
   float lux = 0.0f;
   float max_lux = 0.0f;
   float min_lux = 0.0f;
-  float max_lux_temp = -FLT_MAX;
-  float min_lux_temp = FLT_MAX;
 
-  uint64_t prev_minmax_timestamp_us = 0ULL;
   uint64_t prev_report_timestamp_us = 0ULL;
 
-  uint64_t minmax_period_us = (uint64_t)(TSL2591_MINMAX_PERIOD_MS * 1000ULL);
+#if TSL2591_EVENT_DRIVEN
+  uint64_t report_period_us = (uint64_t)(TSL2591_HEARTBEAT_MS * 1000ULL);
+#else
   uint64_t report_period_us = (uint64_t)(TSL2591_REPORT_PERIOD_MS * 1000ULL);
+#endif
 
-  uint64_t delay_ms = (uint64_t)(TSL2591_TASK_PERIOD_MS);
-  for (;;) {
-    uint32_t lum = tsl2591.getFullLuminosity();
-
-    uint32_t ir = lum >> 16;
-    uint32_t full = lum & 0xFFFF;
+  minmax_window lux_minmax;
+  minmax_window_init(&lux_minmax, (uint64_t)(TSL2591_MINMAX_PERIOD_MS * 1000ULL), TSL2591_MINMAX_SCALE,
+                     (uint64_t)esp_timer_get_time());
 
-    lux = tsl2591.calculateLux(full, ir);
-    lux = ((lux < FLT_MAX) && (lux > -FLT_MAX)) ? lux : 0.0f;
-
-    max_lux_temp = max(lux, max_lux_temp);
-    min_lux_temp = min(lux, min_lux_temp);
+  TickType_t period_ticks = pdMS_TO_TICKS(TSL2591_TASK_PERIOD_MS);
+  TickType_t wake_tick = xTaskGetTickCount();
+  bool is_armed = false;
+  bool is_event = false; // kept over the conversions a saturated reading takes, until it was reported
+  uint32_t events = 0;
+  for (;;) {
+#if TSL2591_EVENT_DRIVEN
+    if (is_armed) {
+      // Light within the window only wakes the task for the heartbeat
+      uint64_t since_report_ms = ((uint64_t)esp_timer_get_time() - prev_report_timestamp_us) / 1000ULL;
+      uint32_t timeout_ms = since_report_ms < TSL2591_HEARTBEAT_MS ? TSL2591_HEARTBEAT_MS - (uint32_t)since_report_ms : 0U;
+      if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) > 0U) {
+        is_event = true;
+        events++;
+      }
+      wake_tick = xTaskGetTickCount();
+    }
+#endif
+
+    // The conversion runs on its own, the bus and the core stay free until the ALS valid bit is due. An armed sensor
+    // kept converting, its channels are already current.
+    uint32_t wait_ms = 0;
+    tsl2591_als_reading_t reading;
+    esp_err_t err = ESP_OK;
+    if (!is_armed) {
+      err = tsl2591_als_start(tsl2591, &wait_ms);
+      vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    }
+    is_armed = false;
+    if (err == ESP_OK) {
+      uint8_t polls = 0;
+      while ((err = tsl2591_als_read(tsl2591, &reading)) == ESP_ERR_NOT_FINISHED && polls++ < TSL2591_POLL_LIMIT) {
+        vTaskDelay(pdMS_TO_TICKS(TSL2591_POLL_MS));
+      }
+    }
+    if (err != ESP_OK) {
+      ESP_LOGW(TAG, "TSL2591 conversion failed: %s", esp_err_to_name(err));
+      vTaskDelayUntil(&wake_tick, period_ticks);
+      continue;
+    }
+    if (reading.saturated) {
+      // Auto ranging already stepped down, convert again right away unless it has nowhere left to go
+      tsl2591_als_gain_t gain;
+      tsl2591_als_atime_t atime;
+      ESP_ERROR_CHECK_WITHOUT_ABORT(tsl2591_als_get_range(tsl2591, &gain, &atime));
+      ESP_LOGD(TAG, "TSL2591 saturated at %.0fx %lu ms", tsl2591_als_gain_factor(reading.gain),
+               tsl2591_als_atime_ms(reading.atime));
+      if (gain == reading.gain && atime == reading.atime) {
+        vTaskDelayUntil(&wake_tick, period_ticks);
+      }
+      continue;
+    }
+    lux = reading.lux;
 
     uint64_t curr_timestamp_us = (uint64_t)esp_timer_get_time();
-    if ((curr_timestamp_us - prev_minmax_timestamp_us) >= minmax_period_us) {
-      prev_minmax_timestamp_us = curr_timestamp_us;
-
-      max_lux = max(max_lux_temp, max_lux);
-      min_lux = min(min_lux_temp, min_lux);
-
-      max_lux_temp = -FLT_MAX;
-      min_lux_temp = FLT_MAX;
-    }
+    minmax_window_push(&lux_minmax, lux, curr_timestamp_us);
+    minmax_window_get(&lux_minmax, &min_lux, &max_lux);
 
-    if ((curr_timestamp_us - prev_report_timestamp_us) >= report_period_us) {
+    if (is_event || (curr_timestamp_us - prev_report_timestamp_us) >= report_period_us) {
       prev_report_timestamp_us = curr_timestamp_us;
+      is_event = false;
 
       payload.timestamp = (uint64_t)(curr_timestamp_us + boot_to_utc_offset_us);
 
@@ -784,68 +1416,189 @@ task_tsl2591_sampling(void *arg) {
       payload.fields[3].type = SENSOR_FIELD_DATATYPE_UINT;
       payload.fields[3].value.u = (uint64_t)(TSL2591_MINMAX_PERIOD_MS / 1000ULL);
 
-      payload.field_count = 4U;
+      strncpy(payload.fields[4].name, "gain", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[4].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[4].type = SENSOR_FIELD_DATATYPE_UINT;
+      payload.fields[4].value.u = (uint64_t)tsl2591_als_gain_factor(reading.gain);
+
+      strncpy(payload.fields[5].name, "atime_ms", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[5].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[5].type = SENSOR_FIELD_DATATYPE_UINT;
+      payload.fields[5].value.u = (uint64_t)tsl2591_als_atime_ms(reading.atime);
+
+      strncpy(payload.fields[6].name, "events", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[6].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[6].type = SENSOR_FIELD_DATATYPE_UINT;
+      payload.fields[6].value.u = (uint64_t)events;
+      events = 0;
+
+      payload.field_count = 7U;
 
       if (xQueueSend(data_aggregation_queue_handle, &payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
         ESP_LOGE(TAG, "Failed sending from tsl2591 task");
       } else {
         ESP_LOGI(TAG, "Sent data from tsl2591 task");
       }
-      snprintf(lux_text, sizeof(lux_text), "Lux:%.4f", lux);
-      grid_composer_draw_descriptor draw_desc_lux = GRID_COMPOSER_TEXT_DESCRIPTOR(
-          0U, 1U, 0U, 0U, GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, lux_text, u8g2_font_7x14_tf, SH110X_WHITE, true);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_lux, 1000U));
-
-      snprintf(min_text, sizeof(min_text), "Min:%.4f", min_lux);
-      grid_composer_draw_descriptor draw_desc_min =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 1U, 0U, 24U, GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT, min_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_min, 1000U));
-
-      snprintf(max_text, sizeof(max_text), "Max:%.4f", max_lux);
-      grid_composer_draw_descriptor draw_desc_max =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 1U, 0U, 48U, GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT, max_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_max, 1000U));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(lux_widget, lux));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(lux_min_widget, min_lux));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(lux_max_widget, max_lux));
     }
 
-    vTaskDelay(pdMS_TO_TICKS(delay_ms));
+#if TSL2591_EVENT_DRIVEN
+    err = tsl2591_als_arm(tsl2591, &reading, TSL2591_EVENT_WINDOW, TSL2591_EVENT_PERSIST);
+    is_armed = err == ESP_OK;
+    if (!is_armed) {
+      ESP_LOGW(TAG, "Failed to arm TSL2591 thresholds, polling: %s", esp_err_to_name(err));
+      vTaskDelayUntil(&wake_tick, period_ticks);
+    }
+#else
+    vTaskDelayUntil(&wake_tick, period_ticks);
+#endif
+  }
+}
+#if TSL2591_EVENT_DRIVEN
+void IRAM_ATTR
+on_tsl2591_interrupt(void *arg) {
+  BaseType_t task_woken = pdFALSE;
+
+  if (task_tsl2591_sampling_handle) {
+    vTaskNotifyGiveFromISR(task_tsl2591_sampling_handle, &task_woken);
   }
+  portYIELD_FROM_ISR(task_woken);
 }
+#endif
 void
 task_air_quality_sampling(void *arg) {
   sensor_payload_t payload;
   strncpy(payload.sensor, "air_quality", SENSOR_NAME_MAX_LEN - 1);
   payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
 
-  char humid_text[32];
-  char temp_text[32];
-  char iaq_text[32];
-  float bmp180_temp = 0.0f;
   float temp = 0.0f;
   float humid = 0.0f;
   float iaq = 0.0f;
+  uint8_t iaq_accuracy = 0;
 
   uint64_t prev_report_timestamp_us = 0ULL;
 
   uint64_t report_period_us = AIR_QUALITY_REPORT_PERIOD_MS * 1000ULL;
 
-  uint64_t delay_ms = (uint64_t)AIR_QUALITY_TASK_PERIOD_MS;
+  // BSEC's temperature still carries some of the board's heat, the BMP180 anchors the room temperature
+  temp_fusion_config_t fusion_cfg = {
+      .sensor_noise = TEMP_FUSION_BME690_NOISE,
+      .ref_noise = TEMP_FUSION_BMP180_NOISE,
+      .temp_drift_per_h = TEMP_FUSION_TEMP_DRIFT_H,
+      .heating_drift_per_h = TEMP_FUSION_HEATING_DRIFT_H,
+      .initial_heating = TEMP_FUSION_INITIAL_HEATING,
+      .initial_heating_stddev = TEMP_FUSION_INITIAL_HEATING_SD,
+  };
+  temp_fusion_t fusion;
+  temp_fusion_init(&fusion, &fusion_cfg);
+  temp_fusion_result_t fused;
+  bmp180_sample bmp180_reading;
+
+#if BSEC_STATE_PERSIST
+  bool is_state_saved = false;
+  uint64_t prev_state_save_timestamp_us = 0ULL;
+  uint64_t state_save_period_us = (uint64_t)BSEC_STATE_SAVE_PERIOD_MS * 1000ULL;
+#endif
+
+  sensor_payload_t timing_payload; // the bus stats go out through it as well
+
+  // Since the previous timing report
+  uint32_t calls = 0;
+  uint32_t late_calls = 0;
+  uint32_t timing_violations = 0;
+  uint32_t early_wakeups = 0;
+  uint32_t max_lateness_ms = 0;
+  uint64_t heater_on_ms = 0;
+  uint64_t prev_timing_report_timestamp_us = (uint64_t)esp_timer_get_time();
+  uint64_t timing_report_period_us = AIR_QUALITY_TIMING_REPORT_MS * 1000ULL;
+
+  uint64_t call_period_us = AIR_QUALITY_CALL_PERIOD_MS * 1000ULL;
+  uint32_t retry_ms = AIR_QUALITY_RETRY_MS;
+
+  uint64_t deadline_us = (uint64_t)esp_timer_get_time(); // BSEC's, the first call is due right away
+  uint64_t next_call_us = deadline_us;                   // the wake up, retries after an early one come before the deadline
   for (;;) {
-    const bsecOutputs *outputs;
+    // Asleep until BSEC's next call, the wrapper gives back nothing before it
+    uint64_t now_us = (uint64_t)esp_timer_get_time();
+    if (next_call_us > now_us) {
+      vTaskDelay(pdMS_TO_TICKS((next_call_us - now_us + 999ULL) / 1000ULL + AIR_QUALITY_CALL_MARGIN_MS));
+    }
+
+    uint64_t call_us = (uint64_t)esp_timer_get_time();
     if (!bme690_bsec.run()) {
-      vTaskDelay(pdMS_TO_TICKS(delay_ms));
+      if (bme690_bsec.status == BSEC_OK) {
+        // Not due yet on the wrapper's clock, which runs on whole milliseconds. BSEC's deadline bounds the backoff.
+        early_wakeups++;
+        next_call_us = call_us + retry_ms * 1000ULL;
+        if (deadline_us > call_us && deadline_us < next_call_us) {
+          next_call_us = deadline_us;
+        }
+        retry_ms = retry_ms * 2U < AIR_QUALITY_LATE_MS ? retry_ms * 2U : AIR_QUALITY_LATE_MS;
+        continue;
+      }
+      retry_ms = AIR_QUALITY_RETRY_MS;
+      // BSEC has set its next call regardless, the measurement of this one is lost
+      if (bme690_bsec.status == BSEC_W_SC_CALL_TIMING_VIOLATION) {
+        timing_violations++;
+      }
+      ESP_LOGW(TAG, "BSEC call failed, code: %i", bme690_bsec.status);
+      // One period on if the failure left the deadline behind, rather than spinning on it
+      deadline_us = bsec_control_next_call_us();
+      next_call_us = deadline_us > call_us ? deadline_us : call_us + call_period_us;
       continue;
     }
 
-    outputs = bme690_bsec.getBSECOutputs();
+    calls++;
+    heater_on_ms += bsec_control_heater_on_ms();
+    retry_ms = AIR_QUALITY_RETRY_MS;
+    // Against BSEC's deadline, not the retry that made the call
+    uint32_t lateness_ms = call_us > deadline_us ? (uint32_t)((call_us - deadline_us) / 1000ULL) : 0U;
+    late_calls += lateness_ms > AIR_QUALITY_LATE_MS ? 1U : 0U;
+    max_lateness_ms = lateness_ms > max_lateness_ms ? lateness_ms : max_lateness_ms;
+    if (bme690_bsec.status == BSEC_W_SC_CALL_TIMING_VIOLATION) {
+      timing_violations++;
+    }
+    deadline_us = bsec_control_next_call_us();
+    next_call_us = deadline_us;
+
+    if (call_us - prev_timing_report_timestamp_us >= timing_report_period_us) {
+      // Share of the time the heater was on, in parts per million
+      uint32_t heater_ppm = (uint32_t)(heater_on_ms * 1000000ULL / ((call_us - prev_timing_report_timestamp_us) / 1000ULL));
+      prev_timing_report_timestamp_us = call_us;
+
+      const char *timing_fields[] = {"calls", "late", "violations", "early", "max_late_ms", "heater_ppm"};
+      const uint32_t timing_values[] = {calls, late_calls, timing_violations, early_wakeups, max_lateness_ms, heater_ppm};
+      strncpy(timing_payload.sensor, "bsec_timing", SENSOR_NAME_MAX_LEN - 1);
+      timing_payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
+      timing_payload.timestamp = (uint64_t)(call_us + boot_to_utc_offset_us);
+      for (uint8_t f = 0; f < sizeof(timing_values) / sizeof(timing_values[0]); ++f) {
+        strncpy(timing_payload.fields[f].name, timing_fields[f], SENSOR_FIELD_NAME_LEN - 1);
+        timing_payload.fields[f].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+        timing_payload.fields[f].type = SENSOR_FIELD_DATATYPE_UINT;
+        timing_payload.fields[f].value.u = timing_values[f];
+      }
+      timing_payload.field_count = sizeof(timing_values) / sizeof(timing_values[0]);
+      if (xQueueSend(data_aggregation_queue_handle, &timing_payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGE(TAG, "Failed sending the BSEC call timing");
+      }
+      // Reset with every timing report, so the waits line up with the late calls
+      for (uint8_t bus = 0; bus < I2C_BUS_COUNT; ++bus) {
+        send_i2c_bus_stats(&timing_payload, i2c_buses[bus].name, i2c_arbiters[bus], timing_payload.timestamp);
+      }
+      calls = late_calls = timing_violations = early_wakeups = max_lateness_ms = 0;
+      heater_on_ms = 0;
+    }
 
-    if (!outputs || outputs->nOutputChnls == 0) {
-      vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    const bsecOutputs *outputs = bme690_bsec.getBSECOutputs();
+    if (!outputs || outputs->nOutputChnls == 0)
       continue;
-    }
 
-    bmp180_temp = bmp180.readTemperature();
+    // Cached by the BMP180 task, each reading is folded in once
+    if (bmp180_queue && xQueueReceive(bmp180_queue, &bmp180_reading, 0) == pdTRUE) {
+      temp_fusion_push_ref(&fusion, bmp180_reading.temp, bmp180_reading.timestamp_us);
+    }
 
     size_t field_index = 0;
     for (uint8_t i = 0; i < outputs->nOutputChnls; i++) {
@@ -861,7 +1614,7 @@ task_air_quality_sampling(void *arg) {
         value_type = SENSOR_FIELD_DATATYPE_FLOAT;
         payload.fields[field_index].value.f = outputs->outputChnls[i].signal;
 
-        temp = (outputs->outputChnls[i].signal + bmp180_temp) / 2.0f;
+        temp_fusion_push_sensor(&fusion, outputs->outputChnls[i].signal, call_us);
         break;
       case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
         value_name = "humid";
@@ -881,6 +1634,7 @@ task_air_quality_sampling(void *arg) {
         payload.fields[field_index].value.f = outputs->outputChnls[i].signal;
 
         iaq = outputs->outputChnls[i].signal;
+        iaq_accuracy = outputs->outputChnls[i].accuracy;
         break;
       default:
         value_type = SENSOR_FIELD_DATATYPE_INVALID;
@@ -895,8 +1649,45 @@ task_air_quality_sampling(void *arg) {
       }
     }
 
+    if (field_index < SENSOR_MAX_FIELDS) {
+      strncpy(payload.fields[field_index].name, "iaq_acc", SENSOR_FIELD_NAME_LEN - 1);
+      payload.fields[field_index].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+      payload.fields[field_index].type = SENSOR_FIELD_DATATYPE_UINT;
+      payload.fields[field_index].value.u = (uint64_t)iaq_accuracy;
+      field_index++;
+    }
+
+    if (temp_fusion_get(&fusion, &fused)) {
+      temp = fused.temp;
+
+      const char *fused_fields[] = {"temp_fused", "self_heat"};
+      const float fused_values[] = {fused.temp, fused.heating};
+      for (uint8_t f = 0; f < sizeof(fused_values) / sizeof(fused_values[0]) && field_index < SENSOR_MAX_FIELDS; ++f) {
+        strncpy(payload.fields[field_index].name, fused_fields[f], SENSOR_FIELD_NAME_LEN - 1);
+        payload.fields[field_index].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+        payload.fields[field_index].type = SENSOR_FIELD_DATATYPE_FLOAT;
+        payload.fields[field_index].value.f = fused_values[f];
+        field_index++;
+      }
+    }
+
     payload.field_count = field_index;
     uint64_t curr_timestamp_us = (uint64_t)esp_timer_get_time();
+
+#if BSEC_STATE_PERSIST
+    if (bsec_state_store && iaq_accuracy >= BSEC_STATE_MIN_ACCURACY &&
+        (!is_state_saved || (curr_timestamp_us - prev_state_save_timestamp_us) >= state_save_period_us)) {
+      bool is_written = false;
+      if (!bme690_bsec.getState(bsec_state_buffer)) {
+        ESP_LOGW(TAG, "Failed to get BSEC state, code: %i", bme690_bsec.status);
+      } else if (state_store_save(bsec_state_store, bsec_state_buffer, sizeof(bsec_state_buffer), curr_timestamp_us,
+                                  &is_written) == ESP_OK) {
+        is_state_saved = true;
+        prev_state_save_timestamp_us = curr_timestamp_us;
+        ESP_LOGI(TAG, "BSEC state %s", is_written ? "saved" : "unchanged or saved too recently");
+      }
+    }
+#endif
     if ((curr_timestamp_us - prev_report_timestamp_us) >= report_period_us) {
       prev_report_timestamp_us = curr_timestamp_us;
 
@@ -910,30 +1701,30 @@ task_air_quality_sampling(void *arg) {
         }
       }
 
-      snprintf(temp_text, sizeof(temp_text), "Temperature:%.1f", temp);
-      grid_composer_draw_descriptor draw_desc_temp =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 0U, 0U, 0U, GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, temp_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, true);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_temp, 1000U));
-      // memset(t_text, 0, sizeof(t_text));
-
-      snprintf(humid_text, sizeof(humid_text), "Humidity:%.1f", humid);
-      grid_composer_draw_descriptor draw_desc_humid =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 0U, 0U, 24U, GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT, humid_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_humid, 1000U));
-      // memset(t_text, 0, sizeof(t_text));
-
-      snprintf(iaq_text, sizeof(iaq_text), "IAQ Index:%.1f", iaq);
-      grid_composer_draw_descriptor draw_desc_iaq =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(0U, 0U, 0U, 48U, GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT, iaq_text,
-                                        u8g2_font_7x14_tf, SH110X_WHITE, false);
-
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc_iaq, 1000U));
-      // memset(t_text, 0, sizeof(t_text));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(air_temp_widget, temp));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(air_humid_widget, humid));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_value(air_iaq_widget, iaq));
+    }
+  }
+}
+void
+task_bmp180_sampling(void *arg) {
+  bmp180_sample sample;
+
+  TickType_t wake_tick = xTaskGetTickCount();
+  for (;;) {
+    // The conversion blocks this task only and leaves the bus free, the air quality task finds the reading when it
+    // next runs. A conversion still running after the wait costs this period's reading.
+    uint32_t wait_ms = 0;
+    if (bmp180_temp_start(bmp180, &wait_ms) == ESP_OK) {
+      vTaskDelay(pdMS_TO_TICKS(wait_ms) + 1U);
+      if (bmp180_temp_read(bmp180, &sample.temp) == ESP_OK) {
+        sample.timestamp_us = (uint64_t)esp_timer_get_time();
+        xQueueOverwrite(bmp180_queue, &sample);
+      }
     }
 
-    vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    vTaskDelayUntil(&wake_tick, pdMS_TO_TICKS(BMP180_TASK_PERIOD_MS));
   }
 }
 void
@@ -974,11 +1765,9 @@ task_sntp_sampling(void *arg) {
         ESP_LOGI(TAG, "Sent data from sntp task");
       }
 
+      // Redrawn only when the minute changes
       sprintf(t_text, "%02i:%02i", timeinfo.tm_hour, timeinfo.tm_min);
-      grid_composer_draw_descriptor draw_desc =
-          GRID_COMPOSER_TEXT_DESCRIPTOR(1U, 0U, 0U, 0U, GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_CENTER, t_text,
-                                        u8g2_font_logisoso22_tn, SH110X_WHITE, true);
-      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_draw_queue_send(grid_composer, &draw_desc, 1000U));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(grid_composer_widget_set_text(clock_widget, t_text));
     }
 
     vTaskDelay(pdMS_TO_TICKS(delay_ms));
@@ -1026,6 +1815,13 @@ task_sensor_data_aggregation(void *arg) {
       cbor_encoder_close_container(&map_outer, &map_data);
       cbor_encoder_close_container(&encoder, &map_outer);
 
+      // Cannot happen while the buffer is sized from the largest payload, a truncated message is not sent
+      size_t extra_bytes = cbor_encoder_get_extra_bytes_needed(&encoder);
+      if (extra_bytes) {
+        ESP_LOGE(TAG, "An mqtt payload of %lu sensor payloads is %zu bytes over, dropping it", payloads_received, extra_bytes);
+        xQueueSend(mqtt_free_queue, &msg, 0);
+        continue;
+      }
       msg->length = cbor_encoder_get_buffer_size(&encoder, msg->buffer);
 
       ESP_LOGI(TAG, "Encoded an mqtt payload, length:%lu, sensor payloads:%lu", msg->length, payloads_received);
@@ -1062,6 +1858,50 @@ task_mqtt_sending(void *arg) {
     }
   }
 }
+#if ADC_SOUND_SENSOR_TRACE
+void
+task_trace_sending(void *arg) {
+  trace_message *msg = NULL;
+  for (;;) {
+    if (xQueueReceive(trace_filled_queue, &msg, portMAX_DELAY) == pdTRUE) {
+      // Reconnecting is left to task_mqtt_sending, a lost message shows up as a gap in the record timestamps
+      mqtt_module_publish(mqtt_module, MQTT_TRACE_TOPIC, (char *)msg->buffer, msg->length, 0, 0);
+      msg->length = 0U;
+      xQueueSend(trace_free_queue, &msg, 0);
+    }
+  }
+}
+/**
+ * Appends a borrowed block to the trace buffer being filled, never waits on the sending task
+ */
+void
+trace_capture(const adc_module_block_t *block, uint64_t timestamp_us) {
+  adc_module_block_t record = *block;
+  record.frames_dropped += trace_frames_missed;
+
+  for (uint8_t attempt = 0; attempt < 2U; ++attempt) {
+    if (NULL == trace_current && xQueueReceive(trace_free_queue, &trace_current, 0) != pdTRUE) {
+      trace_current = NULL;
+      break;
+    }
+    uint32_t length = 0U;
+    if (adc_trace_encode(&record, ADC_SOUND_SENSOR_ADC_SAMPLE_FREQ, timestamp_us, &trace_current->buffer[trace_current->length],
+                         sizeof(trace_current->buffer) - trace_current->length, &length) == ESP_OK) {
+      trace_current->length += length;
+      trace_frames_missed = 0U;
+      return;
+    }
+    if (0U == trace_current->length) {
+      ESP_LOGE(TAG, "A %lu sample block does not fit a trace message", block->count);
+      break;
+    }
+    // Full, the filled queue holds every buffer so this never blocks
+    xQueueSend(trace_filled_queue, &trace_current, 0);
+    trace_current = NULL;
+  }
+  trace_frames_missed += block->frames_dropped + 1U;
+}
+#endif
 esp_err_t
 mqtt_data_event_handler(mqtt_module_handle mqtt_module, int32_t event_id, esp_mqtt_event_handle_t event_handle) {
   //   - msg_id               message id
@@ -1091,3 +1931,166 @@ mqtt_data_event_handler(mqtt_module_handle mqtt_module, int32_t event_id, esp_mq
            event_handle->data);
   return ret;
 }
+
+void
+on_grid_frame_done(grid_composer_handle composer, const grid_composer_frame_stats *stats, void *user_ctx) {
+#if !DISPLAY_USE_ESP_LCD_RENDERER
+  // The esp_lcd bus closes its own mux frames from the flush task
+  pca9548a_mux_frame_end(display_mux);
+#endif
+
+  pca9548a_mux_stats mux_stats;
+  if (pca9548a_mux_get_stats(display_mux, &mux_stats, NULL) == ESP_OK) {
+    ESP_LOGD(TAG, "Grid frame, draws:%u cell switches:%u mux writes:%lu saved:%lu", stats->draws, stats->cell_switches,
+             mux_stats.writes, mux_stats.writes_saved);
+  }
+}
+
+void
+minmax_window_init(minmax_window *window, uint64_t period_us, float scale, uint64_t now_us) {
+  stream_stats_reset(&window->previous);
+  stream_stats_reset(&window->current);
+  window->period_start_us = now_us;
+  window->period_us = period_us;
+  window->scale = scale;
+}
+void
+minmax_window_push(minmax_window *window, float value, uint64_t now_us) {
+  if ((now_us - window->period_start_us) >= window->period_us) {
+    window->period_start_us = now_us;
+    window->previous = window->current;
+    stream_stats_reset(&window->current);
+  }
+
+  // Out of range readings are clamped rather than left to break the integer sums
+  float scaled = roundf(value * window->scale);
+  float limit = (float)(STREAM_STATS_VALUE_MAX - 1);
+  scaled = scaled > limit ? limit : (scaled < -limit ? -limit : scaled);
+  stream_stats_push(&window->current, (int32_t)scaled);
+}
+void
+minmax_window_get(const minmax_window *window, float *out_min, float *out_max) {
+  stream_stats_t both = window->previous;
+  stream_stats_merge(&both, &window->current);
+
+  stream_stats_result_t result;
+  stream_stats_get(&both, &result);
+  *out_min = (float)result.min / window->scale;
+  *out_max = (float)result.max / window->scale;
+}
+
+esp_err_t
+i2c_client_open(i2c_client *client, uint8_t bus, uint8_t address, uint8_t priority) {
+  i2c_device_config_t dev_cfg = {
+      .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+      .device_address = address,
+      .scl_speed_hz = i2c_buses[bus].freq_hz,
+  };
+  client->arbiter = i2c_arbiters[bus];
+  client->priority = priority;
+  return i2c_master_bus_add_device(i2c_master_buses[bus], &dev_cfg, &client->dev);
+}
+esp_err_t
+i2c_client_read_reg(void *user_ctx, uint8_t address, uint8_t reg, uint8_t *data, size_t len) {
+  i2c_client *client = (i2c_client *)user_ctx;
+
+  ESP_RETURN_ON_ERROR(i2c_arbiter_acquire(client->arbiter, client->priority, I2C_WAIT_MS), TAG, "I2C bus busy");
+  esp_err_t ret = i2c_master_transmit_receive(client->dev, &reg, 1U, data, len, I2C_WAIT_MS);
+  if (ret == ESP_OK) {
+    // Both address bytes of the repeated start and the register
+    i2c_arbiter_count_bytes(client->arbiter, len + 3U);
+  }
+  i2c_arbiter_release(client->arbiter);
+  return ret;
+}
+esp_err_t
+i2c_client_write(void *user_ctx, uint8_t address, const uint8_t *data, size_t len) {
+  i2c_client *client = (i2c_client *)user_ctx;
+
+  ESP_RETURN_ON_ERROR(i2c_arbiter_acquire(client->arbiter, client->priority, I2C_WAIT_MS), TAG, "I2C bus busy");
+  esp_err_t ret = i2c_master_transmit(client->dev, data, len, I2C_WAIT_MS);
+  if (ret == ESP_OK) {
+    i2c_arbiter_count_bytes(client->arbiter, len + 1U);
+  }
+  i2c_arbiter_release(client->arbiter);
+  return ret;
+}
+
+/**
+ * Utilization, throughput and the waits of every client above the displays since the previous report, payload is
+ * scratch space. The waits per priority go to the log.
+ */
+void
+send_i2c_bus_stats(sensor_payload_t *payload, const char *name, i2c_arbiter_handle arbiter, uint64_t timestamp_us) {
+  i2c_arbiter_stats stats;
+  if (!arbiter || i2c_arbiter_get_stats(arbiter, &stats, true) != ESP_OK)
+    return;
+
+  uint32_t sensor_waits[I2C_ARBITER_WAIT_BUCKETS] = {0};
+  for (uint8_t p = 0; p < I2C_ARBITER_PRIO_COUNT; ++p) {
+    if (stats.acquisitions[p] == 0)
+      continue;
+    ESP_LOGI(TAG, "%s priority %u: %lu acquisitions, waits <0.1/1/10/100 ms: %lu %lu %lu %lu, more: %lu, max %lu us", name,
+             p, stats.acquisitions[p], stats.wait_hist[p][0], stats.wait_hist[p][1], stats.wait_hist[p][2],
+             stats.wait_hist[p][3], stats.wait_hist[p][4], stats.max_wait_us[p]);
+    for (uint8_t b = 0; b < I2C_ARBITER_WAIT_BUCKETS && p > I2C_PRIO_DISPLAY; ++b) {
+      sensor_waits[b] += stats.wait_hist[p][b];
+    }
+  }
+
+  uint32_t util_ppm = stats.window_us ? (uint32_t)(stats.busy_us * 1000000ULL / stats.window_us) : 0U;
+  uint32_t bytes_s = stats.window_us ? (uint32_t)(stats.bytes * 1000000ULL / stats.window_us) : 0U;
+  ESP_LOGI(TAG, "%s: %lu ppm busy, %lu B/s, %lu preemptions", name, util_ppm, bytes_s, stats.preemptions);
+
+  // Preemptions only in the log, a payload has room for eight fields
+  const char *fields[] = {"util_ppm", "bytes_s", "timeouts", "w_lt100us", "w_lt1ms", "w_lt10ms", "w_lt100ms", "w_ge100ms"};
+  const uint32_t values[] = {util_ppm,        bytes_s,         stats.timeouts,  sensor_waits[0],
+                             sensor_waits[1], sensor_waits[2], sensor_waits[3], sensor_waits[4]};
+
+  strncpy(payload->sensor, name, SENSOR_NAME_MAX_LEN - 1);
+  payload->sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
+  payload->timestamp = timestamp_us;
+  for (uint8_t f = 0; f < sizeof(values) / sizeof(values[0]); ++f) {
+    strncpy(payload->fields[f].name, fields[f], SENSOR_FIELD_NAME_LEN - 1);
+    payload->fields[f].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+    payload->fields[f].type = SENSOR_FIELD_DATATYPE_UINT;
+    payload->fields[f].value.u = values[f];
+  }
+  payload->field_count = sizeof(values) / sizeof(values[0]);
+  if (xQueueSend(data_aggregation_queue_handle, payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
+    ESP_LOGE(TAG, "Failed sending the %s stats", name);
+  }
+}
+/**
+ * How long the boot took and what it left of the heap, once. Times from the start of the image, main_us marks app_main,
+ * drivers_us the last driver up.
+ */
+void
+send_boot_report(uint64_t main_us, uint64_t drivers_us) {
+  static sensor_payload_t payload; // once, the stack of app_main is better kept for the tasks
+  uint64_t ready_us = (uint64_t)esp_timer_get_time();
+  const char *fields[] = {"main_ms", "drivers_ms", "ready_ms", "heap_free", "heap_min", "heap_largest", "psram_free"};
+  const uint32_t values[] = {(uint32_t)(main_us / 1000U),
+                             (uint32_t)(drivers_us / 1000U),
+                             (uint32_t)(ready_us / 1000U),
+                             (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                             (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+                             (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+                             (uint32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM)};
+  ESP_LOGI(TAG, "Boot, main:%lu ms drivers:%lu ms ready:%lu ms, internal free:%lu min:%lu largest:%lu, psram:%lu", values[0],
+           values[1], values[2], values[3], values[4], values[5], values[6]);
+
+  strncpy(payload.sensor, "boot", SENSOR_NAME_MAX_LEN - 1);
+  payload.sensor[SENSOR_NAME_MAX_LEN - 1] = '\0';
+  payload.timestamp = (uint64_t)(ready_us + boot_to_utc_offset_us);
+  for (uint8_t f = 0; f < sizeof(values) / sizeof(values[0]); ++f) {
+    strncpy(payload.fields[f].name, fields[f], SENSOR_FIELD_NAME_LEN - 1);
+    payload.fields[f].name[SENSOR_FIELD_NAME_LEN - 1] = '\0';
+    payload.fields[f].type = SENSOR_FIELD_DATATYPE_UINT;
+    payload.fields[f].value.u = values[f];
+  }
+  payload.field_count = sizeof(values) / sizeof(values[0]);
+  if (xQueueSend(data_aggregation_queue_handle, &payload, pdMS_TO_TICKS(TASK_QUEUE_SEND_TIMEOUT_MS)) != pdTRUE) {
+    ESP_LOGE(TAG, "Failed sending the boot report");
+  }
+}
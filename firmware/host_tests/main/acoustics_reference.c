@@ -0,0 +1,143 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acoustics_reference.h"
+
+#define REF_DC_BLOCK_HZ     5.0
+#define REF_FAST_TAU_S      0.125
+#define REF_PRESSURE_PA     20e-6
+#define REF_LA90_PERCENTILE 10U
+
+static const double poles_hz[] = {20.598997, 107.65265, 737.86223, 12194.217};
+
+static double
+section_gain(const double *s, double omega);
+static double
+to_db(const acoustics_reference *ref, double mean_square);
+static int
+compare_levels(const void *a, const void *b);
+
+void
+acoustics_reference_init(acoustics_reference *ref, uint32_t sample_rate_hz, double mv_per_pa, uint32_t level_interval_ms,
+                         uint32_t settle_ms, int32_t dc_offset_mv) {
+  memset(ref, 0, sizeof(acoustics_reference));
+  double fs = sample_rate_hz;
+
+  double r = exp(-2.0 * M_PI * REF_DC_BLOCK_HZ / fs);
+  double p[4];
+  for (int i = 0; i < 4; ++i) {
+    double w = 2.0 * M_PI * poles_hz[i];
+    p[i] = (2.0 * fs - w) / (2.0 * fs + w);
+  }
+  double sections[4][5] = {
+      {1.0, -1.0, 0.0, -r, 0.0},
+      {1.0, -2.0, 1.0, -2.0 * p[0], p[0] * p[0]},
+      {1.0, -2.0, 1.0, -(p[1] + p[2]), p[1] * p[2]},
+      {1.0, 2.0, 1.0, -2.0 * p[3], p[3] * p[3]},
+  };
+  memcpy(ref->sections, sections, sizeof(sections));
+
+  double ref_hz = fs / 8.0 < 1000.0 ? fs / 8.0 : 1000.0;
+  double omega = 2.0 * M_PI * ref_hz / fs;
+  double gain = pow(10.0, acoustics_reference_a_weighting_db(ref_hz) / 20.0);
+  for (int i = 1; i < 4; ++i) {
+    gain /= section_gain(ref->sections[i], omega);
+  }
+  for (int i = 0; i < 3; ++i) {
+    ref->sections[3][i] *= gain;
+  }
+
+  ref->fast_alpha = 1.0 - exp(-1.0 / (fs * REF_FAST_TAU_S));
+  ref->level_offset_db = -20.0 * log10(mv_per_pa * REF_PRESSURE_PA);
+  ref->dc_offset_mv = dc_offset_mv;
+  ref->level_interval = (uint32_t)((uint64_t)sample_rate_hz * level_interval_ms / 1000U);
+  ref->settle = (uint32_t)((uint64_t)sample_rate_hz * settle_ms / 1000U);
+}
+void
+acoustics_reference_free(acoustics_reference *ref) {
+  free(ref->levels);
+  ref->levels = NULL;
+}
+
+void
+acoustics_reference_feed(acoustics_reference *ref, const uint16_t *samples_mv, uint32_t count) {
+  for (uint32_t n = 0; n < count; ++n) {
+    double y = (double)((int32_t)samples_mv[n] - ref->dc_offset_mv);
+    for (int i = 0; i < 4; ++i) {
+      const double *s = ref->sections[i];
+      double *z = ref->state[i];
+      double x = y;
+      y = s[0] * x + z[0];
+      z[0] = s[1] * x - s[3] * y + z[1];
+      z[1] = s[2] * x - s[4] * y;
+    }
+    ref->fast += ref->fast_alpha * (y * y - ref->fast);
+
+    uint64_t index = ref->index++;
+    if (index < ref->settle)
+      continue;
+
+    ref->energy += y * y;
+    ref->samples++;
+    ref->fast_max = ref->fast > ref->fast_max ? ref->fast : ref->fast_max;
+
+    if ((index - ref->settle + 1U) % ref->level_interval == 0U) {
+      if (ref->level_count == ref->level_capacity) {
+        ref->level_capacity = ref->level_capacity ? ref->level_capacity * 2U : 64U;
+        ref->levels = realloc(ref->levels, ref->level_capacity * sizeof(double));
+      }
+      ref->levels[ref->level_count++] = to_db(ref, ref->fast);
+    }
+  }
+}
+
+void
+acoustics_reference_close(acoustics_reference *ref, double *out_laeq_db, double *out_lafmax_db, double *out_la90_db) {
+  *out_laeq_db = ref->samples ? to_db(ref, ref->energy / ref->samples) : 0.0;
+  *out_lafmax_db = ref->samples ? to_db(ref, ref->fast_max) : 0.0;
+  *out_la90_db = 0.0;
+  if (ref->level_count) {
+    qsort(ref->levels, ref->level_count, sizeof(double), compare_levels);
+    *out_la90_db = ref->levels[(uint64_t)ref->level_count * REF_LA90_PERCENTILE / 100U];
+  }
+
+  ref->energy = 0.0;
+  ref->samples = 0;
+  ref->fast_max = 0.0;
+  ref->level_count = 0;
+}
+
+double
+acoustics_reference_a_weighting_db(double freq_hz) {
+  double f2 = freq_hz * freq_hz;
+  double p1 = poles_hz[0] * poles_hz[0];
+  double p2 = poles_hz[1] * poles_hz[1];
+  double p3 = poles_hz[2] * poles_hz[2];
+  double p4 = poles_hz[3] * poles_hz[3];
+
+  return 20.0 * log10(p4 * f2 * f2 / ((f2 + p1) * sqrt((f2 + p2) * (f2 + p3)) * (f2 + p4))) + 2.0;
+}
+
+static double
+section_gain(const double *s, double omega) {
+  double num_re = s[0] + s[1] * cos(omega) + s[2] * cos(2.0 * omega);
+  double num_im = -s[1] * sin(omega) - s[2] * sin(2.0 * omega);
+  double den_re = 1.0 + s[3] * cos(omega) + s[4] * cos(2.0 * omega);
+  double den_im = -s[3] * sin(omega) - s[4] * sin(2.0 * omega);
+  return sqrt((num_re * num_re + num_im * num_im) / (den_re * den_re + den_im * den_im));
+}
+static double
+to_db(const acoustics_reference *ref, double mean_square) {
+  if (mean_square <= 1e-12)
+    return 0.0;
+
+  double db = 10.0 * log10(mean_square) + ref->level_offset_db;
+  return db > 0.0 ? db : 0.0;
+}
+static int
+compare_levels(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef ACOUSTICS_REFERENCE_H
+#define ACOUSTICS_REFERENCE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Straightforward double precision version of the sound_meter A-weighting stage: transposed direct form biquads,
+ * per sample Fast envelope and exact percentiles over every sampled level. Only used to check the firmware path.
+ */
+typedef struct {
+  double sections[4][5]; // b0 b1 b2 a1 a2, DC blocker first
+  double state[4][2];
+  double fast_alpha;
+  double fast;
+  double level_offset_db;
+  int32_t dc_offset_mv;
+
+  uint32_t level_interval;
+  uint32_t settle;
+  uint64_t index;
+
+  double energy;
+  uint64_t samples;
+  double fast_max;
+  double *levels;
+  uint32_t level_count;
+  uint32_t level_capacity;
+} acoustics_reference;
+
+void
+acoustics_reference_init(acoustics_reference *ref, uint32_t sample_rate_hz, double mv_per_pa, uint32_t level_interval_ms,
+                         uint32_t settle_ms, int32_t dc_offset_mv);
+void
+acoustics_reference_free(acoustics_reference *ref);
+
+void
+acoustics_reference_feed(acoustics_reference *ref, const uint16_t *samples_mv, uint32_t count);
+/**
+ * Levels of everything fed since the previous close, in dB SPL
+ */
+void
+acoustics_reference_close(acoustics_reference *ref, double *out_laeq_db, double *out_lafmax_db, double *out_la90_db);
+
+/**
+ * IEC 61672 analog A-weighting, 0 dB at 1 kHz
+ */
+double
+acoustics_reference_a_weighting_db(double freq_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "host_tests.h"
+
+static uint32_t failures;
+
+void
+host_check(const char *name, bool ok) {
+  printf("  %-18s %s\n", name, ok ? "ok" : "FAIL");
+  failures += !ok;
+}
+
+void
+host_check_count(bool ok) {
+  failures += !ok;
+}
+
+uint32_t
+host_check_failures(void) {
+  return failures;
+}
+
+uint64_t
+host_cpu_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t
+host_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef HOST_TESTS_H
+#define HOST_TESTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * One check, printed as a line of its own and counted when it fails
+ */
+void
+host_check(const char *name, bool ok);
+/**
+ * Counts a check that printed its own line, for checks that show their figures next to the verdict
+ */
+void
+host_check_count(bool ok);
+uint32_t
+host_check_failures(void);
+
+uint64_t
+host_cpu_ns(void); // CPU time of the calling thread, for the benchmarks
+uint64_t
+host_now_ns(void);
+
+/* The suites, each a component or two, run by main.c in this order */
+void
+test_adc_module(void);
+void
+test_bme69x(void);
+void
+test_grid_composer(void);
+void
+test_i2c_arbiter(void);
+void
+test_sound_meter(void);
+void
+test_state_store(void);
+void
+test_stream_stats(void);
+void
+test_temp_fusion(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
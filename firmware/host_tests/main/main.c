@@ -0,0 +1,59 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_tests.h"
+
+#define HOST_TESTS_ENV "HOST_TESTS" /* comma separated suite names, all of them when unset */
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} host_suite;
+
+static const host_suite suites[] = {
+    {"adc_module", test_adc_module},
+    {"bme69x", test_bme69x},
+    {"grid_composer", test_grid_composer},
+    {"i2c_arbiter", test_i2c_arbiter},
+    {"sound_meter", test_sound_meter},
+    {"state_store", test_state_store},
+    {"stream_stats", test_stream_stats},
+    {"temp_fusion", test_temp_fusion},
+};
+
+static bool
+is_selected(const char *selection, const char *name);
+
+void
+app_main(void) {
+  const char *selection = getenv(HOST_TESTS_ENV);
+  uint8_t ran = 0;
+  for (uint8_t i = 0; i < sizeof(suites) / sizeof(suites[0]); ++i) {
+    if (selection && *selection && !is_selected(selection, suites[i].name))
+      continue;
+    printf("== %s\n", suites[i].name);
+    suites[i].run();
+    ++ran;
+  }
+  if (!ran) {
+    printf("FAIL, no suite matches %s=%s\n", HOST_TESTS_ENV, selection);
+    exit(1);
+  }
+
+  uint32_t failures = host_check_failures();
+  printf("%s, %u suites, %" PRIu32 " failed checks\n", failures ? "FAIL" : "PASS", ran, failures);
+  exit(failures ? 1 : 0);
+}
+
+static bool
+is_selected(const char *selection, const char *name) {
+  size_t len = strlen(name);
+  for (const char *item = selection; item; item = strchr(item, ',')) {
+    item += *item == ',';
+    if (strncmp(item, name, len) == 0 && (item[len] == ',' || item[len] == '\0'))
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,525 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adc_trace.h"
+#include "private/adc_decimator.h"
+#include "private/adc_mv_lut.h"
+
+#include "host_tests.h"
+
+#define HOST_OUTPUT_RATE_HZ 2000U // ADC_SOUND_SENSOR_SAMPLE_FREQ
+#define HOST_OVERSAMPLING   16U
+#define HOST_INPUT_RATE_HZ  (HOST_OUTPUT_RATE_HZ * HOST_OVERSAMPLING)
+#define HOST_INPUT_BITS     12U
+#define HOST_FRAC_BITS      3U
+#define HOST_FRAME_SAMPLES  200U // ADC_CONT_FRAME_SAMPLES
+#define HOST_OUTPUTS        8192U
+#define HOST_INPUTS         (HOST_OUTPUTS * HOST_OVERSAMPLING)
+#define HOST_SETTLE         64U // outputs dropped while the filters fill
+#define HOST_BENCH_ROUNDS   50U
+
+#define HOST_MIN_ENOB_GAIN     1.5  // four times the rate buys 1 bit of white noise, sixteen times 2
+#define HOST_MAX_QUIET_ERROR   0.05 // relative amplitude error of a sub-LSB tone
+#define HOST_MAX_PASSBAND_DB   0.15 // half-band chain up to HOST_PASSBAND_EDGE of the output rate
+#define HOST_PASSBAND_EDGE     0.35
+#define HOST_MIN_ALIAS_REJECT  60.0 // half-band chain, aliases folding below HOST_PASSBAND_EDGE
+
+#define HOST_LUT_BITS    12U
+#define HOST_LUT_SAMPLES 204800U
+#define HOST_LUT_MAX_MV  3100.0 // roughly the S3 at 12 dB attenuation
+
+#define HOST_TRACE_PATH     "adc_module_trace.adct"
+#define HOST_TRACE_RECORDS  5U
+#define HOST_TRACE_CAPACITY 256U // replay block, the 600 sample record is split in three
+
+typedef struct {
+  const char *name;
+  uint8_t order;
+  bool use_halfband;
+} host_chain;
+
+typedef struct {
+  double amplitude;
+  double offset;
+  double residual_rms;
+} host_fit;
+
+static const host_chain chains[] = {
+    {"box average", 1U, false},
+    {"CIC3", 3U, false},
+    {"CIC3 + half-band", 3U, true},
+};
+
+static uint16_t inputs[HOST_INPUTS];
+static uint16_t outputs[HOST_INPUTS];
+static uint32_t rng_state = 1U;
+static uint32_t fake_cali_calls;
+
+static void
+check_enob(void);
+static void
+check_quiet(void);
+static void
+check_response(void);
+static void
+check_mv_lut(void);
+static void
+check_trace(void);
+static void
+bench(void);
+
+static void
+synthesize(double freq_hz, double amplitude, double offset, double noise_lsb);
+static uint32_t
+decimate(const host_chain *chain, uint8_t frac_bits);
+static void
+fit_sine(const uint16_t *data, uint32_t count, double rate_hz, double freq_hz, double scale, host_fit *out_fit);
+static esp_err_t
+fake_cali_raw_to_voltage(void *user_ctx, int raw, int *out_mv);
+static double
+enob(const host_fit *fit);
+static double
+gauss(void);
+static uint32_t
+rng_next(void);
+
+void
+test_adc_module(void) {
+  check_enob();
+  check_quiet();
+  check_response();
+  check_mv_lut();
+  check_trace();
+  bench();
+
+}
+
+/**
+ * Near full-scale tone with a LSB of white noise, as the bare ADC sees it and after each chain
+ */
+static void
+check_enob(void) {
+  const double freq_hz = 251.0;
+  printf("[ENOB, %u Hz tone, 1 LSB rms noise, %u x %u Hz]\n", (unsigned)freq_hz, HOST_OVERSAMPLING, HOST_OUTPUT_RATE_HZ);
+  synthesize(freq_hz, 1900.0, 2048.0, 1.0);
+
+  host_fit fit;
+  fit_sine(inputs, HOST_INPUTS, HOST_INPUT_RATE_HZ, freq_hz, 1.0, &fit);
+  double raw_enob = enob(&fit);
+  printf("  %-18s %.2f bits\n", "raw input", raw_enob);
+
+  // Every 16th sample, the rate the sound task used to run at
+  for (uint32_t i = 0; i < HOST_OUTPUTS; ++i) {
+    outputs[i] = inputs[i * HOST_OVERSAMPLING];
+  }
+  fit_sine(outputs, HOST_OUTPUTS, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0, &fit);
+  printf("  %-18s %.2f bits\n", "plain decimation", enob(&fit));
+
+  for (uint8_t c = 0; c < sizeof(chains) / sizeof(chains[0]); ++c) {
+    uint32_t count = decimate(&chains[c], HOST_FRAC_BITS);
+    fit_sine(&outputs[HOST_SETTLE], count - HOST_SETTLE, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0 / (1U << HOST_FRAC_BITS),
+             &fit);
+    double gain = enob(&fit) - raw_enob;
+    bool ok = gain >= HOST_MIN_ENOB_GAIN;
+    printf("  %-18s %.2f bits, %+.2f %s\n", chains[c].name, enob(&fit), gain, ok ? "ok" : "FAIL");
+    host_check_count(ok);
+  }
+}
+/**
+ * Quiet night: a tone below one code on a code boundary, the noise acting as dither
+ */
+static void
+check_quiet(void) {
+  const double freq_hz = 125.0;
+  const double amplitude = 0.6;
+  printf("[quiet, %.1f LSB tone at 2048.5, 0.5 LSB rms noise]\n", amplitude);
+  synthesize(freq_hz, amplitude, 2048.5, 0.5);
+
+  host_fit fit;
+  for (uint32_t i = 0; i < HOST_OUTPUTS; ++i) {
+    outputs[i] = inputs[i * HOST_OVERSAMPLING];
+  }
+  fit_sine(outputs, HOST_OUTPUTS, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0, &fit);
+  printf("  %-18s amplitude %.3f LSB, residual %.3f LSB rms\n", "plain decimation", fit.amplitude, fit.residual_rms);
+
+  uint32_t count = decimate(&chains[2], HOST_FRAC_BITS);
+  fit_sine(&outputs[HOST_SETTLE], count - HOST_SETTLE, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0 / (1U << HOST_FRAC_BITS), &fit);
+  bool ok = fabs(fit.amplitude / amplitude - 1.0) <= HOST_MAX_QUIET_ERROR && fabs(fit.offset - 2048.5) < 0.05;
+  printf("  %-18s amplitude %.3f LSB, offset %.3f, residual %.3f LSB rms %s\n", chains[2].name, fit.amplitude,
+         fit.offset, fit.residual_rms, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+}
+/**
+ * Gain of in-band tones and of tones above the output Nyquist that fold back into the band
+ */
+static void
+check_response(void) {
+  static const double fractions[] = {0.05, 0.1, 0.2, 0.3, 0.35, 0.4, 0.45};
+  printf("[response in dB, tone at a fraction of %u Hz, alias at 1 - fraction]\n", HOST_OUTPUT_RATE_HZ);
+  printf("  %-18s", "fraction");
+  for (uint8_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); ++f) {
+    printf(" %7.2f", fractions[f]);
+  }
+  printf("\n");
+
+  for (uint8_t c = 0; c < sizeof(chains) / sizeof(chains[0]); ++c) {
+    double passband[sizeof(fractions) / sizeof(fractions[0])];
+    double alias[sizeof(fractions) / sizeof(fractions[0])];
+    for (uint8_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); ++f) {
+      host_fit fit;
+      double freq_hz = fractions[f] * HOST_OUTPUT_RATE_HZ;
+      synthesize(freq_hz, 1000.0, 2048.0, 0.0);
+      uint32_t count = decimate(&chains[c], HOST_FRAC_BITS);
+      fit_sine(&outputs[HOST_SETTLE], count - HOST_SETTLE, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0 / (1U << HOST_FRAC_BITS),
+               &fit);
+      passband[f] = 20.0 * log10(fit.amplitude / 1000.0);
+
+      synthesize(HOST_OUTPUT_RATE_HZ - freq_hz, 1000.0, 2048.0, 0.0);
+      count = decimate(&chains[c], HOST_FRAC_BITS);
+      fit_sine(&outputs[HOST_SETTLE], count - HOST_SETTLE, HOST_OUTPUT_RATE_HZ, freq_hz, 1.0 / (1U << HOST_FRAC_BITS),
+               &fit);
+      alias[f] = 20.0 * log10(fit.amplitude / 1000.0 + 1e-9);
+    }
+
+    bool ok = true;
+    printf("  %-18s", chains[c].name);
+    for (uint8_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); ++f) {
+      printf(" %7.2f", passband[f]);
+      if (chains[c].use_halfband && fractions[f] <= HOST_PASSBAND_EDGE) {
+        ok = ok && fabs(passband[f]) <= HOST_MAX_PASSBAND_DB;
+      }
+    }
+    printf("\n  %-18s", "  alias");
+    for (uint8_t f = 0; f < sizeof(fractions) / sizeof(fractions[0]); ++f) {
+      printf(" %7.2f", alias[f]);
+      if (chains[c].use_halfband && fractions[f] <= HOST_PASSBAND_EDGE) {
+        ok = ok && alias[f] <= -HOST_MIN_ALIAS_REJECT;
+      }
+    }
+    printf("%s\n", chains[c].use_halfband ? (ok ? "  ok" : "  FAIL") : "");
+    host_check_count(ok);
+  }
+}
+
+/**
+ * The conversion table against the calibration it was built from, a fake curve fitting scheme with a bent and noisy
+ * curve in place of the driver: every random code must give the calibration's millivolts, the calibration must only
+ * run while the table is built, and oversampled codes must interpolate between the two entries they sit between
+ */
+static void
+check_mv_lut(void) {
+  static uint16_t table[ADC_MV_LUT_LEN(HOST_LUT_BITS)];
+  printf("[conversion table, %u bit codes, %u random samples]\n", HOST_LUT_BITS, HOST_LUT_SAMPLES);
+
+  adc_mv_lut lut;
+  fake_cali_calls = 0;
+  bool ok = adc_mv_lut_build(&lut, table, HOST_LUT_BITS, fake_cali_raw_to_voltage, NULL) == ESP_OK &&
+            lut.len == ADC_MV_LUT_LEN(HOST_LUT_BITS) && fake_cali_calls == lut.len;
+  printf("  %-18s %" PRIu32 " calibration calls %s\n", "build", fake_cali_calls, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+  if (!ok)
+    return;
+
+  uint32_t mismatches = 0;
+  uint32_t build_calls = fake_cali_calls;
+  uint64_t lut_ns = 0;
+  uint64_t cali_ns = 0;
+  for (uint32_t i = 0; i < HOST_LUT_SAMPLES; i += HOST_INPUTS) {
+    uint32_t count = HOST_LUT_SAMPLES - i < HOST_INPUTS ? HOST_LUT_SAMPLES - i : HOST_INPUTS;
+    for (uint32_t j = 0; j < count; ++j) {
+      inputs[j] = (uint16_t)(rng_next() & (lut.len - 1U));
+    }
+
+    uint64_t start = host_cpu_ns();
+    for (uint32_t j = 0; j < count; ++j) {
+      outputs[j] = lut.table[inputs[j]];
+    }
+    lut_ns += host_cpu_ns() - start;
+
+    uint32_t calls = fake_cali_calls;
+    start = host_cpu_ns();
+    for (uint32_t j = 0; j < count; ++j) {
+      int mv = 0;
+      fake_cali_raw_to_voltage(NULL, inputs[j], &mv);
+      mismatches += outputs[j] != (uint16_t)mv;
+    }
+    cali_ns += host_cpu_ns() - start;
+    fake_cali_calls = calls;
+  }
+  ok = mismatches == 0U && fake_cali_calls == build_calls;
+  printf("  %-18s %" PRIu32 " mismatches, %.1f ns table, %.1f ns calibration %s\n", "codes", mismatches,
+         (double)lut_ns / HOST_LUT_SAMPLES, (double)cali_ns / HOST_LUT_SAMPLES, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+
+  // Oversampled codes, the top code and its fractions clamp to the last entry
+  mismatches = 0;
+  for (uint32_t i = 0; i < HOST_INPUTS; ++i) {
+    inputs[i] = (uint16_t)(rng_next() & ((lut.len << HOST_FRAC_BITS) - 1U));
+    outputs[i] = inputs[i];
+  }
+  adc_mv_lut_codes_to_mv(&lut, outputs, HOST_INPUTS, HOST_FRAC_BITS);
+  for (uint32_t i = 0; i < HOST_INPUTS; ++i) {
+    uint32_t code = inputs[i] >> HOST_FRAC_BITS;
+    uint32_t frac = inputs[i] & ((1U << HOST_FRAC_BITS) - 1U);
+    int lower = 0;
+    int upper = 0;
+    fake_cali_raw_to_voltage(NULL, (int)code, &lower);
+    fake_cali_raw_to_voltage(NULL, (int)(code + 1U < lut.len ? code + 1U : code), &upper);
+    int32_t want = (lower << HOST_FRAC_BITS) + (upper - lower) * (int32_t)frac;
+    mismatches += outputs[i] != (uint16_t)want;
+  }
+  ok = mismatches == 0U;
+  printf("  %-18s %" PRIu32 " mismatches over %u samples with %u fraction bits %s\n", "oversampled", mismatches,
+         HOST_INPUTS, HOST_FRAC_BITS, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+
+  // A calibration failing part way leaves no table behind
+  fake_cali_calls = 0;
+  ok = adc_mv_lut_build(&lut, table, HOST_LUT_BITS + 1U, fake_cali_raw_to_voltage, NULL) != ESP_OK && !lut.table &&
+       lut.len == 0U;
+  printf("  %-18s %s\n", "failed build", ok ? "ok" : "FAIL");
+  host_check_count(ok);
+}
+
+/**
+ * Records written the way the firmware captures them, a truncated one at the end, read back by both replay calls
+ */
+static void
+check_trace(void) {
+  static const uint32_t counts[HOST_TRACE_RECORDS] = {200U, 200U, 0U, 600U, 200U};
+  static const uint32_t drops[HOST_TRACE_RECORDS] = {0U, 3U, 1U, 0U, 0U};
+  printf("[trace round trip, %u records, %u sample replay blocks]\n", HOST_TRACE_RECORDS, HOST_TRACE_CAPACITY);
+
+  FILE *file = fopen(HOST_TRACE_PATH, "wb");
+  if (!file) {
+    printf("  cannot write %s FAIL\n", HOST_TRACE_PATH);
+    host_check_count(false);
+    return;
+  }
+  static uint8_t record[ADC_TRACE_RECORD_SIZE(600U)];
+  uint32_t written = 0;
+  uint64_t timestamp_us = 1000000U;
+  for (uint8_t r = 0; r < HOST_TRACE_RECORDS; ++r) {
+    for (uint32_t i = 0; i < counts[r]; ++i) {
+      outputs[i] = (uint16_t)(((written + i) * 37U) % 26400U); // up to 3300 mV in 1/8 mV
+    }
+    adc_module_block_t block = {
+        .samples = outputs,
+        .count = counts[r],
+        .capacity = counts[r],
+        .frac_bits = HOST_FRAC_BITS,
+        .frames_dropped = drops[r],
+    };
+    written += counts[r];
+    timestamp_us += counts[r] * 1000000ULL / HOST_OUTPUT_RATE_HZ;
+    uint32_t len = 0;
+    adc_trace_encode(&block, HOST_OUTPUT_RATE_HZ, timestamp_us, record, sizeof(record), &len);
+    // The last record is cut short, as a capture stopped mid-message would leave it
+    fwrite(record, 1, r + 1U < HOST_TRACE_RECORDS ? len : len / 2U, file);
+  }
+  fclose(file);
+  written -= counts[HOST_TRACE_RECORDS - 1U];
+
+  struct adc_trace_replay_config_t replay_cfg = {.path = HOST_TRACE_PATH};
+  adc_trace_replay_handle replay = NULL;
+  uint32_t rate_hz = 0;
+  uint8_t frac_bits = 0;
+  bool ok = adc_trace_replay_open(&replay_cfg, &replay) == ESP_OK &&
+            adc_trace_replay_get_format(replay, &rate_hz, &frac_bits) == ESP_OK && rate_hz == HOST_OUTPUT_RATE_HZ &&
+            frac_bits == HOST_FRAC_BITS;
+
+  // Blocks: same samples, drops and a timestamp after each block's last sample
+  uint16_t samples[HOST_TRACE_CAPACITY];
+  adc_module_block_t block = {.samples = samples, .capacity = HOST_TRACE_CAPACITY};
+  uint32_t replayed = 0;
+  uint32_t dropped = 0;
+  uint32_t blocks = 0;
+  bool in_order = true;
+  while (ok && adc_trace_replay_next_block(replay, &block, &timestamp_us) == ESP_OK) {
+    for (uint32_t i = 0; i < block.count; ++i) {
+      in_order = in_order && block.samples[i] == ((replayed + i) * 37U) % 26400U;
+    }
+    replayed += block.count;
+    dropped += block.frames_dropped;
+    in_order = in_order && timestamp_us == 1000000U + replayed * 1000000ULL / HOST_OUTPUT_RATE_HZ;
+    ++blocks;
+  }
+  ok = ok && in_order && replayed == written && dropped == 4U && blocks == 5U;
+  if (replay) {
+    adc_trace_replay_close(replay);
+  }
+  printf("  %-18s %" PRIu32 " samples in %" PRIu32 " blocks, %" PRIu32 " frames dropped %s\n", "next_block", replayed, blocks,
+         dropped, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+
+  // Whole millivolts, rounded the way adc_module_get_data does
+  replay = NULL;
+  ok = adc_trace_replay_open(&replay_cfg, &replay) == ESP_OK;
+  replayed = 0;
+  in_order = true;
+  uint32_t data[77];
+  uint32_t read = 0;
+  while (ok && adc_trace_replay_get_data(replay, sizeof(data) / sizeof(data[0]), data, &read) == ESP_OK) {
+    for (uint32_t i = 0; i < read; ++i) {
+      in_order = in_order && data[i] == (((replayed + i) * 37U) % 26400U + 4U) >> HOST_FRAC_BITS;
+    }
+    replayed += read;
+  }
+  ok = ok && in_order && replayed == written;
+  if (replay) {
+    adc_trace_replay_close(replay);
+  }
+  printf("  %-18s %" PRIu32 " samples %s\n", "get_data", replayed, ok ? "ok" : "FAIL");
+  host_check_count(ok);
+  remove(HOST_TRACE_PATH);
+}
+
+/**
+ * Frames of the size the demux task hands over, per output sample
+ */
+static void
+bench(void) {
+  synthesize(251.0, 1900.0, 2048.0, 1.0);
+  printf("[bench] ns/output sample at %u x oversampling:", HOST_OVERSAMPLING);
+  for (uint8_t c = 0; c < sizeof(chains) / sizeof(chains[0]); ++c) {
+    adc_decimator decimator;
+    struct adc_decimator_config_t decimator_cfg = {
+        .factor = HOST_OVERSAMPLING,
+        .order = chains[c].order,
+        .frac_bits = HOST_FRAC_BITS,
+        .input_bits = HOST_INPUT_BITS,
+        .use_halfband = chains[c].use_halfband,
+    };
+    adc_decimator_init(&decimator, &decimator_cfg);
+
+    uint64_t elapsed_ns = 0;
+    uint64_t produced = 0;
+    for (uint32_t round = 0; round < HOST_BENCH_ROUNDS; ++round) {
+      uint64_t start = host_cpu_ns();
+      for (uint32_t offset = 0; offset < HOST_INPUTS; offset += HOST_FRAME_SAMPLES) {
+        uint32_t len = HOST_INPUTS - offset < HOST_FRAME_SAMPLES ? HOST_INPUTS - offset : HOST_FRAME_SAMPLES;
+        produced += adc_decimator_process(&decimator, &inputs[offset], len, outputs);
+      }
+      elapsed_ns += host_cpu_ns() - start;
+    }
+    printf(" %s %.1f%s", chains[c].name, (double)elapsed_ns / produced, c + 1U < sizeof(chains) / sizeof(chains[0]) ? "," : "");
+  }
+  printf("\n");
+}
+
+static void
+synthesize(double freq_hz, double amplitude, double offset, double noise_lsb) {
+  const double max_code = (1U << HOST_INPUT_BITS) - 1U;
+  for (uint32_t i = 0; i < HOST_INPUTS; ++i) {
+    double v = offset + amplitude * sin(2.0 * M_PI * freq_hz * i / HOST_INPUT_RATE_HZ) + noise_lsb * gauss();
+    v = floor(v + 0.5);
+    inputs[i] = (uint16_t)(v < 0.0 ? 0.0 : (v > max_code ? max_code : v));
+  }
+}
+/**
+ * Runs the inputs through a fresh decimator in frames, outputs land in place of the inputs they came from
+ */
+static uint32_t
+decimate(const host_chain *chain, uint8_t frac_bits) {
+  adc_decimator decimator;
+  struct adc_decimator_config_t decimator_cfg = {
+      .factor = HOST_OVERSAMPLING,
+      .order = chain->order,
+      .frac_bits = frac_bits,
+      .input_bits = HOST_INPUT_BITS,
+      .use_halfband = chain->use_halfband,
+  };
+  if (adc_decimator_init(&decimator, &decimator_cfg) != ESP_OK) {
+    printf("  %s does not initialise\n", chain->name);
+    host_check_count(false);
+    return HOST_SETTLE;
+  }
+
+  memcpy(outputs, inputs, sizeof(inputs));
+  uint32_t count = 0;
+  for (uint32_t offset = 0; offset < HOST_INPUTS; offset += HOST_FRAME_SAMPLES) {
+    uint32_t len = HOST_INPUTS - offset < HOST_FRAME_SAMPLES ? HOST_INPUTS - offset : HOST_FRAME_SAMPLES;
+    count += adc_decimator_process(&decimator, &outputs[offset], len, &outputs[count]);
+  }
+  return count;
+}
+/**
+ * Least squares fit of offset + a cos + b sin at a known frequency, IEEE 1057 three parameter
+ */
+static void
+fit_sine(const uint16_t *data, uint32_t count, double rate_hz, double freq_hz, double scale, host_fit *out_fit) {
+  double s[3][3] = {{0}};
+  double r[3] = {0};
+  for (uint32_t i = 0; i < count; ++i) {
+    double basis[3] = {cos(2.0 * M_PI * freq_hz * i / rate_hz), sin(2.0 * M_PI * freq_hz * i / rate_hz), 1.0};
+    double y = data[i] * scale;
+    for (uint8_t j = 0; j < 3; ++j) {
+      r[j] += basis[j] * y;
+      for (uint8_t k = 0; k < 3; ++k) {
+        s[j][k] += basis[j] * basis[k];
+      }
+    }
+  }
+
+  // Cramer's rule on the 3x3 normal equations
+  double det = s[0][0] * (s[1][1] * s[2][2] - s[1][2] * s[2][1]) - s[0][1] * (s[1][0] * s[2][2] - s[1][2] * s[2][0]) +
+               s[0][2] * (s[1][0] * s[2][1] - s[1][1] * s[2][0]);
+  double x[3];
+  for (uint8_t j = 0; j < 3; ++j) {
+    double m[3][3];
+    memcpy(m, s, sizeof(m));
+    for (uint8_t k = 0; k < 3; ++k) {
+      m[k][j] = r[k];
+    }
+    x[j] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+            m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) /
+           det;
+  }
+
+  double residual = 0.0;
+  for (uint32_t i = 0; i < count; ++i) {
+    double model = x[0] * cos(2.0 * M_PI * freq_hz * i / rate_hz) + x[1] * sin(2.0 * M_PI * freq_hz * i / rate_hz) + x[2];
+    double e = data[i] * scale - model;
+    residual += e * e;
+  }
+  out_fit->amplitude = hypot(x[0], x[1]);
+  out_fit->offset = x[2];
+  out_fit->residual_rms = sqrt(residual / count);
+}
+/**
+ * Stand-in for adc_cali_raw_to_voltage with the curve fitting scheme: bent, with the odd code a millivolt off, and out of
+ * range codes refused like the driver does
+ */
+static esp_err_t
+fake_cali_raw_to_voltage(void *user_ctx, int raw, int *out_mv) {
+  ++fake_cali_calls;
+  if (raw < 0 || raw >= (int)ADC_MV_LUT_LEN(HOST_LUT_BITS))
+    return ESP_ERR_INVALID_ARG;
+
+  double x = raw / (double)(ADC_MV_LUT_LEN(HOST_LUT_BITS) - 1U);
+  *out_mv = (int)(HOST_LUT_MAX_MV * x + 90.0 * x * x - 60.0 * x * x * x + 0.5) + (raw * 7) % 3;
+  return ESP_OK;
+}
+static double
+enob(const host_fit *fit) {
+  double sinad_db = 20.0 * log10(fit->amplitude / M_SQRT2 / fit->residual_rms);
+  return (sinad_db - 1.76) / 6.02;
+}
+static double
+gauss(void) {
+  // Box-Muller, the second value is not worth keeping
+  double u1 = (rng_next() + 1.0) / 4294967297.0;
+  double u2 = rng_next() / 4294967296.0;
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+static uint32_t
+rng_next(void) {
+  rng_state ^= rng_state << 13U;
+  rng_state ^= rng_state >> 17U;
+  rng_state ^= rng_state << 5U;
+  return rng_state;
+}
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "BME69xMockBus.h"
+#include "BME69xSensor.h"
+
+#include "host_tests.h"
+
+#define HOST_HEATER_TEMP 320U // BSEC's forced IAQ step
+#define HOST_HEATER_DUR  100U
+#define HOST_TEMP_ADC    500000U
+#define HOST_PRES_ADC    400000U
+#define HOST_HUM_ADC     22000U
+#define HOST_GAS_ADC     600U
+#define HOST_GAS_RANGE   4U
+
+
+static void
+check_calibration();
+static void
+check_heater_encoding();
+static void
+check_parallel_order();
+static void
+check_parallel_resume();
+static void
+check_sequential();
+static void
+check_statuses();
+static void
+check_unique_id();
+static void
+check_transactions();
+
+static void
+load_chip(BME69xMockBus &bus);
+static void
+put_field(BME69xMockBus &bus, uint8_t index, bool isNew, uint8_t gasIndex, uint8_t measIndex, uint32_t tempAdc);
+static void
+put16(uint8_t *regs, uint8_t lsbReg, int32_t value);
+
+void
+test_bme69x(void) {
+  check_calibration();
+  check_heater_encoding();
+  check_parallel_order();
+  check_parallel_resume();
+  check_sequential();
+  check_statuses();
+  check_unique_id();
+  check_transactions();
+
+}
+
+/**
+ * Coefficients spread over the three blocks, and a forced cycle compensated to room values
+ */
+static void
+check_calibration() {
+  printf("[calibration and compensation]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  host_check("begin", sensor.begin() == BME6xxStatus::OK);
+
+  sensor.bme6xxSetOS(BME6xxOversampling::X2, BME6xxOversampling::X16, BME6xxOversampling::X1);
+  sensor.bme6xxSetHeaterProf(HOST_HEATER_TEMP, HOST_HEATER_DUR);
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  put_field(bus, 0, true, 0, 0, HOST_TEMP_ADC);
+
+  BME6xxData data = {};
+  bool ok = sensor.bme6xxFetchData() == 1U && sensor.bme6xxGetData(data) == 0U;
+  printf("  %.2f C, %.1f Pa, %.2f %%, %.0f ohm\n", data.temperature, data.pressure, data.humidity, data.gas_resistance);
+  host_check("room values", ok && data.temperature > 10.0f && data.temperature < 40.0f && data.pressure > 80000.0f &&
+                            data.pressure < 120000.0f && data.humidity > 0.0f && data.humidity < 100.0f &&
+                            data.gas_resistance > 0.0f);
+  host_check("status bits",
+         ok && (data.status & NEW_DATA_MSK) && (data.status & GASM_VALID_MSK) && (data.status & HEAT_STAB_MSK));
+}
+/**
+ * gas_wait and res_heat of a forced step, the shared duration and multipliers of a parallel profile
+ */
+static void
+check_heater_encoding() {
+  printf("[heater encoding]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  // 100 ms is 25 in steps of 4 ms, factor code 1
+  sensor.bme6xxSetHeaterProf(HOST_HEATER_TEMP, HOST_HEATER_DUR);
+  bool ok = sensor.bme6xxCheckStatus() == BME6xxStatus::OK && bus.regs[BME69X_REG_GAS_WAIT0] == 0x59U &&
+            bus.regs[BME69X_REG_CTRL_GAS_1] == 0x20U && bus.regs[BME69X_REG_CTRL_GAS_0] == 0U;
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  put_field(bus, 0, true, 0, 0, HOST_TEMP_ADC);
+  BME6xxData data = {};
+  sensor.bme6xxFetchData();
+  sensor.bme6xxGetData(data);
+  host_check("forced step", ok && data.res_heat == bus.regs[BME69X_REG_RES_HEAT0] && data.gas_wait == 0x59U);
+
+  uint16_t temps[3] = {320U, 100U, 200U};
+  uint16_t muls[3] = {5U, 2U, 10U};
+  sensor.bme6xxSetHeaterProf(temps, muls, 0, 3);
+  host_check("no shared duration", sensor.bme6xxCheckStatus() == BME6xxStatus::WARNING_DEFINE_SHD_HEATR_DUR);
+
+  // 140 ms less the measurement, in steps of 0.477 ms
+  sensor.bme6xxSetHeaterProf(temps, muls, 140, 3);
+  host_check("parallel profile", sensor.bme6xxCheckStatus() == BME6xxStatus::OK && bus.regs[BME69X_REG_SHD_HEATR] == 146U &&
+                                 bus.regs[BME69X_REG_GAS_WAIT0] == 5U && bus.regs[BME69X_REG_GAS_WAIT0 + 1U] == 2U &&
+                                 bus.regs[BME69X_REG_GAS_WAIT0 + 2U] == 10U &&
+                                 (bus.regs[BME69X_REG_CTRL_GAS_1] & 0x0FU) == 3U);
+}
+/**
+ * Three fields of a parallel burst across the meas_index wrap come out oldest first, an old one sorts last
+ */
+static void
+check_parallel_order() {
+  printf("[parallel field order]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  uint16_t temps[3] = {320U, 100U, 200U};
+  uint16_t muls[3] = {5U, 2U, 10U};
+  sensor.bme6xxSetHeaterProf(temps, muls, 140, 3);
+  sensor.bme6xxSetOpMode(BME6xxMode::PARALLEL);
+  put_field(bus, 0, true, 1, 0, HOST_TEMP_ADC);
+  put_field(bus, 1, true, 2, 1, HOST_TEMP_ADC + 100U);
+  put_field(bus, 2, true, 0, 255, HOST_TEMP_ADC - 100U);
+
+  BME6xxData all[BME69X_FIELD_COUNT] = {};
+  bool ok = sensor.bme6xxFetchData() == 3U && sensor.bme6xxGetAllData(all, BME69X_FIELD_COUNT) == 3U;
+  host_check("meas_index wrap", ok && all[0].meas_index == 255U && all[1].meas_index == 0U && all[2].meas_index == 1U);
+  host_check("gas_wait per step", ok && all[0].gas_wait == 5U && all[1].gas_wait == 2U && all[2].gas_wait == 10U);
+
+  BME6xxData data = {};
+  ok = sensor.bme6xxGetData(data) == 2U && data.meas_index == 255U;
+  ok = ok && sensor.bme6xxGetData(data) == 1U && data.meas_index == 0U;
+  ok = ok && sensor.bme6xxGetData(data) == 0U && data.meas_index == 1U;
+  host_check("one at a time", ok);
+
+  bus.regs[BME69X_REG_FIELD0] &= 0x7FU;
+  ok = sensor.bme6xxFetchData() == 2U && sensor.bme6xxGetAllData(all, BME69X_FIELD_COUNT) == 2U;
+  host_check("old field dropped", ok && all[0].meas_index == 255U && all[1].meas_index == 1U);
+}
+/**
+ * New oversampling while parallel mode runs: to sleep, write, and back to parallel mode
+ */
+static void
+check_parallel_resume() {
+  printf("[reconfiguration in parallel mode]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  uint16_t temps[3] = {320U, 100U, 200U};
+  uint16_t muls[3] = {5U, 2U, 10U};
+  sensor.bme6xxSetHeaterProf(temps, muls, 140, 3);
+  sensor.bme6xxSetOpMode(BME6xxMode::PARALLEL);
+  bool ok = (bus.regs[BME69X_REG_CTRL_MEAS] & BME69X_MODE_MSK) == 2U;
+
+  bus.readsToSleep = 1;
+  sensor.bme6xxSetOS(BME6xxOversampling::X1, BME6xxOversampling::X4, BME6xxOversampling::X1);
+  host_check("resumed", ok && sensor.bme6xxCheckStatus() == BME6xxStatus::OK &&
+                        (bus.regs[BME69X_REG_CTRL_MEAS] & BME69X_MODE_MSK) == 2U &&
+                        (bus.regs[BME69X_REG_CTRL_MEAS] >> BME69X_OST_POS) == 1U);
+
+  // The parallel measurement is 1 ms shorter than the forced one, as in the Bosch API
+  printf("  parallel %" PRIu32 " us, forced %" PRIu32 " us\n", sensor.bme6xxGetMeasDur(),
+         sensor.bme6xxGetMeasDur(BME6xxMode::FORCED));
+  host_check("measurement time", sensor.bme6xxGetMeasDur() + 1000U == sensor.bme6xxGetMeasDur(BME6xxMode::FORCED));
+}
+/**
+ * Millisecond steps, the standby codes and the mode bits
+ */
+static void
+check_sequential() {
+  printf("[sequential mode]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  uint16_t temps[2] = {320U, 100U};
+  uint16_t durs[2] = {150U, 300U};
+  sensor.bme6xxSetHeaterProfSeq(temps, durs, 2);
+  host_check("step durations", bus.regs[BME69X_REG_GAS_WAIT0] == 101U && bus.regs[BME69X_REG_GAS_WAIT0 + 1U] == 146U &&
+                               (bus.regs[BME69X_REG_CTRL_GAS_1] & 0x0FU) == 2U);
+
+  sensor.bme6xxSetSeqSleep(BME6xxODR::ODR_NONE);
+  bool ok = (bus.regs[BME69X_REG_CTRL_GAS_1] & 0x80U) && (bus.regs[BME69X_REG_CONFIG] >> 5) == 0U;
+  sensor.bme6xxSetSeqSleep(BME6xxODR::ODR_250_MS);
+  host_check("standby", ok && !(bus.regs[BME69X_REG_CTRL_GAS_1] & 0x80U) && (bus.regs[BME69X_REG_CONFIG] >> 5) == 3U);
+
+  sensor.bme6xxSetOpMode(BME6xxMode::SEQUENTIAL);
+  ok = (bus.regs[BME69X_REG_CTRL_MEAS] & BME69X_MODE_MSK) == 3U;
+  sensor.bme6xxSetOpMode(BME6xxMode::SLEEP);
+  host_check("mode bits", ok && (bus.regs[BME69X_REG_CTRL_MEAS] & BME69X_MODE_MSK) == 0U);
+}
+/**
+ * No new data, a failing bus, a failed self test and a chip of another kind
+ */
+static void
+check_statuses() {
+  printf("[statuses]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  sensor.bme6xxSetHeaterProf(HOST_HEATER_TEMP, HOST_HEATER_DUR);
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  uint64_t start_us = bus.nowUs;
+  host_check("no new data", sensor.bme6xxFetchData() == 0U &&
+                            sensor.bme6xxCheckStatus() == BME6xxStatus::WARNING_NO_NEW_DATA);
+  printf("  gave up after %" PRIu64 " us\n", bus.nowUs - start_us);
+
+  bus.isFailing = true;
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  host_check("bus failure", sensor.bme6xxCheckStatus() == BME6xxStatus::ERROR_COM_FAIL);
+  bus.isFailing = false;
+
+  // Steady fields fail the resistance ratio
+  bus.regs[BME69X_REG_IDAC_HEAT0] = 0x40U;
+  put_field(bus, 0, true, 0, 0, HOST_TEMP_ADC);
+  sensor.bme6xxSelftestCheck();
+  host_check("self test", sensor.bme6xxCheckStatus() == BME6xxStatus::ERROR_SELF_TEST);
+
+  BME69xMockBus other_bus;
+  BME69xSensor other(other_bus);
+  host_check("other chip", other.begin() == BME6xxStatus::ERROR_DEV_NOT_FOUND);
+}
+static void
+check_unique_id() {
+  printf("[unique id]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+
+  bus.regs[BME69X_REG_UNIQUE_ID] = 0x11U;
+  bus.regs[BME69X_REG_UNIQUE_ID + 1U] = 0x22U;
+  bus.regs[BME69X_REG_UNIQUE_ID + 2U] = 0x33U;
+  bus.regs[BME69X_REG_UNIQUE_ID + 3U] = 0xC4U;
+  uint32_t id = sensor.bme6xxGetUniqueId();
+  printf("  0x%08" PRIx32 "\n", id);
+  host_check("id", id == (((((0x33U << 8) + 0xC4U) & 0x7FFFU) << 16) + 0x2211U));
+}
+/**
+ * BSEC's forced cycle: heater profile, mode and fetch. An unchanged profile is not written again.
+ */
+static void
+check_transactions() {
+  printf("[bus transactions]\n");
+  BME69xMockBus bus;
+  load_chip(bus);
+  BME69xSensor sensor(bus);
+  sensor.begin();
+  printf("  %-18s %" PRIu32 "\n", "begin", sensor.transactions());
+
+  sensor.bme6xxSetOS(BME6xxOversampling::X2, BME6xxOversampling::X16, BME6xxOversampling::X1);
+  uint32_t start = sensor.transactions();
+  sensor.bme6xxSetHeaterProf(HOST_HEATER_TEMP, HOST_HEATER_DUR);
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  put_field(bus, 0, true, 0, 0, HOST_TEMP_ADC);
+  sensor.bme6xxFetchData();
+  printf("  %-18s %" PRIu32 "\n", "first cycle", sensor.transactions() - start);
+
+  start = sensor.transactions();
+  sensor.bme6xxSetHeaterProf(HOST_HEATER_TEMP, HOST_HEATER_DUR);
+  sensor.bme6xxSetOpMode(BME6xxMode::FORCED);
+  put_field(bus, 0, true, 0, 1, HOST_TEMP_ADC);
+  sensor.bme6xxFetchData();
+  host_check("next cycles", sensor.transactions() - start == 2U);
+
+  uint16_t temps[3] = {320U, 100U, 200U};
+  uint16_t muls[3] = {5U, 2U, 10U};
+  sensor.bme6xxSetHeaterProf(temps, muls, 140, 3);
+  sensor.bme6xxSetOpMode(BME6xxMode::PARALLEL);
+  put_field(bus, 0, true, 1, 2, HOST_TEMP_ADC);
+  put_field(bus, 1, true, 2, 3, HOST_TEMP_ADC);
+  put_field(bus, 2, true, 0, 4, HOST_TEMP_ADC);
+  start = sensor.transactions();
+  host_check("parallel burst", sensor.bme6xxFetchData() == 3U && sensor.transactions() - start == 1U);
+}
+
+/**
+ * Chip and variant id, coefficients of a typical part and the control registers after reset
+ */
+static void
+load_chip(BME69xMockBus &bus) {
+  uint8_t *regs = bus.regs;
+  regs[BME69X_REG_CHIP_ID] = BME69X_CHIP_ID;
+  regs[BME69X_REG_VARIANT_ID] = 0x01U;
+
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_T2_LSB, 26356);
+  regs[BME69X_REG_COEFF1 + BME69X_IDX_T3] = 3U;
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P1_LSB, 36159);
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P2_LSB, -10426);
+  regs[BME69X_REG_COEFF1 + BME69X_IDX_P3] = 88U;
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P4_LSB, 7128);
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P5_LSB, -166);
+  regs[BME69X_REG_COEFF1 + BME69X_IDX_P7] = 9U;
+  regs[BME69X_REG_COEFF1 + BME69X_IDX_P6] = 30U;
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P8_LSB, -2689);
+  put16(regs, BME69X_REG_COEFF1 + BME69X_IDX_P9_LSB, -1925);
+  regs[BME69X_REG_COEFF1 + BME69X_IDX_P10] = 30U;
+
+  const uint16_t h1 = 813U;
+  const uint16_t h2 = 1010U;
+  regs[BME69X_REG_COEFF2] = (uint8_t)(h2 >> 4);
+  regs[BME69X_REG_COEFF2 + 1U] = (uint8_t)(((h2 & 0x0FU) << 4) | (h1 & 0x0FU));
+  regs[BME69X_REG_COEFF2 + 2U] = (uint8_t)(h1 >> 4);
+  regs[BME69X_REG_COEFF2 + 3U] = 0U;
+  regs[BME69X_REG_COEFF2 + 4U] = 45U;
+  regs[BME69X_REG_COEFF2 + 5U] = 20U;
+  regs[BME69X_REG_COEFF2 + 6U] = 120U;
+  regs[BME69X_REG_COEFF2 + 7U] = (uint8_t)-100;
+  put16(regs, BME69X_REG_COEFF2 + 8U, 26193);
+  put16(regs, BME69X_REG_COEFF2 + 10U, -5969);
+  regs[BME69X_REG_COEFF2 + 12U] = (uint8_t)-30;
+  regs[BME69X_REG_COEFF2 + 13U] = 18U;
+
+  regs[BME69X_REG_COEFF3] = 48U;
+  regs[BME69X_REG_COEFF3 + 2U] = 0x10U;
+  regs[BME69X_REG_COEFF3 + 4U] = 0U;
+
+  regs[BME69X_REG_CTRL_HUM] = 0x01U;
+  regs[BME69X_REG_CTRL_MEAS] = (2U << BME69X_OST_POS) | (5U << BME69X_OSP_POS);
+}
+
+/**
+ * One 17 byte data field, pressure and humidity fixed, the gas measurement valid and stable
+ */
+static void
+put_field(BME69xMockBus &bus, uint8_t index, bool isNew, uint8_t gasIndex, uint8_t measIndex, uint32_t tempAdc) {
+  uint8_t *field = &bus.regs[BME69X_REG_FIELD0 + index * BME69X_LEN_FIELD];
+  memset(field, 0, BME69X_LEN_FIELD);
+  field[0] = (uint8_t)((isNew ? (uint8_t)NEW_DATA_MSK : 0U) | gasIndex);
+  field[1] = measIndex;
+  field[2] = (uint8_t)(HOST_PRES_ADC >> 12);
+  field[3] = (uint8_t)(HOST_PRES_ADC >> 4);
+  field[4] = (uint8_t)((HOST_PRES_ADC & 0x0FU) << 4);
+  field[5] = (uint8_t)(tempAdc >> 12);
+  field[6] = (uint8_t)(tempAdc >> 4);
+  field[7] = (uint8_t)((tempAdc & 0x0FU) << 4);
+  field[8] = (uint8_t)(HOST_HUM_ADC >> 8);
+  field[9] = (uint8_t)HOST_HUM_ADC;
+  field[15] = (uint8_t)(HOST_GAS_ADC >> 2);
+  field[16] = (uint8_t)(((HOST_GAS_ADC & 0x03U) << 6) | GASM_VALID_MSK |
+                        HEAT_STAB_MSK | HOST_GAS_RANGE);
+}
+
+static void
+put16(uint8_t *regs, uint8_t lsbReg, int32_t value) {
+  regs[lsbReg] = (uint8_t)(value & 0xFF);
+  regs[lsbReg + 1U] = (uint8_t)((value >> 8) & 0xFF);
+}
@@ -0,0 +1,478 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "u8g2_fonts.h"
+
+#include "grid_composer.h"
+#include "host_renderer.h"
+#include "mono_glyph_cache.h"
+
+#include "host_tests.h"
+
+#define HOST_SCREEN_WIDTH  128U
+#define HOST_SCREEN_HEIGHT 64U
+
+/* 1: count whole-frame flushes like the Adafruit backend, 0: dirty spans like sh1106_renderer */
+#define HOST_FULL_FLUSH       0U
+#define HOST_USE_GLYPH_CACHE  1U
+#define HOST_GLYPH_ARENA_SIZE 8192U
+
+#define HOST_WIDGET_ROUNDS      1000U
+#define HOST_QUEUE_DESCRIPTORS  10000U
+#define HOST_IDLE_WAIT_MS       50U
+#define HOST_DRAIN_TIMEOUT_MS   10000U
+#define HOST_QUEUE_SEND_TIMEOUT 1000U
+
+#define HOST_DUMP_DIR "frames"
+
+#define HOST_GLYPH_CHECK_DRAWS  20000U
+#define HOST_GLYPH_CHECK_SEED   1U
+#define HOST_GLYPH_BENCH_ROUNDS 200000U
+#define HOST_GLYPH_BENCH_TEXT   "12:34"
+
+typedef struct {
+  int8_t row;
+  int8_t col;
+  host_renderer_handle renderer;
+} host_cell;
+
+static const char *TAG = "host_tests";
+
+/* Same cells as the firmware: air quality, lux, sound on the top row, the clock below */
+static host_cell cells[] = {
+    {0, 0, NULL},
+    {0, 1, NULL},
+    {0, 2, NULL},
+    {1, 0, NULL},
+};
+
+static mono_glyph_cache glyph_cache;
+static uint8_t glyph_arena[HOST_GLYPH_ARENA_SIZE];
+
+static grid_composer_handle grid_composer;
+
+static grid_composer_widget_handle air_temp_widget;
+static grid_composer_widget_handle air_humid_widget;
+static grid_composer_widget_handle air_iaq_widget;
+static grid_composer_widget_handle lux_widget;
+static grid_composer_widget_handle lux_min_widget;
+static grid_composer_widget_handle lux_max_widget;
+static grid_composer_widget_handle sound_laeq_widget;
+static grid_composer_widget_handle sound_la90_widget;
+static grid_composer_widget_handle sound_lafmax_widget;
+static grid_composer_widget_handle clock_widget;
+
+static volatile uint32_t frames_done;
+static volatile uint32_t draws_done;
+static volatile uint32_t cell_switches;
+
+static esp_err_t
+init_grid(void);
+static esp_err_t
+init_widgets(void);
+
+static bool
+check_glyph_cache(void);
+static void
+bench_glyph_cache(void);
+static void
+bench_widgets(void);
+static void
+bench_queue(void);
+
+static void
+on_frame_done(grid_composer_handle composer, const grid_composer_frame_stats *stats, void *user_ctx);
+static bool
+wait_idle(uint32_t timeout_ms);
+static bool
+wait_draws(uint32_t draws, uint32_t timeout_ms);
+static void
+reset_stats(void);
+static void
+report(const char *phase, uint64_t elapsed_ns, uint32_t frames, uint32_t draws);
+static void
+dump_frames(const char *phase);
+
+void
+test_grid_composer(void) {
+  host_check("glyph cache", check_glyph_cache());
+  bench_glyph_cache();
+
+  bool is_ready = init_grid() == ESP_OK && init_widgets() == ESP_OK;
+  host_check("grid", is_ready);
+  if (!is_ready)
+    return;
+
+  bench_widgets();
+  bench_queue();
+}
+
+static esp_err_t
+init_grid(void) {
+  esp_err_t ret = ESP_OK;
+
+  mono_glyph_cache_init(&glyph_cache, glyph_arena, sizeof(glyph_arena));
+
+  ESP_RETURN_ON_ERROR(grid_composer_init(&grid_composer), TAG, "Failed to initialize grid composer");
+  ESP_RETURN_ON_ERROR(grid_composer_set_frame_done_cb(grid_composer, on_frame_done, NULL), TAG,
+                      "Failed to set grid frame callback");
+
+  for (uint8_t i = 0; i < sizeof(cells) / sizeof(cells[0]); ++i) {
+    struct host_renderer_config renderer_cfg = {
+        .width = HOST_SCREEN_WIDTH,
+        .height = HOST_SCREEN_HEIGHT,
+        .full_flush = HOST_FULL_FLUSH,
+        .glyph_cache = HOST_USE_GLYPH_CACHE ? &glyph_cache : NULL,
+    };
+    ESP_RETURN_ON_ERROR(host_renderer_new(&renderer_cfg, &cells[i].renderer), TAG, "Failed to create renderer %u", i);
+
+    grid_composer_renderer renderer = {
+        .user_ctx = cells[i].renderer,
+        .draw_text = host_renderer_draw_text,
+        .draw_figure = host_renderer_draw_figure,
+        .clear = host_renderer_clear,
+    };
+    // Cells are assigned in the order they are added, same as on the device
+    ESP_RETURN_ON_ERROR(grid_composer_add_cell(grid_composer, &renderer), TAG, "Failed to add a cell device %u", i + 1U);
+  }
+
+  return ret;
+}
+
+/**
+ * Copy of the firmware layout in main.cpp, edit both when trying a layout change
+ */
+static esp_err_t
+init_widgets(void) {
+  esp_err_t ret = ESP_OK;
+
+  struct {
+    grid_composer_widget_handle *widget;
+    grid_composer_widget_config cfg;
+  } widgets[] = {
+      {&air_temp_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 0, 128, 16, 0, 0,
+                                                          GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, u8g2_font_7x14_tf,
+                                                          "Temperature:%.1f", MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&air_humid_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 24, 128, 20, 0, 24,
+                                                           GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                           u8g2_font_7x14_tf, "Humidity:%.1f", MONO_CANVAS_COLOR_WHITE,
+                                                           MONO_CANVAS_COLOR_BLACK)},
+      {&air_iaq_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 0, 0, 48, 128, 16, 0, 48,
+                                                         GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "IAQ Index:%.1f", MONO_CANVAS_COLOR_WHITE,
+                                                         MONO_CANVAS_COLOR_BLACK)},
+      {&lux_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 0, 128, 16, 0, 0,
+                                                     GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT, u8g2_font_7x14_tf,
+                                                     "Lux:%.4f", MONO_CANVAS_COLOR_WHITE, MONO_CANVAS_COLOR_BLACK)},
+      {&lux_min_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 24, 128, 20, 0, 24,
+                                                         GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "Min:%.4f", MONO_CANVAS_COLOR_WHITE,
+                                                         MONO_CANVAS_COLOR_BLACK)},
+      {&lux_max_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 1, 0, 48, 128, 16, 0, 48,
+                                                         GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                         u8g2_font_7x14_tf, "Max:%.4f", MONO_CANVAS_COLOR_WHITE,
+                                                         MONO_CANVAS_COLOR_BLACK)},
+      {&sound_laeq_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 0, 128, 16, 0, 0,
+                                                            GRID_COMPOSER_V_ALIGN_TOP, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                            u8g2_font_7x14_tf, "LAeq:%.1f dB", MONO_CANVAS_COLOR_WHITE,
+                                                            MONO_CANVAS_COLOR_BLACK)},
+      {&sound_la90_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 24, 128, 20, 0, 24,
+                                                            GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                            u8g2_font_7x14_tf, "LA90:%.1f dB", MONO_CANVAS_COLOR_WHITE,
+                                                            MONO_CANVAS_COLOR_BLACK)},
+      {&sound_lafmax_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_VALUE, 0, 2, 0, 48, 128, 16, 0, 48,
+                                                              GRID_COMPOSER_V_ALIGN_BOTTOM, GRID_COMPOSER_H_ALIGN_LEFT,
+                                                              u8g2_font_7x14_tf, "LAFmax:%.1f dB", MONO_CANVAS_COLOR_WHITE,
+                                                              MONO_CANVAS_COLOR_BLACK)},
+      {&clock_widget, GRID_COMPOSER_TEXT_WIDGET_CONFIG(GRID_COMPOSER_WIDGET_LABEL, 1, 0, 0, 0, 128, 64, 0, 0,
+                                                       GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_CENTER,
+                                                       u8g2_font_logisoso22_tn, "", MONO_CANVAS_COLOR_WHITE,
+                                                       MONO_CANVAS_COLOR_BLACK)},
+  };
+
+  for (uint8_t i = 0; i < sizeof(widgets) / sizeof(widgets[0]); ++i) {
+    ESP_RETURN_ON_ERROR(grid_composer_widget_add(grid_composer, &widgets[i].cfg, widgets[i].widget), TAG,
+                        "Failed to add widget %u", i);
+  }
+
+  return ret;
+}
+
+/**
+ * Cached and decoded text against each other on randomized draws: clipping at every edge, all colors, solid and
+ * transparent, over random canvas content. Pixels, returned widths, measured widths and the dirty spans must match,
+ * the cached spans may only be wider.
+ */
+static bool
+check_glyph_cache(void) {
+  static uint8_t buffer_font[MONO_CANVAS_BUFFER_SIZE(HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT)];
+  static uint8_t buffer_cache[sizeof(buffer_font)];
+  static uint8_t arena[HOST_GLYPH_ARENA_SIZE];
+  static mono_glyph_cache cache;
+  static const char clock_glyphs[] = "0123456789: ";
+
+  mono_canvas canvas_font;
+  mono_canvas canvas_cache;
+  mono_canvas_init(&canvas_font, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT, buffer_font);
+  mono_canvas_init(&canvas_cache, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT, buffer_cache);
+  mono_glyph_cache_init(&cache, arena, sizeof(arena));
+
+  mono_font_info text_font;
+  mono_font_info clock_font;
+  if (!mono_font_load(&text_font, u8g2_font_7x14_tf) || !mono_font_load(&clock_font, u8g2_font_logisoso22_tn)) {
+    printf("[glyph cache] failed to load the fonts\n");
+    return false;
+  }
+
+  srand(HOST_GLYPH_CHECK_SEED);
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < HOST_GLYPH_CHECK_DRAWS; ++i) {
+    bool is_clock = (i & 1U) != 0U;
+    const mono_font_info *font = is_clock ? &clock_font : &text_font;
+
+    char text[16];
+    int len = 1 + rand() % 10;
+    for (int c = 0; c < len; ++c) {
+      text[c] = is_clock ? clock_glyphs[rand() % (int)(sizeof(clock_glyphs) - 1U)] : (char)(' ' + rand() % 95);
+    }
+    text[len] = '\0';
+
+    int16_t x = (int16_t)(rand() % (HOST_SCREEN_WIDTH + 32) - 20);
+    int16_t y = (int16_t)(rand() % (HOST_SCREEN_HEIGHT + 26) - 10);
+    uint16_t color = (uint16_t)(rand() % 3);
+    bool solid = (rand() & 1) != 0;
+
+    if (rand() % 4 == 0) {
+      memset(buffer_font, rand() & 0xFF, sizeof(buffer_font));
+    }
+    memcpy(buffer_cache, buffer_font, sizeof(buffer_font));
+    mono_canvas_mark_clean(&canvas_font);
+    mono_canvas_mark_clean(&canvas_cache);
+
+    int16_t width_font = mono_font_draw_utf8(&canvas_font, font, x, y, text, color, solid);
+    int16_t width_cache = mono_glyph_cache_draw_utf8(&cache, &canvas_cache, font, x, y, text, color, solid);
+    bool is_same = width_font == width_cache && memcmp(buffer_font, buffer_cache, sizeof(buffer_font)) == 0 &&
+                   mono_font_utf8_width(font, text) == mono_glyph_cache_utf8_width(&cache, font, text);
+
+    for (uint8_t p = 0; p < canvas_font.pages && is_same; ++p) {
+      int16_t font_x0, font_x1, cache_x0, cache_x1;
+      if (!mono_canvas_page_dirty_span(&canvas_font, p, &font_x0, &font_x1))
+        continue;
+      is_same = mono_canvas_page_dirty_span(&canvas_cache, p, &cache_x0, &cache_x1) && cache_x0 <= font_x0 &&
+                cache_x1 >= font_x1;
+    }
+
+    if (!is_same && mismatches++ < 5U) {
+      printf("  draw %" PRIu32 " differs: \"%s\" at %d,%d color %u solid %d\n", i, text, x, y, color, solid);
+    }
+  }
+
+  printf("[glyph cache] %" PRIu32 " draws, %" PRIu32 " mismatches, %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32
+         " uncached, %zu arena bytes\n",
+         (uint32_t)HOST_GLYPH_CHECK_DRAWS, mismatches, cache.hits, cache.misses, cache.uncached, cache.arena_used);
+  return mismatches == 0U;
+}
+/**
+ * The clock redraw, measured and centered, with glyphs decoded from the font every time and from the cache
+ */
+static void
+bench_glyph_cache(void) {
+  static uint8_t buffer[MONO_CANVAS_BUFFER_SIZE(HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT)];
+  static uint8_t arena[HOST_GLYPH_ARENA_SIZE];
+  static mono_glyph_cache cache;
+
+  mono_canvas canvas;
+  mono_canvas_init(&canvas, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT, buffer);
+  mono_glyph_cache_init(&cache, arena, sizeof(arena));
+
+  mono_font_info font;
+  if (!mono_font_load(&font, u8g2_font_logisoso22_tn))
+    return;
+  mono_glyph_cache_preload(&cache, &font, HOST_GLYPH_BENCH_TEXT);
+
+  uint64_t start_ns = host_now_ns();
+  for (uint32_t i = 0; i < HOST_GLYPH_BENCH_ROUNDS; ++i) {
+    mono_canvas_fill(&canvas, MONO_CANVAS_COLOR_BLACK);
+    int16_t w = mono_font_utf8_width(&font, HOST_GLYPH_BENCH_TEXT);
+    mono_font_draw_utf8(&canvas, &font, (int16_t)((HOST_SCREEN_WIDTH - w) / 2), 40, HOST_GLYPH_BENCH_TEXT,
+                        MONO_CANVAS_COLOR_WHITE, false);
+  }
+  uint64_t font_ns = host_now_ns() - start_ns;
+
+  start_ns = host_now_ns();
+  for (uint32_t i = 0; i < HOST_GLYPH_BENCH_ROUNDS; ++i) {
+    mono_canvas_fill(&canvas, MONO_CANVAS_COLOR_BLACK);
+    int16_t w = mono_glyph_cache_utf8_width(&cache, &font, HOST_GLYPH_BENCH_TEXT);
+    mono_glyph_cache_draw_utf8(&cache, &canvas, &font, (int16_t)((HOST_SCREEN_WIDTH - w) / 2), 40, HOST_GLYPH_BENCH_TEXT,
+                               MONO_CANVAS_COLOR_WHITE, false);
+  }
+  uint64_t cache_ns = host_now_ns() - start_ns;
+
+  start_ns = host_now_ns();
+  for (uint32_t i = 0; i < HOST_GLYPH_BENCH_ROUNDS; ++i) {
+    mono_canvas_fill(&canvas, MONO_CANVAS_COLOR_BLACK);
+  }
+  uint64_t fill_ns = host_now_ns() - start_ns;
+
+  printf("[glyph cache] \"%s\" measured and drawn: %.2f us decoded, %.2f us cached (%.2f us of it the fill)\n",
+         HOST_GLYPH_BENCH_TEXT, (double)font_ns / HOST_GLYPH_BENCH_ROUNDS / 1e3,
+         (double)cache_ns / HOST_GLYPH_BENCH_ROUNDS / 1e3, (double)fill_ns / HOST_GLYPH_BENCH_ROUNDS / 1e3);
+}
+
+/**
+ * Sensor-like updates through the widget layer, values repeat often enough for the change detection to matter
+ */
+static void
+bench_widgets(void) {
+  wait_idle(HOST_DRAIN_TIMEOUT_MS);
+  reset_stats();
+
+  uint32_t frames_start = frames_done;
+  uint32_t draws_start = draws_done;
+  uint64_t start_ns = host_now_ns();
+
+  for (uint32_t i = 0; i < HOST_WIDGET_ROUNDS; ++i) {
+    float t = (float)i / 10.0f;
+
+    grid_composer_widget_set_value(air_temp_widget, 21.0f + roundf(sinf(t) * 10.0f) / 10.0f);
+    grid_composer_widget_set_value(air_humid_widget, 40.0f + roundf(cosf(t) * 50.0f) / 10.0f);
+    grid_composer_widget_set_value(air_iaq_widget, 50.0f + (float)(i / 50U));
+    grid_composer_widget_set_value(lux_widget, 120.0f + sinf(t * 3.0f) * 5.0f);
+    grid_composer_widget_set_value(lux_min_widget, 115.0f);
+    grid_composer_widget_set_value(lux_max_widget, 125.0f);
+    grid_composer_widget_set_value(sound_laeq_widget, 42.0f + (float)(i % 7U));
+    grid_composer_widget_set_value(sound_la90_widget, 38.5f);
+    grid_composer_widget_set_value(sound_lafmax_widget, 51.0f);
+
+    char clock_text[8];
+    snprintf(clock_text, sizeof(clock_text), "%02u:%02u", (unsigned)((i / 60U) % 24U), (unsigned)(i % 60U));
+    grid_composer_widget_set_text(clock_widget, clock_text);
+
+    // Roughly one frame per round, like sensor tasks spread over time
+    vTaskDelay(1);
+  }
+  if (!wait_idle(HOST_DRAIN_TIMEOUT_MS)) {
+    ESP_LOGW(TAG, "widget updates did not drain");
+  }
+
+  report("widgets", host_now_ns() - start_ns, frames_done - frames_start, draws_done - draws_start);
+  dump_frames("widgets");
+}
+
+/**
+ * Raw descriptors pushed as fast as the queue takes them, measures the draw task throughput
+ */
+static void
+bench_queue(void) {
+  static const char *clock_texts[] = {"12:00", "12:01", "12:02", "12:03", "12:04"};
+
+  wait_idle(HOST_DRAIN_TIMEOUT_MS);
+  reset_stats();
+
+  uint32_t frames_start = frames_done;
+  uint32_t draws_start = draws_done;
+  uint64_t start_ns = host_now_ns();
+
+  for (uint32_t i = 0; i < HOST_QUEUE_DESCRIPTORS; ++i) {
+    const host_cell *cell = &cells[i % (sizeof(cells) / sizeof(cells[0]))];
+    grid_composer_draw_descriptor desc = GRID_COMPOSER_TEXT_DESCRIPTOR(
+        cell->row, cell->col, 0, 0, GRID_COMPOSER_V_ALIGN_CENTER, GRID_COMPOSER_H_ALIGN_CENTER,
+        clock_texts[i % (sizeof(clock_texts) / sizeof(clock_texts[0]))], u8g2_font_logisoso22_tn, MONO_CANVAS_COLOR_WHITE, true);
+    if (grid_composer_draw_queue_send(grid_composer, &desc, HOST_QUEUE_SEND_TIMEOUT) != ESP_OK) {
+      ESP_LOGW(TAG, "failed to queue descriptor %" PRIu32, i);
+    }
+  }
+  if (!wait_draws(draws_start + HOST_QUEUE_DESCRIPTORS, HOST_DRAIN_TIMEOUT_MS)) {
+    ESP_LOGW(TAG, "queue did not drain");
+  }
+
+  report("queue", host_now_ns() - start_ns, frames_done - frames_start, draws_done - draws_start);
+  dump_frames("queue");
+}
+
+static void
+on_frame_done(grid_composer_handle composer, const grid_composer_frame_stats *stats, void *user_ctx) {
+  frames_done++;
+  draws_done += stats->draws;
+  cell_switches += stats->cell_switches;
+}
+
+/**
+ * Widget updates can be merged, the only end condition is the draw task going quiet
+ */
+static bool
+wait_idle(uint32_t timeout_ms) {
+  TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+  uint32_t last_frames = frames_done;
+
+  while (xTaskGetTickCount() < deadline) {
+    vTaskDelay(pdMS_TO_TICKS(HOST_IDLE_WAIT_MS));
+    if (frames_done == last_frames)
+      return true;
+    last_frames = frames_done;
+  }
+  return false;
+}
+static bool
+wait_draws(uint32_t draws, uint32_t timeout_ms) {
+  TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+
+  while ((int32_t)(draws_done - draws) < 0) {
+    if (xTaskGetTickCount() >= deadline)
+      return false;
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+static void
+reset_stats(void) {
+  for (uint8_t i = 0; i < sizeof(cells) / sizeof(cells[0]); ++i) {
+    host_renderer_reset_stats(cells[i].renderer);
+  }
+  cell_switches = 0;
+}
+
+static void
+report(const char *phase, uint64_t elapsed_ns, uint32_t frames, uint32_t draws) {
+  double elapsed_s = (double)elapsed_ns / 1e9;
+
+  printf("[%s] %.3f s, %" PRIu32 " frames, %" PRIu32 " descriptors (%.0f/s), %.2f descriptors/frame, %" PRIu32
+         " cell switches\n",
+         phase, elapsed_s, frames, draws, elapsed_s > 0.0 ? (double)draws / elapsed_s : 0.0,
+         frames ? (double)draws / (double)frames : 0.0, (uint32_t)cell_switches);
+
+  for (uint8_t i = 0; i < sizeof(cells) / sizeof(cells[0]); ++i) {
+    host_renderer_stats stats;
+    host_renderer_get_stats(cells[i].renderer, &stats);
+
+    printf("  cell %d,%d: %" PRIu32 " draws, %.2f us mean, %.2f us max, %" PRIu32 " flushes, %" PRIu32 " page writes, %" PRIu64
+           " bus bytes\n",
+           cells[i].row, cells[i].col, stats.draws, stats.draws ? (double)stats.draw_ns / stats.draws / 1e3 : 0.0,
+           (double)stats.draw_ns_max / 1e3, stats.flushes, stats.page_writes, stats.bus_bytes);
+  }
+  printf("  glyph cache: %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " uncached, %zu/%zu arena bytes\n", glyph_cache.hits,
+         glyph_cache.misses, glyph_cache.uncached, glyph_cache.arena_used, glyph_cache.arena_size);
+}
+
+static void
+dump_frames(const char *phase) {
+  mkdir(HOST_DUMP_DIR, 0755);
+
+  for (uint8_t i = 0; i < sizeof(cells) / sizeof(cells[0]); ++i) {
+    char path[64];
+    snprintf(path, sizeof(path), HOST_DUMP_DIR "/%s_%d_%d.pbm", phase, cells[i].row, cells[i].col);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(host_renderer_dump_pbm(cells[i].renderer, path));
+  }
+}
@@ -0,0 +1,274 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "i2c_arbiter.h"
+
+#include "host_tests.h"
+
+#define HOST_TASK_STACK    4096U
+#define HOST_TASK_PRIORITY 2U
+#define HOST_QUEUE_MS      5U // between the waiters, so they queue up in the order they are started
+
+#define HOST_TIMEOUT_MS 20U
+
+#define HOST_RACE_ROUNDS 300U
+#define HOST_RACE_MS     3U // the waiter's timeout, the holder releases a tick before, on or after it
+
+#define HOST_CHUNKS             8U // a full SH1106 frame, one page per chunk
+#define HOST_CHUNK_MS           3U
+#define HOST_SENSOR_ROUNDS      100U
+#define HOST_SENSOR_HOLD_MS     1U
+#define HOST_SENSOR_PERIOD_MS   7U
+#define HOST_MAX_URGENT_WAIT_US (HOST_CHUNKS * HOST_CHUNK_MS * 1000U) // a whole frame, as without the yields
+
+typedef struct {
+  uint8_t priority;
+  uint32_t timeout_ms;
+  uint32_t hold_ms;
+  esp_err_t result;
+} host_client;
+
+static i2c_arbiter_handle arbiter;
+static SemaphoreHandle_t done; // one give per client task that finished
+
+static uint8_t served[I2C_ARBITER_PRIO_COUNT];
+static uint8_t served_count;
+static volatile uint32_t in_bus;
+static volatile uint32_t overlaps;
+static volatile bool is_display_stopped;
+
+static void
+check_priority(void);
+static void
+check_timeout(void);
+static void
+check_race(void);
+static void
+check_contention(void);
+
+static void
+client_task(void *arg);
+static void
+display_task(void *arg);
+static void
+sensor_task(void *arg);
+static void
+on_bus(uint32_t hold_ms);
+static void
+start_task(TaskFunction_t task, const char *name, void *arg);
+
+void
+test_i2c_arbiter(void) {
+  struct i2c_arbiter_config arbiter_cfg = {.name = "host"};
+  done = xSemaphoreCreateCounting(I2C_ARBITER_PRIO_COUNT, 0);
+  bool is_ready = done && i2c_arbiter_new(&arbiter_cfg, &arbiter) == ESP_OK;
+  host_check("arbiter", is_ready);
+  if (!is_ready)
+    return;
+
+  check_priority();
+  check_timeout();
+  check_race();
+  check_contention();
+
+  i2c_arbiter_del(arbiter);
+}
+
+/**
+ * Waiters of priority 1, 3 and 2 queue behind a holder and are served most urgent first
+ */
+static void
+check_priority(void) {
+  printf("[priority]\n");
+  host_client clients[] = {{.priority = 1U}, {.priority = 3U}, {.priority = 2U}};
+  const uint8_t count = sizeof(clients) / sizeof(clients[0]);
+
+  served_count = 0;
+  bool ok = i2c_arbiter_acquire(arbiter, 0, 0) == ESP_OK;
+  for (uint8_t i = 0; i < count; ++i) {
+    clients[i].timeout_ms = 1000U;
+    start_task(client_task, "client", &clients[i]);
+    vTaskDelay(pdMS_TO_TICKS(HOST_QUEUE_MS));
+  }
+  ok = ok && i2c_arbiter_release(arbiter) == ESP_OK;
+  for (uint8_t i = 0; i < count; ++i) {
+    xSemaphoreTake(done, portMAX_DELAY);
+  }
+
+  printf("  served %u %u %u\n", served[0], served[1], served[2]);
+  host_check("order", ok && served_count == count && served[0] == 3U && served[1] == 2U && served[2] == 1U);
+}
+/**
+ * A waiter gives up after its timeout and leaves the holder alone
+ */
+static void
+check_timeout(void) {
+  printf("[timeout, %u ms]\n", HOST_TIMEOUT_MS);
+  i2c_arbiter_stats stats;
+  i2c_arbiter_get_stats(arbiter, &stats, true);
+
+  host_client client = {.priority = 2U, .timeout_ms = HOST_TIMEOUT_MS};
+  bool ok = i2c_arbiter_acquire(arbiter, 0, 0) == ESP_OK;
+  TickType_t start = xTaskGetTickCount();
+  start_task(client_task, "client", &client);
+  xSemaphoreTake(done, portMAX_DELAY);
+  TickType_t waited = xTaskGetTickCount() - start;
+  i2c_arbiter_get_stats(arbiter, &stats, true);
+
+  host_check("timed out", ok && client.result == ESP_ERR_TIMEOUT && waited >= pdMS_TO_TICKS(HOST_TIMEOUT_MS) &&
+                          stats.timeouts == 1U);
+  host_check("holder keeps it", i2c_arbiter_release(arbiter) == ESP_OK);
+  host_check("release when free", i2c_arbiter_release(arbiter) == ESP_ERR_INVALID_STATE);
+}
+/**
+ * The holder releases as the waiter's timeout runs out. Whichever wins, the bus ends up either with the waiter or
+ * free, never handed to a waiter that has left.
+ */
+static void
+check_race(void) {
+  printf("[hand over racing the timeout, %u rounds]\n", HOST_RACE_ROUNDS);
+  uint32_t handed = 0;
+  uint32_t timed_out = 0;
+  uint32_t lost = 0;
+  for (uint32_t round = 0; round < HOST_RACE_ROUNDS; ++round) {
+    host_client client = {.priority = 1U, .timeout_ms = HOST_RACE_MS};
+    if (i2c_arbiter_acquire(arbiter, 0, 0) != ESP_OK) {
+      ++lost;
+      break;
+    }
+    start_task(client_task, "client", &client);
+    vTaskDelay(pdMS_TO_TICKS(HOST_RACE_MS - 1U + round % 3U));
+    i2c_arbiter_release(arbiter);
+    xSemaphoreTake(done, portMAX_DELAY);
+
+    handed += client.result == ESP_OK;
+    timed_out += client.result == ESP_ERR_TIMEOUT;
+    // Free again, a hand over to nobody would leave it held for good
+    if (i2c_arbiter_acquire(arbiter, 0, 0) != ESP_OK) {
+      ++lost;
+      break;
+    }
+    i2c_arbiter_release(arbiter);
+  }
+  printf("  %" PRIu32 " handed over, %" PRIu32 " timed out\n", handed, timed_out);
+  host_check("no lost bus", lost == 0 && handed + timed_out == HOST_RACE_ROUNDS);
+}
+/**
+ * A display sending a frame in chunks, yielding between them, against two sensors
+ */
+static void
+check_contention(void) {
+  printf("[display frames against sensors at priority 3 and 1]\n");
+  i2c_arbiter_stats stats;
+  i2c_arbiter_get_stats(arbiter, &stats, true);
+
+  static host_client sensors[] = {{.priority = 3U}, {.priority = 1U}};
+  is_display_stopped = false;
+  overlaps = 0;
+  start_task(display_task, "display", NULL);
+  for (uint8_t i = 0; i < sizeof(sensors) / sizeof(sensors[0]); ++i) {
+    start_task(sensor_task, "sensor", &sensors[i]);
+  }
+  for (uint8_t i = 0; i < sizeof(sensors) / sizeof(sensors[0]); ++i) {
+    xSemaphoreTake(done, portMAX_DELAY);
+  }
+  is_display_stopped = true;
+  xSemaphoreTake(done, portMAX_DELAY);
+  i2c_arbiter_get_stats(arbiter, &stats, false);
+
+  printf("  utilization %.2f, %" PRIu32 " preemptions, %" PRIu32 " timeouts\n",
+         (double)stats.busy_us / (double)stats.window_us, stats.preemptions, stats.timeouts);
+  for (uint8_t p = 0; p < I2C_ARBITER_PRIO_COUNT; ++p) {
+    printf("  priority %u: %5" PRIu32 " acquisitions, max wait %6" PRIu32 " us, waits", p, stats.acquisitions[p],
+           stats.max_wait_us[p]);
+    for (uint8_t b = 0; b < I2C_ARBITER_WAIT_BUCKETS; ++b) {
+      printf(" %" PRIu32, stats.wait_hist[p][b]);
+    }
+    printf("\n");
+  }
+  host_check("exclusive", overlaps == 0);
+  host_check("no timeouts", stats.timeouts == 0 && sensors[0].result == ESP_OK && sensors[1].result == ESP_OK);
+  host_check("urgent wait", stats.acquisitions[3] == HOST_SENSOR_ROUNDS && stats.max_wait_us[3] <= HOST_MAX_URGENT_WAIT_US);
+  host_check("display yielded", stats.preemptions > 0);
+}
+
+static void
+client_task(void *arg) {
+  host_client *client = arg;
+  client->result = i2c_arbiter_acquire(arbiter, client->priority, client->timeout_ms);
+  if (client->result == ESP_OK) {
+    if (served_count < sizeof(served)) {
+      served[served_count++] = client->priority;
+    }
+    on_bus(client->hold_ms);
+    i2c_arbiter_release(arbiter);
+  }
+  xSemaphoreGive(done);
+  vTaskDelete(NULL);
+}
+
+static void
+display_task(void *arg) {
+  while (!is_display_stopped) {
+    if (i2c_arbiter_acquire(arbiter, 0, 1000U) != ESP_OK)
+      continue;
+    bool is_held = true;
+    for (uint8_t chunk = 0; chunk < HOST_CHUNKS && is_held; ++chunk) {
+      on_bus(HOST_CHUNK_MS);
+      if (chunk + 1U < HOST_CHUNKS) {
+        is_held = i2c_arbiter_yield(arbiter, 1000U) == ESP_OK;
+      }
+    }
+    if (is_held) {
+      i2c_arbiter_release(arbiter);
+    }
+  }
+  xSemaphoreGive(done);
+  vTaskDelete(NULL);
+}
+
+static void
+sensor_task(void *arg) {
+  host_client *sensor = arg;
+  sensor->result = ESP_OK;
+  for (uint32_t round = 0; round < HOST_SENSOR_ROUNDS; ++round) {
+    esp_err_t ret = i2c_arbiter_acquire(arbiter, sensor->priority, 1000U);
+    if (ret != ESP_OK) {
+      sensor->result = ret;
+      continue;
+    }
+    on_bus(HOST_SENSOR_HOLD_MS);
+    i2c_arbiter_release(arbiter);
+    vTaskDelay(pdMS_TO_TICKS(HOST_SENSOR_PERIOD_MS));
+  }
+  xSemaphoreGive(done);
+  vTaskDelete(NULL);
+}
+
+/**
+ * Stands in for a transfer, counts a second client on the bus at the same time
+ */
+static void
+on_bus(uint32_t hold_ms) {
+  if (++in_bus > 1U) {
+    overlaps++;
+  }
+  if (hold_ms) {
+    vTaskDelay(pdMS_TO_TICKS(hold_ms));
+  }
+  in_bus--;
+}
+
+static void
+start_task(TaskFunction_t task, const char *name, void *arg) {
+  if (xTaskCreate(task, name, HOST_TASK_STACK, arg, HOST_TASK_PRIORITY, NULL) != pdPASS) {
+    printf("  cannot start %s\n", name);
+    exit(1);
+  }
+}
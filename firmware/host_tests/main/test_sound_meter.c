@@ -0,0 +1,653 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "adc_trace.h"
+#include "sound_meter.h"
+
+#include "acoustics_reference.h"
+
+#include "host_tests.h"
+
+/* Same as the firmware: MAX4466 biased at half supply, 4 s windows */
+#define HOST_DC_OFFSET_MV   1650U
+#define HOST_FULL_SCALE_MV  1650.0f
+#define HOST_ADC_MAX_MV     3160U
+#define HOST_WINDOW_MS      4000U
+#define HOST_FRAME_SAMPLES  200U // ADC_CONT_CONV_FRAME_SIZE / SOC_ADC_DIGI_RESULT_BYTES
+#define HOST_MAX_RATE_HZ    16000U
+#define HOST_EVENT_PEAK_MV  100U
+
+/* A-weighted levels: MAX4466 at 25x gain behind a -44 dBV/Pa electret, same as ADC_SOUND_SENSOR_MV_PER_PA */
+#define HOST_MV_PER_PA            158.0f
+#define HOST_LEVEL_INTERVAL_MS    100U
+#define HOST_SETTLE_MS            500U // SOUND_METER_SETTLE_MS
+#define HOST_MAX_WINDOWS_PER_FILL 2U
+#define HOST_TONE_MV              1000.0
+#define HOST_TONE_SECONDS         3U
+#define HOST_FFT_SIZE             512U // the firmware's size and bands for the replay
+#define HOST_BANDS_PER_OCTAVE     1U
+#define HOST_CHECK_FFT_SIZE       1024U // band placement is checked in thirds of an octave
+#define HOST_BENCH_FRAMES         256U
+
+/* What task_sound_sampling read before the stream: 25 samples every 100 ms */
+#define HOST_LEGACY_SAMPLES   25U
+#define HOST_LEGACY_PERIOD_MS 100U
+
+#define HOST_WAV_ENV   "SOUND_METER_WAV"
+#define HOST_TRACE_ENV "SOUND_METER_TRACE" // adc_trace captures of the device, replayed at their own rate
+
+#define HOST_TRACE_BLOCK_SAMPLES 1024U
+
+/* Pass marks. The bilinear A-weighting falls off towards Nyquist, it is held to IEC 61672 below an eighth of the rate. */
+#define HOST_WEIGHTING_RATE_DIV    8U
+#define HOST_MAX_WEIGHTING_ERR_DB  0.7
+#define HOST_MAX_BAND_ERR_DB       0.2
+#define HOST_MIN_BAND_REJECTION_DB 30.0
+#define HOST_MIN_COVERAGE          0.999f
+#define HOST_MAX_LAEQ_DELTA_DB     0.05 // LAeq and LAFmax against the double precision reference
+#define HOST_MAX_LA90_DELTA_DB     0.5  // the histogram resolution of LA90
+
+/* Synthetic night: a quiet noise floor with a few short knocks */
+#define HOST_SYNTH_RATE_HZ    48000U
+#define HOST_SYNTH_SECONDS    120U
+#define HOST_SYNTH_FLOOR      0.004f
+#define HOST_SYNTH_EVENT      0.35f
+#define HOST_SYNTH_EVENT_MS   30U
+#define HOST_SYNTH_EVENT_GAP  7.737
+
+typedef struct {
+  FILE *wav;
+  uint32_t rate_hz;
+  uint16_t channels;
+  uint16_t bits;
+  uint16_t format;
+  uint32_t data_left;
+
+  uint64_t synth_index; // synthetic source when wav is NULL
+  uint32_t synth_seed;
+} replay_source;
+
+typedef struct {
+  replay_source *src;
+  double step;
+  double pos;
+  float a;
+  float b;
+} replay_resampler;
+
+typedef struct {
+  double laeq;
+  double lafmax;
+  double la90;
+} replay_delta;
+
+typedef struct {
+  sound_meter_handle meter;
+  uint32_t windows;
+  uint32_t event_windows;
+  float coverage_min;
+  double coverage_sum;
+  uint16_t peak_max_mv;
+} replay_consumer;
+
+static const char *TAG = "host_tests";
+
+static const uint32_t replay_rates_hz[] = {2000U, 8000U, 16000U};
+static const double tone_freqs_hz[] = {31.5, 63.0, 125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 6300.0};
+static const uint16_t bench_fft_sizes[] = {64U, 128U, 256U, 512U, 1024U, 2048U, 4096U};
+
+static uint16_t chunk[HOST_MAX_RATE_HZ];
+static uint16_t legacy_chunk[HOST_MAX_RATE_HZ];
+
+static void
+check_weighting(uint32_t rate_hz);
+static void
+check_spectrum(uint32_t rate_hz);
+static void
+bench_spectrum(void);
+static void
+feed_tone(sound_meter_handle meter, uint32_t rate_hz, double freq_hz);
+static void
+replay(const char *path, uint32_t rate_hz);
+static void
+replay_trace(const char *path);
+
+static esp_err_t
+source_open(replay_source *src, const char *path);
+static void
+source_close(replay_source *src);
+static bool
+source_next(replay_source *src, float *out_sample);
+
+static bool
+resampler_init(replay_resampler *rs, replay_source *src, uint32_t rate_hz);
+static uint32_t
+resampler_fill(replay_resampler *rs, uint16_t *out_mv, uint32_t count);
+
+static esp_err_t
+consumer_init(replay_consumer *consumer, uint32_t rate_hz, uint8_t frac_bits, float mv_per_pa, uint16_t fft_size);
+static void
+consumer_close_window(replay_consumer *consumer, uint64_t now_us, sound_meter_window_t *out_window);
+static void
+compare_window(const sound_meter_window_t *window, acoustics_reference *ref, replay_delta *max_delta);
+
+
+void
+test_sound_meter(void) {
+  const char *paths = getenv(HOST_WAV_ENV);
+
+  bench_spectrum();
+  for (uint8_t r = 0; r < sizeof(replay_rates_hz) / sizeof(replay_rates_hz[0]); ++r) {
+    check_weighting(replay_rates_hz[r]);
+    check_spectrum(replay_rates_hz[r]);
+
+    if (!paths || !*paths) {
+      replay(NULL, replay_rates_hz[r]);
+      continue;
+    }
+
+    char list[1024];
+    snprintf(list, sizeof(list), "%s", paths);
+    for (char *save = NULL, *path = strtok_r(list, ":", &save); path; path = strtok_r(NULL, ":", &save)) {
+      replay(path, replay_rates_hz[r]);
+    }
+  }
+
+  const char *traces = getenv(HOST_TRACE_ENV);
+  if (traces && *traces) {
+    char list[1024];
+    snprintf(list, sizeof(list), "%s", traces);
+    for (char *save = NULL, *path = strtok_r(list, ":", &save); path; path = strtok_r(NULL, ":", &save)) {
+      replay_trace(path);
+    }
+  }
+}
+
+/**
+ * A tone at each frequency, the weighted level against IEC 61672, checked below rate / HOST_WEIGHTING_RATE_DIV
+ */
+static void
+check_weighting(uint32_t rate_hz) {
+  printf("[A-weighting] %" PRIu32 " Hz, measured (IEC 61672):", rate_hz);
+
+  double max_error = 0.0;
+  for (uint8_t f = 0; f < sizeof(tone_freqs_hz) / sizeof(tone_freqs_hz[0]); ++f) {
+    if (tone_freqs_hz[f] > 0.45 * rate_hz)
+      break;
+
+    replay_consumer tone;
+    if (consumer_init(&tone, rate_hz, 0U, HOST_MV_PER_PA, 0U) != ESP_OK) {
+      host_check("A-weighting", false);
+      return;
+    }
+
+    feed_tone(tone.meter, rate_hz, tone_freqs_hz[f]);
+    sound_meter_window_t window;
+    consumer_close_window(&tone, (uint64_t)HOST_TONE_SECONDS * 1000000ULL, &window);
+    double unweighted_db = 10.0 * log10(HOST_TONE_MV * HOST_TONE_MV / 2.0) - 20.0 * log10(HOST_MV_PER_PA * 20e-6);
+    double expected_db = acoustics_reference_a_weighting_db(tone_freqs_hz[f]);
+    printf(" %g:%.2f(%.2f)", tone_freqs_hz[f], window.laeq_db - unweighted_db, expected_db);
+    if (tone_freqs_hz[f] <= (double)rate_hz / HOST_WEIGHTING_RATE_DIV) {
+      max_error = fmax(max_error, fabs(window.laeq_db - unweighted_db - expected_db));
+    }
+    sound_meter_del(tone.meter);
+  }
+  printf("\n  max |error| %.2f dB up to %" PRIu32 " Hz\n", max_error, rate_hz / HOST_WEIGHTING_RATE_DIV);
+  host_check("A-weighting", max_error <= HOST_MAX_WEIGHTING_ERR_DB);
+}
+/**
+ * A tone at every band centre, its own band should read the tone level and the neighbours far less
+ */
+static void
+check_spectrum(uint32_t rate_hz) {
+  printf("[bands] %" PRIu32 " Hz, %u-point FFT, own band error / loudest neighbour:", rate_hz, HOST_CHECK_FFT_SIZE);
+
+  double tone_db = 10.0 * log10(HOST_TONE_MV * HOST_TONE_MV / 2.0) - 20.0 * log10(HOST_MV_PER_PA * 20e-6);
+  double max_error = 0.0, max_neighbour = -INFINITY;
+  for (uint8_t b = 0, band_count = 1U; b < band_count; ++b) {
+    struct sound_meter_config_t meter_cfg = {
+        .sample_rate_hz = rate_hz,
+        .dc_offset_mv = HOST_DC_OFFSET_MV,
+        .mv_per_pa = HOST_MV_PER_PA,
+        .fft_size = HOST_CHECK_FFT_SIZE,
+        .bands_per_octave = 3U,
+    };
+    sound_meter_handle meter = NULL;
+    sound_meter_band_t band;
+    if (sound_meter_new(&meter_cfg, &meter) != ESP_OK) {
+      host_check("bands", false);
+      return;
+    }
+    if (sound_meter_get_band(meter, b, &band) != ESP_OK) {
+      sound_meter_del(meter);
+      host_check("bands", false);
+      return;
+    }
+
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_reset(meter, 0U));
+    feed_tone(meter, rate_hz, band.centre_hz);
+    sound_meter_window_t window;
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_close_window(meter, (uint64_t)HOST_TONE_SECONDS * 1000000ULL, &window));
+
+    band_count = window.band_count;
+    double error = window.band_db[b] - tone_db;
+    double neighbour = fmax(b ? window.band_db[b - 1U] : 0.0, b + 1U < band_count ? window.band_db[b + 1U] : 0.0) - tone_db;
+    max_error = fmax(max_error, fabs(error));
+    max_neighbour = fmax(max_neighbour, neighbour);
+    printf(" %s:%+.2f/%.0f", band.name, error, neighbour);
+    sound_meter_del(meter);
+  }
+  printf("\n  max |error| %.2f dB, loudest neighbour %.1f dB below the tone\n", max_error, -max_neighbour);
+  host_check("own band", max_error <= HOST_MAX_BAND_ERR_DB);
+  host_check("neighbours", -max_neighbour >= HOST_MIN_BAND_REJECTION_DB);
+}
+/**
+ * Time per frame of the band analysis against the share of a core it takes at the replay rates
+ */
+static void
+bench_spectrum(void) {
+  printf("[bench] band analysis per 50 %% overlapped frame:\n");
+  for (uint8_t i = 0; i < sizeof(bench_fft_sizes) / sizeof(bench_fft_sizes[0]); ++i) {
+    uint32_t ns_per_frame = 0;
+    if (sound_meter_benchmark_spectrum(bench_fft_sizes[i], HOST_BENCH_FRAMES, &ns_per_frame) != ESP_OK)
+      continue;
+
+    printf("  %4u-point: %7" PRIu32 " ns/frame", bench_fft_sizes[i], ns_per_frame);
+    for (uint8_t r = 0; r < sizeof(replay_rates_hz) / sizeof(replay_rates_hz[0]); ++r) {
+      double frames_per_s = 2.0 * replay_rates_hz[r] / bench_fft_sizes[i];
+      printf(", %.4f%% at %" PRIu32 " Hz", ns_per_frame * frames_per_s / 1e7, replay_rates_hz[r]);
+    }
+    printf("\n");
+  }
+}
+static void
+feed_tone(sound_meter_handle meter, uint32_t rate_hz, double freq_hz) {
+  uint32_t total = rate_hz * HOST_TONE_SECONDS;
+  for (uint32_t offset = 0; offset < total; offset += HOST_FRAME_SAMPLES) {
+    uint16_t frame[HOST_FRAME_SAMPLES];
+    for (uint32_t i = 0; i < HOST_FRAME_SAMPLES; ++i) {
+      double phase = 2.0 * M_PI * freq_hz * (double)(offset + i) / rate_hz;
+      frame[i] = (uint16_t)lround(HOST_DC_OFFSET_MV + HOST_TONE_MV * sin(phase));
+    }
+    sound_meter_feed(meter, frame, HOST_FRAME_SAMPLES, 0U);
+  }
+}
+
+static void
+replay(const char *path, uint32_t rate_hz) {
+  replay_source src;
+  if (source_open(&src, path) != ESP_OK) {
+    host_check("replay", false);
+    return;
+  }
+
+  replay_resampler rs;
+  replay_consumer stream;
+  replay_consumer legacy;
+  acoustics_reference ref;
+  acoustics_reference_init(&ref, rate_hz, HOST_MV_PER_PA, HOST_LEVEL_INTERVAL_MS, HOST_SETTLE_MS, HOST_DC_OFFSET_MV);
+  if (!resampler_init(&rs, &src, rate_hz) || consumer_init(&stream, rate_hz, 0U, HOST_MV_PER_PA, HOST_FFT_SIZE) != ESP_OK ||
+      consumer_init(&legacy, rate_hz, 0U, 0.0f, 0U) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to set up the replay of %s", path ? path : "synthetic");
+    acoustics_reference_free(&ref);
+    source_close(&src);
+    host_check("replay", false);
+    return;
+  }
+
+  uint32_t legacy_period = rate_hz * HOST_LEGACY_PERIOD_MS / 1000U;
+  uint64_t window_us = HOST_WINDOW_MS * 1000ULL;
+  uint64_t stream_window_start_us = 0;
+  uint64_t legacy_window_start_us = 0;
+  uint64_t produced = 0;
+  uint64_t stream_ns = 0;
+  uint32_t count = 0;
+
+  sound_meter_window_t closed[HOST_MAX_WINDOWS_PER_FILL];
+  replay_delta max_delta = {0};
+  float laeq_min = INFINITY, laeq_max = 0.0f, lafmax_max = 0.0f, la90_min = INFINITY;
+
+  while ((count = resampler_fill(&rs, chunk, rate_hz)) > 0U) {
+    // Frame by frame like adc_module_stream_borrow hands them out, only the stream consumer is timed
+    uint32_t closed_count = 0;
+    uint64_t start_ns = host_cpu_ns();
+    for (uint32_t offset = 0; offset < count; offset += HOST_FRAME_SAMPLES) {
+      uint32_t frame = count - offset < HOST_FRAME_SAMPLES ? count - offset : HOST_FRAME_SAMPLES;
+      sound_meter_feed(stream.meter, &chunk[offset], frame, 0U);
+
+      uint64_t now_us = (produced + offset + frame) * 1000000ULL / rate_hz;
+      if (now_us - stream_window_start_us >= window_us && closed_count < HOST_MAX_WINDOWS_PER_FILL) {
+        consumer_close_window(&stream, now_us, &closed[closed_count++]);
+        stream_window_start_us = now_us;
+      }
+    }
+    stream_ns += host_cpu_ns() - start_ns;
+
+    // The same frames through the double precision reference and the legacy reader, closed on the same edges
+    uint32_t compared = 0;
+    for (uint32_t offset = 0; offset < count; offset += HOST_FRAME_SAMPLES) {
+      uint32_t frame = count - offset < HOST_FRAME_SAMPLES ? count - offset : HOST_FRAME_SAMPLES;
+      acoustics_reference_feed(&ref, &chunk[offset], frame);
+
+      // The legacy task only kept the first samples of every period
+      uint32_t kept = 0;
+      for (uint32_t i = offset; i < offset + frame; ++i) {
+        if ((produced + i) % legacy_period < HOST_LEGACY_SAMPLES) {
+          legacy_chunk[kept++] = chunk[i];
+        }
+      }
+      sound_meter_feed(legacy.meter, legacy_chunk, kept, 0U);
+
+      uint64_t now_us = (produced + offset + frame) * 1000000ULL / rate_hz;
+      if (now_us - legacy_window_start_us >= window_us && compared < closed_count) {
+        consumer_close_window(&legacy, now_us, NULL);
+        legacy_window_start_us = now_us;
+
+        const sound_meter_window_t *window = &closed[compared++];
+        compare_window(window, &ref, &max_delta);
+        laeq_min = fminf(laeq_min, window->laeq_db);
+        laeq_max = fmaxf(laeq_max, window->laeq_db);
+        lafmax_max = fmaxf(lafmax_max, window->lafmax_db);
+        la90_min = fminf(la90_min, window->la90_db);
+      }
+    }
+    produced += count;
+  }
+
+  double audio_s = (double)produced / rate_hz;
+  double ns_per_sample = produced ? (double)stream_ns / (double)produced : 0.0;
+
+  printf("[%s] %" PRIu32 " Hz: %.1f s of audio, %" PRIu64 " samples, %" PRIu32 " windows\n", path ? path : "synthetic", rate_hz,
+         audio_s, produced, stream.windows);
+  const replay_consumer *consumers[] = {&stream, &legacy};
+  const char *names[] = {"stream", "legacy"};
+  for (uint8_t i = 0; i < 2U; ++i) {
+    const replay_consumer *c = consumers[i];
+    printf("  %-6s coverage %6.2f%% mean, %6.2f%% min, %" PRIu32 " windows over %u mV, peak %u mV\n", names[i],
+           c->windows ? 100.0 * c->coverage_sum / c->windows : 0.0, c->windows ? 100.0 * c->coverage_min : 0.0,
+           c->event_windows, HOST_EVENT_PEAK_MV, c->peak_max_mv);
+  }
+  printf("  levels LAeq %.1f..%.1f dB, LAFmax up to %.1f dB, LA90 down to %.1f dB\n", laeq_min, laeq_max, lafmax_max,
+         la90_min);
+  printf("  vs reference: max |dLAeq| %.3f dB, |dLAFmax| %.3f dB, |dLA90| %.3f dB\n", max_delta.laeq, max_delta.lafmax,
+         max_delta.la90);
+  printf("  meter  %.2f ns/sample, %.4f%% of a host core, %.0fx real time\n", ns_per_sample, ns_per_sample * rate_hz / 1e7,
+         stream_ns ? audio_s * 1e9 / (double)stream_ns : 0.0);
+
+  sound_meter_window_t totals;
+  ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_get_totals(stream.meter, &totals));
+  printf("  bands ");
+  for (uint8_t b = 0; b < totals.band_count; ++b) {
+    sound_meter_band_t band;
+    ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_get_band(stream.meter, b, &band));
+    printf(" %s:%.1f", band.name, totals.band_db[b]);
+  }
+  printf(" dB\n");
+  host_check("coverage", stream.windows && stream.coverage_min >= HOST_MIN_COVERAGE);
+  host_check("vs reference", max_delta.laeq <= HOST_MAX_LAEQ_DELTA_DB && max_delta.lafmax <= HOST_MAX_LAEQ_DELTA_DB &&
+                             max_delta.la90 <= HOST_MAX_LA90_DELTA_DB);
+
+  acoustics_reference_free(&ref);
+  sound_meter_del(stream.meter);
+  sound_meter_del(legacy.meter);
+  source_close(&src);
+}
+
+/**
+ * A recorded night block by block on the record timestamps, as fast as the host goes. Windows close on the device's
+ * 4 s edges and lost frames count against coverage the way they did on the device.
+ */
+static void
+replay_trace(const char *path) {
+  struct adc_trace_replay_config_t replay_cfg = {.path = path};
+  adc_trace_replay_handle trace = NULL;
+  uint32_t rate_hz = 0;
+  uint8_t frac_bits = 0;
+  if (adc_trace_replay_open(&replay_cfg, &trace) != ESP_OK) {
+    host_check("trace replay", false);
+    return;
+  }
+  adc_trace_replay_get_format(trace, &rate_hz, &frac_bits);
+
+  adc_module_block_t block = {.samples = chunk, .capacity = HOST_TRACE_BLOCK_SAMPLES};
+  uint64_t timestamp_us = 0;
+  replay_consumer stream;
+  acoustics_reference ref;
+  // The reference works on whatever unit it is fed, mV * 2^frac_bits here
+  acoustics_reference_init(&ref, rate_hz, HOST_MV_PER_PA * (1U << frac_bits), HOST_LEVEL_INTERVAL_MS, HOST_SETTLE_MS,
+                           HOST_DC_OFFSET_MV << frac_bits);
+  if (adc_trace_replay_next_block(trace, &block, &timestamp_us) != ESP_OK ||
+      consumer_init(&stream, rate_hz, frac_bits, HOST_MV_PER_PA, HOST_FFT_SIZE) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to set up the replay of %s", path);
+    acoustics_reference_free(&ref);
+    adc_trace_replay_close(trace);
+    host_check("trace replay", false);
+    return;
+  }
+
+  uint64_t window_us = HOST_WINDOW_MS * 1000ULL;
+  uint64_t start_us = timestamp_us - block.count * 1000000ULL / rate_hz;
+  uint64_t window_start_us = start_us;
+  ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_reset(stream.meter, start_us));
+
+  uint64_t produced = 0;
+  uint64_t dropped = 0;
+  uint64_t meter_ns = 0;
+  uint64_t start_ns = host_cpu_ns();
+  replay_delta max_delta = {0};
+  do {
+    uint64_t feed_ns = host_cpu_ns();
+    sound_meter_window_t window;
+    sound_meter_feed(stream.meter, block.samples, block.count, block.frames_dropped);
+    bool close = timestamp_us - window_start_us >= window_us;
+    if (close) {
+      consumer_close_window(&stream, timestamp_us, &window);
+      window_start_us = timestamp_us;
+    }
+    meter_ns += host_cpu_ns() - feed_ns;
+
+    acoustics_reference_feed(&ref, block.samples, block.count);
+    if (close) {
+      compare_window(&window, &ref, &max_delta);
+    }
+    produced += block.count;
+    dropped += block.frames_dropped;
+  } while (adc_trace_replay_next_block(trace, &block, &timestamp_us) == ESP_OK);
+  uint64_t replay_ns = host_cpu_ns() - start_ns;
+
+  double audio_s = (timestamp_us - start_us) / 1e6;
+  printf("[%s] trace at %" PRIu32 " Hz, %u fractional bits: %.1f s, %" PRIu64 " samples, %" PRIu64
+         " frames dropped, %" PRIu32 " windows\n",
+         path, rate_hz, frac_bits, audio_s, produced, dropped, stream.windows);
+  printf("  coverage %6.2f%% mean, %6.2f%% min, %" PRIu32 " windows over %u mV, peak %u mV\n",
+         stream.windows ? 100.0 * stream.coverage_sum / stream.windows : 0.0, stream.windows ? 100.0 * stream.coverage_min : 0.0,
+         stream.event_windows, HOST_EVENT_PEAK_MV, stream.peak_max_mv);
+  printf("  vs reference: max |dLAeq| %.3f dB, |dLAFmax| %.3f dB, |dLA90| %.3f dB\n", max_delta.laeq, max_delta.lafmax,
+         max_delta.la90);
+  printf("  meter  %.2f ns/sample, %.0fx real time, %.0fx with the reference and file reads\n",
+         produced ? (double)meter_ns / (double)produced : 0.0, meter_ns ? audio_s * 1e9 / (double)meter_ns : 0.0,
+         replay_ns ? audio_s * 1e9 / (double)replay_ns : 0.0);
+
+  // Coverage is what the device lost, not checked here
+  host_check("vs reference", max_delta.laeq <= HOST_MAX_LAEQ_DELTA_DB && max_delta.lafmax <= HOST_MAX_LAEQ_DELTA_DB &&
+                             max_delta.la90 <= HOST_MAX_LA90_DELTA_DB);
+
+  acoustics_reference_free(&ref);
+  sound_meter_del(stream.meter);
+  adc_trace_replay_close(trace);
+}
+
+static esp_err_t
+source_open(replay_source *src, const char *path) {
+  esp_err_t ret = ESP_OK;
+  *src = (replay_source){
+      .rate_hz = HOST_SYNTH_RATE_HZ,
+      .channels = 1U,
+      .synth_seed = 0x2545F491U,
+  };
+  if (!path)
+    return ESP_OK;
+
+  src->wav = fopen(path, "rb");
+  ESP_RETURN_ON_FALSE(src->wav, ESP_ERR_NOT_FOUND, TAG, "failed to open %s", path);
+
+  uint8_t header[12];
+  ESP_GOTO_ON_FALSE(fread(header, 1, sizeof(header), src->wav) == sizeof(header) && !memcmp(header, "RIFF", 4) &&
+                        !memcmp(&header[8], "WAVE", 4),
+                    ESP_ERR_INVALID_ARG, err, TAG, "%s is not a WAV file", path);
+
+  // Walks the chunks up to "data", "fmt " has to come first
+  for (;;) {
+    uint8_t chunk_header[8];
+    ESP_GOTO_ON_FALSE(fread(chunk_header, 1, sizeof(chunk_header), src->wav) == sizeof(chunk_header), ESP_ERR_INVALID_SIZE, err,
+                      TAG, "%s has no data chunk", path);
+    uint32_t size = chunk_header[4] | chunk_header[5] << 8 | chunk_header[6] << 16 | (uint32_t)chunk_header[7] << 24;
+
+    if (!memcmp(chunk_header, "fmt ", 4)) {
+      uint8_t fmt[16];
+      ESP_GOTO_ON_FALSE(size >= sizeof(fmt) && fread(fmt, 1, sizeof(fmt), src->wav) == sizeof(fmt), ESP_ERR_INVALID_SIZE, err,
+                        TAG, "%s has a short fmt chunk", path);
+      src->format = fmt[0] | fmt[1] << 8;
+      src->channels = fmt[2] | fmt[3] << 8;
+      src->rate_hz = fmt[4] | fmt[5] << 8 | fmt[6] << 16 | (uint32_t)fmt[7] << 24;
+      src->bits = fmt[14] | fmt[15] << 8;
+      fseek(src->wav, (long)(size - sizeof(fmt) + (size & 1U)), SEEK_CUR);
+    } else if (!memcmp(chunk_header, "data", 4)) {
+      src->data_left = size;
+      break;
+    } else {
+      fseek(src->wav, (long)(size + (size & 1U)), SEEK_CUR);
+    }
+  }
+
+  ESP_GOTO_ON_FALSE(src->channels && src->rate_hz &&
+                        ((src->format == 1U && src->bits == 16U) || (src->format == 3U && src->bits == 32U)),
+                    ESP_ERR_NOT_SUPPORTED, err, TAG, "%s is not 16 bit PCM or 32 bit float", path);
+  return ESP_OK;
+err:
+  fclose(src->wav);
+  src->wav = NULL;
+  return ret;
+}
+static void
+source_close(replay_source *src) {
+  if (src->wav) {
+    fclose(src->wav);
+  }
+  src->wav = NULL;
+}
+/**
+ * First channel only, normalized to [-1, 1]
+ */
+static bool
+source_next(replay_source *src, float *out_sample) {
+  if (!src->wav) {
+    if (src->synth_index >= (uint64_t)HOST_SYNTH_SECONDS * HOST_SYNTH_RATE_HZ)
+      return false;
+
+    src->synth_seed = src->synth_seed * 1664525U + 1013904223U;
+    float noise = (float)(int32_t)src->synth_seed / 2147483648.0f;
+
+    double t = (double)src->synth_index++ / HOST_SYNTH_RATE_HZ;
+    double since_event = t - (uint64_t)(t / HOST_SYNTH_EVENT_GAP) * HOST_SYNTH_EVENT_GAP;
+    *out_sample = noise * (since_event * 1000.0 < HOST_SYNTH_EVENT_MS && t > 1.0 ? HOST_SYNTH_EVENT : HOST_SYNTH_FLOOR);
+    return true;
+  }
+
+  uint32_t frame_bytes = (uint32_t)src->channels * src->bits / 8U;
+  if (src->data_left < frame_bytes)
+    return false;
+
+  uint8_t frame[64];
+  if (frame_bytes > sizeof(frame) || fread(frame, 1, frame_bytes, src->wav) != frame_bytes)
+    return false;
+  src->data_left -= frame_bytes;
+
+  if (src->format == 3U) {
+    memcpy(out_sample, frame, sizeof(float));
+  } else {
+    *out_sample = (float)(int16_t)(frame[0] | frame[1] << 8) / 32768.0f;
+  }
+  return true;
+}
+
+static bool
+resampler_init(replay_resampler *rs, replay_source *src, uint32_t rate_hz) {
+  *rs = (replay_resampler){
+      .src = src,
+      .step = (double)src->rate_hz / rate_hz,
+  };
+  return source_next(src, &rs->a) && source_next(src, &rs->b);
+}
+/**
+ * Linear interpolation to the ADC rate, then the same millivolt scale and clipping the ADC would give
+ */
+static uint32_t
+resampler_fill(replay_resampler *rs, uint16_t *out_mv, uint32_t count) {
+  uint32_t filled = 0;
+
+  for (; filled < count; ++filled) {
+    while (rs->pos >= 1.0) {
+      rs->a = rs->b;
+      if (!source_next(rs->src, &rs->b))
+        return filled;
+      rs->pos -= 1.0;
+    }
+
+    float sample = rs->a + (rs->b - rs->a) * (float)rs->pos;
+    float mv = (float)HOST_DC_OFFSET_MV + sample * HOST_FULL_SCALE_MV + 0.5f;
+    out_mv[filled] = mv < 0.0f ? 0U : mv > (float)HOST_ADC_MAX_MV ? HOST_ADC_MAX_MV : (uint16_t)mv;
+    rs->pos += rs->step;
+  }
+  return filled;
+}
+
+static esp_err_t
+consumer_init(replay_consumer *consumer, uint32_t rate_hz, uint8_t frac_bits, float mv_per_pa, uint16_t fft_size) {
+  *consumer = (replay_consumer){
+      .coverage_min = 1.0f,
+  };
+
+  struct sound_meter_config_t meter_cfg = {
+      .sample_rate_hz = rate_hz,
+      .dc_offset_mv = HOST_DC_OFFSET_MV,
+      .sample_frac_bits = frac_bits,
+      .mv_per_pa = mv_per_pa,
+      .level_interval_ms = HOST_LEVEL_INTERVAL_MS,
+      .fft_size = fft_size,
+      .bands_per_octave = HOST_BANDS_PER_OCTAVE,
+  };
+  ESP_RETURN_ON_ERROR(sound_meter_new(&meter_cfg, &consumer->meter), TAG, "Failed to create a sound meter");
+  return sound_meter_reset(consumer->meter, 0U);
+}
+static void
+consumer_close_window(replay_consumer *consumer, uint64_t now_us, sound_meter_window_t *out_window) {
+  sound_meter_window_t window;
+  ESP_ERROR_CHECK_WITHOUT_ABORT(sound_meter_close_window(consumer->meter, now_us, &window));
+
+  consumer->windows++;
+  consumer->coverage_sum += window.coverage;
+  consumer->coverage_min = window.coverage < consumer->coverage_min ? window.coverage : consumer->coverage_min;
+  consumer->event_windows += window.peak_mv >= HOST_EVENT_PEAK_MV;
+  consumer->peak_max_mv = window.peak_mv > consumer->peak_max_mv ? window.peak_mv : consumer->peak_max_mv;
+  if (out_window) {
+    *out_window = window;
+  }
+}
+static void
+compare_window(const sound_meter_window_t *window, acoustics_reference *ref, replay_delta *max_delta) {
+  double laeq = 0.0, lafmax = 0.0, la90 = 0.0;
+  acoustics_reference_close(ref, &laeq, &lafmax, &la90);
+
+  max_delta->laeq = fmax(max_delta->laeq, fabs(window->laeq_db - laeq));
+  max_delta->lafmax = fmax(max_delta->lafmax, fabs(window->lafmax_db - lafmax));
+  max_delta->la90 = fmax(max_delta->la90, fabs(window->la90_db - la90));
+}
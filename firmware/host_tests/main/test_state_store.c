@@ -0,0 +1,306 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvs.h"
+#include "state_store.h"
+
+#include "host_tests.h"
+
+#define HOST_NVS_ENTRIES  4U
+#define HOST_NVS_BLOB_MAX 512U
+#define HOST_STATE_LEN    221U // BSEC_MAX_STATE_BLOB_SIZE
+#define HOST_MIN_INTERVAL 1000U
+#define HOST_VERSION      3U
+
+/* Fake NVS, one namespace. Its functions take the place of nvs_flash's at link time, state_store calls no others. */
+typedef struct {
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  uint8_t data[HOST_NVS_BLOB_MAX];
+  size_t len;
+  bool is_used;
+} host_nvs_entry;
+
+static host_nvs_entry nvs_entries[HOST_NVS_ENTRIES];
+static int32_t nvs_tear_at = -1; // next nvs_set_blob loses power after this many bytes, -1 for none
+
+static const struct state_store_config_t store_cfg = {
+    .namespace_name = "host",
+    .key = "bsec",
+    .version = HOST_VERSION,
+    .max_len = HOST_STATE_LEN,
+    .min_interval_ms = HOST_MIN_INTERVAL,
+};
+
+static void
+check_round_trip(void);
+static void
+check_skips(void);
+static void
+check_power_loss(void);
+static void
+check_corruption(void);
+static void
+check_version(void);
+
+static state_store_handle
+reboot(state_store_handle store, const struct state_store_config_t *cfg);
+static bool
+loads(state_store_handle store, uint8_t generation);
+static bool
+save(state_store_handle store, uint8_t generation, uint64_t now_us);
+static void
+fill_state(uint8_t *data, uint8_t generation);
+static host_nvs_entry *
+find_entry(const char *key);
+
+void
+test_state_store(void) {
+  check_round_trip();
+  check_skips();
+  check_power_loss();
+  check_corruption();
+  check_version();
+
+}
+
+/**
+ * Nothing saved yet, then a few saves and the newest one back after a reboot
+ */
+static void
+check_round_trip(void) {
+  printf("[round trip, %u byte state]\n", HOST_STATE_LEN);
+  memset(nvs_entries, 0, sizeof(nvs_entries));
+
+  state_store_handle store = reboot(NULL, &store_cfg);
+  uint8_t data[HOST_STATE_LEN];
+  size_t len = 0;
+  host_check("empty store", store && state_store_load(store, data, sizeof(data), &len) == ESP_ERR_NOT_FOUND);
+
+  bool ok = true;
+  for (uint8_t g = 1; g <= 5; ++g) {
+    ok = ok && save(store, g, g * HOST_MIN_INTERVAL * 1000ULL);
+  }
+  store = reboot(store, &store_cfg);
+  host_check("after reboot", ok && loads(store, 5));
+
+  // A buffer short of the saved state is refused, not overrun
+  host_check("short buffer", state_store_load(store, data, HOST_STATE_LEN - 1U, &len) == ESP_ERR_INVALID_SIZE);
+  state_store_del(store);
+}
+/**
+ * Saves within min_interval_ms and of the newest blob again reach no slot
+ */
+static void
+check_skips(void) {
+  printf("[skips, %u ms min interval]\n", HOST_MIN_INTERVAL);
+  memset(nvs_entries, 0, sizeof(nvs_entries));
+
+  state_store_handle store = reboot(NULL, &store_cfg);
+  uint8_t data[HOST_STATE_LEN];
+  fill_state(data, 1);
+  bool written[4] = {false};
+  state_store_save(store, data, sizeof(data), 0, &written[0]);
+  state_store_save(store, data, sizeof(data), HOST_MIN_INTERVAL * 500ULL, &written[1]);
+  state_store_save(store, data, sizeof(data), HOST_MIN_INTERVAL * 2000ULL, &written[2]);
+  fill_state(data, 2);
+  state_store_save(store, data, sizeof(data), HOST_MIN_INTERVAL * 4000ULL, &written[3]);
+
+  state_store_stats_t stats;
+  state_store_get_stats(store, &stats);
+  host_check("early", !written[1] && stats.skipped_early == 1U);
+  host_check("unchanged", !written[2] && stats.skipped_unchanged == 1U);
+  host_check("writes", written[0] && written[3] && stats.writes == 2U);
+  state_store_del(store);
+}
+/**
+ * Power lost at every byte of a write: whatever the torn slot holds, the reboot loads the state before it, and the next
+ * save goes over the torn slot again rather than the good one
+ */
+static void
+check_power_loss(void) {
+  const uint32_t slot_len = HOST_STATE_LEN + 16U; // state_store_header_t
+  printf("[power loss at each of %" PRIu32 " bytes of a write]\n", slot_len);
+
+  uint32_t lost = 0;
+  uint32_t recovered = 0;
+  for (uint32_t tear = 0; tear < slot_len; ++tear) {
+    memset(nvs_entries, 0, sizeof(nvs_entries));
+    state_store_handle store = reboot(NULL, &store_cfg);
+    bool ok = save(store, 1, 0) && save(store, 2, HOST_MIN_INTERVAL * 1000ULL);
+
+    nvs_tear_at = (int32_t)tear;
+    ok = ok && !save(store, 3, HOST_MIN_INTERVAL * 2000ULL);
+    nvs_tear_at = -1;
+
+    store = reboot(store, &store_cfg);
+    if (!ok || !loads(store, 2)) {
+      ++lost;
+    } else if (save(store, 4, 0) && loads(store, 4)) {
+      store = reboot(store, &store_cfg);
+      recovered += loads(store, 4);
+    }
+    state_store_del(store);
+  }
+  host_check("previous state", lost == 0);
+  host_check("next save", recovered == slot_len);
+}
+/**
+ * The newest slot going bad after start up, load falls back to the older one and saves compare against that
+ */
+static void
+check_corruption(void) {
+  printf("[corrupted newest slot]\n");
+  memset(nvs_entries, 0, sizeof(nvs_entries));
+
+  state_store_handle store = reboot(NULL, &store_cfg);
+  bool ok = save(store, 1, 0) && save(store, 2, HOST_MIN_INTERVAL * 1000ULL);
+  host_nvs_entry *newest = find_entry("bsec1");
+  ok = ok && newest;
+  if (newest) {
+    newest->data[newest->len / 2U] ^= 0x5AU;
+  }
+  host_check("older slot", ok && loads(store, 1));
+
+  // The blob of the bad slot again, it is not on flash any more so it is written, over the bad slot
+  host_check("save after it", save(store, 2, HOST_MIN_INTERVAL * 2000ULL) && loads(store, 2));
+
+  // Both gone, nothing left to load
+  for (uint8_t i = 0; i < HOST_NVS_ENTRIES; ++i) {
+    if (nvs_entries[i].is_used) {
+      nvs_entries[i].data[nvs_entries[i].len - 1U] ^= 0x5AU;
+    }
+  }
+  uint8_t data[HOST_STATE_LEN];
+  size_t len = 0;
+  store = reboot(store, &store_cfg);
+  host_check("both slots", state_store_load(store, data, sizeof(data), &len) == ESP_ERR_NOT_FOUND);
+  state_store_del(store);
+}
+/**
+ * Slots of another format version are ignored, as after a BSEC update
+ */
+static void
+check_version(void) {
+  printf("[version %u after %u]\n", HOST_VERSION + 1U, HOST_VERSION);
+  memset(nvs_entries, 0, sizeof(nvs_entries));
+
+  state_store_handle store = reboot(NULL, &store_cfg);
+  bool ok = save(store, 1, 0);
+
+  struct state_store_config_t next_cfg = store_cfg;
+  next_cfg.version = HOST_VERSION + 1U;
+  store = reboot(store, &next_cfg);
+  uint8_t data[HOST_STATE_LEN];
+  size_t len = 0;
+  host_check("old slot ignored", ok && state_store_load(store, data, sizeof(data), &len) == ESP_ERR_NOT_FOUND);
+
+  ok = save(store, 2, 0);
+  store = reboot(store, &next_cfg);
+  host_check("new version", ok && loads(store, 2));
+  state_store_del(store);
+}
+
+static state_store_handle
+reboot(state_store_handle store, const struct state_store_config_t *cfg) {
+  if (store) {
+    state_store_del(store);
+  }
+  store = NULL;
+  if (state_store_new(cfg, &store) != ESP_OK) {
+    printf("  state_store_new failed\n");
+    return NULL;
+  }
+  return store;
+}
+
+static bool
+loads(state_store_handle store, uint8_t generation) {
+  uint8_t expected[HOST_STATE_LEN];
+  uint8_t data[HOST_STATE_LEN];
+  size_t len = 0;
+  fill_state(expected, generation);
+  return store && state_store_load(store, data, sizeof(data), &len) == ESP_OK && len == sizeof(data) &&
+         memcmp(data, expected, sizeof(data)) == 0;
+}
+
+static bool
+save(state_store_handle store, uint8_t generation, uint64_t now_us) {
+  uint8_t data[HOST_STATE_LEN];
+  bool is_written = false;
+  fill_state(data, generation);
+  return store && state_store_save(store, data, sizeof(data), now_us, &is_written) == ESP_OK && is_written;
+}
+
+static void
+fill_state(uint8_t *data, uint8_t generation) {
+  for (uint32_t i = 0; i < HOST_STATE_LEN; ++i) {
+    data[i] = (uint8_t)(i * 31U + generation * 7U);
+  }
+}
+
+static host_nvs_entry *
+find_entry(const char *key) {
+  for (uint8_t i = 0; i < HOST_NVS_ENTRIES; ++i) {
+    if (nvs_entries[i].is_used && strcmp(nvs_entries[i].key, key) == 0)
+      return &nvs_entries[i];
+  }
+  return NULL;
+}
+
+esp_err_t
+nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+  *out_handle = 1;
+  return ESP_OK;
+}
+void
+nvs_close(nvs_handle_t handle) {}
+esp_err_t
+nvs_commit(nvs_handle_t handle) {
+  return ESP_OK;
+}
+
+esp_err_t
+nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+  if (length > HOST_NVS_BLOB_MAX)
+    return ESP_ERR_NVS_VALUE_TOO_LONG;
+  host_nvs_entry *entry = find_entry(key);
+  for (uint8_t i = 0; !entry && i < HOST_NVS_ENTRIES; ++i) {
+    if (!nvs_entries[i].is_used) {
+      entry = &nvs_entries[i];
+    }
+  }
+  if (!entry)
+    return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+
+  // Worse than NVS itself allows: the torn entry keeps the new bytes up to the cut and the old ones after it
+  size_t copied = nvs_tear_at >= 0 && (size_t)nvs_tear_at < length ? (size_t)nvs_tear_at : length;
+  strncpy(entry->key, key, sizeof(entry->key) - 1U);
+  memcpy(entry->data, value, copied);
+  entry->len = length;
+  entry->is_used = true;
+  return copied == length ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t
+nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+  host_nvs_entry *entry = find_entry(key);
+  if (!entry)
+    return ESP_ERR_NVS_NOT_FOUND;
+  if (*length < entry->len)
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  memcpy(out_value, entry->data, entry->len);
+  *length = entry->len;
+  return ESP_OK;
+}
+
+esp_err_t
+nvs_erase_key(nvs_handle_t handle, const char *key) {
+  host_nvs_entry *entry = find_entry(key);
+  if (!entry)
+    return ESP_ERR_NVS_NOT_FOUND;
+  entry->is_used = false;
+  return ESP_OK;
+}
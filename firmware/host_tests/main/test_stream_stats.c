@@ -0,0 +1,269 @@
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stream_stats.h"
+
+#include "host_tests.h"
+
+#define HOST_SAMPLES       200000U
+#define HOST_FRAME_SAMPLES 200U // ADC_CONT_CONV_FRAME_SIZE / SOC_ADC_DIGI_RESULT_BYTES
+#define HOST_DC_OFFSET_MV  1650
+#define HOST_ADC_MAX_MV    3160U
+#define HOST_SPLITS        7U
+#define HOST_BENCH_ROUNDS  200U
+
+/* Relative tolerance against the double reference, the fixed point mean carries 8 fraction bits */
+#define HOST_REL_TOLERANCE 1e-5
+#define HOST_ABS_TOLERANCE (2.0 / (1 << STREAM_STATS_FRAC_BITS))
+
+typedef struct {
+  const char *name;
+  int32_t centre;
+  int32_t spread;
+  bool u16;
+  uint32_t count;
+} host_case;
+
+typedef struct {
+  double mean;
+  double variance;
+  double rms;
+  int32_t min;
+  int32_t max;
+} host_reference;
+
+static const host_case cases[] = {
+    {"microphone mV around the bias", HOST_DC_OFFSET_MV, 600, true, HOST_SAMPLES},
+    {"quiet microphone, 2 mV of noise", HOST_DC_OFFSET_MV, 2, true, HOST_SAMPLES},
+    {"full ADC range", HOST_ADC_MAX_MV / 2, HOST_ADC_MAX_MV / 2, true, HOST_SAMPLES},
+    {"deci-lux near the top, +-1 of noise", STREAM_STATS_VALUE_MAX - 2, 1, false, HOST_SAMPLES},
+    {"signed around 0, +-2^16", 0, 1 << 16, false, HOST_SAMPLES},
+    {"full value range up to the M2 capacity", 0, STREAM_STATS_VALUE_MAX - 1, false, 100000U},
+    {"constant", -12345, 0, false, HOST_SAMPLES},
+};
+
+static int32_t values[HOST_SAMPLES];
+static uint16_t samples[HOST_SAMPLES];
+static uint32_t rng_state = 1U;
+
+static void
+check_case(const host_case *c);
+static void
+check_legacy_overflow(void);
+static void
+bench(void);
+
+static void
+fill(const host_case *c);
+static void
+reference(const int32_t *data, uint32_t count, host_reference *out_ref);
+static void
+expect(const char *what, const stream_stats_t *stats, uint32_t count, const host_reference *ref);
+static bool
+close_to(double value, double expected);
+static uint32_t
+rng_next(void);
+
+void
+test_stream_stats(void) {
+  for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    check_case(&cases[i]);
+  }
+  check_legacy_overflow();
+  bench();
+
+}
+
+/**
+ * Every way of feeding the same values has to land on the two-pass statistics
+ */
+static void
+check_case(const host_case *c) {
+  printf("[%s]\n", c->name);
+  fill(c);
+  host_reference ref;
+  reference(values, c->count, &ref);
+
+  stream_stats_t stats;
+  stream_stats_reset(&stats);
+  for (uint32_t i = 0; i < c->count; ++i) {
+    stream_stats_push(&stats, values[i]);
+  }
+  expect("push", &stats, c->count, &ref);
+
+  stream_stats_reset(&stats);
+  stream_stats_add(&stats, values, c->count);
+  expect("add", &stats, c->count, &ref);
+
+  if (c->u16) {
+    stream_stats_reset(&stats);
+    for (uint32_t offset = 0; offset < c->count; offset += HOST_FRAME_SAMPLES) {
+      stream_stats_add_u16(&stats, &samples[offset], HOST_FRAME_SAMPLES, HOST_DC_OFFSET_MV);
+    }
+    expect("add_u16 frames", &stats, c->count, &ref);
+  }
+
+  // Uneven partial windows merged in order and in reverse, plus empty ones in between
+  stream_stats_t parts[HOST_SPLITS + 1U];
+  uint32_t edges[HOST_SPLITS + 2U] = {0};
+  for (uint8_t i = 1; i <= HOST_SPLITS; ++i) {
+    edges[i] = (uint32_t)((uint64_t)c->count * i * i / ((HOST_SPLITS + 1U) * (HOST_SPLITS + 1U)));
+  }
+  edges[HOST_SPLITS + 1U] = c->count;
+  for (uint8_t i = 0; i <= HOST_SPLITS; ++i) {
+    stream_stats_reset(&parts[i]);
+    stream_stats_add(&parts[i], &values[edges[i]], edges[i + 1U] - edges[i]);
+  }
+
+  stream_stats_t empty;
+  stream_stats_reset(&empty);
+  stream_stats_reset(&stats);
+  for (uint8_t i = 0; i <= HOST_SPLITS; ++i) {
+    stream_stats_merge(&stats, &parts[i]);
+    stream_stats_merge(&stats, &empty);
+  }
+  expect("merge", &stats, c->count, &ref);
+
+  stream_stats_reset(&stats);
+  for (int8_t i = HOST_SPLITS; i >= 0; --i) {
+    stream_stats_merge(&stats, &parts[i]);
+  }
+  expect("merge reversed", &stats, c->count, &ref);
+}
+/**
+ * What the sound task used to do: uint32_t sum of squared offsets and an integer mean
+ */
+static void
+check_legacy_overflow(void) {
+  printf("[legacy accumulator, full-scale microphone]\n");
+  for (uint32_t i = 0; i < HOST_SAMPLES; ++i) {
+    samples[i] = (uint16_t)(i & 1U ? HOST_ADC_MAX_MV : 140U);
+  }
+
+  uint32_t accumulator_value = 0;
+  uint32_t overflow_at = 0;
+  for (uint32_t i = 0; i < HOST_SAMPLES && !overflow_at; ++i) {
+    int32_t v = (int32_t)samples[i] - HOST_DC_OFFSET_MV;
+    uint32_t next = accumulator_value + (uint32_t)(v * v);
+    overflow_at = next < accumulator_value ? i + 1U : 0U;
+    accumulator_value = next;
+  }
+
+  stream_stats_t stats;
+  stream_stats_reset(&stats);
+  stream_stats_add_u16(&stats, samples, HOST_SAMPLES, HOST_DC_OFFSET_MV);
+  stream_stats_result_t result;
+  stream_stats_get(&stats, &result);
+
+  printf("  uint32_t sum wraps after %" PRIu32 " samples, stream_stats RMS %.1f mV over %" PRIu64 " samples\n",
+         overflow_at, result.rms, result.count);
+  host_check_count(close_to(result.rms, 1510.0));
+}
+
+static void
+bench(void) {
+  host_case noise = cases[0];
+  fill(&noise);
+
+  stream_stats_t stats;
+  uint64_t push_ns = 0, add_ns = 0, add_u16_ns = 0, float_ns = 0;
+  volatile float sink = 0.0f;
+  for (uint32_t round = 0; round < HOST_BENCH_ROUNDS; ++round) {
+    uint64_t start = host_cpu_ns();
+    stream_stats_reset(&stats);
+    for (uint32_t i = 0; i < HOST_SAMPLES; ++i) {
+      stream_stats_push(&stats, values[i]);
+    }
+    push_ns += host_cpu_ns() - start;
+
+    start = host_cpu_ns();
+    stream_stats_reset(&stats);
+    for (uint32_t offset = 0; offset < HOST_SAMPLES; offset += HOST_FRAME_SAMPLES) {
+      stream_stats_add(&stats, &values[offset], HOST_FRAME_SAMPLES);
+    }
+    add_ns += host_cpu_ns() - start;
+
+    start = host_cpu_ns();
+    stream_stats_reset(&stats);
+    for (uint32_t offset = 0; offset < HOST_SAMPLES; offset += HOST_FRAME_SAMPLES) {
+      stream_stats_add_u16(&stats, &samples[offset], HOST_FRAME_SAMPLES, HOST_DC_OFFSET_MV);
+    }
+    add_u16_ns += host_cpu_ns() - start;
+
+    // Textbook float Welford for comparison, one division per sample
+    start = host_cpu_ns();
+    float mean = 0.0f, m2 = 0.0f;
+    for (uint32_t i = 0; i < HOST_SAMPLES; ++i) {
+      float delta = (float)values[i] - mean;
+      mean += delta / (float)(i + 1U);
+      m2 += delta * ((float)values[i] - mean);
+    }
+    sink += m2;
+    float_ns += host_cpu_ns() - start;
+  }
+
+  double samples_total = (double)HOST_SAMPLES * HOST_BENCH_ROUNDS;
+  printf("[bench] ns/sample: push %.2f, add %.2f, add_u16 %.2f (%u-sample frames), float Welford %.2f\n",
+         push_ns / samples_total, add_ns / samples_total, add_u16_ns / samples_total, HOST_FRAME_SAMPLES,
+         float_ns / samples_total);
+}
+
+static void
+fill(const host_case *c) {
+  for (uint32_t i = 0; i < c->count; ++i) {
+    int32_t noise = c->spread ? (int32_t)(rng_next() % (2U * c->spread + 1U)) - c->spread : 0;
+    values[i] = c->centre + noise;
+    if (c->u16) {
+      samples[i] = (uint16_t)values[i];
+      values[i] -= HOST_DC_OFFSET_MV;
+    }
+  }
+}
+static void
+reference(const int32_t *data, uint32_t count, host_reference *out_ref) {
+  double sum = 0.0;
+  *out_ref = (host_reference){.min = data[0], .max = data[0]};
+  for (uint32_t i = 0; i < count; ++i) {
+    sum += data[i];
+    out_ref->min = data[i] < out_ref->min ? data[i] : out_ref->min;
+    out_ref->max = data[i] > out_ref->max ? data[i] : out_ref->max;
+  }
+  out_ref->mean = sum / count;
+
+  double m2 = 0.0;
+  for (uint32_t i = 0; i < count; ++i) {
+    m2 += (data[i] - out_ref->mean) * (data[i] - out_ref->mean);
+  }
+  out_ref->variance = m2 / count;
+  out_ref->rms = sqrt(out_ref->mean * out_ref->mean + out_ref->variance);
+}
+static void
+expect(const char *what, const stream_stats_t *stats, uint32_t count, const host_reference *ref) {
+  stream_stats_result_t result;
+  stream_stats_get(stats, &result);
+
+  bool ok = result.count == count && result.min == ref->min && result.max == ref->max &&
+            close_to(result.mean, ref->mean) && close_to(result.variance, ref->variance) && close_to(result.rms, ref->rms);
+  printf("  %-15s %s mean %.4f (%.4f) var %.4f (%.4f) rms %.4f (%.4f) min %" PRId32 " max %" PRId32 "\n", what,
+         ok ? "ok  " : "FAIL", result.mean, ref->mean, result.variance, ref->variance, result.rms, ref->rms, result.min,
+         result.max);
+  host_check_count(ok);
+}
+static bool
+close_to(double value, double expected) {
+  // The results are floats, so anything finer than their own rounding does not count
+  double tolerance = fmax(HOST_ABS_TOLERANCE, fabs(expected) * fmax(HOST_REL_TOLERANCE, 2.0 * FLT_EPSILON));
+  return fabs(value - expected) <= tolerance;
+}
+static uint32_t
+rng_next(void) {
+  rng_state ^= rng_state << 13U;
+  rng_state ^= rng_state >> 17U;
+  rng_state ^= rng_state << 5U;
+  return rng_state;
+}
\ No newline at end of file
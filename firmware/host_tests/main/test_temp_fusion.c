@@ -0,0 +1,174 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "temp_fusion.h"
+
+#include "host_tests.h"
+
+/* As main.cpp configures the filter for the BME690 and the BMP180 */
+#define HOST_SENSOR_NOISE       0.05f
+#define HOST_REF_NOISE          0.15f
+#define HOST_TEMP_DRIFT_H       1.0f
+#define HOST_HEATING_DRIFT_H    0.2f
+#define HOST_INITIAL_HEATING    0.0f
+#define HOST_INITIAL_HEATING_SD 2.0f
+
+#define HOST_SENSOR_PERIOD_US 3000000ULL // BSEC LP
+#define HOST_REF_PERIOD_US    60000000ULL
+#define HOST_REF_DELAY_US     1000000ULL // the cached reference is a little behind
+#define HOST_RUN_H            6U
+#define HOST_SETTLE_H         1U // left out of the error, the heating is still unknown
+#define HOST_HEATING          1.5f
+#define HOST_ROOM             21.0f
+#define HOST_ROOM_SWING       1.0f // over the run, half a sine
+
+#define HOST_MAX_RMS_ERROR   0.1f
+#define HOST_MAX_HEATING_ERR 0.1f
+#define HOST_MAX_REJECTED    5U
+#define HOST_MAX_SPIKE_MOVE  0.05f
+#define HOST_STEP            5.0f
+#define HOST_MAX_STEP_ERROR  0.2f
+#define HOST_STEP_READINGS   10U
+
+static uint32_t rng_state = 1U;
+
+static const temp_fusion_config_t fusion_cfg = {
+    .sensor_noise = HOST_SENSOR_NOISE,
+    .ref_noise = HOST_REF_NOISE,
+    .temp_drift_per_h = HOST_TEMP_DRIFT_H,
+    .heating_drift_per_h = HOST_HEATING_DRIFT_H,
+    .initial_heating = HOST_INITIAL_HEATING,
+    .initial_heating_stddev = HOST_INITIAL_HEATING_SD,
+};
+
+static void
+check_run(void);
+static void
+check_sensor_alone(void);
+
+static float
+run_room(temp_fusion_t *fusion, bool has_ref, uint64_t *out_end_us);
+static float
+room_at(uint64_t timestamp_us);
+static float
+gauss(void);
+static uint32_t
+rng_next(void);
+
+void
+test_temp_fusion(void) {
+  check_run();
+  check_sensor_alone();
+
+}
+
+/**
+ * Both sensors over the run, then a lone spike and a real step of the room
+ */
+static void
+check_run(void) {
+  printf("[%u h, %.1f C of self heating, reference every %u s]\n", HOST_RUN_H, HOST_HEATING,
+         (unsigned)(HOST_REF_PERIOD_US / 1000000ULL));
+  temp_fusion_t fusion;
+  temp_fusion_init(&fusion, &fusion_cfg);
+  temp_fusion_result_t result;
+  host_check("no reading yet", !temp_fusion_get(&fusion, &result));
+
+  uint64_t timestamp_us = 0;
+  float rms = run_room(&fusion, true, &timestamp_us);
+  temp_fusion_get(&fusion, &result);
+  printf("  rms %.3f C, heating %.2f C, stddev %.3f C, %" PRIu32 " + %" PRIu32 " updates, %" PRIu32 " rejected\n", rms,
+         result.heating, result.temp_stddev, fusion.sensor_updates, fusion.ref_updates, fusion.rejected);
+  host_check("tracking", rms <= HOST_MAX_RMS_ERROR);
+  host_check("heating", fabsf(result.heating - HOST_HEATING) <= HOST_MAX_HEATING_ERR);
+  host_check("few rejected", fusion.rejected <= HOST_MAX_REJECTED);
+
+  // One reading 5 C off, the gate drops it
+  float before = result.temp;
+  uint32_t rejected = fusion.rejected;
+  timestamp_us += HOST_SENSOR_PERIOD_US;
+  float room = room_at(timestamp_us);
+  temp_fusion_push_sensor(&fusion, room + HOST_HEATING + HOST_STEP, timestamp_us);
+  temp_fusion_get(&fusion, &result);
+  host_check("spike", fusion.rejected == rejected + 1U && fabsf(result.temp - before) <= HOST_MAX_SPIKE_MOVE);
+
+  // The room itself jumps, followed once the gate gives in
+  for (uint8_t i = 0; i < HOST_STEP_READINGS; ++i) {
+    timestamp_us += HOST_SENSOR_PERIOD_US;
+    temp_fusion_push_sensor(&fusion, room + HOST_HEATING + HOST_STEP, timestamp_us);
+  }
+  temp_fusion_get(&fusion, &result);
+  printf("  after the step %.2f C, %.2f expected\n", result.temp + result.heating, room + HOST_HEATING + HOST_STEP);
+  host_check("step", fabsf(result.temp + result.heating - (room + HOST_HEATING + HOST_STEP)) <= HOST_MAX_STEP_ERROR);
+}
+/**
+ * No reference, as without the BMP180: the heating stays at its prior and the sum follows the sensor
+ */
+static void
+check_sensor_alone(void) {
+  printf("[sensor alone]\n");
+  temp_fusion_t fusion;
+  temp_fusion_init(&fusion, &fusion_cfg);
+
+  uint64_t timestamp_us = 0;
+  run_room(&fusion, false, &timestamp_us);
+  temp_fusion_result_t result;
+  temp_fusion_get(&fusion, &result);
+  float expected = room_at(timestamp_us) + HOST_HEATING;
+  printf("  %.2f C read, %.2f expected, heating %.2f C\n", result.temp + result.heating, expected, result.heating);
+  host_check("follows sensor", fabsf(result.temp + result.heating - expected) <= HOST_MAX_STEP_ERROR);
+  host_check("heating prior", fabsf(result.heating - HOST_INITIAL_HEATING) <= HOST_MAX_HEATING_ERR);
+  host_check("no reference", fusion.ref_updates == 0U);
+}
+
+/**
+ * Feeds the run and returns the rms error of the room temperature after the settling hour
+ */
+static float
+run_room(temp_fusion_t *fusion, bool has_ref, uint64_t *out_end_us) {
+  const uint64_t end_us = HOST_RUN_H * 3600ULL * 1000000ULL;
+  const uint64_t settle_us = HOST_SETTLE_H * 3600ULL * 1000000ULL;
+  double error2 = 0.0;
+  uint32_t count = 0;
+  uint64_t timestamp_us = 0;
+  for (; timestamp_us < end_us; timestamp_us += HOST_SENSOR_PERIOD_US) {
+    float room = room_at(timestamp_us);
+    temp_fusion_push_sensor(fusion, room + HOST_HEATING + gauss() * HOST_SENSOR_NOISE, timestamp_us);
+    if (has_ref && timestamp_us % HOST_REF_PERIOD_US == 0 && timestamp_us >= HOST_REF_DELAY_US) {
+      uint64_t ref_us = timestamp_us - HOST_REF_DELAY_US;
+      temp_fusion_push_ref(fusion, room_at(ref_us) + gauss() * HOST_REF_NOISE, ref_us);
+    }
+
+    temp_fusion_result_t result;
+    temp_fusion_get(fusion, &result);
+    if (timestamp_us >= settle_us) {
+      error2 += (double)(result.temp - room) * (result.temp - room);
+      ++count;
+    }
+  }
+  *out_end_us = timestamp_us - HOST_SENSOR_PERIOD_US;
+  return count ? (float)sqrt(error2 / count) : 0.0f;
+}
+
+static float
+room_at(uint64_t timestamp_us) {
+  return HOST_ROOM + HOST_ROOM_SWING * sinf((float)M_PI * timestamp_us / (HOST_RUN_H * 3600.0f * 1000000.0f));
+}
+
+static float
+gauss(void) {
+  // Box-Muller, the second value is not worth keeping
+  double u1 = (rng_next() + 1.0) / 4294967297.0;
+  double u2 = rng_next() / 4294967296.0;
+  return (float)(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+}
+static uint32_t
+rng_next(void) {
+  rng_state ^= rng_state << 13U;
+  rng_state ^= rng_state >> 17U;
+  rng_state ^= rng_state << 5U;
+  return rng_state;
+}